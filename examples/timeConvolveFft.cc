@@ -0,0 +1,114 @@
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Time direct and FFT convolution of a large MaskedImage across a range of kernel sizes,
+ * and report which algorithm the AUTO cost model picks
+ *
+ * Usage: timeConvolveFft [imageSize [maxKernelSize [nIter]]]
+ */
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include "lsst/geom.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/math/ConvolveImage.h"
+#include "lsst/afw/math/FunctionLibrary.h"
+#include "lsst/afw/math/Kernel.h"
+#include "lsst/afw/math/Random.h"
+#include "lsst/afw/math/RandomImage.h"
+
+namespace afwImage = lsst::afw::image;
+namespace afwMath = lsst::afw::math;
+
+typedef afwImage::MaskedImage<float> MaskedImage;
+
+const unsigned DefNIter = 3;
+const int DefImageSize = 2048;
+const int DefMaxKernelSize = 63;
+
+template <typename ImageT>
+double timeOne(ImageT &outImage, ImageT const &inImage, afwMath::Kernel const &kernel,
+               afwMath::ConvolutionControl const &convControl, unsigned nIter) {
+    auto const startTime = std::chrono::steady_clock::now();
+    for (unsigned iter = 0; iter < nIter; ++iter) {
+        afwMath::convolve(outImage, inImage, kernel, convControl);
+    }
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - startTime;
+    return elapsed.count() / nIter;
+}
+
+template <typename ImageT>
+void timeImage(std::string const &imageDescr, ImageT const &inImage, int maxKernelSize, unsigned nIter) {
+    ImageT outImage(inImage.getDimensions());
+    afwMath::ConvolutionControl convControl;
+
+    std::cout << std::endl << imageDescr << std::endl;
+    std::cout << "KSize\tDirSec\tFftSec\tAutoSec\tSpeedup" << std::endl;
+    for (int kSize = 3; kSize <= maxKernelSize; kSize = kSize * 3 / 2 + (kSize * 3 / 2) % 2 + 1) {
+        double const sigma = kSize / 6.0;
+        afwMath::GaussianFunction2<afwMath::Kernel::Pixel> gaussFunc(sigma, sigma, 0);
+        afwMath::AnalyticKernel kernel(kSize, kSize, gaussFunc);
+
+        convControl.setAlgorithm(afwMath::ConvolutionControl::DIRECT);
+        double const directSec = timeOne(outImage, inImage, kernel, convControl, nIter);
+        convControl.setAlgorithm(afwMath::ConvolutionControl::FFT);
+        double const fftSec = timeOne(outImage, inImage, kernel, convControl, nIter);
+        convControl.setAlgorithm(afwMath::ConvolutionControl::AUTO);
+        double const autoSec = timeOne(outImage, inImage, kernel, convControl, nIter);
+        std::cout << kSize << "\t" << directSec << "\t" << fftSec << "\t" << autoSec << "\t"
+                  << directSec / fftSec << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    int imageSize = DefImageSize;
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> imageSize;
+    }
+    int maxKernelSize = DefMaxKernelSize;
+    if (argc > 2) {
+        std::istringstream(argv[2]) >> maxKernelSize;
+    }
+    unsigned nIter = DefNIter;
+    if (argc > 3) {
+        std::istringstream(argv[3]) >> nIter;
+    }
+
+    MaskedImage inImage(lsst::geom::Extent2I(imageSize, imageSize));
+    afwMath::Random rand;
+    afwMath::randomGaussianImage(inImage.getImage().get(), rand);
+    *inImage.getVariance() = 1.0;
+
+    std::cout << "Timing convolution of a " << imageSize << " x " << imageSize
+              << " image with Gaussian kernels of up to " << maxKernelSize << " x " << maxKernelSize
+              << " pixels" << std::endl;
+    std::cout << "* KSize: width and height of kernel (pixels)" << std::endl;
+    std::cout << "* DirSec, FftSec, AutoSec: time to perform one convolution directly, using FFTs,"
+              << " and using the algorithm picked by the cost model (sec)" << std::endl;
+    std::cout << "* Speedup: DirSec / FftSec" << std::endl;
+
+    timeImage("Image<float>", *inImage.getImage(), maxKernelSize, nIter);
+    timeImage("MaskedImage<float>", inImage, maxKernelSize, nIter);
+}
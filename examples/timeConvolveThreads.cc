@@ -0,0 +1,119 @@
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Time convolution of a large MaskedImage using 1 to N threads
+ *
+ * Usage: timeConvolveThreads [maxThreads [imageSize [nIter]]]
+ */
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "lsst/geom.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/math/ConvolveImage.h"
+#include "lsst/afw/math/FunctionLibrary.h"
+#include "lsst/afw/math/Kernel.h"
+#include "lsst/afw/math/Random.h"
+#include "lsst/afw/math/RandomImage.h"
+
+namespace afwImage = lsst::afw::image;
+namespace afwMath = lsst::afw::math;
+
+typedef afwImage::MaskedImage<float> MaskedImage;
+
+const unsigned DefNIter = 3;
+const int DefImageSize = 4096;
+const int KernelSize = 19;
+const double Sigma = 3;
+
+double timeOne(MaskedImage &outImage, MaskedImage const &inImage, afwMath::Kernel const &kernel,
+               afwMath::ConvolutionControl const &convControl, unsigned nIter) {
+    auto const startTime = std::chrono::steady_clock::now();
+    for (unsigned iter = 0; iter < nIter; ++iter) {
+        afwMath::convolve(outImage, inImage, kernel, convControl);
+    }
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - startTime;
+    return elapsed.count() / nIter;
+}
+
+void timeKernel(std::string const &kernelDescr, MaskedImage const &inImage, afwMath::Kernel const &kernel,
+                int maxThreads, unsigned nIter) {
+    MaskedImage outImage(inImage.getDimensions());
+    afwMath::ConvolutionControl convControl;
+
+    std::cout << std::endl << kernelDescr << std::endl;
+    std::cout << "Threads\tCnvSec\tSpeedup" << std::endl;
+    double serialSec = 0;
+    for (int nThreads = 1; nThreads <= maxThreads; nThreads *= 2) {
+        convControl.setNThreads(nThreads);
+        double const sec = timeOne(outImage, inImage, kernel, convControl, nIter);
+        if (nThreads == 1) {
+            serialSec = sec;
+        }
+        std::cout << nThreads << "\t" << sec << "\t" << serialSec / sec << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> maxThreads;
+    }
+    int imageSize = DefImageSize;
+    if (argc > 2) {
+        std::istringstream(argv[2]) >> imageSize;
+    }
+    unsigned nIter = DefNIter;
+    if (argc > 3) {
+        std::istringstream(argv[3]) >> nIter;
+    }
+
+    MaskedImage inImage(lsst::geom::Extent2I(imageSize, imageSize));
+    afwMath::Random rand;
+    afwMath::randomGaussianImage(inImage.getImage().get(), rand);
+    *inImage.getVariance() = 1.0;
+
+    std::cout << "Timing convolution of a " << imageSize << " x " << imageSize << " MaskedImage<float>"
+              << " with a " << KernelSize << " x " << KernelSize << " kernel, using up to " << maxThreads
+              << " threads" << std::endl;
+    std::cout << "* CnvSec: wall-clock time to perform one convolution (sec)" << std::endl;
+
+    afwMath::GaussianFunction2<afwMath::Kernel::Pixel> gaussFunc2(Sigma, Sigma, 0);
+    afwMath::AnalyticKernel analyticKernel(KernelSize, KernelSize, gaussFunc2);
+    timeKernel("Analytic Kernel", inImage, analyticKernel, maxThreads, nIter);
+
+    afwMath::GaussianFunction1<afwMath::Kernel::Pixel> gaussFunc1(Sigma);
+    afwMath::SeparableKernel separableKernel(KernelSize, KernelSize, gaussFunc1, gaussFunc1);
+    timeKernel("Separable Kernel", inImage, separableKernel, maxThreads, nIter);
+
+    afwMath::PolynomialFunction2<double> spatialFunc(1);
+    afwMath::AnalyticKernel varyingKernel(KernelSize, KernelSize, gaussFunc2, spatialFunc);
+    std::vector<std::vector<double>> spatialParams = {{Sigma, 1.0e-4, 0.0}, {Sigma, 0.0, 1.0e-4}, {0, 0, 0}};
+    varyingKernel.setSpatialParameters(spatialParams);
+    timeKernel("Spatially Varying Analytic Kernel (interpolated)", inImage, varyingKernel, maxThreads, nIter);
+}
@@ -0,0 +1,111 @@
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Time matching a catalog of sources against a reference catalog covering the same field,
+ * using 1 to N threads
+ *
+ * Usage: timeMatchRaDec [maxThreads [nSources [nReference [decDeg]]]]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "lsst/geom.h"
+#include "lsst/afw/math/Random.h"
+#include "lsst/afw/table/Match.h"
+#include "lsst/afw/table/Simple.h"
+#include "lsst/afw/table/Source.h"
+
+namespace afwMath = lsst::afw::math;
+namespace afwTable = lsst::afw::table;
+
+const int DefNSources = 1000000;
+const int DefNReference = 10000000;
+const double DefDecDeg = 0.0;
+const double FieldRadiusDeg = 1.75;  // roughly an LSST focal plane
+const double MatchRadiusArcsec = 1.0;
+
+// Fill `cat` with `n` records scattered uniformly over a circular field centred at (0, decDeg)
+template <typename Catalog>
+void makeField(Catalog &cat, int n, double decDeg, afwMath::Random &rand) {
+    lsst::geom::SpherePoint const center(0.0 * lsst::geom::degrees, decDeg * lsst::geom::degrees);
+    cat.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        auto record = cat.addNew();
+        record->setId(i);
+        lsst::geom::Angle const bearing = rand.flat(0.0, 360.0) * lsst::geom::degrees;
+        lsst::geom::Angle const offset = std::sqrt(rand.uniform()) * FieldRadiusDeg * lsst::geom::degrees;
+        record->setCoord(center.offset(bearing, offset));
+    }
+}
+
+int main(int argc, char **argv) {
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> maxThreads;
+    }
+    int nSources = DefNSources;
+    if (argc > 2) {
+        std::istringstream(argv[2]) >> nSources;
+    }
+    int nReference = DefNReference;
+    if (argc > 3) {
+        std::istringstream(argv[3]) >> nReference;
+    }
+    double decDeg = DefDecDeg;
+    if (argc > 4) {
+        std::istringstream(argv[4]) >> decDeg;
+    }
+
+    afwMath::Random rand;
+    afwTable::SimpleCatalog reference(afwTable::SimpleTable::makeMinimalSchema());
+    afwTable::SourceCatalog sources(afwTable::SourceTable::makeMinimalSchema());
+    makeField(reference, nReference, decDeg, rand);
+    makeField(sources, nSources, decDeg, rand);
+
+    std::cout << "Matching " << nSources << " sources against " << nReference << " reference objects"
+              << " in a field at dec = " << decDeg << " deg, using up to " << maxThreads << " threads"
+              << std::endl;
+    std::cout << "* MatchSec: wall-clock time to perform one match (sec)" << std::endl;
+    std::cout << "Threads\tMatchSec\tSpeedup\tNMatches" << std::endl;
+
+    afwTable::MatchControl mc;
+    double serialSec = 0;
+    for (int nThreads = 1; nThreads <= maxThreads; nThreads *= 2) {
+        mc.nThreads = nThreads;
+        auto const startTime = std::chrono::steady_clock::now();
+        auto const matches =
+                afwTable::matchRaDec(reference, sources, MatchRadiusArcsec * lsst::geom::arcseconds, mc);
+        std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - startTime;
+        double const sec = elapsed.count();
+        if (nThreads == 1) {
+            serialSec = sec;
+        }
+        std::cout << nThreads << "\t" << sec << "\t" << serialSec / sec << "\t" << matches.size()
+                  << std::endl;
+    }
+}
@@ -152,8 +152,8 @@ def run():
     print("Destination image size:", destDim)
     print()
 
-    print("test# interp  scaleFac     skyOffset     rotAng   kernel   goodPix time/iter")
-    print('       (pix)              (RA, Dec ")    (deg)                      (sec)')
+    print("test# interp  scaleFac     skyOffset     rotAng     kernel     goodPix time/iter")
+    print('       (pix)              (RA, Dec ")    (deg)                        (sec)')
     testNum = 1
     for interpLength in (0, 1, 5, 10):
         for scaleFac in (1.2,):  # (1.0, 1.5):
@@ -165,6 +165,8 @@ def run():
                     (0.0, "lanczos2"),
                     (0.0, "lanczos3"),
                     (45.0, "lanczos3"),
+                    (0.0, "lanczos3-lut"),
+                    (45.0, "lanczos3-lut"),
                 ):
                     warpingControl = afwMath.WarpingControl(
                         kernelName,
@@ -184,7 +186,7 @@ def run():
                     destExposure.setWcs(destWcs)
                     dTime, nIter, goodPix = timeWarp(
                         destExposure, srcExposure, warpingControl)
-                    print("%4d  %5d  %8.1f  %6.1f, %6.1f  %7.1f %10s %8d %6.2f" % (
+                    print("%4d  %5d  %8.1f  %6.1f, %6.1f  %7.1f %12s %8d %6.2f" % (
                         testNum, interpLength, scaleFac, skyOffsetArcSec[0], skyOffsetArcSec[1],
                         rotAng, kernelName, goodPix, dTime/float(nIter)))
 
@@ -0,0 +1,132 @@
+// -*- LSST-C++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Time computing warping kernel values, and warping a MaskedImage, for Lanczos kernels
+ * computed directly and interpolated from a table (lanczos#-lut)
+ *
+ * Usage: timeWarpingKernel [imageSize [nIter]]
+ */
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lsst/geom.h"
+#include "lsst/afw/geom.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/math/Random.h"
+#include "lsst/afw/math/RandomImage.h"
+#include "lsst/afw/math/warpExposure.h"
+
+namespace afwGeom = lsst::afw::geom;
+namespace afwImage = lsst::afw::image;
+namespace afwMath = lsst::afw::math;
+
+typedef afwImage::MaskedImage<float> MaskedImage;
+
+const unsigned DefNIter = 3;
+const int DefImageSize = 2048;
+const int NKernelEvals = 1000000;
+
+/*
+ * Return the number of kernels computed per second by SeparableKernel::computeVectors,
+ * which is what warping does once per destination pixel
+ */
+double timeKernel(afwMath::SeparableKernel const &kernel) {
+    std::vector<afwMath::Kernel::Pixel> colList(kernel.getWidth());
+    std::vector<afwMath::Kernel::Pixel> rowList(kernel.getHeight());
+    std::vector<double> params(2);
+    double sum = 0;
+    auto const startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < NKernelEvals; ++i) {
+        params[0] = (i % 997) / 997.0;
+        params[1] = (i % 991) / 991.0;
+        kernel.setKernelParameters(params);
+        sum += kernel.computeVectors(colList, rowList, false);
+    }
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - startTime;
+    if (sum == 0) {
+        std::cout << "unexpected kernel sum" << std::endl;
+    }
+    return NKernelEvals / elapsed.count();
+}
+
+/*
+ * Return the number of destination pixels warped per second
+ */
+double timeWarp(MaskedImage &destImage, MaskedImage const &srcImage,
+                afwGeom::TransformPoint2ToPoint2 const &srcToDest, afwMath::WarpingControl const &control,
+                unsigned nIter) {
+    auto const startTime = std::chrono::steady_clock::now();
+    for (unsigned iter = 0; iter < nIter; ++iter) {
+        afwMath::warpImage(destImage, srcImage, srcToDest, control);
+    }
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - startTime;
+    return static_cast<double>(destImage.getWidth()) * destImage.getHeight() * nIter / elapsed.count();
+}
+
+int main(int argc, char **argv) {
+    int imageSize = DefImageSize;
+    if (argc > 1) {
+        std::istringstream(argv[1]) >> imageSize;
+    }
+    unsigned nIter = DefNIter;
+    if (argc > 2) {
+        std::istringstream(argv[2]) >> nIter;
+    }
+
+    MaskedImage srcImage(lsst::geom::Extent2I(imageSize, imageSize));
+    afwMath::Random rand;
+    afwMath::randomGaussianImage(srcImage.getImage().get(), rand);
+    *srcImage.getVariance() = 1.0;
+    MaskedImage destImage(lsst::geom::Extent2I(imageSize / 2, imageSize / 2));
+
+    // rotate by 30 degrees and shrink by 10%, mapping the center of the source to the center of the dest
+    lsst::geom::Extent2D const srcCtr(srcImage.getWidth() / 2.0, srcImage.getHeight() / 2.0);
+    lsst::geom::Extent2D const destCtr(destImage.getWidth() / 2.0, destImage.getHeight() / 2.0);
+    lsst::geom::LinearTransform const linear =
+            lsst::geom::LinearTransform::makeRotation(30.0 * lsst::geom::degrees) *
+            lsst::geom::LinearTransform::makeScaling(0.9);
+    auto const affine = lsst::geom::AffineTransform(destCtr) * lsst::geom::AffineTransform(linear) *
+                        lsst::geom::AffineTransform(-srcCtr);
+    auto const srcToDest = afwGeom::makeTransform(affine);
+
+    std::cout << "Timing Lanczos warping kernels; warping a " << imageSize << " x " << imageSize
+              << " MaskedImage<float> to " << imageSize / 2 << " x " << imageSize / 2 << std::endl;
+    std::cout << "* KernPerSec: kernels computed per second (millions)" << std::endl;
+    std::cout << "* PixPerSec: destination pixels warped per second, without interpolation"
+              << " of the transform (millions)" << std::endl;
+    std::cout << "Name\t\tKernPerSec\tPixPerSec" << std::endl;
+    for (std::string const name : {"lanczos3", "lanczos3-lut", "lanczos4", "lanczos4-lut", "lanczos5",
+                                   "lanczos5-lut"}) {
+        afwMath::WarpingControl control(name);
+        double const kernPerSec = timeKernel(*control.getWarpingKernel());
+        double const pixPerSec = timeWarp(destImage, srcImage, *srcToDest, control, nIter);
+        std::cout << name << "\t" << (name.size() < 8 ? "\t" : "") << kernPerSec * 1e-6 << "\t\t"
+                  << pixPerSec * 1e-6 << std::endl;
+    }
+}
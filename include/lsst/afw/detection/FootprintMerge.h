@@ -24,8 +24,10 @@
 #ifndef LSST_AFW_DETECTION_FOOTPRINTMERGE_H
 #define LSST_AFW_DETECTION_FOOTPRINTMERGE_H
 
+#include <cstdint>
 #include <vector>
 #include <map>
+#include <unordered_map>
 
 #include "lsst/afw/table/Source.h"
 
@@ -49,8 +51,8 @@ class FootprintMerge;
  *  existing FootprintMerge, the Footprint will be added to it.  If not, then a new FootprintMerge will be
  *  created and added to the vector.
  *
- *  The search algorithm uses a brute force approach over the current list.  This should be fine if we
- *  are operating on smallish number of objects, such as at the tract level.
+ *  To find the FootprintMerges a Footprint might overlap, the bounding boxes of the FootprintMerges are
+ *  indexed by a uniform grid of square cells, so only those that are nearby are tested.
  *
  */
 class FootprintMergeList final {
@@ -110,7 +112,11 @@ public:
     /**
      *  Clear entries in the current vector
      */
-    void clearCatalog() { _mergeList.clear(); }
+    void clearCatalog() {
+        _mergeList.clear();
+        _mergeBoxes.clear();
+        _mergeGrid.clear();
+    }
 
     /**
      *  Get SourceCatalog with entries that contain the final Footprint and SourceRecord for each entry
@@ -133,9 +139,22 @@ private:
 
     friend class FootprintMerge;
 
+    typedef std::unordered_map<std::uint64_t, std::vector<std::size_t>> MergeGrid;
+
     void _initialize(afw::table::Schema &sourceSchema, std::vector<std::string> const &filterList);
 
-    FootprintMergeVec _mergeList;
+    // Add _mergeList[i] to the cells of _mergeGrid its (grown) bounding box now touches
+    void _indexMerge(std::size_t i);
+
+    // Return the indices in _mergeList of the FootprintMerges that might touch bbox, in increasing order
+    std::vector<std::size_t> _findMergeCandidates(lsst::geom::Box2I const &bbox) const;
+
+    // Remove the FootprintMerges that have been merged into others from _mergeList, and rebuild the grid
+    void _compactMergeList();
+
+    FootprintMergeVec _mergeList;  // entries are reset when merged into another, until _compactMergeList
+    std::vector<lsst::geom::Box2I> _mergeBoxes;  // the (grown) box each FootprintMerge is indexed with
+    MergeGrid _mergeGrid;                        // the indices in _mergeList touching each cell of the grid
     FilterMap _filterMap;
     afw::table::SchemaMapper _peakSchemaMapper;
     std::shared_ptr<PeakTable> _peakTable;
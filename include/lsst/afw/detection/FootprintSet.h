@@ -58,24 +58,35 @@ public:
     /**
      * Find a FootprintSet given an Image and a threshold
      *
+     * The Footprints are ordered by their first pixel, in row-major order (by y, then x).
+     *
      * @param img Image to search for objects
      * @param threshold threshold to find objects
      * @param npixMin minimum number of pixels in an object
      * @param setPeaks should I set the Peaks list?
+     * @param nThreads number of threads to use; 0 for one per hardware core
+     *
+     * @throws lsst::pex::exceptions::InvalidParameterError if nThreads < 0
      */
     template <typename ImagePixelT>
     FootprintSet(image::Image<ImagePixelT> const& img, Threshold const& threshold, int const npixMin = 1,
-                 bool const setPeaks = true);
+                 bool const setPeaks = true, int const nThreads = 1);
 
     /**
      * Find a FootprintSet given a Mask and a threshold
      *
+     * The Footprints are ordered by their first pixel, in row-major order (by y, then x).
+     *
      * @param img Image to search for objects
      * @param threshold threshold to find objects
      * @param npixMin minimum number of pixels in an object
+     * @param nThreads number of threads to use; 0 for one per hardware core
+     *
+     * @throws lsst::pex::exceptions::InvalidParameterError if nThreads < 0
      */
     template <typename MaskPixelT>
-    FootprintSet(image::Mask<MaskPixelT> const& img, Threshold const& threshold, int const npixMin = 1);
+    FootprintSet(image::Mask<MaskPixelT> const& img, Threshold const& threshold, int const npixMin = 1,
+                 int const nThreads = 1);
 
     /**
      * Find a FootprintSet given a MaskedImage and a threshold
@@ -89,15 +100,27 @@ public:
      * are processed (Threshold will probably have to be below the background level
      * for this to make sense, e.g. for difference imaging)
      *
+     * The Footprints are ordered by their first pixel, in row-major order (by y, then x).
+     * Previously, a Footprint assembled from parts that only joined further down the image
+     * could come out of order, so the order (and hence source IDs) may differ from older versions.
+     *
+     * If nThreads != 1, large images are split into horizontal strips that are searched on separate
+     * threads, and the peaks in the Footprints are found in parallel too.  The result does not
+     * depend on the number of threads.
+     *
      * @param img MaskedImage to search for objects
      * @param threshold threshold for footprints (controls size)
      * @param planeName mask plane to set (if != "")
      * @param npixMin minimum number of pixels in an object
      * @param setPeaks should I set the Peaks list?
+     * @param nThreads number of threads to use; 0 for one per hardware core
+     *
+     * @throws lsst::pex::exceptions::InvalidParameterError if nThreads < 0
      */
     template <typename ImagePixelT, typename MaskPixelT>
     FootprintSet(image::MaskedImage<ImagePixelT, MaskPixelT> const& img, Threshold const& threshold,
-                 std::string const& planeName = "", int const npixMin = 1, bool const setPeaks = true);
+                 std::string const& planeName = "", int const npixMin = 1, bool const setPeaks = true,
+                 int const nThreads = 1);
 
     /**
      * Construct an empty FootprintSet given a region that its footprints would have lived in
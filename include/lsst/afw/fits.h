@@ -586,6 +586,9 @@ public:
     /// Write a string to a binary table.
     void writeTableScalar(std::size_t row, int col, std::string const& value);
 
+    /// Write strings to `nRows` consecutive rows of a fixed-length string column, starting at `row`.
+    void writeTableStrings(std::size_t row, int col, std::size_t nRows, std::string const* values);
+
     /// Read an array value from a binary table.
     template <typename T>
     void readTableArray(std::size_t row, int col, int nElements, T* value);
@@ -599,12 +602,18 @@ public:
     /// Read a string from a binary table.
     void readTableScalar(std::size_t row, int col, std::string& value, bool isVariableLength);
 
+    /// Read strings from `nRows` consecutive rows of a fixed-length string column, starting at `row`.
+    void readTableStrings(std::size_t row, int col, std::size_t nRows, std::string* values);
+
     /// Return the size of an array column.
     long getTableArraySize(int col);
 
     /// Return the size of an variable-length array field.
     long getTableArraySize(std::size_t row, int col);
 
+    /// Return the offset in bytes of the current HDU's data unit from the start of the file.
+    std::size_t getDataOffset();
+
     /// Default constructor; set all data members to 0.
     Fits() : fptr(0), status(0), behavior(0) {}
 
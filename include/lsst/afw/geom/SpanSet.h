@@ -183,6 +183,8 @@ public:
      * without going over a pixel not contained in the SpanSet this method will return
      * true. If the SpanSet is disjoint aka the above is not true and there is more
      * than one region, returns false.
+     *
+     * The Spans are only examined until a second region is found.
      */
     bool isContiguous() const;
 
@@ -741,10 +743,17 @@ private:
 
     /* Label Spans according to contiguous group. If the SpanSet is contiguous, all Spans will be labeled 1.
      * If there is more than one group each group will receive a label one higher than the previous.
+     * The labels are written to labels, whose storage is reused, and the number of groups is returned.
+     * If stopIfDisjoint is true, 2 is returned (and labels is meaningless) as soon as a second group
+     * is found.
+     */
+    std::size_t _makeLabels(std::vector<std::size_t> &labels, bool stopIfDisjoint = false) const;
+
+    /* Dilate or erode the SpanSet by a structuring element given as its Spans, one row at a time.
+     * The SpanSet and the structuring element must both be non-empty.
      */
-    void _label(geom::Span const &spn, std::vector<std::size_t> &labelVector, std::size_t currentLabel,
-                std::unordered_map<int, std::vector<std::pair<std::size_t, const Span *>>> &sortVector) const;
-    std::pair<std::vector<std::size_t>, std::size_t> _makeLabels() const;
+    std::shared_ptr<SpanSet> _dilated(std::vector<Span> const &stencil) const;
+    std::shared_ptr<SpanSet> _eroded(std::vector<Span> const &stencil) const;
 
     std::shared_ptr<SpanSet> makeShift(int x, int y) const;
 
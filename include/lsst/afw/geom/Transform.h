@@ -153,6 +153,36 @@ public:
      */
     ToArray applyForward(FromArray const &array) const;
 
+    /**
+     * Transform a regular grid of points in the forward direction, writing the results into
+     * preallocated arrays
+     *
+     * This is much faster than applyForward(FromArray const &) for large numbers of points,
+     * such as every pixel of an image, because the points are not converted to and from
+     * FromPoint and ToPoint and no memory is allocated (beyond what AST itself uses).
+     *
+     * The grid has `count[i]` points along "from" axis `i`, at `start[i] + j * step[i]`
+     * for `j = 0, 1, ..., count[i] - 1`; the first axis varies fastest. Thus for a 2-axis
+     * "from" endpoint grid point `(j0, j1)` has index `j0 + j1 * count[0]`.
+     * Values are the raw axis values used by the contained mapping, e.g. radians for
+     * SpherePointEndpoint.
+     *
+     * @param[in] start  first grid point; one value per "from" axis
+     * @param[in] step  spacing of grid points; one value per "from" axis
+     * @param[in] count  number of grid points; one value per "from" axis
+     * @param[out] from  array of shape (number of "from" axes, number of grid points);
+     *                   scratch space that is set to the grid points
+     * @param[out] to  array of shape (number of "to" axes, number of grid points)
+     *                 that is set to the transformed points, e.g. x in `to[0]` and y in `to[1]`
+     *
+     * @throws lsst::pex::exceptions::InvalidParameterError if `start`, `step` or `count`
+     *         does not have one value per "from" axis, if any count is negative,
+     *         or if `from` or `to` has the wrong shape.
+     */
+    void applyForwardGrid(std::vector<double> const &start, std::vector<double> const &step,
+                          std::vector<int> const &count, ndarray::Array<double, 2, 2> const &from,
+                          ndarray::Array<double, 2, 2> const &to) const;
+
     /**
      * Transform one point in the inverse direction ("to" to "from")
      */
@@ -167,6 +197,17 @@ public:
      */
     FromArray applyInverse(ToArray const &array) const;
 
+    /**
+     * Transform a regular grid of points in the inverse direction, writing the results into
+     * preallocated arrays
+     *
+     * This is the inverse counterpart of applyForwardGrid: the grid is defined on the "to" axes
+     * and the results are written in terms of the "from" axes.
+     */
+    void applyInverseGrid(std::vector<double> const &start, std::vector<double> const &step,
+                          std::vector<int> const &count, ndarray::Array<double, 2, 2> const &to,
+                          ndarray::Array<double, 2, 2> const &from) const;
+
     /**
      * The inverse of this Transform.
      *
@@ -429,6 +429,10 @@ private:
  * BackgroundControl contains a public StatisticsControl member to allow user control of how the backgrounds
  * are computed.
  *
+ * The interpolation of the grid is cached, so calling getImage() again with the same styles (e.g. for
+ * another bounding box) only has to evaluate the interpolants.  The cache is rebuilt if the values in
+ * the statsImage change.
+ *
  *     math::BackgroundControl bctrl(7, 7);  // number of sub-image squares in {x,y}-dimensions
  *     bctrl.sctrl.setNumSigmaClip(5.0);     // use 5-sigma clipping for the sub-image means
  *     std::shared_ptr<math::Background> backobj = math::makeBackground(img, bctrl);
@@ -529,9 +533,23 @@ private:
     lsst::afw::image::MaskedImage<InternalPixelT>
             _statsImage;  // statistical properties for the grid of subimages
     mutable std::vector<std::vector<double>> _gridColumns;  // interpolated columns for the bicubic spline
+    // The interpolants along each row of the image, built from _gridColumns as they're needed and
+    // reused by later calls to getImage with the same styles (and statsImage values)
+    mutable std::vector<std::shared_ptr<Interpolate>> _rowInterpolates;
+    mutable Interpolate::Style _cachedInterpStyle;       // the style _rowInterpolates are for
+    mutable UndersampleStyle _cachedUndersampleStyle;    // the undersampleStyle _rowInterpolates are for
+    mutable std::vector<InternalPixelT> _cachedStatsValues;  // _statsImage's values when they were built
 
     void _setGridColumns(Interpolate::Style const interpStyle, UndersampleStyle const undersampleStyle,
-                         int const iX, std::vector<int> const& ypix) const;
+                         int const iX) const;
+    /*
+     * Make sure that _gridColumns are set, and that _rowInterpolates is ready for them, for the given
+     * styles, reusing the ones from the previous call if nothing has changed
+     */
+    void _setInterpolation(Interpolate::Style const interpStyle,
+                           UndersampleStyle const undersampleStyle) const;
+    // Return the interpolant along row iY of the image, building it if needed
+    Interpolate const& _getRowInterpolate(int const iY) const;
 
 #if defined(LSST_makeBackground_getImage)
     BOOST_PP_SEQ_FOR_EACH(LSST_makeBackground_getImage, override, LSST_makeBackground_getImage_types);
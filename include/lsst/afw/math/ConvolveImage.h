@@ -49,25 +49,54 @@ namespace math {
  */
 class ConvolutionControl {
 public:
+    /**
+     * How to convolve with a spatially invariant kernel
+     *
+     * Spatially varying kernels, and output images with integer pixels, are always convolved directly.
+     */
+    enum Algorithm {
+        AUTO = 0,  ///< pick DIRECT or FFT, whichever a simple cost model predicts is faster
+        DIRECT,    ///< sum the products of kernel and image pixels at each output pixel
+        FFT        ///< multiply Fourier transforms of blocks of the image by that of the kernel
+    };
+
     ConvolutionControl(bool doNormalize = true,  ///< normalize the kernel to sum=1?
                        bool doCopyEdge = false,  ///< copy edge pixels from source image
                        ///< instead of setting them to the standard edge pixel?
-                       int maxInterpolationDistance = 10  ///< maximum width or height of a region
+                       int maxInterpolationDistance = 10,  ///< maximum width or height of a region
                        ///< over which to use linear interpolation interpolate
+                       int nThreads = 1,   ///< number of threads to use; 0 for one per hardware core
+                       int tileSize = 256,  ///< maximum width or height of a tile of output pixels
+                       ///< handed to one thread (but see convolve)
+                       Algorithm algorithm = AUTO,  ///< how to convolve with a spatially invariant kernel
+                       bool doBasisConvolution = false  ///< convolve with each basis kernel of a spatially
+                       ///< varying LinearCombinationKernel and combine the results?
                        )
             : _doNormalize(doNormalize),
               _doCopyEdge(doCopyEdge),
-              _maxInterpolationDistance(maxInterpolationDistance) {}
+              _maxInterpolationDistance(maxInterpolationDistance),
+              _nThreads(nThreads),
+              _tileSize(tileSize),
+              _algorithm(algorithm),
+              _doBasisConvolution(doBasisConvolution) {}
 
     bool getDoNormalize() const { return _doNormalize; }
     bool getDoCopyEdge() const { return _doCopyEdge; }
     int getMaxInterpolationDistance() const { return _maxInterpolationDistance; };
+    int getNThreads() const { return _nThreads; }
+    int getTileSize() const { return _tileSize; }
+    Algorithm getAlgorithm() const { return _algorithm; }
+    bool getDoBasisConvolution() const { return _doBasisConvolution; }
 
     void setDoNormalize(bool doNormalize) { _doNormalize = doNormalize; }
     void setDoCopyEdge(bool doCopyEdge) { _doCopyEdge = doCopyEdge; }
     void setMaxInterpolationDistance(int maxInterpolationDistance) {
         _maxInterpolationDistance = maxInterpolationDistance;
     }
+    void setNThreads(int nThreads) { _nThreads = nThreads; }
+    void setTileSize(int tileSize) { _tileSize = tileSize; }
+    void setAlgorithm(Algorithm algorithm) { _algorithm = algorithm; }
+    void setDoBasisConvolution(bool doBasisConvolution) { _doBasisConvolution = doBasisConvolution; }
 
 private:
     bool _doNormalize;              ///< normalize the kernel to sum=1?
@@ -75,6 +104,12 @@ private:
                                     ///< instead of setting them to the standard edge pixel?
     int _maxInterpolationDistance;  ///< maximum width or height of a region
                                     ///< over which to attempt interpolation
+    int _nThreads;                  ///< number of threads to use; 0 for one per hardware core
+    int _tileSize;                  ///< maximum width or height of a tile of output pixels
+                                    ///< handed to one thread (but see convolve)
+    Algorithm _algorithm;           ///< how to convolve with a spatially invariant kernel
+    bool _doBasisConvolution;       ///< convolve with each basis kernel of a spatially varying
+                                    ///< LinearCombinationKernel and combine the results?
 };
 
 /**
@@ -131,9 +166,13 @@ inline typename OutImageT::SinglePixel convolveAtAPoint(
  * to the lower left corner of the sub-image, but it will almost certainly change to be
  * the lower left corner of the parent image.
  *
- * All convolution is performed in real space. This allows convolution to handle masked pixels
- * and spatially varying kernels. Although convolution of an Image with a spatially invariant kernel could,
- * in fact, be performed in Fourier space, the code does not do this.
+ * Convolution is performed in real space, except that an %image with floating-point pixels may be
+ * convolved with a spatially invariant kernel in Fourier space (see below). FFT convolution is used
+ * if ConvolutionControl's algorithm is FFT, or if it is AUTO (the default) and the cost model predicts
+ * it to be faster, which is typically the case for kernels of about 11 x 11 pixels or larger.
+ * For a MaskedImage the mask plane is always smeared in real space; the image plane and the variance
+ * plane (with the square of the kernel) are convolved in Fourier space. Spatially varying kernels
+ * and images with integer pixels are always convolved in real space.
  *
  * Note that mask bits are smeared by convolution; all nonzero pixels in the kernel smear the mask, even
  * pixels that have very small values. Larger kernels smear the mask more and are also slower to convolve.
@@ -160,22 +199,43 @@ inline typename OutImageT::SinglePixel convolveAtAPoint(
  *   convolution with a kernel of size nCols x 1, followed by convolution with a kernel of size 1 x nRows.
  * - Convolution with spatially invariant versions of the other kernels is performed by computing
  *   the kernel %image once and convolving with that. The code has been optimized for cache performance
- *   and so should be fairly efficient.
- * - Convolution with a spatially varying LinearCombinationKernel is performed by convolving the %image
- *   by each basis kernel and combining the result by solving the spatial model. This will be efficient
- *   provided the kernel does not contain too many or very large basis kernels.
+ *   and so should be fairly efficient. For large kernels the kernel %image is instead applied
+ *   using FFTs, by overlap-add: the input is cut into blocks, each block is zero-padded and multiplied
+ *   in Fourier space by the transformed kernel, and the overlapping results are summed.
+ *   ConvolutionControl's algorithm selects this explicitly; by default (AUTO) a cost model
+ *   based on the image and kernel sizes picks whichever should be faster. The FFT results agree with
+ *   the direct results to within floating-point roundoff, non-finite input pixels are handled exactly
+ *   as they are by direct convolution, and only images with floating-point pixels are supported.
+ * - Convolution with a spatially varying LinearCombinationKernel is performed by computing the kernel
+ *   %image at the corners of regions of at most maxInterpolationDistance pixels on a side and linearly
+ *   interpolating between them, or (if maxInterpolationDistance < 2) by computing the kernel %image
+ *   at every pixel. Alternatively, if ConvolutionControl's doBasisConvolution is set, the %image is
+ *   convolved once by each basis kernel (using the fastest method for that kernel) and the results
+ *   are combined at each pixel using the spatial model. This is exact (no interpolation) and efficient
+ *   for kernels with a modest number of basis kernels, such as Alard-Lupton kernels. For a MaskedImage
+ *   the variance plane must also be convolved with the product of each pair of basis kernels that
+ *   overlap, and mask bits are smeared by every basis kernel whose coefficient is nonzero at a pixel
+ *   (this differs from the other methods only where basis kernels exactly cancel).
  * - Convolution with spatially varying AnalyticKernel is likely to be slow. The code simply computes
  *   the output one pixel at a time by computing the AnalyticKernel at that point and applying it to
  *   the input %image. This is not favorable for cache performance (especially for large kernels)
  *   but avoids recomputing the AnalyticKernel. It is probably possible to do better.
  *
+ * Convolution may be split across several threads by setting ConvolutionControl's nThreads.
+ * The good region of the output is then divided into tiles of at most tileSize x tileSize pixels
+ * (the height is rounded down to a multiple of the kernel height, but is at least the kernel height),
+ * each of which is convolved independently; spatially varying kernels that are convolved using
+ * interpolation are instead split by interpolation region, so that the regions are unchanged.
+ * Either way every output pixel is computed exactly as it is by a single thread.
+ *
  * Additional convolution functions include:
  *  - convolveAtAPoint(): convolve a Kernel to an Image or MaskedImage at a point.
  *  - basicConvolve(): convolve a Kernel with an Image or MaskedImage, but do not set the edge pixels
  *    of the output. Optimization of convolution for different types of Kernel are handled by different
  *    specializations of basicConvolve().
  *
- * afw/examples offers programs that time convolution including timeConvolve and timeSpatiallyVaryingConvolve.
+ * afw/examples offers programs that time convolution including timeConvolve, timeConvolveFft
+ * and timeSpatiallyVaryingConvolve.
  *
  * @param[out] convolvedImage convolved %image; must be the same size as inImage
  * @param[in] inImage %image to convolve
@@ -59,6 +59,19 @@ public:
     virtual double interpolate(double const x) const = 0;
     std::vector<double> interpolate(std::vector<double> const &x) const;
     ndarray::Array<double, 1> interpolate(ndarray::Array<double const, 1> const &x) const;
+    /**
+     * Interpolate to the n equally spaced points x0, x0 + 1, ..., x0 + n - 1
+     *
+     * Equivalent to setting out[i] = interpolate(x0 + i), but subclasses may do it more efficiently;
+     * the spline styles evaluate each interval's polynomial in a loop over the points in it that the
+     * compiler can vectorize, which matches interpolate() only to within rounding. The CONSTANT and
+     * LINEAR styles give identical values.
+     *
+     * @param x0 The first point
+     * @param n The number of points
+     * @param out Where to put the n interpolated values
+     */
+    virtual void interpolateRange(double const x0, int const n, double *out) const;
 
 protected:
     /**
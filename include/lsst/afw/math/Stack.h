@@ -27,9 +27,12 @@
 /*
  * Functions to stack images
  */
+#include <functional>
 #include <vector>
+#include "lsst/geom/Box.h"
 #include "lsst/afw/image/Image.h"
 #include "lsst/afw/image/Mask.h"
+#include "lsst/afw/image/MaskedImageFitsReader.h"
 #include "lsst/afw/math/Statistics.h"
 
 namespace lsst {
@@ -40,6 +43,9 @@ namespace math {
  *
  * z stacks
  *
+ * Image and MaskedImage stacks are computed in blocks of output rows that are shared
+ * among StatisticsControl::getNThreads() threads; the result does not depend on the number of threads.
+ *
  * ******************************************************************* */
 
 /**
@@ -166,6 +172,76 @@ std::vector<PixelT> statisticsStack(
                 std::vector<lsst::afw::image::VariancePixel>(0)  ///< vector containing weights
 );
 
+/* ****************************************************************** *
+ *
+ * streaming z stacks
+ *
+ * MaskedImages that are too large to hold in memory all at once are read from FITS a strip of rows
+ * at a time, so only stripHeight rows of each input are in memory at any one time.
+ *
+ * ******************************************************************* */
+
+/**
+ * Compute some statistics of a stack of MaskedImages read from FITS, one strip of rows at a time
+ *
+ * For each strip of `bbox` the matching sub-image is read from every input and stacked exactly as
+ * the in-memory statisticsStack would stack it; the result is passed to `sink` before the next strip
+ * is read, so that it may be written out incrementally.
+ *
+ * @param[in] readers      Readers for the MaskedImages to process.
+ * @param[in] bbox         Region to stack, in PARENT coordinates; must be contained in every input.
+ * @param[in] flags        Statistics requested.
+ * @param[in] sctrl        Control structure.
+ * @param[in] wvector      Vector of weights.
+ * @param[in] clipped      Mask to set for pixels that were clipped (NOT rejected
+ *                         due to masks).
+ * @param[in] maskMap      Vector of pairs of mask pixel values; any pixel
+ *                         on an input with any of the bits in .first will result
+ *                         in all of the bits in .second being set on the
+ *                         corresponding pixel on the output.
+ * @param[in] stripHeight  Number of rows to read from each input at a time.
+ * @param[in] sink         Called with each stacked strip, in order of increasing y.  The strip's xy0
+ *                         is its position in PARENT coordinates; its pixels are only valid until
+ *                         the call returns.
+ *
+ * @throws lsst::pex::exceptions::InvalidParameterError if stripHeight < 1 or `bbox` is not contained
+ *         in every input.
+ */
+template <typename PixelT>
+void streamStatisticsStack(
+        std::vector<std::shared_ptr<lsst::afw::image::MaskedImageFitsReader>> const& readers,
+        lsst::geom::Box2I const& bbox, Property flags, StatisticsControl const& sctrl,
+        std::vector<lsst::afw::image::VariancePixel> const& wvector, image::MaskPixel clipped,
+        std::vector<std::pair<image::MaskPixel, image::MaskPixel>> const& maskMap, int stripHeight,
+        std::function<void(lsst::afw::image::MaskedImage<PixelT> const&)> const& sink);
+
+/**
+ * Compute some statistics of a stack of MaskedImages read from FITS, one strip of rows at a time
+ *
+ * As the version taking a `sink`, but each strip is stacked directly into the corresponding rows
+ * of `out`, whose bounding box defines the region to stack.
+ *
+ * @param[out] out         Output MaskedImage.
+ * @param[in] readers      Readers for the MaskedImages to process.
+ * @param[in] flags        Statistics requested.
+ * @param[in] sctrl        Control structure.
+ * @param[in] wvector      Vector of weights.
+ * @param[in] clipped      Mask to set for pixels that were clipped (NOT rejected
+ *                         due to masks).
+ * @param[in] maskMap      Vector of pairs of mask pixel values, as for statisticsStack.
+ * @param[in] stripHeight  Number of rows to read from each input at a time.
+ *
+ * @throws lsst::pex::exceptions::InvalidParameterError if stripHeight < 1 or the bounding box
+ *         of `out` is not contained in every input.
+ */
+template <typename PixelT>
+void streamStatisticsStack(
+        lsst::afw::image::MaskedImage<PixelT>& out,
+        std::vector<std::shared_ptr<lsst::afw::image::MaskedImageFitsReader>> const& readers,
+        Property flags, StatisticsControl const& sctrl,
+        std::vector<lsst::afw::image::VariancePixel> const& wvector, image::MaskPixel clipped,
+        std::vector<std::pair<image::MaskPixel, image::MaskPixel>> const& maskMap, int stripHeight = 256);
+
 /* ****************************************************************** *
  *
  * x,y stacks
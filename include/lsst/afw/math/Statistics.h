@@ -40,6 +40,7 @@
 #include "boost/iterator/iterator_adaptor.hpp"
 #include "boost/tuple/tuple.hpp"
 #include <memory>
+#include <vector>
 #include "lsst/afw/image/MaskedImage.h"
 #include "lsst/afw/math/MaskedVector.h"
 
@@ -109,7 +110,8 @@ public:
               _isNanSafe(isNanSafe),
               _useWeights(useWeights),
               _calcErrorFromInputVariance(false),
-              _maskPropagationThresholds() {
+              _maskPropagationThresholds(),
+              _nThreads(1) {
         try {
             _noGoodPixelsMask = lsst::afw::image::Mask<>::getPlaneBitMask("NO_DATA");
         } catch (lsst::pex::exceptions::InvalidParameterError) {
@@ -138,6 +140,8 @@ public:
     bool getWeighted() const noexcept { return _useWeights == WEIGHTS_TRUE ? true : false; }
     bool getWeightedIsSet() const noexcept { return _useWeights != WEIGHTS_NONE ? true : false; }
     bool getCalcErrorFromInputVariance() const noexcept { return _calcErrorFromInputVariance; }
+    /// Number of threads used by statisticsStack; 0 for one per hardware core
+    int getNThreads() const noexcept { return _nThreads; }
 
     void setNumSigmaClip(double numSigmaClip) {
         assert(numSigmaClip > 0);
@@ -154,9 +158,11 @@ public:
     void setCalcErrorFromInputVariance(bool calcErrorFromInputVariance) noexcept {
         _calcErrorFromInputVariance = calcErrorFromInputVariance;
     }
+    void setNThreads(int nThreads) noexcept { _nThreads = nThreads; }
 
 private:
     friend class Statistics;
+    friend bool canMakeGridStatistics(int const, StatisticsControl const &);
 
     double _numSigmaClip;              // Number of standard deviations to clip at
     int _numIter;                      // Number of iterations
@@ -167,6 +173,8 @@ private:
     bool _calcErrorFromInputVariance;  // Calculate errors from the input variances, if available
     std::vector<double> _maskPropagationThresholds;  // Thresholds for when to propagate mask bits,
                                                      // treated like a dict (unset bits are set to 1.0)
+    int _nThreads;  // Number of threads for statisticsStack, makeGridStatistics and BackgroundMI;
+                    // 0 for one per core
 };
 
 /**
@@ -283,6 +291,28 @@ public:
     lsst::afw::image::MaskPixel getOrMask() const noexcept { return _allPixelOrMask; }
 
 private:
+    friend std::vector<Statistics> makeGridStatistics(lsst::afw::image::Image<float> const &,
+                                                      std::vector<int> const &, std::vector<int> const &,
+                                                      std::vector<int> const &, std::vector<int> const &,
+                                                      int const, StatisticsControl const &);
+    friend std::vector<Statistics> makeGridStatistics(lsst::afw::image::MaskedImage<float> const &,
+                                                      std::vector<int> const &, std::vector<int> const &,
+                                                      std::vector<int> const &, std::vector<int> const &,
+                                                      int const, StatisticsControl const &);
+
+    /**
+     * Construct from standard statistics that have already been computed (by makeGridStatistics)
+     *
+     * @param flags Describe what was calculated; no property may need more than one pass
+     * @param sctrl Control how things were calculated
+     * @param num Number of pixels, good or bad
+     * @param n Number of good pixels
+     * @param sum, mean, variance, min, max, allPixelOrMask The standard statistics of the good pixels
+     */
+    Statistics(int const flags, StatisticsControl const &sctrl, int const num, int const n, double const sum,
+               Value const &mean, Value const &variance, double const min, double const max,
+               lsst::afw::image::MaskPixel const allPixelOrMask);
+
     long _flags;  // The desired calculation
 
     int _n;                                       // number of pixels in the image
@@ -531,6 +561,69 @@ Statistics makeStatistics(lsst::afw::math::MaskedVector<EntryT> const &mv,  ///<
         return Statistics(*mv.getImage(), *mv.getMask(), var, weights, flags, sctrl);
     }
 }
+
+/**
+ * Compute statistics of each cell of a grid on an image, in a single pass over the pixels
+ *
+ * The grid's cells are the boxes with corner (xOrigins[iX], yOrigins[iY]) and dimensions
+ * (xSizes[iX], ySizes[iY]), in the image's LOCAL coordinates.  The result for a cell is the same as
+ * calling makeStatistics on the corresponding subimage, but the image is read a row at a time
+ * rather than a cell at a time, and rows of cells are processed in parallel using up to
+ * sctrl.getNThreads() threads.
+ *
+ * Only statistics that can be computed in a single pass are supported, so MEDIAN, IQRANGE, MEANCLIP,
+ * STDEVCLIP and VARIANCECLIP may not be requested, and sctrl must be NaN-safe, unweighted, and use
+ * neither the input variance nor mask propagation thresholds.
+ *
+ * @param img Image whose cells' properties we want
+ * @param xOrigins, xSizes The starting columns and widths of the columns of cells
+ * @param yOrigins, ySizes The starting rows and heights of the rows of cells
+ * @param flags Describe what we want to calculate
+ * @param sctrl Control how things are calculated
+ * @returns the statistics of cell (iX, iY) at index `iY*xOrigins.size() + iX`
+ *
+ * @throws lsst::pex::exceptions::InvalidParameterError if flags or sctrl are not supported, or if
+ *         xOrigins and xSizes (or yOrigins and ySizes) have different lengths
+ * @throws lsst::pex::exceptions::LengthError if a cell is empty or extends outside the image
+ *
+ * @relatesalso Statistics
+ */
+std::vector<Statistics> makeGridStatistics(lsst::afw::image::Image<float> const &img,
+                                           std::vector<int> const &xOrigins, std::vector<int> const &xSizes,
+                                           std::vector<int> const &yOrigins, std::vector<int> const &ySizes,
+                                           int const flags,
+                                           StatisticsControl const &sctrl = StatisticsControl());
+
+/**
+ * Compute statistics of each cell of a grid on a MaskedImage, in a single pass over the pixels
+ *
+ * As for the Image overload, except that pixels with any of the mask bits in sctrl.getAndMask() set
+ * are ignored.  The variance plane is not used.
+ *
+ * @param mimg MaskedImage whose cells' properties we want
+ * @param xOrigins, xSizes The starting columns and widths of the columns of cells
+ * @param yOrigins, ySizes The starting rows and heights of the rows of cells
+ * @param flags Describe what we want to calculate
+ * @param sctrl Control how things are calculated
+ * @returns the statistics of cell (iX, iY) at index `iY*xOrigins.size() + iX`
+ *
+ * @relatesalso Statistics
+ */
+std::vector<Statistics> makeGridStatistics(lsst::afw::image::MaskedImage<float> const &mimg,
+                                           std::vector<int> const &xOrigins, std::vector<int> const &xSizes,
+                                           std::vector<int> const &yOrigins, std::vector<int> const &ySizes,
+                                           int const flags,
+                                           StatisticsControl const &sctrl = StatisticsControl());
+
+/**
+ * Return true if makeGridStatistics supports the given flags and control
+ *
+ * @param flags Describe what we want to calculate
+ * @param sctrl Control how things are calculated
+ *
+ * @relatesalso Statistics
+ */
+bool canMakeGridStatistics(int const flags, StatisticsControl const &sctrl);
 }  // namespace math
 }  // namespace afw
 }  // namespace lsst
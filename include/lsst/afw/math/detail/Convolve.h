@@ -85,9 +85,10 @@ void basicConvolve(OutImageT& convolvedImage, InImageT const& inImage,
  * A version of basicConvolve that should be used when convolving a LinearCombinationKernel
  *
  * The Algorithm:
- * - If the kernel is spatially varying and contains only DeltaFunctionKernels
+ * - If the kernel is spatially varying and convolutionControl.getDoBasisConvolution() is true
  *   then convolves the input Image by each basis kernel in turn, solves the spatial model
- *   for that component and adds in the appropriate amount of the convolved %image.
+ *   for that component and adds in the appropriate amount of the convolved %image
+ *   (see convolveWithBasis).
  * - In all other cases uses normal convolution
  *
  * @param[out] convolvedImage convolved %image
@@ -124,6 +125,9 @@ void basicConvolve(OutImageT& convolvedImage, InImageT const& inImage,
  * Convolve an Image or MaskedImage with a Kernel by computing the kernel image
  * at every point. (If the kernel is not spatially varying then only compute it once).
  *
+ * Spatially invariant kernels are applied using convolveWithFft when the convolution control
+ * (or, for the AUTO algorithm, its cost model) calls for it.
+ *
  * convolvedImage must be the same size as inImage.
  * convolvedImage has a border in which the output pixels are not set. This border has size:
  * - kernel.getCtrX() along the left edge
@@ -148,6 +152,84 @@ void convolveWithBruteForce(OutImageT& convolvedImage, InImageT const& inImage,
                             lsst::afw::math::Kernel const& kernel,
                             lsst::afw::math::ConvolutionControl const& convolutionControl);
 
+/**
+ * Convolve an Image or MaskedImage with a spatially varying LinearCombinationKernel
+ * by convolving with each basis kernel and combining the results
+ *
+ * The input is convolved once with each basis kernel, using whichever method basicConvolve picks for it
+ * (so delta function, separable and large basis kernels are all handled efficiently), and the results
+ * are summed at each pixel weighted by the basis kernel coefficients given by the spatial model.
+ * There is no interpolation, so apart from roundoff the %image and variance planes match brute force
+ * convolution. The variance plane is convolved with the square of the kernel; this requires one extra
+ * convolution of the variance plane for each pair of basis kernels whose nonzero pixels overlap.
+ * Mask bits are smeared by each basis kernel whose coefficient is nonzero at the output pixel.
+ *
+ * @param[out] convolvedImage convolved %image
+ * @param[in] inImage %image to convolve
+ * @param[in] kernel convolution kernel; must be spatially varying
+ * @param[in] convolutionControl convolution control parameters
+ *
+ * @throws std::bad_alloc when allocation of CPU memory fails
+ *
+ * @warning Low-level convolution function that does not set edge pixels
+ * and does not check the image or kernel dimensions.
+ */
+template <typename OutImageT, typename InImageT>
+void convolveWithBasis(OutImageT& convolvedImage, InImageT const& inImage,
+                       lsst::afw::math::LinearCombinationKernel const& kernel,
+                       lsst::afw::math::ConvolutionControl const& convolutionControl);
+
+/**
+ * Convolve an Image or MaskedImage with a spatially invariant kernel using FFTs, if appropriate
+ *
+ * FFTs are used if the convolution control's algorithm is FFT, or if it is AUTO and a cost model
+ * predicts that FFTs will be faster than direct convolution, provided the kernel is spatially invariant
+ * and the output pixels are floating point. The image is convolved by overlap-add: it is cut into blocks
+ * that are zero-padded to a size that suits the kernel, and each block is multiplied in Fourier space
+ * by the transform of the kernel %image. The variance plane of a MaskedImage is convolved
+ * with the square of the kernel and the mask plane is the OR of the mask pixels under nonzero
+ * kernel pixels, as for direct convolution.
+ *
+ * Output pixels that depend on non-finite input pixels are recomputed directly, so they are
+ * exactly what direct convolution produces; the rest match direct convolution to within roundoff.
+ *
+ * @param[out] convolvedImage convolved %image
+ * @param[in] inImage %image to convolve
+ * @param[in] kernel convolution kernel
+ * @param[in] convolutionControl convolution control parameters
+ * @returns true if the image was convolved, false if the caller should convolve it directly
+ *
+ * @throws std::bad_alloc when allocation of CPU memory fails
+ *
+ * @warning Low-level convolution function that does not set edge pixels
+ * and does not check the image or kernel dimensions.
+ */
+template <typename OutImageT, typename InImageT>
+bool convolveWithFft(OutImageT& convolvedImage, InImageT const& inImage,
+                     lsst::afw::math::Kernel const& kernel,
+                     lsst::afw::math::ConvolutionControl const& convolutionControl);
+
+/**
+ * Add a scaled row of pixels to another row of pixels: outRow[i] += OutPixelT(inRow[i] * scale)
+ *
+ * This is the inner loop of convolution with a separable kernel, which is applied once per nonzero
+ * kernel value. Each product is computed in double precision and rounded to OutPixelT before it is
+ * added, exactly as the generic convolution code does, so the results are identical.
+ *
+ * On x86-64 the loop is explicitly vectorized using AVX-512 or AVX2 instructions,
+ * whichever is the best the CPU supports (as determined at run time); otherwise a scalar loop is used.
+ * Only float and double pixels are supported.
+ *
+ * @param[in,out] outRow pointer to first pixel of output row
+ * @param[in] inRow pointer to first pixel of input row
+ * @param[in] width number of pixels to process
+ * @param[in] scale value by which to scale inRow
+ *
+ * @warning: this is a low-level routine that performs no bounds checking.
+ */
+template <typename OutPixelT, typename InPixelT>
+void accumulateScaledRow(OutPixelT* outRow, InPixelT const* inRow, int width, double scale);
+
 // I would prefer this to be nested in KernelImagesForRegion but SWIG doesn't support that
 class RowOfKernelImagesForRegion;
 
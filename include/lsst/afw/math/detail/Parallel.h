@@ -0,0 +1,142 @@
+// -*- LSST-C++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSST_AFW_MATH_DETAIL_PARALLEL_H
+#define LSST_AFW_MATH_DETAIL_PARALLEL_H
+/*
+ * Minimal support for running independent work items on several threads
+ */
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "lsst/pex/exceptions.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+
+/**
+ * Resolve a requested number of threads
+ *
+ * @param nThreads requested number of threads; 0 means one thread per hardware core
+ * @returns the number of threads to use (always >= 1)
+ *
+ * @throws lsst::pex::exceptions::InvalidParameterError if nThreads < 0
+ */
+inline int resolveNThreads(int nThreads) {
+    if (nThreads < 0) {
+        std::ostringstream os;
+        os << "nThreads = " << nThreads << " < 0";
+        throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterError, os.str());
+    }
+    if (nThreads > 0) {
+        return nThreads;
+    }
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+/**
+ * Return the number of workers parallelFor will use for a given amount of work
+ *
+ * Use this to size per-worker scratch space.
+ *
+ * @param nItems number of work items
+ * @param nThreads requested number of threads; 0 means one thread per hardware core
+ */
+inline int getNWorkers(int nItems, int nThreads) {
+    return std::max(1, std::min(resolveNThreads(nThreads), nItems));
+}
+
+/**
+ * Call `function(item, worker)` for each item in [0, nItems), using up to nThreads threads
+ *
+ * Items are handed out dynamically, so items need not take the same time. The calling thread
+ * is one of the workers, and if only one worker is needed no threads are started at all.
+ * `worker` is in the range [0, getNWorkers(nItems, nThreads)) and is unique to the calling thread
+ * for the duration of the call, so it may be used to index per-worker scratch space.
+ *
+ * If any call throws, no new items are started and the first exception is rethrown
+ * once all workers have finished.
+ *
+ * @param nItems number of work items
+ * @param nThreads requested number of threads; 0 means one thread per hardware core
+ * @param function callable as `function(int item, int worker)`
+ */
+template <typename Function>
+void parallelFor(int nItems, int nThreads, Function const& function) {
+    int const nWorkers = getNWorkers(nItems, nThreads);
+    if (nWorkers == 1) {
+        for (int item = 0; item < nItems; ++item) {
+            function(item, 0);
+        }
+        return;
+    }
+
+    std::atomic<int> nextItem(0);
+    std::exception_ptr firstError;
+    std::mutex errorMutex;
+    auto runWorker = [&](int worker) {
+        for (int item = nextItem++; item < nItems; item = nextItem++) {
+            try {
+                function(item, worker);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!firstError) {
+                    firstError = std::current_exception();
+                }
+                nextItem = nItems;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(nWorkers - 1);
+    try {
+        for (int worker = 1; worker < nWorkers; ++worker) {
+            threads.emplace_back(runWorker, worker);
+        }
+    } catch (...) {
+        // could not start a thread; let the threads we have (and this one) do the work
+    }
+    runWorker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
+}  // namespace detail
+}  // namespace math
+}  // namespace afw
+}  // namespace lsst
+
+#endif  // !defined(LSST_AFW_MATH_DETAIL_PARALLEL_H)
@@ -0,0 +1,82 @@
+// -*- LSST-C++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSST_AFW_MATH_DETAIL_ROWSTATISTICS_H
+#define LSST_AFW_MATH_DETAIL_ROWSTATISTICS_H
+/*
+ * Single-pass accumulation of the standard statistics of rows of float pixels
+ */
+#include "lsst/afw/image/Mask.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+
+/**
+ * Sums of the good pixels in one or more rows, as accumulated by accumulateRowStatistics
+ *
+ * Pixel `i` of a row is accumulated into lane `i % nLanes`; combine the lanes to get the totals.
+ */
+struct RowStatisticsSums {
+    static int const nLanes = 8;
+
+    RowStatisticsSums();
+
+    int n[nLanes];                               ///< number of good pixels
+    double sum[nLanes];                          ///< sum of (value - shift)
+    double sum2[nLanes];                         ///< sum of (value - shift)^2
+    float min[nLanes];                           ///< minimum value (+inf if n == 0)
+    float max[nLanes];                           ///< maximum value (-inf if n == 0)
+    lsst::afw::image::MaskPixel orMask[nLanes];  ///< OR of the mask values
+};
+
+/**
+ * Add the good pixels of a row to sums, in a single pass
+ *
+ * A pixel is good if it is finite and its mask (if any) has none of the bits in andMask set.
+ * The values are accumulated in double precision after subtracting `shift`, which should be
+ * close to the mean for the sake of the numerical stability of the variance.
+ *
+ * On x86-64 the loop is explicitly vectorized using AVX2 instructions if the CPU supports them
+ * (as determined at run time); otherwise a scalar loop is used.  Both give identical results.
+ *
+ * @param[in] row pointer to first pixel of the row
+ * @param[in] maskRow pointer to first mask pixel of the row, or nullptr if there is no mask
+ * @param[in] width number of pixels to process
+ * @param[in] shift value to subtract from each pixel before summing
+ * @param[in] andMask mask of bad pixels
+ * @param[in,out] sums sums to update
+ *
+ * @warning: this is a low-level routine that performs no bounds checking.
+ */
+void accumulateRowStatistics(float const* row, lsst::afw::image::MaskPixel const* maskRow, int width,
+                             double shift, lsst::afw::image::MaskPixel andMask, RowStatisticsSums& sums);
+
+}  // namespace detail
+}  // namespace math
+}  // namespace afw
+}  // namespace lsst
+
+#endif  // !defined(LSST_AFW_MATH_DETAIL_ROWSTATISTICS_H)
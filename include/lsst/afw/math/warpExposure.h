@@ -29,8 +29,10 @@
 #ifndef LSST_AFW_MATH_WARPEXPOSURE_H
 #define LSST_AFW_MATH_WARPEXPOSURE_H
 
+#include <cmath>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "lsst/base.h"
 #include "lsst/pex/exceptions.h"
@@ -87,6 +89,113 @@ protected:
     void setKernelParameter(unsigned int ind, double value) const override;
 };
 
+/**
+ * Lanczos warping using a precomputed table of the Lanczos function.
+ *
+ * This kernel has the same size and center as LanczosWarpingKernel, but each kernel value
+ * is linearly interpolated from a table of the 1-dimensional Lanczos function sampled every
+ * 1/oversample pixel, instead of being computed from two sines. With the default oversampling
+ * of 1024 the kernel values differ from those of LanczosWarpingKernel by less than 1e-6.
+ *
+ * The table is shared (never copied) between clones of the kernel.
+ *
+ * For more information about warping kernels see makeWarpingKernel
+ */
+class LanczosLutWarpingKernel : public SeparableKernel {
+public:
+    /**
+     * Construct a tabulated Lanczos warping kernel
+     *
+     * @throws lsst::pex::exceptions::InvalidParameterError if order < 1 or oversample < 1
+     */
+    explicit LanczosLutWarpingKernel(int order,            ///< order of Lanczos function
+                                     int oversample = 1024  ///< number of table entries per pixel
+                                     );
+
+    LanczosLutWarpingKernel(const LanczosLutWarpingKernel &) = delete;
+    LanczosLutWarpingKernel(LanczosLutWarpingKernel &&) = delete;
+    LanczosLutWarpingKernel &operator=(const LanczosLutWarpingKernel &) = delete;
+    LanczosLutWarpingKernel &operator=(LanczosLutWarpingKernel &&) = delete;
+
+    ~LanczosLutWarpingKernel() override = default;
+
+    std::shared_ptr<Kernel> clone() const override;
+
+    /**
+     * get the order of the kernel
+     */
+    int getOrder() const;
+
+    /**
+     * get the number of table entries per pixel
+     */
+    int getOversample() const;
+
+    /**
+     * 1-dimensional Lanczos function interpolated from a table.
+     *
+     * Returns 0 for |x - offset| >= order, like a truncated Lanczos function.
+     */
+    class LanczosLutFunction1 : public Function1<Kernel::Pixel> {
+    public:
+        typedef std::shared_ptr<Function1<Kernel::Pixel>> Function1Ptr;
+
+        /**
+         * Construct a tabulated Lanczos function, computing a new table
+         */
+        LanczosLutFunction1(int order,       ///< order of Lanczos function
+                            int oversample,  ///< number of table entries per pixel
+                            double xOffset = 0.0  ///< x offset
+                            );
+
+        ~LanczosLutFunction1() override {}
+
+        Function1Ptr clone() const override;
+
+        Kernel::Pixel operator()(double x) const override {
+            double const tableX = std::fabs(x - this->_params[0]) * _oversample;
+            std::size_t const ind = static_cast<std::size_t>(tableX);
+            if (ind + 1 >= _table->size()) {
+                return 0.0;
+            }
+            double const frac = tableX - static_cast<double>(ind);
+            double const value = (*_table)[ind];
+            return value + frac * ((*_table)[ind + 1] - value);
+        }
+
+        /**
+         * get the order of the Lanczos function
+         */
+        int getOrder() const { return _order; }
+
+        /**
+         * get the number of table entries per pixel
+         */
+        int getOversample() const { return _oversample; }
+
+        /**
+         * Return string representation.
+         */
+        std::string toString(std::string const & = "") const override;
+
+    private:
+        /// Construct a tabulated Lanczos function that shares an existing table
+        LanczosLutFunction1(int order, int oversample, std::shared_ptr<std::vector<double> const> table,
+                            double xOffset);
+
+        int _order;
+        int _oversample;
+        /// Lanczos function at x = i / oversample for i = 0, 1, ... order * oversample
+        std::shared_ptr<std::vector<double> const> _table;
+    };
+
+protected:
+    void setKernelParameter(unsigned int ind, double value) const override;
+
+private:
+    explicit LanczosLutWarpingKernel(LanczosLutFunction1 const &function);
+};
+
 /**
  * Bilinear warping: fast; good for undersampled data.
  *
@@ -222,6 +331,10 @@ protected:
  * Allowed names are:
  * - bilinear: return a BilinearWarpingKernel
  * - lanczos#: return a LanczosWarpingKernel of order #, e.g. lanczos4
+ * - lanczos#-lut: return a LanczosLutWarpingKernel of order # with the default oversampling,
+ *   e.g. lanczos3-lut
+ * - lanczos#-lut#: return a LanczosLutWarpingKernel of the first order # with oversampling
+ *   of the second #, e.g. lanczos3-lut4096
  * - nearest: return a NearestWarpingKernel
  *
  * A warping kernel is a subclass of SeparableKernel with the following properties
@@ -266,14 +379,16 @@ public:
             int cacheSize = 0,  ///< cache size for warping kernel; no cache if 0
             ///< (used as the argument to the warping kernels' computeCache method)
             int interpLength = 0,  ///< distance over which the WCS can be linearly interpolated
-            lsst::afw::image::MaskPixel growFullMask = 0
+            lsst::afw::image::MaskPixel growFullMask = 0,
             ///< mask bits to grow to full width of image/variance kernel
+            int nThreads = 1  ///< number of threads to use; 0 for one per hardware core
             )
             : _warpingKernelPtr(makeWarpingKernel(warpingKernelName)),
               _maskWarpingKernelPtr(),
               _cacheSize(cacheSize),
               _interpLength(interpLength),
-              _growFullMask(growFullMask) {
+              _growFullMask(growFullMask),
+              _nThreads(nThreads) {
         setMaskWarpingKernelName(maskWarpingKernelName);
     }
 
@@ -373,6 +488,24 @@ public:
         _growFullMask = growFullMask;
     }
 
+    /**
+     * get the number of threads to use when warping
+     */
+    int getNThreads() const { return _nThreads; }
+
+    /**
+     * set the number of threads to use when warping
+     *
+     * The destination image is divided into bands of rows (one band per interpolation length
+     * if interpolating), which are warped independently, each thread using its own copy
+     * of the warping kernel(s). The transform itself is only evaluated by the calling thread.
+     * The result does not depend on the number of threads.
+     */
+    void setNThreads(int nThreads  ///< number of threads; 0 for one per hardware core
+    ) {
+        _nThreads = nThreads;
+    }
+
 private:
     /**
      * Throw an exception if the two kernels are not compatible in shape
@@ -389,6 +522,7 @@ private:
     int _cacheSize;
     int _interpLength;
     lsst::afw::image::MaskPixel _growFullMask;
+    int _nThreads;
 };
 
 /**
@@ -7,6 +7,7 @@
 #include "lsst/afw/table/Source.h"
 #include "lsst/afw/table/Exposure.h"
 #include "lsst/afw/table/Match.h"
+#include "lsst/afw/table/MatchIndex.h"
 #include "lsst/afw/table/BaseColumnView.h"
 #include "lsst/afw/table/FunctorKey.h"
 #include "lsst/afw/table/aggregates.h"
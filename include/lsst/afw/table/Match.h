@@ -44,7 +44,7 @@ namespace table {
  */
 class MatchControl {
 public:
-    MatchControl() : findOnlyClosest(true), symmetricMatch(true), includeMismatches(false) {}
+    MatchControl() : findOnlyClosest(true), symmetricMatch(true), includeMismatches(false), nThreads(1) {}
     LSST_CONTROL_FIELD(findOnlyClosest, bool,
                        "Return only the closest match if more than one is found "
                        "(default: true)");
@@ -54,6 +54,9 @@ public:
     LSST_CONTROL_FIELD(includeMismatches, bool,
                        "Include failed matches (i.e. one 'match' is NULL) "
                        "(default: false)");
+    LSST_CONTROL_FIELD(nThreads, int,
+                       "Number of threads to use for matching in ra, dec space; "
+                       "0 for one per hardware core (default: 1)");
 };
 
 /**
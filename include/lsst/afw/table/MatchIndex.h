@@ -0,0 +1,175 @@
+// -*- lsst-c++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSST_AFW_TABLE_MATCHINDEX_H
+#define LSST_AFW_TABLE_MATCHINDEX_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "lsst/geom/Angle.h"
+#include "lsst/geom/SpherePoint.h"
+#include "lsst/afw/table/Match.h"
+#include "lsst/afw/table/detail/UnitVectorTree.h"
+#include "lsst/afw/table/io/Persistable.h"
+
+namespace lsst {
+namespace afw {
+namespace table {
+
+/**
+ * A spatial index of the positions (ra, dec) of the records in a catalog
+ *
+ * Building the index is the expensive part of matching a catalog in ra, dec; a MatchIndex lets
+ * that be done once for a catalog (typically a reference catalog) that is then matched against
+ * many others, or queried for the neighbours of individual positions.  It may be persisted
+ * alongside the catalog it indexes, and may be used from several threads at once.
+ *
+ * The index refers to records by their position in the catalog it was built from, and does not
+ * hold on to the catalog itself.  Matching with the index requires that catalog (or an identical
+ * copy) to be passed back in; this is checked using the record IDs.
+ *
+ * Records with positions containing a NaN are not indexed.
+ */
+class MatchIndex final : public io::PersistableFacade<MatchIndex>, public io::Persistable {
+public:
+    /// A record's index in the indexed catalog, and its distance from a query position
+    typedef std::pair<std::size_t, lsst::geom::Angle> Neighbour;
+
+    /**
+     * Index the positions of the records in a catalog
+     *
+     * This is instantiated for Simple and Source catalogs.
+     */
+    template <typename Cat>
+    explicit MatchIndex(Cat const &catalog);
+
+    MatchIndex(MatchIndex const &);
+    MatchIndex(MatchIndex &&);
+    MatchIndex &operator=(MatchIndex const &);
+    MatchIndex &operator=(MatchIndex &&);
+    ~MatchIndex() override;
+
+    /// Return the number of records in the indexed catalog
+    std::size_t getCatalogSize() const noexcept { return _catalogSize; }
+
+    /// Return the number of records in the index (those whose positions do not contain a NaN)
+    std::size_t size() const noexcept { return _tree.size(); }
+
+    /**
+     * Return the indexed records within `radius` of a position, closest first
+     *
+     * @param[in] point    position to search around
+     * @param[in] radius   search radius
+     */
+    std::vector<Neighbour> findWithin(lsst::geom::SpherePoint const &point, lsst::geom::Angle radius) const;
+
+    /**
+     * Return the `k` indexed records closest to a position, closest first
+     *
+     * Ties are resolved in favour of the record earlier in the catalog.  Fewer than `k` records are
+     * returned if there are fewer than `k` in the index.
+     *
+     * @param[in] point    position to search around
+     * @param[in] k        number of records to return
+     */
+    std::vector<Neighbour> findNearest(lsst::geom::SpherePoint const &point, std::size_t k) const;
+
+    /**
+     * Match a catalog against the indexed catalog
+     *
+     * This is equivalent to `matchRaDec(cat1, catalog, radius, mc)`, without the cost of indexing
+     * `catalog`.
+     *
+     * @param[in] cat1      catalog to match
+     * @param[in] catalog   the indexed catalog
+     * @param[in] radius    match radius
+     * @param[in] mc        how to do the matching (obeys MatchControl::findOnlyClosest,
+     *                      MatchControl::includeMismatches and MatchControl::nThreads)
+     *
+     * @throws lsst::pex::exceptions::RangeError if radius is not in the range 0 to 45 degrees
+     * @throws lsst::pex::exceptions::InvalidParameterError if `catalog` is not the catalog
+     *         that was indexed
+     *
+     * This is instantiated for Simple-Simple, Simple-Source, and Source-Source catalog combinations.
+     */
+    template <typename Cat1, typename Cat2>
+    std::vector<Match<typename Cat1::Record, typename Cat2::Record> > match(
+            Cat1 const &cat1, Cat2 const &catalog, lsst::geom::Angle radius,
+            MatchControl const &mc = MatchControl()) const;
+
+    /**
+     * Match the indexed catalog against itself
+     *
+     * This is equivalent to `matchRaDec(catalog, radius, mc)`, without the cost of indexing `catalog`.
+     *
+     * @param[in] catalog   the indexed catalog
+     * @param[in] radius    match radius
+     * @param[in] mc        how to do the matching (obeys MatchControl::symmetricMatch and
+     *                      MatchControl::nThreads)
+     *
+     * @throws lsst::pex::exceptions::RangeError if radius is not in the range 0 to 45 degrees
+     * @throws lsst::pex::exceptions::InvalidParameterError if `catalog` is not the catalog
+     *         that was indexed
+     *
+     * This is instantiated for Simple and Source catalogs.
+     */
+    template <typename Cat>
+    std::vector<Match<typename Cat::Record, typename Cat::Record> > match(
+            Cat const &catalog, lsst::geom::Angle radius, MatchControl const &mc = MatchControl()) const;
+
+    /// A MatchIndex is always persistable.
+    bool isPersistable() const noexcept override { return true; }
+
+protected:
+    std::string getPersistenceName() const override;
+    std::string getPythonModule() const override;
+    void write(OutputArchiveHandle &handle) const override;
+
+private:
+    // Helper class used in persistence.
+    class Factory;
+
+    static Factory const registration;
+
+    // Private ctor, only called by Factory.
+    MatchIndex(std::size_t catalogSize, std::vector<std::size_t> &&catalogIndices,
+               std::vector<RecordId> &&ids, detail::UnitVectorTree &&tree);
+
+    // Check that `catalog` is the catalog that was indexed
+    template <typename Cat>
+    void checkCatalog(Cat const &catalog) const;
+
+    std::size_t _catalogSize;
+    std::vector<std::size_t> _catalogIndices;  // catalog index of each point in _tree
+    std::vector<RecordId> _ids;                // record ID of each point in _tree
+    detail::UnitVectorTree _tree;
+};
+
+}  // namespace table
+}  // namespace afw
+}  // namespace lsst
+
+#endif  // LSST_AFW_TABLE_MATCHINDEX_H
@@ -0,0 +1,200 @@
+// -*- lsst-c++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LSST_AFW_TABLE_DETAIL_UNITVECTORTREE_H
+#define LSST_AFW_TABLE_DETAIL_UNITVECTORTREE_H
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace lsst {
+namespace afw {
+namespace table {
+namespace detail {
+
+/**
+ * @internal A k-d tree of unit vectors, used to find the points near a position on the sphere
+ *
+ * Working with unit vectors rather than (ra, dec) means that there is nothing special about the
+ * poles or the ra = 0 meridian, and the cost of a query depends only on the number of points near
+ * the query position.  Distances are the squared chord lengths between unit vectors (see
+ * toUnitSphereDistanceSquared in MatchIndex.cc).
+ *
+ * Points are identified by their index in the vector the tree was built from, so a tree may be
+ * built once and then queried many times, including concurrently from several threads.
+ */
+class UnitVectorTree final {
+public:
+    typedef std::array<double, 3> Point;
+
+    /// Index returned by findClosest if there is no point within the requested distance
+    static std::size_t const NONE = std::numeric_limits<std::size_t>::max();
+
+    /**
+     * Build a tree
+     *
+     * @param[in] points  unit vectors to index; they must not contain NaNs
+     */
+    explicit UnitVectorTree(std::vector<Point> const &points);
+
+    /**
+     * Reconstruct a tree from the points and indices of another, as returned by getPoints()
+     * and getIndices()
+     *
+     * This is much faster than building a tree from scratch.
+     *
+     * @throws lsst::pex::exceptions::LengthError if points and indices have different lengths
+     * @throws lsst::pex::exceptions::InvalidParameterError if indices is not a permutation
+     */
+    static UnitVectorTree fromTreeOrder(std::vector<Point> points, std::vector<std::size_t> indices);
+
+    UnitVectorTree(UnitVectorTree const &) = default;
+    UnitVectorTree(UnitVectorTree &&) = default;
+    UnitVectorTree &operator=(UnitVectorTree const &) = default;
+    UnitVectorTree &operator=(UnitVectorTree &&) = default;
+    ~UnitVectorTree() = default;
+
+    /// Return the number of points in the tree
+    std::size_t size() const noexcept { return _indices.size(); }
+
+    /// Return the points, in the order they are stored in the tree
+    std::vector<Point> const &getPoints() const noexcept { return _points; }
+
+    /// Return the index of each of getPoints() in the vector the tree was built from
+    std::vector<std::size_t> const &getIndices() const noexcept { return _indices; }
+
+    /**
+     * Call `function(index, d2)` for every point whose squared distance d2 from `point` is
+     * less than `d2Limit`
+     *
+     * Points are visited in an unspecified order.
+     */
+    template <typename Function>
+    void forEachWithin(Point const &point, double d2Limit, Function &&function) const;
+
+    /**
+     * Return the index of the point closest to `point`, and its squared distance
+     *
+     * Only points whose squared distance is less than `d2Limit` are considered; if there are none
+     * the returned index is NONE.
+     */
+    std::pair<std::size_t, double> findClosest(Point const &point, double d2Limit) const;
+
+    /**
+     * Return the indices and squared distances of the `k` points closest to `point`
+     *
+     * The points are sorted by distance, with ties resolved by index.  Fewer than `k` points
+     * are returned if the tree holds fewer than `k`.
+     */
+    std::vector<std::pair<std::size_t, double> > findNearest(Point const &point, std::size_t k) const;
+
+private:
+    UnitVectorTree() : _points(), _indices(), _nodes(), _firstLeaf(0) {}
+
+    // A box containing all the points in [begin, end).  The children of node i are nodes
+    // 2i + 1 and 2i + 2, and all the leaves are at the same depth.
+    struct Node {
+        Point min;
+        Point max;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    // Squared distance from `point` to the nearest point in `node`'s box
+    static double boxDistanceSquared(Node const &node, Point const &point) noexcept {
+        double d2 = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            double const below = node.min[k] - point[k];
+            double const above = point[k] - node.max[k];
+            double const d = below > 0.0 ? below : (above > 0.0 ? above : 0.0);
+            d2 += d * d;
+        }
+        return d2;
+    }
+
+    static double distanceSquared(Point const &p1, Point const &p2) noexcept {
+        double const dx = p1[0] - p2[0];
+        double const dy = p1[1] - p2[1];
+        double const dz = p1[2] - p2[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // A point, and its index in the vector the tree was built from
+    struct Entry {
+        Point point;
+        std::size_t index;
+    };
+
+    // Compute the box of node `index`, containing entries [begin, end), and build its children;
+    // the entries are rearranged into tree order
+    void build(std::size_t index, std::size_t begin, std::size_t end, std::vector<Entry> &entries);
+
+    // Compute the boxes of node `index`, containing points [begin, end), and its descendents,
+    // for points that are already in tree order
+    void computeBoxes(std::size_t index, std::size_t begin, std::size_t end);
+
+    std::vector<Point> _points;         // the points, in tree order
+    std::vector<std::size_t> _indices;  // index of each of _points in the vector the tree was built from
+    std::vector<Node> _nodes;
+    std::size_t _firstLeaf;             // index of the first leaf in _nodes
+};
+
+template <typename Function>
+void UnitVectorTree::forEachWithin(Point const &point, double d2Limit, Function &&function) const {
+    if (_nodes.empty()) {
+        return;
+    }
+    // the tree is balanced, so its depth is at most the number of bits in size()
+    std::size_t stack[std::numeric_limits<std::size_t>::digits + 1];
+    int nStack = 0;
+    stack[nStack++] = 0;
+    while (nStack > 0) {
+        std::size_t const index = stack[--nStack];
+        Node const &node = _nodes[index];
+        if (boxDistanceSquared(node, point) >= d2Limit) {
+            continue;
+        }
+        if (index >= _firstLeaf) {
+            for (std::size_t i = node.begin; i < node.end; ++i) {
+                double const d2 = distanceSquared(point, _points[i]);
+                if (d2 < d2Limit) {
+                    function(_indices[i], d2);
+                }
+            }
+        } else {
+            stack[nStack++] = 2 * index + 2;
+            stack[nStack++] = 2 * index + 1;
+        }
+    }
+}
+
+}  // namespace detail
+}  // namespace table
+}  // namespace afw
+}  // namespace lsst
+
+#endif  // LSST_AFW_TABLE_DETAIL_UNITVECTORTREE_H
@@ -2,7 +2,12 @@
 #ifndef AFW_TABLE_IO_FitsReader_h_INCLUDED
 #define AFW_TABLE_IO_FitsReader_h_INCLUDED
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include "lsst/afw/fits.h"
 #include "lsst/afw/table/Schema.h"
@@ -16,6 +21,50 @@ namespace afw {
 namespace table {
 namespace io {
 
+/**
+ *  Options for reading only part of a FITS binary table into a catalog.
+ *
+ *  The default-constructed options read the whole table.
+ */
+struct FitsReadOptions {
+    /**
+     *  Names of the fields to read; if empty, all fields are read.
+     *
+     *  The columns of other fields are never read from the file.  Catalogs whose tables require a
+     *  minimal schema (e.g. SimpleCatalog and SourceCatalog) must include its fields.
+     */
+    std::vector<std::string> columns;
+
+    /// Index of the first row to read; ignored if `rows` is not empty.
+    std::size_t beginRow = 0;
+
+    /// One past the index of the last row to read (clipped to the table); ignored if `rows` is not empty.
+    std::size_t endRow = std::numeric_limits<std::size_t>::max();
+
+    /// Indices of the rows to read, in the order they are to appear in the catalog.
+    std::vector<std::size_t> rows;
+
+    /**
+     *  Name of the field that `filter` looks at.
+     *
+     *  The field is always read, whether or not it is in `columns`.
+     */
+    std::string filterColumn;
+
+    /**
+     *  If set, only rows for which this returns true are read.
+     *
+     *  It is passed a record in which only the `filterColumn` field has been read, so the rest of the
+     *  row need not be read or decoded for rows that are rejected.
+     */
+    std::function<bool(BaseRecord const&)> filter;
+
+    /// Add the names of all the fields in a Schema to `columns`.
+    void selectColumns(Schema const& schema) {
+        schema.forEach([this](auto const& item) { columns.push_back(item.field.getName()); });
+    }
+};
+
 /**
  *  A utility class for reading FITS binary tables.
  *
@@ -55,6 +104,7 @@ public:
      *  found in the file, then reads the schema and adds records to the Catalog.
      *
      *  @param[in]  fits     An afw::fits::Fits helper that points to a FITS binary table HDU.
+     *  @param[in]  options  Which columns and rows of the table to read.
      *  @param[in]  ioFlags  A set of subclass-dependent bitflags that control optional aspects of FITS
      *                       persistence.  For instance, SourceFitsFlags are used by SourceCatalog
      *                       to control how to read and write Footprints.
@@ -68,32 +118,62 @@ public:
      *                       persistence).
      */
     template <typename ContainerT>
-    static ContainerT apply(afw::fits::Fits& fits, int ioFlags,
+    static ContainerT apply(afw::fits::Fits& fits, FitsReadOptions const& options, int ioFlags,
                             std::shared_ptr<InputArchive> archive = std::shared_ptr<InputArchive>()) {
         std::shared_ptr<daf::base::PropertyList> metadata = std::make_shared<daf::base::PropertyList>();
         fits.readMetadata(*metadata, true);
         FitsReader const* reader = _lookupFitsReader(*metadata);
         FitsSchemaInputMapper mapper(*metadata, true);
         reader->_setupArchive(fits, mapper, archive, ioFlags);
+        if (!options.columns.empty()) {
+            mapper.selectColumns(options.columns, options.filterColumn);
+        }
+        if (options.filter) {
+            mapper.setFilterColumn(options.filterColumn);
+        }
         std::shared_ptr<BaseTable> table = reader->makeTable(mapper, metadata, ioFlags, true);
         ContainerT container(std::dynamic_pointer_cast<typename ContainerT::Table>(table));
         if (!container.getTable()) {
             throw LSST_EXCEPT(pex::exceptions::RuntimeError, "Invalid table class for catalog.");
         }
-        std::size_t nRows = fits.countRows();
-        container.reserve(nRows);
-        for (std::size_t row = 0; row < nRows; ++row) {
+        auto readRecord = [&](std::size_t row, std::size_t runEnd) {
             mapper.readRecord(
                     // We need to be able to support reading Catalog<T const>, since it shares the same
                     // template
                     // as Catalog<T> (which invokes this method in readFits).
                     const_cast<typename std::remove_const<typename ContainerT::Record>::type&>(
                             *container.addNew()),
-                    fits, row);
+                    fits, row, runEnd);
+        };
+        if (options.rows.empty() && !options.filter) {
+            // a single run of consecutive rows, which there's no need to list
+            std::size_t const end = std::min(options.endRow, fits.countRows());
+            std::size_t const begin = std::min(options.beginRow, end);
+            container.reserve(end - begin);
+            for (std::size_t row = begin; row < end; ++row) {
+                readRecord(row, end);
+            }
+            return container;
+        }
+        std::vector<std::size_t> const rows = _selectRows(fits, mapper, *table, options);
+        container.reserve(rows.size());
+        std::size_t runEnd = 0;
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            if (i == 0 || rows[i] != rows[i - 1] + 1) {
+                runEnd = _findRunEnd(rows, i);
+            }
+            readRecord(rows[i], runEnd);
         }
         return container;
     }
 
+    /// Create a new Catalog by reading all of a FITS binary table.
+    template <typename ContainerT>
+    static ContainerT apply(afw::fits::Fits& fits, int ioFlags,
+                            std::shared_ptr<InputArchive> archive = std::shared_ptr<InputArchive>()) {
+        return apply<ContainerT>(fits, FitsReadOptions(), ioFlags, archive);
+    }
+
     /**
      *  Create a new Catalog by reading a FITS file.
      *
@@ -108,6 +188,20 @@ public:
         return apply<ContainerT>(fits, ioFlags, archive);
     }
 
+    /**
+     *  Create a new Catalog by reading part of a FITS file.
+     *
+     *  This is simply a convenience function that creates an afw::fits::Fits object from either
+     *  a string filename or a afw::fits::MemFileManager, then calls the other apply() overload.
+     */
+    template <typename ContainerT, typename SourceT>
+    static ContainerT apply(SourceT& source, FitsReadOptions const& options, int hdu, int ioFlags,
+                            std::shared_ptr<InputArchive> archive = std::shared_ptr<InputArchive>()) {
+        afw::fits::Fits fits(source, "r", afw::fits::Fits::AUTO_CLOSE | afw::fits::Fits::AUTO_CHECK);
+        fits.setHdu(hdu);
+        return apply<ContainerT>(fits, options, ioFlags, archive);
+    }
+
     /**
      *  Callback to create a Table object from a FITS binary table schema.
      *
@@ -142,6 +236,13 @@ public:
 private:
     static FitsReader const* _lookupFitsReader(daf::base::PropertyList const& metadata);
 
+    // Return the rows selected by options.rows or the row range, and passed by options.filter.
+    static std::vector<std::size_t> _selectRows(afw::fits::Fits& fits, FitsSchemaInputMapper& mapper,
+                                                BaseTable& table, FitsReadOptions const& options);
+
+    // Return one past the last row of the run of consecutive rows that starts at rows[i].
+    static std::size_t _findRunEnd(std::vector<std::size_t> const& rows, std::size_t i);
+
     void _setupArchive(afw::fits::Fits& fits, FitsSchemaInputMapper& mapper,
                        std::shared_ptr<InputArchive> archive, int ioFlags) const;
 };
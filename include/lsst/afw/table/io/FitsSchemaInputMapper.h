@@ -2,6 +2,8 @@
 #ifndef AFW_TABLE_IO_FitsSchemaInputMapper_h_INCLUDED
 #define AFW_TABLE_IO_FitsSchemaInputMapper_h_INCLUDED
 
+#include <limits>
+
 #include "lsst/afw/fits.h"
 #include "lsst/afw/table/Schema.h"
 #include "lsst/afw/table/io/InputArchive.h"
@@ -169,6 +171,29 @@ public:
      */
     void customize(std::unique_ptr<FitsColumnReader> reader);
 
+    /**
+     *  Restrict the regular fields added by finalize() to those with the given names.
+     *
+     *  The columns of the other items are never read.  Names are matched against the field names
+     *  finalize() would produce (which may differ from the column names in old files).  Columns
+     *  handled by readers passed to customize() are not affected.
+     *
+     *  @param[in] names         Names of the fields to keep.
+     *  @param[in] filterColumn  Name of a field to keep in addition to `names`; may be empty.
+     *
+     *  Must be called before finalize(), which throws pex::exceptions::NotFoundError if any of the
+     *  names does not correspond to a regular field.
+     */
+    void selectColumns(std::vector<std::string> const &names, std::string const &filterColumn = "");
+
+    /**
+     *  Set the field that readFilterColumn() reads.
+     *
+     *  Must be called before finalize(), which throws pex::exceptions::NotFoundError if the name
+     *  does not correspond to a regular field.
+     */
+    void setFilterColumn(std::string const &name);
+
     /**
      *  Map any remaining items into regular Schema items, and return the final Schema.
      *
@@ -178,8 +203,25 @@ public:
 
     /**
      *  Fill a record from a FITS binary table row.
+     *
+     *  @param[out] record  Record to fill.
+     *  @param[in]  fits    FITS file positioned at the binary table HDU.
+     *  @param[in]  row     Row to read.
+     *  @param[in]  endRow  One past the last row of the run of consecutive rows, starting with `row`,
+     *                      that will be read next.  Values are only read ahead and cached for these
+     *                      rows, so callers that skip around the table do not read rows they never use.
+     */
+    void readRecord(BaseRecord &record, afw::fits::Fits &fits, std::size_t row,
+                    std::size_t endRow = std::numeric_limits<std::size_t>::max());
+
+    /**
+     *  Read only the field set by setFilterColumn() from a FITS binary table row into a record.
+     *
+     *  This is cheaper than readRecord() when deciding whether a row should be read at all.
+     *  The arguments are as for readRecord().
      */
-    void readRecord(BaseRecord &record, afw::fits::Fits &fits, std::size_t row);
+    void readFilterColumn(BaseRecord &record, afw::fits::Fits &fits, std::size_t row,
+                          std::size_t endRow = std::numeric_limits<std::size_t>::max());
 
 private:
     class Impl;
@@ -72,9 +72,19 @@ public:
         for (typename ContainerT::const_iterator i = container.begin(); i != container.end(); ++i) {
             _writeRecord(*i);
         }
+        _flushRecords();
         _finish();
     }
 
+    /**
+     *  Divide this number by the record size (in bytes) to get the number of records that are
+     *  buffered before they are written, each column in a single call to CFITSIO.
+     *
+     *  The per-call overhead of CFITSIO dominates the cost of writing a table one cell at a time,
+     *  so this should be large enough to hold many rows even for catalogs with wide schemas.
+     */
+    static std::size_t WRITTEN_ROWS_FACTOR;
+
     /// Construct from a wrapped cfitsio pointer.
     explicit FitsWriter(Fits* fits, int flags) : _fits(fits), _flags(flags) {}
 
@@ -88,7 +98,12 @@ protected:
     /// Write a table and its schema.
     virtual void _writeTable(std::shared_ptr<BaseTable const> const& table, std::size_t nRows);
 
-    /// Write an individual record.
+    /**
+     *  Write an individual record.
+     *
+     *  Records are buffered and written a block of rows at a time, so they may not be in the
+     *  table until the whole container has been written.
+     */
     virtual void _writeRecord(BaseRecord const& source);
 
     /// Finish writing a catalog.
@@ -101,6 +116,9 @@ protected:
 private:
     struct ProcessRecords;
 
+    // Write any records that _writeRecord has buffered but not yet written to the table.
+    void _flushRecords();
+
     std::shared_ptr<ProcessRecords> _processor;  // a private Schema::forEach functor that write records
 };
 }  // namespace io
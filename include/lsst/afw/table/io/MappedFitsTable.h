@@ -0,0 +1,267 @@
+// -*- lsst-c++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef AFW_TABLE_IO_MappedFitsTable_h_INCLUDED
+#define AFW_TABLE_IO_MappedFitsTable_h_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "lsst/daf/base.h"
+#include "lsst/afw/fits.h"
+#include "lsst/afw/table/Schema.h"
+
+namespace lsst {
+namespace afw {
+namespace table {
+namespace detail {
+
+// Return a value of type T stored big-endian (as in a FITS file) at `data`.
+template <typename T>
+inline T fromBigEndian(std::uint8_t const *data) noexcept {
+    T value;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    std::memcpy(&value, data, sizeof(T));
+#else
+    std::uint8_t bytes[sizeof(T)];
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        bytes[i] = data[sizeof(T) - 1 - i];
+    }
+    std::memcpy(&value, bytes, sizeof(T));
+#endif
+    return value;
+}
+
+// How an element of a field is stored in a FITS binary table, and how to convert it back.
+template <typename T>
+struct MappedStorage {
+    typedef T Stored;
+    static T convert(T value) noexcept { return value; }
+};
+
+template <>
+struct MappedStorage<lsst::geom::Angle> {
+    typedef double Stored;
+    static lsst::geom::Angle convert(double value) noexcept { return value * lsst::geom::radians; }
+};
+
+// FITS has no unsigned 16-bit type; they are stored as signed values with TZERO = 32768.
+template <>
+struct MappedStorage<std::uint16_t> {
+    typedef std::uint16_t Stored;
+    static std::uint16_t convert(std::uint16_t value) noexcept { return value ^ 0x8000; }
+};
+
+}  // namespace detail
+
+namespace io {
+
+/**
+ *  A read-only view of one field of a memory-mapped FITS binary table.
+ *
+ *  Values are left in the file as they are stored there (big-endian, a row at a time), and are
+ *  converted as they are accessed.  Only the pages of the file that hold the values accessed are
+ *  ever read from disk.
+ *
+ *  A MappedColumn keeps the file mapped for as long as it exists, even if the MappedFitsTable it
+ *  came from does not.
+ */
+template <typename T>
+class MappedColumn final {
+public:
+    typedef typename Field<T>::Element Element;
+
+    /// Return the number of rows in the table.
+    std::size_t size() const noexcept { return _nRows; }
+
+    /// Return the number of elements in each row (1 for scalar fields).
+    int getElementCount() const noexcept { return _elementCount; }
+
+    /// Return element `i` of the value in row `row`.  No bounds checking is performed.
+    Element get(std::size_t row, int i = 0) const noexcept {
+        typedef detail::MappedStorage<Element> Storage;
+        typedef typename Storage::Stored Stored;
+        return Storage::convert(
+                detail::fromBigEndian<Stored>(_data.get() + row * _rowSize + i * sizeof(Stored)));
+    }
+
+    /// Return the (first element of the) value in row `row`.  No bounds checking is performed.
+    Element operator[](std::size_t row) const noexcept { return get(row); }
+
+    /// Return a pointer to the big-endian value in the first row.
+    std::uint8_t const *getData() const noexcept { return _data.get(); }
+
+    /// Return the number of bytes between the values in consecutive rows.
+    std::size_t getStride() const noexcept { return _rowSize; }
+
+    /// Return the mapping that holds the values, which may be used to keep it alive.
+    std::shared_ptr<std::uint8_t const> getMapping() const noexcept { return _data; }
+
+private:
+    friend class MappedFitsTable;
+
+    MappedColumn(std::shared_ptr<std::uint8_t const> data, std::size_t nRows, std::size_t rowSize,
+                 int elementCount)
+            : _data(std::move(data)), _nRows(nRows), _rowSize(rowSize), _elementCount(elementCount) {}
+
+    std::shared_ptr<std::uint8_t const> _data;
+    std::size_t _nRows;
+    std::size_t _rowSize;
+    int _elementCount;
+};
+
+/**
+ *  A read-only view of a Flag field of a memory-mapped FITS binary table.
+ *
+ *  All Flag fields share a single FITS column, with one bit for each.
+ */
+template <>
+class MappedColumn<Flag> final {
+public:
+    typedef bool Element;
+
+    /// Return the number of rows in the table.
+    std::size_t size() const noexcept { return _nRows; }
+
+    /// Return the number of elements in each row (always 1).
+    int getElementCount() const noexcept { return 1; }
+
+    /// Return the value in row `row`.  No bounds checking is performed.
+    bool get(std::size_t row) const noexcept { return _data.get()[row * _rowSize] & _mask; }
+
+    /// Return the value in row `row`.  No bounds checking is performed.
+    bool operator[](std::size_t row) const noexcept { return get(row); }
+
+    /// Return the mapping that holds the values, which may be used to keep it alive.
+    std::shared_ptr<std::uint8_t const> getMapping() const noexcept { return _data; }
+
+private:
+    friend class MappedFitsTable;
+
+    MappedColumn(std::shared_ptr<std::uint8_t const> data, std::size_t nRows, std::size_t rowSize, int bit)
+            : _data(std::move(data)), _nRows(nRows), _rowSize(rowSize), _mask(0x80 >> bit) {}
+
+    std::shared_ptr<std::uint8_t const> _data;  // points to the byte holding the bit in the first row
+    std::size_t _nRows;
+    std::size_t _rowSize;
+    std::uint8_t _mask;
+};
+
+/**
+ *  A FITS binary table that is mapped into memory rather than read into a catalog.
+ *
+ *  Opening a MappedFitsTable only reads the header, no matter how large the table is; the values
+ *  of a field are read from disk by the operating system as they are accessed through the
+ *  MappedColumn returned by getColumn().  This makes it cheap to look at a few fields of a
+ *  very large catalog.
+ *
+ *  Only uncompressed binary tables in regular files can be mapped.  Of those, only the fields
+ *  whose values are stored directly in the table can be accessed: numeric scalars and fixed-size
+ *  arrays, Angles and Flags.  Strings, variable-length arrays, and fields converted from older
+ *  versions of the file format cannot.
+ *
+ *  A MappedFitsTable may be used from several threads at once.
+ */
+class MappedFitsTable final {
+public:
+    /**
+     *  Map a FITS binary table.
+     *
+     *  @param[in] filename    Name of the file to map.
+     *  @param[in] hdu         Number of the "header-data unit" to map (where 0 is the Primary HDU).
+     *                         The default value of afw::fits::DEFAULT_HDU is interpreted as
+     *                         "the first HDU with NAXIS != 0".
+     *
+     *  @throws lsst::afw::fits::FitsError if the HDU is not an uncompressed binary table in a
+     *          file that can be mapped.
+     */
+    explicit MappedFitsTable(std::string const &filename, int hdu = fits::DEFAULT_HDU);
+
+    MappedFitsTable(MappedFitsTable const &) = default;
+    MappedFitsTable(MappedFitsTable &&) = default;
+    MappedFitsTable &operator=(MappedFitsTable const &) = default;
+    MappedFitsTable &operator=(MappedFitsTable &&) = default;
+    ~MappedFitsTable() = default;
+
+    /// Return the schema a catalog read from the table would have.
+    Schema getSchema() const { return _schema; }
+
+    /// Return the header, without the keys that describe the schema.
+    std::shared_ptr<daf::base::PropertyList> getMetadata() const { return _metadata; }
+
+    /// Return the number of rows in the table.
+    std::size_t size() const noexcept { return _nRows; }
+
+    /**
+     *  Return true if getColumn() can be called for the field with the given name.
+     *
+     *  This is false for fields that are not in the table, and for strings, variable-length arrays
+     *  and fields stored with a scale or offset.
+     */
+    bool isMapped(std::string const &name) const { return _columns.count(name) > 0; }
+
+    /**
+     *  Return a view of the values of a field.
+     *
+     *  @throws lsst::pex::exceptions::NotFoundError if the field is not in the schema.
+     *  @throws lsst::pex::exceptions::TypeError if the field is in the schema, but is not stored
+     *          in a form that can be mapped.
+     *
+     *  This is instantiated for all field types except std::string.
+     */
+    template <typename T>
+    MappedColumn<T> getColumn(Key<T> const &key) const;
+
+    /// @copydoc getColumn(Key<T> const &) const
+    template <typename T>
+    MappedColumn<T> getColumn(std::string const &name) const {
+        return getColumn(_schema.find<T>(name).key);
+    }
+
+private:
+    // Where a field is stored in a row of the table.
+    struct Column {
+        std::size_t offset;  // offset in bytes from the start of the row
+        char code;           // FITS TFORM type code
+        int count;           // number of elements (bits, for the flag column)
+        int bit;             // bit in the flag column; -1 for other fields
+    };
+
+    Schema _schema;
+    std::shared_ptr<daf::base::PropertyList> _metadata;
+    std::shared_ptr<std::uint8_t const> _data;  // the first row of the table
+    std::size_t _nRows;
+    std::size_t _rowSize;
+    std::map<std::string, Column> _columns;     // keyed by field name; only fields that can be mapped
+};
+
+}  // namespace io
+}  // namespace table
+}  // namespace afw
+}  // namespace lsst
+
+#endif  // !AFW_TABLE_IO_MappedFitsTable_h_INCLUDED
@@ -61,11 +61,12 @@ void declareSetMask(PyClass &cls) {
 template <typename PixelT, typename PyClass>
 void declareTemplatedMembers(PyClass &cls) {
     /* Constructors */
-    cls.def(py::init<image::Image<PixelT> const &, Threshold const &, int const, bool const>(), "img"_a,
-            "threshold"_a, "npixMin"_a = 1, "setPeaks"_a = true);
+    cls.def(py::init<image::Image<PixelT> const &, Threshold const &, int const, bool const, int const>(),
+            "img"_a, "threshold"_a, "npixMin"_a = 1, "setPeaks"_a = true, "nThreads"_a = 1);
     cls.def(py::init<image::MaskedImage<PixelT, image::MaskPixel> const &, Threshold const &,
-                     std::string const &, int const, bool const>(),
-            "img"_a, "threshold"_a, "planeName"_a = "", "npixMin"_a = 1, "setPeaks"_a = true);
+                     std::string const &, int const, bool const, int const>(),
+            "img"_a, "threshold"_a, "planeName"_a = "", "npixMin"_a = 1, "setPeaks"_a = true,
+            "nThreads"_a = 1);
 
     /* Members */
     declareMakeHeavy<int>(cls);
@@ -88,8 +89,9 @@ PYBIND11_MODULE(footprintSet, mod) {
     declareTemplatedMembers<float>(clsFootprintSet);
     declareTemplatedMembers<double>(clsFootprintSet);
 
-    clsFootprintSet.def(py::init<image::Mask<image::MaskPixel> const &, Threshold const &, int const>(),
-                        "img"_a, "threshold"_a, "npixMin"_a = 1);
+    clsFootprintSet.def(
+            py::init<image::Mask<image::MaskPixel> const &, Threshold const &, int const, int const>(),
+            "img"_a, "threshold"_a, "npixMin"_a = 1, "nThreads"_a = 1);
 
     /* Members */
     clsFootprintSet.def(py::init<lsst::geom::Box2I>(), "region"_a);
@@ -75,8 +75,16 @@ PYBIND11_MODULE(convolveImage, mod) {
     py::class_<ConvolutionControl, std::shared_ptr<ConvolutionControl>> clsConvolutionControl(
             mod, "ConvolutionControl");
 
-    clsConvolutionControl.def(py::init<bool, bool, int>(), "doNormalize"_a = true, "doCopyEdge"_a = false,
-                              "maxInterpolationDistance"_a = 10);
+    py::enum_<ConvolutionControl::Algorithm>(clsConvolutionControl, "Algorithm")
+            .value("AUTO", ConvolutionControl::Algorithm::AUTO)
+            .value("DIRECT", ConvolutionControl::Algorithm::DIRECT)
+            .value("FFT", ConvolutionControl::Algorithm::FFT)
+            .export_values();
+
+    clsConvolutionControl.def(py::init<bool, bool, int, int, int, ConvolutionControl::Algorithm, bool>(),
+                              "doNormalize"_a = true, "doCopyEdge"_a = false,
+                              "maxInterpolationDistance"_a = 10, "nThreads"_a = 1, "tileSize"_a = 256,
+                              "algorithm"_a = ConvolutionControl::AUTO, "doBasisConvolution"_a = false);
 
     clsConvolutionControl.def("getDoNormalize", &ConvolutionControl::getDoNormalize);
     clsConvolutionControl.def("getDoCopyEdge", &ConvolutionControl::getDoCopyEdge);
@@ -86,6 +94,14 @@ PYBIND11_MODULE(convolveImage, mod) {
     clsConvolutionControl.def("setDoCopyEdge", &ConvolutionControl::setDoCopyEdge);
     clsConvolutionControl.def("setMaxInterpolationDistance",
                               &ConvolutionControl::setMaxInterpolationDistance);
+    clsConvolutionControl.def("getNThreads", &ConvolutionControl::getNThreads);
+    clsConvolutionControl.def("getTileSize", &ConvolutionControl::getTileSize);
+    clsConvolutionControl.def("setNThreads", &ConvolutionControl::setNThreads);
+    clsConvolutionControl.def("setTileSize", &ConvolutionControl::setTileSize);
+    clsConvolutionControl.def("getAlgorithm", &ConvolutionControl::getAlgorithm);
+    clsConvolutionControl.def("setAlgorithm", &ConvolutionControl::setAlgorithm);
+    clsConvolutionControl.def("getDoBasisConvolution", &ConvolutionControl::getDoBasisConvolution);
+    clsConvolutionControl.def("setDoBasisConvolution", &ConvolutionControl::setDoBasisConvolution);
 
     declareAll<double, double>(mod);
     declareAll<double, float>(mod);
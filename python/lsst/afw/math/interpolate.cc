@@ -20,6 +20,8 @@
  * see <https://www.lsstcorp.org/LegalNotices/>.
  */
 
+#include <algorithm>
+
 #include <pybind11/pybind11.h>
 //#include <pybind11/operators.h>
 #include <pybind11/stl.h>
@@ -63,6 +65,12 @@ PYBIND11_MODULE(interpolate, mod) {
             (ndarray::Array<double, 1> (Interpolate::*)(ndarray::Array<double const, 1> const &) const) &
                     Interpolate::interpolate);
 
+    clsInterpolate.def("interpolateRange", [](Interpolate const &self, double const x0, int const n) {
+        ndarray::Array<double, 1, 1> out = ndarray::allocate(std::max(n, 0));
+        self.interpolateRange(x0, n, out.getData());
+        return out;
+    }, "x0"_a, "n"_a);
+
     mod.def("makeInterpolate",
             (std::shared_ptr<Interpolate>(*)(std::vector<double> const &, std::vector<double> const &,
                                              Interpolate::Style const))makeInterpolate,
@@ -21,11 +21,13 @@
  */
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <pybind11/pybind11.h>
 //#include <pybind11/operators.h>
 #include <pybind11/stl.h>
+#include <pybind11/functional.h>
 
 #include "lsst/afw/math/Stack.h"
 
@@ -103,6 +105,34 @@ void declareStatisticsStack(py::module &mod) {
                     std::vector<lsst::afw::image::VariancePixel> const &))statisticsStack<PixelT>,
             "vectors"_a, "flags"_a, "sctrl"_a = StatisticsControl(),
             "wvector"_a = std::vector<lsst::afw::image::VariancePixel>(0));
+    mod.def("streamStatisticsStack",
+            (void (*)(lsst::afw::image::MaskedImage<PixelT> &,
+                      std::vector<std::shared_ptr<lsst::afw::image::MaskedImageFitsReader>> const &, Property,
+                      StatisticsControl const &, std::vector<lsst::afw::image::VariancePixel> const &,
+                      lsst::afw::image::MaskPixel,
+                      std::vector<std::pair<lsst::afw::image::MaskPixel,
+                                            lsst::afw::image::MaskPixel>> const &,
+                      int))streamStatisticsStack<PixelT>,
+            "out"_a, "readers"_a, "flags"_a, "sctrl"_a, "wvector"_a, "clipped"_a, "maskMap"_a,
+            "stripHeight"_a = 256);
+}
+
+/*
+ * The version passing strips to a sink can't be overloaded on the pixel type, as only the sink's
+ * argument depends on it, so the type is given by a suffix on the name (e.g. streamStatisticsStackF)
+ */
+template <typename PixelT>
+void declareStreamStatisticsStack(py::module &mod, std::string const &suffix) {
+    mod.def(("streamStatisticsStack" + suffix).c_str(),
+            (void (*)(std::vector<std::shared_ptr<lsst::afw::image::MaskedImageFitsReader>> const &,
+                      lsst::geom::Box2I const &, Property, StatisticsControl const &,
+                      std::vector<lsst::afw::image::VariancePixel> const &, lsst::afw::image::MaskPixel,
+                      std::vector<std::pair<lsst::afw::image::MaskPixel,
+                                            lsst::afw::image::MaskPixel>> const &,
+                      int, std::function<void(lsst::afw::image::MaskedImage<PixelT> const &)> const &))
+                    streamStatisticsStack<PixelT>,
+            "readers"_a, "bbox"_a, "flags"_a, "sctrl"_a, "wvector"_a, "clipped"_a, "maskMap"_a,
+            "stripHeight"_a, "sink"_a);
 }
 
 }  // namespace
@@ -111,4 +141,6 @@ PYBIND11_MODULE(stack, mod) {
     /* Module level */
     declareStatisticsStack<float>(mod);
     declareStatisticsStack<double>(mod);
+    declareStreamStatisticsStack<float>(mod, "F");
+    declareStreamStatisticsStack<double>(mod, "D");
 }
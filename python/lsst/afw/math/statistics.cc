@@ -115,6 +115,7 @@ PYBIND11_MODULE(statistics, mod) {
     clsStatisticsControl.def("getWeightedIsSet", &StatisticsControl::getWeightedIsSet);
     clsStatisticsControl.def("getCalcErrorFromInputVariance",
                              &StatisticsControl::getCalcErrorFromInputVariance);
+    clsStatisticsControl.def("getNThreads", &StatisticsControl::getNThreads);
     clsStatisticsControl.def("setNumSigmaClip", &StatisticsControl::setNumSigmaClip);
     clsStatisticsControl.def("setNumIter", &StatisticsControl::setNumIter);
     clsStatisticsControl.def("setAndMask", &StatisticsControl::setAndMask);
@@ -123,6 +124,7 @@ PYBIND11_MODULE(statistics, mod) {
     clsStatisticsControl.def("setWeighted", &StatisticsControl::setWeighted);
     clsStatisticsControl.def("setCalcErrorFromInputVariance",
                              &StatisticsControl::setCalcErrorFromInputVariance);
+    clsStatisticsControl.def("setNThreads", &StatisticsControl::setNThreads);
 
     py::class_<Statistics> clsStatistics(mod, "Statistics");
 
@@ -143,6 +145,22 @@ PYBIND11_MODULE(statistics, mod) {
     declareStatisticsVectorOverloads<double>(mod);
     declareStatisticsVectorOverloads<float>(mod);
     declareStatisticsVectorOverloads<int>(mod);
+
+    mod.def("makeGridStatistics",
+            (std::vector<Statistics>(*)(image::Image<float> const &, std::vector<int> const &,
+                                        std::vector<int> const &, std::vector<int> const &,
+                                        std::vector<int> const &, int const, StatisticsControl const &))
+                    makeGridStatistics,
+            "img"_a, "xOrigins"_a, "xSizes"_a, "yOrigins"_a, "ySizes"_a, "flags"_a,
+            "sctrl"_a = StatisticsControl());
+    mod.def("makeGridStatistics",
+            (std::vector<Statistics>(*)(image::MaskedImage<float> const &, std::vector<int> const &,
+                                        std::vector<int> const &, std::vector<int> const &,
+                                        std::vector<int> const &, int const, StatisticsControl const &))
+                    makeGridStatistics,
+            "mimg"_a, "xOrigins"_a, "xSizes"_a, "yOrigins"_a, "ySizes"_a, "flags"_a,
+            "sctrl"_a = StatisticsControl());
+    mod.def("canMakeGridStatistics", canMakeGridStatistics, "flags"_a, "sctrl"_a = StatisticsControl());
 }
 
 }  // math
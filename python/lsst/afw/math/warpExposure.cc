@@ -133,6 +133,8 @@ void declareWarpingFunctions(py::module &mod) {
 PYBIND11_MODULE(warpExposure, mod) {
     /* Module level */
     auto clsLanczosWarpingKernel = declareWarpingKernel<LanczosWarpingKernel>(mod, "LanczosWarpingKernel");
+    auto clsLanczosLutWarpingKernel =
+            declareWarpingKernel<LanczosLutWarpingKernel>(mod, "LanczosLutWarpingKernel");
     declareSimpleWarpingKernel<BilinearWarpingKernel>(mod, "BilinearWarpingKernel");
     declareSimpleWarpingKernel<NearestWarpingKernel>(mod, "NearestWarpingKernel");
 
@@ -152,13 +154,16 @@ PYBIND11_MODULE(warpExposure, mod) {
 
     /* Constructors */
     clsLanczosWarpingKernel.def(py::init<int>(), "order"_a);
+    clsLanczosLutWarpingKernel.def(py::init<int, int>(), "order"_a, "oversample"_a = 1024);
 
-    clsWarpingControl.def(py::init<std::string, std::string, int, int, image::MaskPixel>(),
+    clsWarpingControl.def(py::init<std::string, std::string, int, int, image::MaskPixel, int>(),
                           "warpingKernelName"_a, "maskWarpingKernelName"_a = "", "cacheSize"_a = 0,
-                          "interpLength"_a = 0, "growFullMask"_a = 0);
+                          "interpLength"_a = 0, "growFullMask"_a = 0, "nThreads"_a = 1);
 
     /* Operators */
     clsLanczosWarpingKernel.def("getOrder", &LanczosWarpingKernel::getOrder);
+    clsLanczosLutWarpingKernel.def("getOrder", &LanczosLutWarpingKernel::getOrder);
+    clsLanczosLutWarpingKernel.def("getOversample", &LanczosLutWarpingKernel::getOversample);
 
     clsWarpingControl.def("getCacheSize", &WarpingControl::getCacheSize);
     clsWarpingControl.def("setCacheSize", &WarpingControl::setCacheSize, "cacheSize"_a);
@@ -178,6 +183,8 @@ PYBIND11_MODULE(warpExposure, mod) {
                           "maskWarpingKernel"_a);
     clsWarpingControl.def("getGrowFullMask", &WarpingControl::getGrowFullMask);
     clsWarpingControl.def("setGrowFullMask", &WarpingControl::setGrowFullMask, "growFullMask"_a);
+    clsWarpingControl.def("getNThreads", &WarpingControl::getNThreads);
+    clsWarpingControl.def("setNThreads", &WarpingControl::setNThreads, "nThreads"_a);
 
     /* Members */
 }
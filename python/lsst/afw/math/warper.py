@@ -70,6 +70,9 @@ class WarperConfig(pexConfig.Config):
             "lanczos3": "Lanczos kernel of order 3",
             "lanczos4": "Lanczos kernel of order 4",
             "lanczos5": "Lanczos kernel of order 5",
+            "lanczos3-lut": "Lanczos kernel of order 3, interpolated from a table",
+            "lanczos4-lut": "Lanczos kernel of order 4, interpolated from a table",
+            "lanczos5-lut": "Lanczos kernel of order 5, interpolated from a table",
         }
     )
     maskWarpingKernelName = pexConfig.ChoiceField(
@@ -99,6 +102,11 @@ class WarperConfig(pexConfig.Config):
         doc="mask bits to grow to full width of image/variance kernel,",
         default=afwImage.Mask.getPlaneBitMask("EDGE"),
     )
+    nThreads = pexConfig.Field(
+        dtype=int,
+        doc="number of threads to use for warping; 0 for one per hardware core",
+        default=1,
+    )
 
 
 class Warper:
@@ -117,6 +125,8 @@ class Warper:
         see `WarperConfig.maskWarpingKernelName`
     growFullMask : `int`, optional
         mask bits to grow to full width of image/variance kernel
+    nThreads : `int`, optional
+        number of threads to use for warping; 0 for one per hardware core
     """
     ConfigClass = WarperConfig
 
@@ -125,9 +135,10 @@ class Warper:
                  interpLength=_DefaultInterpLength,
                  cacheSize=_DefaultCacheSize,
                  maskWarpingKernelName="",
-                 growFullMask=afwImage.Mask.getPlaneBitMask("EDGE"),):
+                 growFullMask=afwImage.Mask.getPlaneBitMask("EDGE"),
+                 nThreads=1,):
         self._warpingControl = mathLib.WarpingControl(
-            warpingKernelName, maskWarpingKernelName, cacheSize, interpLength, growFullMask)
+            warpingKernelName, maskWarpingKernelName, cacheSize, interpLength, growFullMask, nThreads)
 
     @classmethod
     def fromConfig(cls, config):
@@ -144,6 +155,7 @@ class Warper:
             interpLength=config.interpLength,
             cacheSize=config.cacheSize,
             growFullMask=config.growFullMask,
+            nThreads=config.nThreads,
         )
 
     def getWarpingKernel(self):
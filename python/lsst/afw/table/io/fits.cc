@@ -21,8 +21,14 @@
 
 
 #include "pybind11/pybind11.h"
+#include "pybind11/functional.h"
+#include "pybind11/numpy.h"
+#include "pybind11/stl.h"
 
+#include "lsst/afw/table/io/FitsReader.h"
 #include "lsst/afw/table/io/FitsSchemaInputMapper.h"
+#include "lsst/afw/table/io/FitsWriter.h"
+#include "lsst/afw/table/io/MappedFitsTable.h"
 
 namespace py = pybind11;
 using namespace py::literals;
@@ -31,11 +37,106 @@ namespace lsst {
 namespace afw {
 namespace table {
 namespace io {
+namespace {
+
+// Return an array that refers to the big-endian values in the mapped file, and keeps the file mapped.
+template <typename T>
+py::object viewColumn(MappedColumn<T> const &column) {
+    typedef typename detail::MappedStorage<typename MappedColumn<T>::Element>::Stored Stored;
+    py::dtype dtype(std::string(">") + py::format_descriptor<Stored>::format());
+    std::vector<std::size_t> shape = {column.size()};
+    std::vector<std::size_t> strides = {column.getStride()};
+    if (!std::is_same<T, typename MappedColumn<T>::Element>::value) {  // an Array field
+        shape.push_back(column.getElementCount());
+        strides.push_back(sizeof(Stored));
+    }
+    py::capsule base(new std::shared_ptr<std::uint8_t const>(column.getMapping()), [](void *mapping) {
+        delete reinterpret_cast<std::shared_ptr<std::uint8_t const> *>(mapping);
+    });
+    py::array result(dtype, shape, strides, column.getData(), base);
+    result.attr("setflags")("write"_a = false);
+    return result;
+}
+
+// Return an array holding a copy of values that can't be viewed in place.
+template <typename T>
+py::object copyColumn(MappedColumn<T> const &column) {
+    py::array_t<typename MappedColumn<T>::Element> result(
+            std::vector<std::size_t>{column.size(), static_cast<std::size_t>(column.getElementCount())});
+    auto values = result.template mutable_unchecked<2>();
+    for (std::size_t row = 0; row < column.size(); ++row) {
+        for (int i = 0; i < column.getElementCount(); ++i) {
+            values(row, i) = column.get(row, i);
+        }
+    }
+    if (std::is_same<T, typename MappedColumn<T>::Element>::value) {  // not an Array field
+        return result.attr("reshape")(column.size());
+    }
+    return std::move(result);
+}
+
+py::object viewColumn(MappedColumn<std::uint16_t> const &column) { return copyColumn(column); }
+
+py::object viewColumn(MappedColumn<Array<std::uint16_t>> const &column) { return copyColumn(column); }
+
+py::object viewColumn(MappedColumn<Flag> const &column) {
+    py::array_t<bool> result(column.size());
+    auto values = result.mutable_unchecked<1>();
+    for (std::size_t row = 0; row < column.size(); ++row) {
+        values(row) = column[row];
+    }
+    return result;
+}
+
+// Schema::findAndApply functor that sets `result` to an array of a mapped field's values.
+struct GetMappedColumn {
+    template <typename T>
+    void operator()(SchemaItem<T> const &item) const {
+        result = viewColumn(table.getColumn(item.key));
+    }
+
+    void operator()(SchemaItem<std::string> const &item) const {
+        throw LSST_EXCEPT(pex::exceptions::TypeError,
+                          "String field '" + item.field.getName() + "' cannot be mapped");
+    }
+
+    MappedFitsTable const &table;
+    py::object &result;
+};
+
+}  // namespace
 
 PYBIND11_MODULE(fits, mod) {
 
     mod.def("setPreppedRowsFactor", [](std::size_t n) { FitsSchemaInputMapper::PREPPED_ROWS_FACTOR = n; });
     mod.def("getPreppedRowsFactor", []() { return FitsSchemaInputMapper::PREPPED_ROWS_FACTOR; });
+    mod.def("setWrittenRowsFactor", [](std::size_t n) { FitsWriter::WRITTEN_ROWS_FACTOR = n; });
+    mod.def("getWrittenRowsFactor", []() { return FitsWriter::WRITTEN_ROWS_FACTOR; });
+
+    py::class_<FitsReadOptions> clsFitsReadOptions(mod, "FitsReadOptions");
+    clsFitsReadOptions.def(py::init<>());
+    clsFitsReadOptions.def_readwrite("columns", &FitsReadOptions::columns);
+    clsFitsReadOptions.def_readwrite("beginRow", &FitsReadOptions::beginRow);
+    clsFitsReadOptions.def_readwrite("endRow", &FitsReadOptions::endRow);
+    clsFitsReadOptions.def_readwrite("rows", &FitsReadOptions::rows);
+    clsFitsReadOptions.def_readwrite("filterColumn", &FitsReadOptions::filterColumn);
+    clsFitsReadOptions.def_readwrite("filter", &FitsReadOptions::filter);
+    clsFitsReadOptions.def("selectColumns", &FitsReadOptions::selectColumns, "schema"_a);
+
+    py::class_<MappedFitsTable, std::shared_ptr<MappedFitsTable>> clsMappedFitsTable(mod, "MappedFitsTable");
+    clsMappedFitsTable.def(py::init<std::string const &, int>(), "filename"_a, "hdu"_a = fits::DEFAULT_HDU);
+    clsMappedFitsTable.def("getSchema", &MappedFitsTable::getSchema);
+    clsMappedFitsTable.def_property_readonly("schema", &MappedFitsTable::getSchema);
+    clsMappedFitsTable.def("getMetadata", &MappedFitsTable::getMetadata);
+    clsMappedFitsTable.def("__len__", &MappedFitsTable::size);
+    clsMappedFitsTable.def("isMapped", &MappedFitsTable::isMapped, "name"_a);
+    auto getColumn = [](MappedFitsTable const &self, std::string const &name) {
+        py::object result;
+        self.getSchema().findAndApply(name, GetMappedColumn{self, result});
+        return result;
+    };
+    clsMappedFitsTable.def("getColumn", getColumn, "name"_a);
+    clsMappedFitsTable.def("__getitem__", getColumn);
 
 }
 
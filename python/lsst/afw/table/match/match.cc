@@ -27,6 +27,8 @@
 #include "lsst/afw/table/Simple.h"
 #include "lsst/afw/table/Source.h"
 #include "lsst/afw/table/Match.h"
+#include "lsst/afw/table/MatchIndex.h"
+#include "lsst/afw/table/io/python.h"  // for addPersistableMethods
 
 namespace py = pybind11;
 using namespace pybind11::literals;
@@ -79,6 +81,40 @@ void declareMatch1(py::module &mod) {
     //          &matchRaDec<Catalog1>, "cat"_a, "radius"_a, "symmetric"_a);
 }
 
+/// @internal Declare MatchIndex methods templated on two types of catalog
+template <typename Catalog1, typename Catalog2>
+void declareMatchIndexMatch2(py::class_<MatchIndex, std::shared_ptr<MatchIndex>> &cls) {
+    cls.def("match",
+            py::overload_cast<Catalog1 const &, Catalog2 const &, lsst::geom::Angle, MatchControl const &>(
+                    &MatchIndex::match<Catalog1, Catalog2>, py::const_),
+            "cat1"_a, "catalog"_a, "radius"_a, "mc"_a = MatchControl());
+}
+
+/// @internal Declare MatchIndex methods templated on one type of catalog
+template <typename Catalog>
+void declareMatchIndexMatch1(py::class_<MatchIndex, std::shared_ptr<MatchIndex>> &cls) {
+    cls.def(py::init<Catalog const &>(), "catalog"_a);
+    cls.def("match",
+            py::overload_cast<Catalog const &, lsst::geom::Angle, MatchControl const &>(
+                    &MatchIndex::match<Catalog>, py::const_),
+            "catalog"_a, "radius"_a, "mc"_a = MatchControl());
+}
+
+void declareMatchIndex(py::module &mod) {
+    py::class_<MatchIndex, std::shared_ptr<MatchIndex>> cls(mod, "MatchIndex");
+    declareMatchIndexMatch1<SimpleCatalog>(cls);
+    declareMatchIndexMatch1<SourceCatalog>(cls);
+    declareMatchIndexMatch2<SimpleCatalog, SimpleCatalog>(cls);
+    declareMatchIndexMatch2<SimpleCatalog, SourceCatalog>(cls);
+    declareMatchIndexMatch2<SourceCatalog, SourceCatalog>(cls);
+    cls.def("getCatalogSize", &MatchIndex::getCatalogSize);
+    cls.def("size", &MatchIndex::size);
+    cls.def("__len__", &MatchIndex::size);
+    cls.def("findWithin", &MatchIndex::findWithin, "point"_a, "radius"_a);
+    cls.def("findNearest", &MatchIndex::findNearest, "point"_a, "k"_a);
+    table::io::python::addPersistableMethods<MatchIndex>(cls);
+}
+
 }  // <anonymous>
 
 PYBIND11_MODULE(match, mod) {
@@ -87,12 +123,14 @@ PYBIND11_MODULE(match, mod) {
     LSST_DECLARE_CONTROL_FIELD(clsMatchControl, MatchControl, findOnlyClosest);
     LSST_DECLARE_CONTROL_FIELD(clsMatchControl, MatchControl, symmetricMatch);
     LSST_DECLARE_CONTROL_FIELD(clsMatchControl, MatchControl, includeMismatches);
+    LSST_DECLARE_CONTROL_FIELD(clsMatchControl, MatchControl, nThreads);
 
     declareMatch2<SimpleCatalog, SimpleCatalog>(mod, "Simple");
     declareMatch2<SimpleCatalog, SourceCatalog>(mod, "Reference");
     declareMatch2<SourceCatalog, SourceCatalog>(mod, "Source");
     declareMatch1<SimpleCatalog>(mod);
     declareMatch1<SourceCatalog>(mod);
+    declareMatchIndex(mod);
 
     mod.def("matchXy", (SourceMatchVector(*)(SourceCatalog const &, SourceCatalog const &, double,
                                              MatchControl const &))matchXy,
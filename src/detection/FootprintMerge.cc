@@ -19,6 +19,7 @@
  * the GNU General Public License along with this program.  If not,
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
+#include <algorithm>
 #include <cstdint>
 
 #include "boost/bind.hpp"
@@ -31,6 +32,31 @@ namespace lsst {
 namespace afw {
 namespace detection {
 
+namespace {
+
+// The side of the square cells of the grid FootprintMergeList uses to find nearby FootprintMerges.
+// Most Footprints only touch a cell or two, while a very large one touches O(area/MERGE_GRID_CELL_SIZE^2)
+int const MERGE_GRID_CELL_SIZE = 128;
+
+// Return the cell of the grid that holds a pixel coordinate (rounding down for negative coordinates)
+int getGridCell(int coord) {
+    return (coord >= 0) ? coord / MERGE_GRID_CELL_SIZE : -((-coord - 1) / MERGE_GRID_CELL_SIZE) - 1;
+}
+
+// Return the key of a cell of the grid; the bits are shifted unsigned, as cells may be negative
+std::uint64_t makeGridKey(int cellX, int cellY) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(cellX)) << 32) |
+           static_cast<std::uint32_t>(cellY);
+}
+
+// Return the bounding box of a FootprintMerge grown by one pixel, to allow for touching
+lsst::geom::Box2I getGrownBBox(lsst::geom::Box2I box) {
+    box.grow(lsst::geom::Extent2I(1, 1));
+    return box;
+}
+
+}  // namespace
+
 class FootprintMerge {
 public:
     typedef FootprintMergeList::KeyTuple KeyTuple;
@@ -249,6 +275,7 @@ void FootprintMergeList::addCatalog(std::shared_ptr<afw::table::SourceTable> sou
 
     // If list is empty or merging not requested, don't check for any matches, just add all the objects
     bool checkForMatches = !_mergeList.empty() && doMerge;
+    bool anyMerged = false;
 
     for (afw::table::SourceCatalog::const_iterator srcIter = inputCat.begin(); srcIter != inputCat.end();
          ++srcIter) {
@@ -260,16 +287,20 @@ void FootprintMergeList::addCatalog(std::shared_ptr<afw::table::SourceTable> sou
         // Empty pointer to account for the first match in the catalog.  If there is more than one
         // match, subsequent matches will be merged with this one
         std::shared_ptr<FootprintMerge> first = std::shared_ptr<FootprintMerge>();
+        std::size_t firstIndex = 0;
 
         if (checkForMatches) {
-            FootprintMergeVec::iterator iter = _mergeList.begin();
-            while (iter != _mergeList.end()) {
+            // Only FootprintMerges that share a cell of the grid with foot can overlap it; we consider
+            // them in the order they were added, just as a search of the whole list would
+            for (std::size_t i : _findMergeCandidates(foot->getBBox())) {
+                std::shared_ptr<FootprintMerge> &merge = _mergeList[i];
+                if (!merge) continue;  // already merged into another FootprintMerge
+
                 // Grow by one pixel to allow for touching
-                lsst::geom::Box2I box((**iter).getBBox());
-                box.grow(lsst::geom::Extent2I(1, 1));
-                if (box.overlaps(foot->getBBox()) && (**iter).overlaps(*foot)) {
+                if (getGrownBBox(merge->getBBox()).overlaps(foot->getBBox()) && merge->overlaps(*foot)) {
                     if (!first) {
-                        first = *iter;
+                        first = merge;
+                        firstIndex = i;
                         // Spatially extend existing FootprintMerge in order to connect subsequent,
                         // now-overlapping FootprintMerges. If a subsequent FootprintMerge overlaps with
                         // the new footprint, it's now guaranteed to overlap with this first FootprintMerge.
@@ -277,25 +308,79 @@ void FootprintMergeList::addCatalog(std::shared_ptr<afw::table::SourceTable> sou
                         // higher-priority existing peaks are merged into this first FootprintMerge.
                         first->addSpans(foot);
                     } else {
-                        // Add existing merged Footprint to first
-                        first->add(**iter, _filterMap, minNewPeakDist, maxSamePeakDist);
-                        iter = _mergeList.erase(iter);
-                        continue;
+                        // Add existing merged Footprint to first, and forget it
+                        first->add(*merge, _filterMap, minNewPeakDist, maxSamePeakDist);
+                        merge.reset();
+                        anyMerged = true;
                     }
                 }
-                ++iter;
-            } // while mergeList
-        } //     if checkForMatches
+            }  // for candidates
+        }      // if checkForMatches
 
         if (first) {
             // Now merge footprint including peaks into the newly-connected, higher-priority FootprintMerge
             first->add(foot, _peakSchemaMapper, keyIter->second, minNewPeakDist, maxSamePeakDist);
+            _indexMerge(firstIndex);  // its bbox may have grown
         } else {
-           // Footprint did not overlap with any existing FootprintMerges. Add to MergeList
+            // Footprint did not overlap with any existing FootprintMerges. Add to MergeList
             _mergeList.push_back(std::make_shared<FootprintMerge>(foot, sourceTable, _peakTable,
                                                                   _peakSchemaMapper, keyIter->second));
+            _mergeBoxes.push_back(lsst::geom::Box2I());
+            _indexMerge(_mergeList.size() - 1);
         }
     }
+
+    if (anyMerged) {
+        _compactMergeList();
+    }
+}
+
+void FootprintMergeList::_indexMerge(std::size_t i) {
+    lsst::geom::Box2I const box = getGrownBBox(_mergeList[i]->getBBox());
+    lsst::geom::Box2I const &oldBox = _mergeBoxes[i];
+    if (box.isEmpty()) {
+        return;
+    }
+    for (int cellY = getGridCell(box.getMinY()); cellY <= getGridCell(box.getMaxY()); ++cellY) {
+        for (int cellX = getGridCell(box.getMinX()); cellX <= getGridCell(box.getMaxX()); ++cellX) {
+            // boxes only grow, so we've already added i to the cells the old box touched
+            bool const alreadyIndexed =
+                    !oldBox.isEmpty() && cellX >= getGridCell(oldBox.getMinX()) &&
+                    cellX <= getGridCell(oldBox.getMaxX()) && cellY >= getGridCell(oldBox.getMinY()) &&
+                    cellY <= getGridCell(oldBox.getMaxY());
+            if (!alreadyIndexed) {
+                _mergeGrid[makeGridKey(cellX, cellY)].push_back(i);
+            }
+        }
+    }
+    _mergeBoxes[i] = box;
+}
+
+std::vector<std::size_t> FootprintMergeList::_findMergeCandidates(lsst::geom::Box2I const &bbox) const {
+    std::vector<std::size_t> candidates;
+    if (bbox.isEmpty()) {
+        return candidates;
+    }
+    for (int cellY = getGridCell(bbox.getMinY()); cellY <= getGridCell(bbox.getMaxY()); ++cellY) {
+        for (int cellX = getGridCell(bbox.getMinX()); cellX <= getGridCell(bbox.getMaxX()); ++cellX) {
+            MergeGrid::const_iterator cell = _mergeGrid.find(makeGridKey(cellX, cellY));
+            if (cell != _mergeGrid.end()) {
+                candidates.insert(candidates.end(), cell->second.begin(), cell->second.end());
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    return candidates;
+}
+
+void FootprintMergeList::_compactMergeList() {
+    _mergeList.erase(std::remove(_mergeList.begin(), _mergeList.end(), nullptr), _mergeList.end());
+    _mergeBoxes.assign(_mergeList.size(), lsst::geom::Box2I());
+    _mergeGrid.clear();
+    for (std::size_t i = 0; i < _mergeList.size(); ++i) {
+        _indexMerge(i);
+    }
 }
 
 void FootprintMergeList::getFinalSources(afw::table::SourceCatalog &outputCat) {
@@ -40,16 +40,20 @@
        cout << "Found " << sources.getFootprints()->size() << " sources" << std::endl;
  */
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <algorithm>
 #include <cassert>
+#include <numeric>
 #include <set>
 #include <string>
 #include <typeinfo>
+#include <vector>
 #include "boost/format.hpp"
 #include "lsst/pex/exceptions.h"
 #include "lsst/afw/image/MaskedImage.h"
 #include "lsst/afw/math/Statistics.h"
+#include "lsst/afw/math/detail/Parallel.h"
 #include "lsst/afw/detection/Peak.h"
 #include "lsst/afw/detection/FootprintSet.h"
 #include "lsst/afw/detection/FootprintCtrl.h"
@@ -64,6 +68,8 @@ namespace {
 
 typedef std::uint64_t IdPixelT;  // Type of temporary Images used in merging Footprints
 
+int const MIN_STRIP_HEIGHT = 64;  // Don't split images into strips of fewer rows than this when detecting
+
 struct Threshold_traits {};
 struct ThresholdLevel_traits : public Threshold_traits {  // Threshold is a single number
 };
@@ -127,25 +133,6 @@ private:
     std::set<std::uint64_t>::const_iterator _pos;
 };
 
-//
-// Define our own functions to handle NaN tests;  this gives us the
-// option to define a value for e.g. image::MaskPixel or int
-//
-template <typename T>
-inline bool isBadPixel(T) {
-    return false;
-}
-
-template <>
-inline bool isBadPixel(float val) {
-    return std::isnan(val);
-}
-
-template <>
-inline bool isBadPixel(double val) {
-    return std::isnan(val);
-}
-
 /*
  * Return the number of bits required to represent a unsigned long
  */
@@ -452,6 +439,13 @@ struct IdSpanCompare {
         }
     }
 };
+/*
+ * A run of consecutive pixels in a row that are in a Footprint
+ */
+struct PixelRun {
+    int x0, x1; /* inclusive range of columns */
+    bool good;  /* includes a value over the desired threshold? */
+};
 /*
  * Follow a chain of aliases, returning the final resolved value.
  */
@@ -465,19 +459,58 @@ int resolve_alias(std::vector<int> const &aliases, /* list of aliases */
 
     return (resolved);
 }
+/*
+ * Merge the objects with IDs id1 and id2, keeping the smaller of their resolved IDs.
+ *
+ * IDs are handed out in the order in which objects are first seen, so the resolved ID of an object
+ * is then that of its first pixel (in row-major order), however the object's pixels were labelled.
+ */
+void merge_aliases(std::vector<int> &aliases, int id1, int id2) {
+    int const resolved1 = resolve_alias(aliases, id1);
+    int const resolved2 = resolve_alias(aliases, id2);
+
+    if (resolved1 < resolved2) {
+        aliases[resolved2] = resolved1;
+    } else {
+        aliases[resolved1] = resolved2;
+    }
+}
 /// @endcond
 }  // namespace
 
 namespace {
+/*
+ * A peak found in a Footprint, waiting to be added to the Footprint's PeakCatalog
+ */
+struct PeakPosition {
+    int x, y;
+    float value;  // the type used by PeakRecord
+};
+/*
+ * Sort PeakPositions in the same order as SortPeaks sorts PeakRecords
+ */
+struct SortPeakPositions {
+    bool operator()(PeakPosition const &a, PeakPosition const &b) const {
+        if (a.value != b.value) {
+            return (a.value > b.value);
+        }
+
+        if (a.x != b.x) {
+            return (a.x < b.x);
+        }
+
+        return (a.y < b.y);
+    }
+};
+
 template <typename ImageT>
-void findPeaksInFootprint(ImageT const &image, bool polarity, PeakCatalog &peaks, Footprint &foot,
-                          std::size_t const margin = 0) {
-    auto spanSet = foot.getSpans();
-    if (spanSet->size() == 0) {
+void findPeaksInFootprint(ImageT const &image, bool polarity, geom::SpanSet const &spanSet,
+                          std::vector<PeakPosition> &peaks, std::size_t const margin = 0) {
+    if (spanSet.size() == 0) {
         return;
     }
     auto bbox = image.getBBox();
-    for (auto const &spanIter : *spanSet) {
+    for (auto const &spanIter : spanSet) {
         auto y = spanIter.getY() - image.getY0();
         if (static_cast<std::size_t>(y + image.getY0()) < bbox.getMinY() + margin ||
             static_cast<std::size_t>(y + image.getY0()) > bbox.getMaxY() - margin) {
@@ -503,7 +536,7 @@ void findPeaksInFootprint(ImageT const &image, bool polarity, PeakCatalog &peaks
                 }
             }
 
-            foot.addPeak(x + image.getX0(), y + image.getY0(), val);
+            peaks.push_back(PeakPosition{x + image.getX0(), y + image.getY0(), static_cast<float>(val)});
         }
     }
 }
@@ -534,34 +567,37 @@ public:
         }
     }
 
-    void addRecord(Footprint &foot) const { foot.addPeak(_x, _y, _polarity ? _max : _min); }
+    PeakPosition getPeak() const { return PeakPosition{_x, _y, static_cast<float>(_polarity ? _max : _min)}; }
 
 private:
     bool _polarity;
     int _x, _y;
     double _min, _max;
 };
-
+/*
+ * Find the peaks in a Footprint, sorted as they should appear in its PeakCatalog
+ *
+ * This only reads foot, so it may be called for several Footprints at once; adding the peaks to the
+ * Footprints' PeakCatalogs may not (they share a PeakTable)
+ */
 template <typename ImageT, typename ThresholdT>
-void findPeaks(std::shared_ptr<Footprint> foot, ImageT const &img, bool polarity, ThresholdT) {
-    findPeaksInFootprint(img, polarity, foot->getPeaks(), *foot, 1);
+void findPeaks(Footprint const &foot, ImageT const &img, bool polarity, std::vector<PeakPosition> &peaks,
+               ThresholdT) {
+    findPeaksInFootprint(img, polarity, *foot.getSpans(), peaks, 1);
 
-    // We use getInternal() here to get the vector of shared_ptr that Catalog uses internally,
-    // which causes the STL algorithm to copy pointers instead of PeakRecords (which is what
-    // it'd try to do if we passed Catalog's own iterators).
-    std::stable_sort(foot->getPeaks().getInternal().begin(), foot->getPeaks().getInternal().end(),
-                     SortPeaks());
+    std::stable_sort(peaks.begin(), peaks.end(), SortPeakPositions());
 
-    if (foot->getPeaks().empty()) {
+    if (peaks.empty()) {
         FindMaxInFootprint<typename ImageT::Pixel> maxFinder(polarity);
-        foot->getSpans()->applyFunctor(maxFinder, ndarray::ndImage(img.getArray(), img.getXY0()));
-        maxFinder.addRecord(*foot);
+        foot.getSpans()->applyFunctor(maxFinder, ndarray::ndImage(img.getArray(), img.getXY0()));
+        peaks.push_back(maxFinder.getPeak());
     }
 }
 
 // No need to search for peaks when processing a Mask
 template <typename ImageT>
-void findPeaks(std::shared_ptr<Footprint>, ImageT const &, bool, ThresholdBitmask_traits) {
+void findPeaks(Footprint const &, ImageT const &, bool, std::vector<PeakPosition> &,
+               ThresholdBitmask_traits) {
     ;
 }
 }  // namespace
@@ -588,16 +624,187 @@ static inline bool inFootprint(ImagePixelT pixVal, IterT, bool, double threshold
 }
 
 /*
- * Advance the x_iterator to the variance image, when relevant (it may be NULL otherwise)
+ * Set flags[x] for the pixels of a row that are in a Footprint, and clear it for the others
+ *
+ * These are plain loops over arrays that the compiler can vectorize.  NaNs fail every comparison,
+ * so bad pixels are never flagged.
+ */
+template <typename ImagePixelT, typename VariancePixelT>
+static void flagRow(ImagePixelT const *pix, VariancePixelT const *, int const width, bool const polarity,
+                    double const thresholdVal, std::uint8_t *flags, ThresholdLevel_traits) {
+    if (polarity) {
+        for (int x = 0; x < width; ++x) {
+            flags[x] = (pix[x] >= thresholdVal);
+        }
+    } else {
+        for (int x = 0; x < width; ++x) {
+            flags[x] = (-pix[x] >= thresholdVal);
+        }
+    }
+}
+
+template <typename ImagePixelT, typename VariancePixelT>
+static void flagRow(ImagePixelT const *pix, VariancePixelT const *var, int const width, bool const polarity,
+                    double const thresholdVal, std::uint8_t *flags, ThresholdPixelLevel_traits) {
+    if (polarity) {
+        for (int x = 0; x < width; ++x) {
+            flags[x] = (pix[x] >= thresholdVal * ::sqrt(var[x]));
+        }
+    } else {
+        for (int x = 0; x < width; ++x) {
+            flags[x] = (-pix[x] >= thresholdVal * ::sqrt(var[x]));
+        }
+    }
+}
+
+template <typename ImagePixelT, typename VariancePixelT>
+static void flagRow(ImagePixelT const *pix, VariancePixelT const *, int const width, bool const,
+                    double const thresholdVal, std::uint8_t *flags, ThresholdBitmask_traits) {
+    long const bits = static_cast<long>(thresholdVal);
+    for (int x = 0; x < width; ++x) {
+        flags[x] = ((pix[x] & bits) != 0);
+    }
+}
+
+/*
+ * Append the runs of set flags in flags[0, width) to runs, skipping eight flags at a time where we can
  */
-template <typename IterT>
-static inline IterT advancePtr(IterT varPtr, Threshold_traits) {
-    return varPtr;
+static void findRuns(std::uint8_t const *flags, int const width, std::vector<PixelRun> &runs) {
+    std::uint64_t const allSet = 0x0101010101010101;
+    auto getWord = [flags](int x) {
+        std::uint64_t word;
+        std::memcpy(&word, flags + x, sizeof(word));
+        return word;
+    };
+
+    int x = 0;
+    while (x < width) {
+        while (x + 8 <= width && getWord(x) == 0) {
+            x += 8;
+        }
+        while (x < width && !flags[x]) {
+            ++x;
+        }
+        if (x == width) {
+            break;
+        }
+
+        int const x0 = x;
+        while (x + 8 <= width && getWord(x) == allSet) {
+            x += 8;
+        }
+        while (x < width && flags[x]) {
+            ++x;
+        }
+        runs.push_back(PixelRun{x0, x - 1, false});
+    }
 }
 
-template <typename IterT>
-static inline IterT advancePtr(IterT varPtr, ThresholdPixelLevel_traits) {
-    return varPtr + 1;
+/*
+ * Label the objects in rows [yBegin, yEnd) of img, appending an IdSpan for each of their runs of
+ * pixels to spans
+ *
+ * Each row is first reduced to its runs of pixels that are over threshold, and it's the runs that are
+ * labelled; each is joined to the runs in the previous row that it touches.
+ *
+ * The objects are given IDs 1, 2, ... in the order in which they're first seen, and the IdSpans carry
+ * resolved IDs.  Returns the number of IDs used.
+ */
+template <typename ImagePixelT, typename VariancePixelT, typename ThresholdTraitT>
+static int labelRows(image::ImageBase<ImagePixelT> const &img,  // Image to search for objects
+                     image::Image<VariancePixelT> const *var,   // img's variance
+                     int const yBegin,                          // first row to search
+                     int const yEnd,                            // one past the last row to search
+                     double const footprintThreshold,           // threshold value for footprint
+                     double const includeThreshold,             // threshold for inclusion
+                     bool const includeAll,                     // include objects whatever includeThreshold?
+                     bool const polarity,                       // if false, search _below_ thresholdVal
+                     std::vector<IdSpan> &spans                 // y:x0,x1 for objects
+) {
+    int nobj = 0; /* number of objects found */
+
+    int const width = img.getWidth();
+    auto const imgArray = img.getArray();
+    ImagePixelT const *const imgData = imgArray.getData();
+    long const imgStride = imgArray.template getStride<0>();
+    VariancePixelT const *varData = nullptr;
+    long varStride = 0;
+    if (var != NULL) {
+        auto const varArray = var->getArray();
+        varData = varArray.getData();
+        varStride = varArray.template getStride<0>();
+    }
+
+    std::vector<std::uint8_t> flags(width);  // is each pixel in the current row in a Footprint?
+    std::vector<PixelRun> runs, prevRuns;    // runs of pixels in Footprints in the current/previous row
+    std::vector<int> ids, prevIds;           // object IDs of runs and prevRuns
+
+    std::vector<int> aliases;                   // aliases for initially disjoint parts of Footprints
+    aliases.reserve(1 + (yEnd - yBegin) / 20);  // initial size of aliases
+
+    std::size_t const span0 = spans.size();  // index of our first IdSpan
+
+    aliases.push_back(0);  // 0 --> 0
+                           /*
+                            * Go through image identifying objects
+                            */
+    for (int y = yBegin; y != yEnd; ++y) {
+        ImagePixelT const *const pixRow = imgData + y * imgStride;
+        VariancePixelT const *const varRow = (varData == nullptr) ? nullptr : varData + y * varStride;
+
+        flagRow(pixRow, varRow, width, polarity, footprintThreshold, flags.data(), ThresholdTraitT());
+        runs.clear();
+        findRuns(flags.data(), width, runs);
+        /*
+         * Does each run include a pixel that exceeds the inclusion threshold?
+         */
+        for (auto &run : runs) {
+            run.good = includeAll;
+            for (int x = run.x0; !run.good && x <= run.x1; ++x) {
+                run.good = inFootprint(pixRow[x], (varRow == nullptr) ? varRow : varRow + x, polarity,
+                                       includeThreshold, ThresholdTraitT());
+            }
+        }
+        /*
+         * Give each run the ID of the runs it touches in the previous row (merging their IDs if
+         * there are several), or a new ID if there aren't any
+         */
+        ids.resize(runs.size());
+        std::size_t p = 0;  // first run in previous row that might touch the current one
+        for (std::size_t i = 0; i < runs.size(); ++i) {
+            PixelRun const &run = runs[i];
+            while (p < prevRuns.size() && prevRuns[p].x1 + 1 < run.x0) {
+                ++p;
+            }
+
+            int id = 0;
+            for (std::size_t q = p; q < prevRuns.size() && prevRuns[q].x0 <= run.x1 + 1; ++q) {
+                if (id == 0) {
+                    id = prevIds[q];
+                } else if (prevIds[q] != id) {
+                    merge_aliases(aliases, prevIds[q], id);
+                }
+            }
+            if (id == 0) {
+                id = ++nobj;
+                aliases.push_back(id);
+            }
+
+            ids[i] = id;
+            spans.emplace_back(id, y, run.x0, run.x1, run.good);
+        }
+
+        runs.swap(prevRuns);
+        ids.swap(prevIds);
+    }
+    /*
+     * Resolve aliases; first alias chains, then the IDs in the spans
+     */
+    for (std::size_t i = span0; i < spans.size(); i++) {
+        spans[i].id = resolve_alias(aliases, spans[i].id);
+    }
+
+    return nobj;
 }
 
 /*
@@ -614,113 +821,91 @@ static void findFootprints(
         double const includeThresholdMultiplier,  // threshold (relative to footprintThreshold) for inclusion
         bool const polarity,                      // if false, search _below_ thresholdVal
         int const npixMin,                        // minimum number of pixels in an object
-        bool const setPeaks                       // should I set the Peaks list?
+        bool const setPeaks,                      // should I set the Peaks list?
+        int const nThreads                        // number of threads to use; 0 for one per hardware core
 ) {
-    int id;       /* object ID */
-    int in_span;  /* object ID of current IdSpan */
-    int nobj = 0; /* number of objects found */
-    int x0 = 0;   /* unpacked from a IdSpan */
+    int id;  /* object ID */
 
     double includeThreshold = footprintThreshold * includeThresholdMultiplier;  // Threshold for inclusion
 
     int const row0 = img.getY0();
     int const col0 = img.getX0();
     int const height = img.getHeight();
-    int const width = img.getWidth();
     /*
-     * Storage for arrays that identify objects by ID. We want to be able to
-     * refer to idp[-1] and idp[width], hence the (width + 2)
+     * Label horizontal strips of the image independently, and then join up the objects that cross
+     * the seams between them.  Each object is identified by the ID of its first pixel, so neither
+     * the Footprints nor their order depend on the number of strips
      */
-    std::vector<int> id1(width + 2);
-    std::fill(id1.begin(), id1.end(), 0);
-    std::vector<int> id2(width + 2);
-    std::fill(id2.begin(), id2.end(), 0);
-    std::vector<int>::iterator idc = id1.begin() + 1;  // object IDs in current/
-    std::vector<int>::iterator idp = id2.begin() + 1;  //                       previous row
-
-    std::vector<int> aliases;          // aliases for initially disjoint parts of Footprints
-    aliases.reserve(1 + height / 20);  // initial size of aliases
-
-    std::vector<IdSpan> spans;          // y:x0,x1 for objects
-    spans.reserve(aliases.capacity());  // initial size of spans
+    int const nStrips = math::detail::getNWorkers(height / MIN_STRIP_HEIGHT, nThreads);
+    auto getStripBegin = [height, nStrips](int strip) {
+        return static_cast<int>(static_cast<long>(height) * strip / nStrips);
+    };
 
-    aliases.push_back(0);  // 0 --> 0
-                           /*
-                            * Go through image identifying objects
-                            */
-    typedef typename image::Image<ImagePixelT>::x_iterator x_iterator;
-    typedef typename image::Image<VariancePixelT>::x_iterator x_var_iterator;
-
-    in_span = 0;  // not in a span
-    for (int y = 0; y != height; ++y) {
-        if (idc == id1.begin() + 1) {
-            idc = id2.begin() + 1;
-            idp = id1.begin() + 1;
-        } else {
-            idc = id1.begin() + 1;
-            idp = id2.begin() + 1;
+    std::vector<std::vector<IdSpan>> stripSpans(nStrips);  // y:x0,x1 for objects in each strip
+    std::vector<int> stripNobj(nStrips);                   // number of IDs used in each strip
+    math::detail::parallelFor(nStrips, nThreads, [&](int strip, int) {
+        stripNobj[strip] = labelRows<ImagePixelT, VariancePixelT, ThresholdTraitT>(
+                img, var, getStripBegin(strip), getStripBegin(strip + 1), footprintThreshold,
+                includeThreshold, includeThresholdMultiplier == 1.0, polarity, stripSpans[strip]);
+    });
+    /*
+     * Renumber the objects in each strip to follow those in the strips above it
+     */
+    int nobj = 0;  // number of IDs used
+    for (int strip = 0; strip < nStrips; ++strip) {
+        for (auto &span : stripSpans[strip]) {
+            span.id += nobj;
         }
-        std::fill_n(idc - 1, width + 2, 0);
-
-        in_span = 0;                                     /* not in a span */
-        bool good = (includeThresholdMultiplier == 1.0); /* Span exceeds the threshold? */
-
-        x_iterator pixPtr = img.row_begin(y);
-        x_var_iterator varPtr = (var == NULL) ? NULL : var->row_begin(y);
-        for (int x = 0; x < width; ++x, ++pixPtr, varPtr = advancePtr(varPtr, ThresholdTraitT())) {
-            ImagePixelT const pixVal = *pixPtr;
-
-            if (isBadPixel(pixVal) ||
-                !inFootprint(pixVal, varPtr, polarity, footprintThreshold, ThresholdTraitT())) {
-                if (in_span) {
-                    spans.emplace_back(in_span, y, x0, x - 1, good);
-
-                    in_span = 0;
-                    good = false;
-                }
-            } else { /* a pixel to fix */
-                if (idc[x - 1] != 0) {
-                    id = idc[x - 1];
-                } else if (idp[x - 1] != 0) {
-                    id = idp[x - 1];
-                } else if (idp[x] != 0) {
-                    id = idp[x];
-                } else if (idp[x + 1] != 0) {
-                    id = idp[x + 1];
+        nobj += stripNobj[strip];
+    }
+    std::vector<int> aliases(nobj + 1);  // aliases for parts of Footprints in different strips
+    std::iota(aliases.begin(), aliases.end(), 0);
+    /*
+     * Merge the objects that touch across each seam; both rows' IdSpans are sorted by x0
+     */
+    for (int strip = 1; strip < nStrips; ++strip) {
+        int const y = getStripBegin(strip);  // first row of this strip
+        std::vector<IdSpan> const &above = stripSpans[strip - 1];
+        std::vector<IdSpan> const &below = stripSpans[strip];
+
+        auto abovePtr = std::partition_point(above.begin(), above.end(),
+                                             [y](IdSpan const &span) { return span.y < y - 1; });
+        auto const belowEnd = std::partition_point(below.begin(), below.end(),
+                                                   [y](IdSpan const &span) { return span.y == y; });
+        auto belowPtr = below.begin();
+        while (abovePtr != above.end() && belowPtr != belowEnd) {
+            if (abovePtr->x1 + 1 < belowPtr->x0) {
+                ++abovePtr;
+            } else if (belowPtr->x1 + 1 < abovePtr->x0) {
+                ++belowPtr;
+            } else {  // the spans are 8-connected
+                merge_aliases(aliases, abovePtr->id, belowPtr->id);
+
+                if (abovePtr->x1 < belowPtr->x1) {
+                    ++abovePtr;
                 } else {
-                    id = ++nobj;
-                    aliases.push_back(id);
-                }
-
-                idc[x] = id;
-                if (!in_span) {
-                    x0 = x;
-                    in_span = id;
-                }
-                /*
-                 * Do we need to merge ID numbers? If so, make suitable entries in aliases[]
-                 */
-                if (idp[x + 1] != 0 && idp[x + 1] != id) {
-                    aliases[resolve_alias(aliases, idp[x + 1])] = resolve_alias(aliases, id);
-
-                    idc[x] = id = idp[x + 1];
-                }
-
-                if (!good && inFootprint(pixVal, varPtr, polarity, includeThreshold, ThresholdTraitT())) {
-                    good = true;
+                    ++belowPtr;
                 }
             }
         }
+    }
 
-        if (in_span) {
-            spans.emplace_back(in_span, y, x0, width - 1, good);
+    std::vector<IdSpan> spans;  // y:x0,x1 for objects
+    if (nStrips == 1) {
+        spans.swap(stripSpans[0]);
+    } else {
+        std::size_t nSpans = 0;
+        for (auto const &s : stripSpans) {
+            nSpans += s.size();
+        }
+        spans.reserve(nSpans);
+        for (auto &s : stripSpans) {
+            for (auto &span : s) {
+                span.id = resolve_alias(aliases, span.id);
+                spans.push_back(span);
+            }
+            std::vector<IdSpan>().swap(s);
         }
-    }
-    /*
-     * Resolve aliases; first alias chains, then the IDs in the spans
-     */
-    for (unsigned int i = 0; i < spans.size(); i++) {
-        spans[i].id = resolve_alias(aliases, spans[i].id);
     }
     /*
      * Sort spans by ID, so we can sweep through them once
@@ -758,43 +943,51 @@ static void findFootprints(
         }
     }
     /*
-     * Find all peaks within those Footprints
+     * Find all peaks within those Footprints; the search is done in parallel, but the peaks
+     * must be added to the Footprints one at a time
      */
     if (setPeaks) {
-        typedef FootprintSet::FootprintList::iterator fiterator;
-        for (fiterator ptr = _footprints->begin(), end = _footprints->end(); ptr != end; ++ptr) {
-            findPeaks(*ptr, img, polarity, ThresholdTraitT());
+        FootprintSet::FootprintList &footprints = *_footprints;
+        std::vector<std::vector<PeakPosition>> peaks(footprints.size());
+        math::detail::parallelFor(static_cast<int>(footprints.size()), nThreads, [&](int i, int) {
+            findPeaks(*footprints[i], img, polarity, peaks[i], ThresholdTraitT());
+        });
+        for (std::size_t i = 0; i < footprints.size(); ++i) {
+            for (auto const &peak : peaks[i]) {
+                footprints[i]->addPeak(peak.x, peak.y, peak.value);
+            }
         }
     }
 }
 
 template <typename ImagePixelT>
 FootprintSet::FootprintSet(image::Image<ImagePixelT> const &img, Threshold const &threshold,
-                           int const npixMin, bool const setPeaks)
+                           int const npixMin, bool const setPeaks, int const nThreads)
         : daf::base::Citizen(typeid(this)), _footprints(new FootprintList()), _region(img.getBBox()) {
     typedef float VariancePixelT;
 
     findFootprints<ImagePixelT, image::MaskPixel, VariancePixelT, ThresholdLevel_traits>(
             _footprints.get(), _region, img, NULL, threshold.getValue(img), threshold.getIncludeMultiplier(),
-            threshold.getPolarity(), npixMin, setPeaks);
+            threshold.getPolarity(), npixMin, setPeaks, nThreads);
 }
 
 // NOTE: not a template to appease swig (see note by instantiations at bottom)
 
 template <typename MaskPixelT>
-FootprintSet::FootprintSet(image::Mask<MaskPixelT> const &msk, Threshold const &threshold, int const npixMin)
+FootprintSet::FootprintSet(image::Mask<MaskPixelT> const &msk, Threshold const &threshold, int const npixMin,
+                           int const nThreads)
         : daf::base::Citizen(typeid(this)), _footprints(new FootprintList()), _region(msk.getBBox()) {
     switch (threshold.getType()) {
         case Threshold::BITMASK:
             findFootprints<MaskPixelT, MaskPixelT, float, ThresholdBitmask_traits>(
                     _footprints.get(), _region, msk, NULL, threshold.getValue(),
-                    threshold.getIncludeMultiplier(), threshold.getPolarity(), npixMin, false);
+                    threshold.getIncludeMultiplier(), threshold.getPolarity(), npixMin, false, nThreads);
             break;
 
         case Threshold::VALUE:
             findFootprints<MaskPixelT, MaskPixelT, float, ThresholdLevel_traits>(
                     _footprints.get(), _region, msk, NULL, threshold.getValue(),
-                    threshold.getIncludeMultiplier(), threshold.getPolarity(), npixMin, false);
+                    threshold.getIncludeMultiplier(), threshold.getPolarity(), npixMin, false, nThreads);
             break;
 
         default:
@@ -806,7 +999,7 @@ FootprintSet::FootprintSet(image::Mask<MaskPixelT> const &msk, Threshold const &
 template <typename ImagePixelT, typename MaskPixelT>
 FootprintSet::FootprintSet(const image::MaskedImage<ImagePixelT, MaskPixelT> &maskedImg,
                            Threshold const &threshold, std::string const &planeName, int const npixMin,
-                           bool const setPeaks)
+                           bool const setPeaks, int const nThreads)
         : daf::base::Citizen(typeid(this)),
           _footprints(new FootprintList()),
           _region(lsst::geom::Point2I(maskedImg.getX0(), maskedImg.getY0()),
@@ -818,13 +1011,13 @@ FootprintSet::FootprintSet(const image::MaskedImage<ImagePixelT, MaskPixelT> &ma
             findFootprints<ImagePixelT, MaskPixelT, VariancePixelT, ThresholdPixelLevel_traits>(
                     _footprints.get(), _region, *maskedImg.getImage(), maskedImg.getVariance().get(),
                     threshold.getValue(maskedImg), threshold.getIncludeMultiplier(), threshold.getPolarity(),
-                    npixMin, setPeaks);
+                    npixMin, setPeaks, nThreads);
             break;
         default:
             findFootprints<ImagePixelT, MaskPixelT, VariancePixelT, ThresholdLevel_traits>(
                     _footprints.get(), _region, *maskedImg.getImage(), maskedImg.getVariance().get(),
                     threshold.getValue(maskedImg), threshold.getIncludeMultiplier(), threshold.getPolarity(),
-                    npixMin, setPeaks);
+                    npixMin, setPeaks, nThreads);
             break;
     }
     // Set Mask if requested
@@ -972,13 +1165,15 @@ void FootprintSet::makeSources(afw::table::SourceCatalog &cat) const {
 
 #define INSTANTIATE(PIXEL)                                                                              \
     template FootprintSet::FootprintSet(image::Image<PIXEL> const &, Threshold const &, int const,      \
-                                        bool const);                                                    \
+                                        bool const, int const);                                         \
     template FootprintSet::FootprintSet(image::MaskedImage<PIXEL, image::MaskPixel> const &,            \
-                                        Threshold const &, std::string const &, int const, bool const); \
+                                        Threshold const &, std::string const &, int const, bool const,  \
+                                        int const);                                                     \
     template void FootprintSet::makeHeavy(image::MaskedImage<PIXEL, image::MaskPixel> const &,          \
                                           HeavyFootprintCtrl const *)
 
-template FootprintSet::FootprintSet(image::Mask<image::MaskPixel> const &, Threshold const &, int const);
+template FootprintSet::FootprintSet(image::Mask<image::MaskPixel> const &, Threshold const &, int const,
+                                    int const);
 
 template void FootprintSet::setMask(image::Mask<image::MaskPixel> *, std::string const &);
 template void FootprintSet::setMask(std::shared_ptr<image::Mask<image::MaskPixel>>, std::string const &);
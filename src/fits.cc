@@ -1153,6 +1153,20 @@ void Fits::writeTableScalar(std::size_t row, int col, std::string const &value)
     }
 }
 
+void Fits::writeTableStrings(std::size_t row, int col, std::size_t nRows, std::string const *values) {
+    // As in writeTableScalar, cfitsio finds the end of each string from its null terminator.
+    std::vector<char const *> tmp(nRows);
+    for (std::size_t i = 0; i < nRows; ++i) {
+        tmp[i] = values[i].c_str();
+    }
+    fits_write_col(reinterpret_cast<fitsfile *>(fptr), TSTRING, col + 1, row + 1, 1, nRows,
+                   const_cast<char const **>(tmp.data()), &status);
+    if (behavior & AUTO_CHECK) {
+        LSST_FITS_CHECK_STATUS(*this, boost::format("Writing %d strings at table cell (%d, %d)") % nRows %
+                                              row % col);
+    }
+}
+
 template <typename T>
 void Fits::readTableArray(std::size_t row, int col, int nElements, T *value) {
     int anynul = false;
@@ -1179,6 +1193,25 @@ void Fits::readTableScalar(std::size_t row, int col, std::string &value, bool is
     value = std::string(tmp);
 }
 
+void Fits::readTableStrings(std::size_t row, int col, std::size_t nRows, std::string *values) {
+    int anynul = false;
+    long size = getTableArraySize(col);
+    std::vector<char> buf(nRows * (size + 1), 0);
+    std::vector<char *> tmp(nRows);
+    for (std::size_t i = 0; i < nRows; ++i) {
+        tmp[i] = &buf[i * (size + 1)];
+    }
+    fits_read_col(reinterpret_cast<fitsfile *>(fptr), TSTRING, col + 1, row + 1, 1, nRows, 0, tmp.data(),
+                  &anynul, &status);
+    if (behavior & AUTO_CHECK) {
+        LSST_FITS_CHECK_STATUS(*this, boost::format("Reading %d strings at table cell (%d, %d)") % nRows %
+                                              row % col);
+    }
+    for (std::size_t i = 0; i < nRows; ++i) {
+        values[i] = std::string(tmp[i]);
+    }
+}
+
 long Fits::getTableArraySize(int col) {
     int typecode = 0;
     long result = 0;
@@ -1200,6 +1233,17 @@ long Fits::getTableArraySize(std::size_t row, int col) {
     return result;
 }
 
+std::size_t Fits::getDataOffset() {
+    LONGLONG headStart = 0;
+    LONGLONG dataStart = 0;
+    LONGLONG dataEnd = 0;
+    fits_get_hduaddrll(reinterpret_cast<fitsfile *>(fptr), &headStart, &dataStart, &dataEnd, &status);
+    if (behavior & AUTO_CHECK) {
+        LSST_FITS_CHECK_STATUS(*this, "Looking up the offset of the data unit");
+    }
+    return dataStart;
+}
+
 // ---- Manipulating images ---------------------------------------------------------------------------------
 
 void Fits::createEmpty() {
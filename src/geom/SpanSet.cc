@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <numeric>
 #include "lsst/afw/geom/SpanSet.h"
 #include "lsst/afw/table/io/CatalogVector.h"
 #include "lsst/afw/table/io/InputArchive.h"
@@ -41,36 +42,6 @@ template std::shared_ptr<geom::SpanSet> table::io::PersistableFacade<geom::SpanS
 namespace geom {
 namespace {
 
-/* These classes are used in the erode operator to quickly calculate the
- * contents of the shrunken SpanSet
- */
-
-struct PrimaryRun {
-    int m, y, xmin, xmax;
-};
-
-bool comparePrimaryRun(PrimaryRun const& first, PrimaryRun const& second) {
-    if (first.y != second.y) {
-        return first.y < second.y;
-    } else if (first.m != second.m) {
-        return first.m < second.m;
-    } else {
-        return first.xmin < second.xmin;
-    }
-}
-
-class ComparePrimaryRunY {
-public:
-    bool operator()(PrimaryRun const& pr, int yval) { return pr.y < yval; }
-    bool operator()(int yval, PrimaryRun const& pr) { return yval < pr.y; }
-};
-
-class ComparePrimaryRunM {
-public:
-    bool operator()(PrimaryRun const& pr, int mval) { return pr.m < mval; }
-    bool operator()(int mval, PrimaryRun const& pr) { return mval < pr.m; }
-};
-
 /* Determine if two spans overlap
  *
  * a First Span in comparison
@@ -106,6 +77,237 @@ bool spansContiguous(Span const& a, Span const& b, bool compareY = true) {
                    : false;
 }
 
+/* Find the root of the tree holding element i of a disjoint-set forest, halving the path to it
+ * on the way
+ *
+ * parents the index of the parent of each element; roots are their own parents
+ * i the element to look up
+ */
+std::size_t findRoot(std::vector<std::size_t>& parents, std::size_t i) {
+    while (parents[i] != i) {
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+    }
+    return i;
+}
+
+/* Join the trees holding elements i and j of a disjoint-set forest, keeping the smaller root
+ *
+ * parents the index of the parent of each element; roots are their own parents
+ * i, j the elements whose trees are joined
+ */
+void joinRegions(std::vector<std::size_t>& parents, std::size_t i, std::size_t j) {
+    i = findRoot(parents, i);
+    j = findRoot(parents, j);
+    if (i < j) {
+        parents[j] = i;
+    } else {
+        parents[i] = j;
+    }
+}
+
+/* Return the rows of a Stencil of radius r centered on offset, as one Span for each row
+ */
+std::vector<Span> makeStencilSpans(int r, Stencil s,
+                                   lsst::geom::Point2I const& offset = lsst::geom::Point2I()) {
+    std::vector<Span> tempVec;
+    tempVec.reserve(2 * r + 1);
+    switch (s) {
+        case Stencil::CIRCLE:
+            for (auto dy = -r; dy <= r; ++dy) {
+                int dx = static_cast<int>(sqrt(r * r - dy * dy));
+                tempVec.push_back(Span(dy + offset.getY(), -dx + offset.getX(), dx + offset.getX()));
+            }
+            break;
+        case Stencil::MANHATTAN:
+            for (auto dy = -r; dy <= r; ++dy) {
+                int dx = r - abs(dy);
+                tempVec.push_back(Span(dy + offset.getY(), -dx + offset.getX(), dx + offset.getX()));
+            }
+            break;
+        case Stencil::BOX:
+            for (auto dy = -r; dy <= r; ++dy) {
+                int dx = r;
+                tempVec.push_back(Span(dy + offset.getY(), -dx + offset.getX(), dx + offset.getX()));
+            }
+            break;
+    }
+    return tempVec;
+}
+
+/* The Spans of a sorted, non-empty, vector of Spans, looked up by row
+ */
+class SpanRows {
+public:
+    explicit SpanRows(std::vector<Span> const& spans)
+            : _spans(spans), _minY(spans.front().getY()), _rowStarts(spans.back().getY() - _minY + 2) {
+        std::size_t i = 0;
+        for (std::size_t row = 0; row < _rowStarts.size(); ++row) {
+            while (i < _spans.size() && _spans[i].getY() < _minY + static_cast<int>(row)) {
+                ++i;
+            }
+            _rowStarts[row] = i;
+        }
+    }
+
+    int getMinY() const { return _minY; }
+    int getMaxY() const { return _spans.back().getY(); }
+
+    // Return the first and one past the last Span in row y, which may be outside the SpanSet
+    std::pair<Span const*, Span const*> getRow(int y) const {
+        if (y < getMinY() || y > getMaxY()) {
+            return std::make_pair(nullptr, nullptr);
+        }
+        Span const* const first = _spans.data();
+        return std::make_pair(first + _rowStarts[y - _minY], first + _rowStarts[y - _minY + 1]);
+    }
+
+private:
+    std::vector<Span> const& _spans;
+    int _minY;
+    std::vector<std::size_t> _rowStarts;  // index of the first Span in each row, and one past the last
+};
+
+/* Return the smallest and largest row of a non-empty vector of Spans
+ */
+std::pair<int, int> getRowRange(std::vector<Span> const& spans) {
+    auto const range = std::minmax_element(spans.begin(), spans.end(), [](Span const& a, Span const& b) {
+        return a.getY() < b.getY();
+    });
+    return std::make_pair(range.first->getY(), range.second->getY());
+}
+
+/* Return the Spans of a SpanSet dilated by a structuring element
+ *
+ * Each row of the output is the union of the rows of the input shifted by the Spans of the
+ * structuring element, each of which is a sorted list of intervals.  These lists are merged a row at a
+ * time using a heap, so the output Spans come out in order, already normalized.
+ *
+ * spans the Spans of the SpanSet; they must be sorted and non-empty
+ * stencil the Spans of the structuring element, in any order; must be non-empty
+ */
+std::vector<Span> dilateSpans(std::vector<Span> const& spans, std::vector<Span> const& stencil) {
+    // The next interval from one Span of the structuring element, and the input Spans that follow it
+    struct Cursor {
+        int xmin, xmax;          // the interval
+        Span const* next;        // the input Span that gives the next interval
+        Span const* end;         // one past the last input Span in the row
+        Span const* stencilSpn;  // the Span of the structuring element
+    };
+    auto later = [](Cursor const& a, Cursor const& b) { return a.xmin > b.xmin; };
+
+    SpanRows const rows(spans);
+    auto const stencilRows = getRowRange(stencil);
+    std::vector<Span> tempVec;
+    std::vector<Cursor> heap;
+    heap.reserve(stencil.size());
+
+    for (int y = rows.getMinY() + stencilRows.first; y <= rows.getMaxY() + stencilRows.second; ++y) {
+        heap.clear();
+        for (auto const& stencilSpn : stencil) {
+            auto const row = rows.getRow(y - stencilSpn.getY());
+            if (row.first != row.second) {
+                heap.push_back(Cursor{row.first->getMinX() + stencilSpn.getMinX(),
+                                      row.first->getMaxX() + stencilSpn.getMaxX(), row.first + 1, row.second,
+                                      &stencilSpn});
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), later);
+
+        bool started = false;  // have we started an output Span?
+        int xmin = 0, xmax = 0;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            Cursor& cursor = heap.back();
+            if (started && cursor.xmin <= xmax + 1) {
+                xmax = std::max(xmax, cursor.xmax);
+            } else {
+                if (started) {
+                    tempVec.push_back(Span(y, xmin, xmax));
+                }
+                started = true;
+                xmin = cursor.xmin;
+                xmax = cursor.xmax;
+            }
+
+            if (cursor.next == cursor.end) {
+                heap.pop_back();
+            } else {
+                cursor.xmin = cursor.next->getMinX() + cursor.stencilSpn->getMinX();
+                cursor.xmax = cursor.next->getMaxX() + cursor.stencilSpn->getMaxX();
+                ++cursor.next;
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+        if (started) {
+            tempVec.push_back(Span(y, xmin, xmax));
+        }
+    }
+    return tempVec;
+}
+
+/* Return the Spans of a SpanSet eroded by a structuring element
+ *
+ * A pixel survives if the structuring element centered on it lies within the SpanSet, so each Span of
+ * the structuring element allows a sorted list of intervals in each row of the output: those in which
+ * it fits inside a Span of the input.  The output rows are the intersections of these lists, so they
+ * come out in order, already normalized.
+ *
+ * spans the Spans of the SpanSet; they must be sorted, normalized, and non-empty
+ * stencil the Spans of the structuring element, in any order; must be non-empty
+ */
+std::vector<Span> erodeSpans(std::vector<Span> const& spans, std::vector<Span> const& stencil) {
+    typedef std::vector<std::pair<int, int>> IntervalList;
+
+    SpanRows const rows(spans);
+    auto const stencilRows = getRowRange(stencil);
+    std::vector<Span> tempVec;
+    IntervalList good, candidates, intersection;
+
+    for (int y = rows.getMinY() - stencilRows.first; y <= rows.getMaxY() - stencilRows.second; ++y) {
+        good.clear();
+        for (auto stencilSpn = stencil.begin(); stencilSpn != stencil.end(); ++stencilSpn) {
+            auto const row = rows.getRow(y + stencilSpn->getY());
+            int const width = stencilSpn->getMaxX() - stencilSpn->getMinX();
+            candidates.clear();
+            for (auto spn = row.first; spn != row.second; ++spn) {
+                if (spn->getMaxX() - spn->getMinX() >= width) {
+                    candidates.emplace_back(spn->getMinX() - stencilSpn->getMinX(),
+                                            spn->getMaxX() - stencilSpn->getMaxX());
+                }
+            }
+
+            if (stencilSpn == stencil.begin()) {
+                good.swap(candidates);
+            } else {
+                intersection.clear();
+                auto goodIter = good.begin();
+                auto candidateIter = candidates.begin();
+                while (goodIter != good.end() && candidateIter != candidates.end()) {
+                    int const start = std::max(goodIter->first, candidateIter->first);
+                    int const end = std::min(goodIter->second, candidateIter->second);
+                    if (end >= start) {
+                        intersection.emplace_back(start, end);
+                    }
+                    if (goodIter->second < candidateIter->second) {
+                        ++goodIter;
+                    } else {
+                        ++candidateIter;
+                    }
+                }
+                good.swap(intersection);
+            }
+            if (good.empty()) {
+                break;
+            }
+        }
+        for (auto const& run : good) {
+            tempVec.push_back(Span(y, run.first, run.second));
+        }
+    }
+    return tempVec;
+}
+
 /* Determine the intersection with a mask or its logical inverse
  *
  * spanSet - SpanSet object with which to intersect the mask
@@ -286,116 +488,129 @@ std::size_t SpanSet::getArea() const { return _area; }
 // Getter for the bounding box of the SpanSet
 lsst::geom::Box2I SpanSet::getBBox() const { return _bbox; }
 
-/* Here is a description of how the _makeLabels and _label function works. In the
-   _makeLabels function, a vector is created with the same number of elements as
-   spans in the SpanSet. This vector will contain the label for each Span in the
-   SpanSet. These labels correspond to which connected region the span falls in.
-   If the whole SpanSet is connected than there will only be one region and every
-   Span will be labeled with a 1. If there are two regions (i.e. there are points
-   in between not contained in the SpanSet) then Some of the Spans will be labeled
-   1, and the rest labeled 2. _makeLabels also sorts each of the Spans in the
-   current span into an unordered map that is indexed by the y position of each
-   span. This allows efficient lookups of corresponding rows.
-
-   The function loops over all the Spans in the Spanset. If the Span has not been
-   labeled, the _label function is called, with the current span, the vector
-   containing the labels, the label for the current region under consideration,
-   and the indexed map of Spans.
-
-   The _label function will then loop over all Spans in the SpanSet looking for
-   rows adjacent to the currently being labeled Span which overlap in the x
-   dimension and have not yet been labeled, and mark them with the current label,
-   and recursively call the _label function with the adjacent row as the new Span
-   under consideration. This results in all Spans which overlap each other in x
-   being labeled with the current label.
-
-   Once _label reaches the end of Spans which meet it's criteria, control falls
-   back to the _makeLabels function and the current label is incremented. The
-   function then moves onto the next Span in the SpanSet which has not been
-   labeled. If all spans were labeled in the recursive call the loop falls to the
-   end, and the label vector and one past the last label number (number of labels +1)
-   are returned to the caller. If instead _makeLabels finds a Span that has not
-   been labeled, the next label is assigned and the process is repeated until
-   all Spans have been labeled.
+/* Here is a description of how the _makeLabels function works. Each Span in the
+   SpanSet is labeled with the connected region it falls in. If the whole SpanSet
+   is connected there will be only one region and every Span will be labeled 1. If
+   there are two regions (i.e. there are points in between not contained in the
+   SpanSet) some of the Spans will be labeled 1, and the rest labeled 2.
+
+   The regions are found with a disjoint-set forest, stored in the vector that will
+   hold the labels: each element holds the index of another Span in the same region,
+   and following these links always leads to the region's first Span (its root).
+
+   The Spans are swept through a row at a time, in sorted order (which is the order
+   they're stored in, unless the SpanSet was built without normalizing). As rows are
+   sorted by x, a single pass over each pair of adjacent rows finds all the Spans
+   that overlap in x, and their regions are joined. Each Span is visited a fixed
+   number of times, so the whole labeling takes time linear in the number of Spans
+   (plus a sort if the Spans are out of order).
+
+   Finally the roots are numbered 1, 2, ... in the order of their Spans, and every
+   Span is given the number of its root.
+
+   If stopIfDisjoint is true, the sweep gives up as soon as it finds a second region:
+   a row of the SpanSet that is empty, or a region that doesn't reach the row after
+   its last one. The labels are then meaningless, and the count returned is 2.
  */
+std::size_t SpanSet::_makeLabels(std::vector<std::size_t>& labels, bool stopIfDisjoint) const {
+    std::size_t const nSpans = _spanVector.size();
+    // Start with each Span as the root of its own region
+    labels.resize(nSpans);
+    std::iota(labels.begin(), labels.end(), 0);
+
+    // Visit the Spans in sorted order
+    std::vector<std::size_t> order;
+    bool const isSorted = std::is_sorted(_spanVector.begin(), _spanVector.end());
+    if (!isSorted) {
+        order.resize(nSpans);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(),
+                  [this](std::size_t a, std::size_t b) { return _spanVector[a] < _spanVector[b]; });
+    }
+    auto getIndex = [isSorted, &order](std::size_t k) { return isSorted ? k : order[k]; };
+    auto getSpan = [this, &getIndex](std::size_t k) -> Span const& { return _spanVector[getIndex(k)]; };
 
-void SpanSet::_label(
-        Span const& spn, std::vector<std::size_t>& labelVector, std::size_t currentLabel,
-        std::unordered_map<int, std::vector<std::pair<std::size_t, const Span*>>>& sortMap) const {
-    auto currentIndex = spn.getY();
-    if (currentIndex > 0) {
-        // loop over the prevous row
-        for (auto const& tup : sortMap[currentIndex - 1]) {
-            if (!labelVector[tup.first] && spansOverlap(spn, *(tup.second), false)) {
-                labelVector[tup.first] = currentLabel;
-                _label(*(tup.second), labelVector, currentLabel, sortMap);
+    // Is each root the root of a Span in the current row?  Only used if stopIfDisjoint
+    std::vector<char> inRow(stopIfDisjoint ? nSpans : 0, 0);
+
+    std::size_t prevBegin = 0;  // the Spans in the previous row are [prevBegin, prevEnd) in sorted order
+    std::size_t prevEnd = 0;
+    for (std::size_t rowBegin = 0, rowEnd = 0; rowBegin < nSpans; rowBegin = rowEnd) {
+        int const y = getSpan(rowBegin).getY();
+        for (rowEnd = rowBegin + 1; rowEnd < nSpans && getSpan(rowEnd).getY() == y; ++rowEnd) {
+        }
+        if (prevBegin < prevEnd && getSpan(prevBegin).getY() != y - 1) {
+            // There's a gap between the rows
+            if (stopIfDisjoint) {
+                return 2;
             }
+            prevBegin = prevEnd;
         }
-    }
-    if (currentIndex <= _spanVector.back().getY() - 1) {
-        // loop over the next row
-        for (auto& tup : sortMap[currentIndex + 1]) {
-            if (!labelVector[tup.first] && spansOverlap(spn, *(tup.second), false)) {
-                labelVector[tup.first] = currentLabel;
-                _label(*(tup.second), labelVector, currentLabel, sortMap);
+
+        std::size_t first = prevBegin;  // first Span in the previous row that can overlap the current Span
+        for (std::size_t k = rowBegin; k < rowEnd; ++k) {
+            Span const& spn = getSpan(k);
+            while (first < prevEnd && getSpan(first).getMaxX() < spn.getMinX()) {
+                ++first;
+            }
+            for (std::size_t q = first; q < prevEnd && getSpan(q).getMinX() <= spn.getMaxX(); ++q) {
+                if (spansOverlap(spn, getSpan(q), false)) {
+                    joinRegions(labels, getIndex(q), getIndex(k));
+                }
+            }
+        }
+
+        if (stopIfDisjoint) {
+            // Every region in the previous row must carry on into this one
+            for (std::size_t k = rowBegin; k < rowEnd; ++k) {
+                inRow[findRoot(labels, getIndex(k))] = 1;
+            }
+            for (std::size_t q = prevBegin; q < prevEnd; ++q) {
+                if (!inRow[findRoot(labels, getIndex(q))]) {
+                    return 2;
+                }
+            }
+            for (std::size_t k = rowBegin; k < rowEnd; ++k) {
+                inRow[findRoot(labels, getIndex(k))] = 0;
             }
         }
+
+        prevBegin = rowBegin;
+        prevEnd = rowEnd;
     }
-}
 
-std::pair<std::vector<std::size_t>, std::size_t> SpanSet::_makeLabels() const {
-    std::vector<std::size_t> labelVector(_spanVector.size(), 0);
-    std::size_t currentLabel = 1;
-    std::size_t index = 0;
-    // Create a sorted array of arrays
-    std::unordered_map<int, std::vector<std::pair<std::size_t, const Span*>>> sortMap;
-    std::size_t tempIndex = 0;
-    for (auto const& spn : _spanVector) {
-        sortMap[spn.getY()].push_back(std::make_pair(tempIndex, &spn));
-        tempIndex++;
+    // Replace the links by the labels; a region's root is its first Span, so its label is set
+    // before those of the region's other Spans are looked up
+    for (std::size_t i = 0; i < nSpans; ++i) {
+        labels[i] = findRoot(labels, i);
     }
-    for (auto const& currentSpan : _spanVector) {
-        if (!labelVector[index]) {
-            labelVector[index] = currentLabel;
-            _label(currentSpan, labelVector, currentLabel, sortMap);
-            /* At this point we have recursed enough to reach all of the connected
-             * region, and should increment the label such that any spans not
-             * labeled in the first loop will get a new value. If all of the spans
-             * were connected in the first pass, the rest of this loop will just
-             * fall though.
-             */
-            ++currentLabel;
-        }
-        ++index;
+    std::size_t nLabels = 0;
+    for (std::size_t i = 0; i < nSpans; ++i) {
+        labels[i] = (labels[i] == i) ? ++nLabels : labels[labels[i]];
     }
-    return std::pair<std::vector<std::size_t>, std::size_t>(labelVector, currentLabel);
+    return nLabels;
 }
 
 bool SpanSet::isContiguous() const {
-    auto labeledPair = _makeLabels();
-    // Here we want to check if there is only one label. Since _makeLabels always increments
-    // at the end of each loop, we need to compare against the number 2. I.e. if everything
-    // gets labeled 1, the label counter will increment to 2, and the if statement will always
-    // be false and _makeLabels will fall through to the end and return to here.
-    return labeledPair.second <= 2;
+    std::vector<std::size_t> labels;
+    return _makeLabels(labels, true) <= 1;
 }
 
 std::vector<std::shared_ptr<SpanSet>> SpanSet::split() const {
-    auto labeledPair = _makeLabels();
-    auto labels = labeledPair.first;
-    auto numberOfLabels = labeledPair.second;
+    std::vector<std::size_t> labels;
+    std::size_t const numberOfLabels = _makeLabels(labels);
     std::vector<std::shared_ptr<SpanSet>> subRegions;
-    // As the number of labels is known, the number of SpanSets to be created is also known
-    // make a vector of vectors to hold the Spans which will correspond to each SpanSet
-    std::vector<std::vector<Span>> subSpanLists(numberOfLabels - 1);
 
-    // if numberOfLabels is 1, that means a null SpanSet is being operated on,
+    // if numberOfLabels is 0, that means a null SpanSet is being operated on,
     // and we should return like
-    if (numberOfLabels == 1) {
+    if (numberOfLabels == 0) {
         subRegions.push_back(std::make_shared<SpanSet>());
         return subRegions;
     }
-    subRegions.reserve(numberOfLabels - 1);
+    // As the number of labels is known, the number of SpanSets to be created is also known
+    // make a vector of vectors to hold the Spans which will correspond to each SpanSet
+    std::vector<std::vector<Span>> subSpanLists(numberOfLabels);
+    subRegions.reserve(numberOfLabels);
 
     // loop over the current SpanSet's spans sorting each of the spans according to the label
     // that was assigned
@@ -403,8 +618,8 @@ std::vector<std::shared_ptr<SpanSet>> SpanSet::split() const {
         subSpanLists[labels[i] - 1].push_back(_spanVector[i]);
     }
     // Transform each of the vectors of Spans into a SpanSet
-    for (std::size_t i = 0; i < numberOfLabels - 1; ++i) {
-        subRegions.push_back(std::make_shared<SpanSet>(subSpanLists[i]));
+    for (std::size_t i = 0; i < numberOfLabels; ++i) {
+        subRegions.push_back(std::make_shared<SpanSet>(std::move(subSpanLists[i])));
     }
     return subRegions;
 }
@@ -543,38 +758,42 @@ ellipses::Quadrupole SpanSet::computeShape() const {
 }
 
 std::shared_ptr<SpanSet> SpanSet::dilated(int r, Stencil s) const {
-    // Return a dilated SpanSet made with the given stencil, by creating a SpanSet
-    // from the stencil and forwarding to the appropriate overloaded method
-    std::shared_ptr<SpanSet> stencilToSpanSet = fromShape(r, s);
-    return dilated(*stencilToSpanSet);
+    // Return a dilated SpanSet made with the given stencil, by breaking the stencil
+    // into its rows and forwarding to the same code as the SpanSet overload
+    std::vector<Span> const stencilSpans = makeStencilSpans(r, s);
+    if (stencilSpans.empty() || this->size() == 0) {
+        return std::make_shared<SpanSet>(_spanVector.begin(), _spanVector.end(), false);
+    }
+    return _dilated(stencilSpans);
 }
 
 std::shared_ptr<SpanSet> SpanSet::dilated(SpanSet const& other) const {
     // Handle a null SpanSet nothing should be dilated
-    if (other.size() == 0) {
+    if (other.size() == 0 || this->size() == 0) {
         return std::make_shared<SpanSet>(_spanVector.begin(), _spanVector.end(), false);
     }
+    return _dilated(other._spanVector);
+}
 
-    // Return a dilated Spanset by the given SpanSet
-    std::vector<Span> tempVec;
-
-    for (auto const& spn : _spanVector) {
-        for (auto const& otherSpn : other) {
-            int const xmin = spn.getMinX() + otherSpn.getMinX();
-            int const xmax = spn.getMaxX() + otherSpn.getMaxX();
-            int const yval = spn.getY() + otherSpn.getY();
-            tempVec.push_back(Span(yval, xmin, xmax));
-        }
+std::shared_ptr<SpanSet> SpanSet::_dilated(std::vector<Span> const& stencil) const {
+    // The merge relies on the Spans being sorted, which they only might not be if the
+    // SpanSet was constructed without normalizing
+    if (!std::is_sorted(_spanVector.begin(), _spanVector.end())) {
+        std::vector<Span> sorted(_spanVector);
+        std::sort(sorted.begin(), sorted.end());
+        return std::make_shared<SpanSet>(dilateSpans(sorted, stencil), false);
     }
-    // Allow constructor to handle merging adjacent and overlapping spans
-    return std::make_shared<SpanSet>(std::move(tempVec));
+    return std::make_shared<SpanSet>(dilateSpans(_spanVector, stencil), false);
 }
 
 std::shared_ptr<SpanSet> SpanSet::eroded(int r, Stencil s) const {
-    // Return an eroded SpanSet made with the given stencil, by creating a SpanSet
-    // from the stencil and forwarding to the appropriate overloaded method
-    std::shared_ptr<SpanSet> stencilToSpanSet = fromShape(r, s);
-    return eroded(*stencilToSpanSet);
+    // Return an eroded SpanSet made with the given stencil, by breaking the stencil
+    // into its rows and forwarding to the same code as the SpanSet overload
+    std::vector<Span> const stencilSpans = makeStencilSpans(r, s);
+    if (stencilSpans.empty() || this->size() == 0) {
+        return std::make_shared<SpanSet>(_spanVector.begin(), _spanVector.end(), false);
+    }
+    return _eroded(stencilSpans);
 }
 
 std::shared_ptr<SpanSet> SpanSet::eroded(SpanSet const& other) const {
@@ -582,98 +801,22 @@ std::shared_ptr<SpanSet> SpanSet::eroded(SpanSet const& other) const {
     if (other.size() == 0 || this->size() == 0) {
         return std::make_shared<SpanSet>(_spanVector.begin(), _spanVector.end(), false);
     }
+    return _eroded(other._spanVector);
+}
 
-    // Return a SpanSet eroded by the given SpanSet
-    std::vector<Span> tempVec;
-
-    // Calculate all possible primary runs.
-    std::vector<PrimaryRun> primaryRuns;
-    for (auto const& spn : _spanVector) {
-        int m = 0;
-        for (auto const& otherSpn : other) {
-            if ((otherSpn.getMaxX() - otherSpn.getMinX()) <= (spn.getMaxX() - spn.getMinX())) {
-                int xmin = spn.getMinX() - otherSpn.getMinX();
-                int xmax = spn.getMaxX() - otherSpn.getMaxX();
-                int y = spn.getY() - otherSpn.getY();
-                primaryRuns.push_back(PrimaryRun({m, y, xmin, xmax}));
-            }
-            ++m;
-        }
-    }
-
-    // Iterate over the primary runs in such a way that we consider all values of m
-    // for a given y, then all m for y+1 etc.
-    std::sort(primaryRuns.begin(), primaryRuns.end(), comparePrimaryRun);
-
-    for (int y = primaryRuns.front().y; y <= primaryRuns.back().y; ++y) {
-        auto yRange = std::equal_range(primaryRuns.begin(), primaryRuns.end(), y, ComparePrimaryRunY());
-
-        /* Discard runs for any value of y for which we find fewer groups than M,
-         * the total Y range of the structuring element. This is step 3.1 of the
-         * Kim et al. algorithm.
-         */
-        // Plus one because end points are inclusive
-        auto otherYRange = other.back().getY() - other.front().getY() + 1;
-        if (std::distance(yRange.first, yRange.second) < otherYRange) {
-            continue;
-        }
-
-        /* "good" runs are those which are covered by each value of m, ie by each
-         * row in the structuring element. Our algorithm will consider each value
-         * of m in turn, gradually whittling down the list of good runs, then
-         * finally convert the remainder into Spans.
-         */
-        std::list<PrimaryRun> goodRuns;
-
-        for (int m = 0; m < otherYRange; ++m) {
-            auto mRange = std::equal_range(yRange.first, yRange.second, m, ComparePrimaryRunM());
-            if ((mRange.first == mRange.second)) {
-                // If a particular m is missing, we known that this y contains
-                // no good runs; this is equivalent to Kim et al. step 3.2.
-                goodRuns.clear();
-            } else {
-                // Consolidate all primary runs at this m so that they don't overlap.
-                std::list<PrimaryRun> candidateRuns;
-                int startX = mRange.first->xmin;
-                int endX = mRange.first->xmax;
-                for (auto run = mRange.first + 1; run != mRange.second; ++run) {
-                    if (run->xmin > endX) {
-                        // Start of a new run
-                        candidateRuns.push_back(PrimaryRun{m, y, startX, endX});
-                        startX = run->xmin;
-                        endX = run->xmax;
-                    } else {
-                        // Continuation of an existing run
-                        endX = run->xmax;
-                    }
-                }
-                candidateRuns.push_back(PrimaryRun{m, y, startX, endX});
-
-                // Otherwise, calculate the intersection of candidate runs at
-                // this m with good runs from all previous m.
-                if (m == 0) {
-                    // For m = 0 we have nothing to compare to; all runs are accepted
-                    std::swap(goodRuns, candidateRuns);
-                } else {
-                    std::list<PrimaryRun> newlist;
-                    for (auto& good : goodRuns) {
-                        for (auto& cand : candidateRuns) {
-                            int start = std::max(good.xmin, cand.xmin);
-                            int end = std::min(good.xmax, cand.xmax);
-                            if (end >= start) {
-                                newlist.push_back(PrimaryRun({m, y, start, end}));
-                            }
-                        }
-                    }
-                    std::swap(newlist, goodRuns);
-                }
-            }
-        }
-        for (auto& run : goodRuns) {
-            tempVec.push_back(Span(run.y, run.xmin, run.xmax));
-        }
+std::shared_ptr<SpanSet> SpanSet::_eroded(std::vector<Span> const& stencil) const {
+    // The intersections rely on the Spans being sorted and not touching, which they only might
+    // not be if the SpanSet was constructed without normalizing
+    auto const unmerged = std::adjacent_find(_spanVector.begin(), _spanVector.end(),
+                                             [](Span const& a, Span const& b) {
+                                                 return b < a || (a.getY() == b.getY() &&
+                                                                  b.getMinX() <= a.getMaxX() + 1);
+                                             });
+    if (unmerged != _spanVector.end()) {
+        SpanSet const normalized(_spanVector);
+        return std::make_shared<SpanSet>(erodeSpans(normalized._spanVector, stencil), false);
     }
-    return std::make_shared<SpanSet>(std::move(tempVec));
+    return std::make_shared<SpanSet>(erodeSpans(_spanVector, stencil), false);
 }
 
 bool SpanSet::operator==(SpanSet const& other) const {
@@ -688,29 +831,7 @@ bool SpanSet::operator!=(SpanSet const& other) const {
 
 std::shared_ptr<SpanSet> SpanSet::fromShape(int r, Stencil s, lsst::geom::Point2I offset) {
     // Create a SpanSet from a given Stencil
-    std::vector<Span> tempVec;
-    tempVec.reserve(2 * r + 1);
-    switch (s) {
-        case Stencil::CIRCLE:
-            for (auto dy = -r; dy <= r; ++dy) {
-                int dx = static_cast<int>(sqrt(r * r - dy * dy));
-                tempVec.push_back(Span(dy + offset.getY(), -dx + offset.getX(), dx + offset.getX()));
-            }
-            break;
-        case Stencil::MANHATTAN:
-            for (auto dy = -r; dy <= r; ++dy) {
-                int dx = r - abs(dy);
-                tempVec.push_back(Span(dy + offset.getY(), -dx + offset.getX(), dx + offset.getX()));
-            }
-            break;
-        case Stencil::BOX:
-            for (auto dy = -r; dy <= r; ++dy) {
-                int dx = r;
-                tempVec.push_back(Span(dy + offset.getY(), -dx + offset.getX(), dx + offset.getX()));
-            }
-            break;
-    }
-    return std::make_shared<SpanSet>(std::move(tempVec), false);
+    return std::make_shared<SpanSet>(makeStencilSpans(r, s, offset), false);
 }
 
 std::shared_ptr<SpanSet> SpanSet::fromShape(ellipses::Ellipse const& ellipse) {
@@ -20,6 +20,7 @@
  * see <http://www.lsstcorp.org/LegalNotices/>.
  */
 
+#include <algorithm>
 #include <exception>
 #include <memory>
 #include <ostream>
@@ -40,6 +41,63 @@
 namespace lsst {
 namespace afw {
 namespace geom {
+namespace {
+
+/*
+ * Check the arguments of Transform::applyForwardGrid or applyInverseGrid
+ * and set `in` to the points of the grid
+ *
+ * @param[in] nInAxes, nOutAxes  number of input and output axes of the mapping
+ * @param[in] start, step, count  description of the grid, as for applyForwardGrid
+ * @param[out] in  array to which to write the grid points
+ * @param[in] out  array that is to receive the transformed points; only its shape is checked
+ */
+void fillGrid(int nInAxes, int nOutAxes, std::vector<double> const &start, std::vector<double> const &step,
+              std::vector<int> const &count, ndarray::Array<double, 2, 2> const &in,
+              ndarray::Array<double, 2, 2> const &out) {
+    if (static_cast<int>(start.size()) != nInAxes || static_cast<int>(step.size()) != nInAxes ||
+        static_cast<int>(count.size()) != nInAxes) {
+        std::ostringstream os;
+        os << "start, step and count have " << start.size() << ", " << step.size() << " and "
+           << count.size() << " elements; each must have " << nInAxes;
+        throw LSST_EXCEPT(pex::exceptions::InvalidParameterError, os.str());
+    }
+    std::size_t nPoints = 1;
+    for (int axis = 0; axis < nInAxes; ++axis) {
+        if (count[axis] < 0) {
+            std::ostringstream os;
+            os << "count[" << axis << "] = " << count[axis] << " < 0";
+            throw LSST_EXCEPT(pex::exceptions::InvalidParameterError, os.str());
+        }
+        nPoints *= count[axis];
+    }
+    if (in.getSize<0>() != static_cast<std::size_t>(nInAxes) || in.getSize<1>() != nPoints ||
+        out.getSize<0>() != static_cast<std::size_t>(nOutAxes) || out.getSize<1>() != nPoints) {
+        std::ostringstream os;
+        os << "input and output arrays have shapes (" << in.getSize<0>() << ", " << in.getSize<1>()
+           << ") and (" << out.getSize<0>() << ", " << out.getSize<1>() << "); expected (" << nInAxes
+           << ", " << nPoints << ") and (" << nOutAxes << ", " << nPoints << ")";
+        throw LSST_EXCEPT(pex::exceptions::InvalidParameterError, os.str());
+    }
+
+    // stride = number of consecutive points that share the same value on this axis
+    std::size_t stride = 1;
+    for (int axis = 0; axis < nInAxes; ++axis) {
+        double *const axisData = in[axis].getData();
+        std::size_t const blockSize = stride * count[axis];
+        for (std::size_t blockStart = 0; blockStart < nPoints; blockStart += blockSize) {
+            double *pointData = axisData + blockStart;
+            for (int j = 0; j < count[axis]; ++j) {
+                double const value = start[axis] + j * step[axis];
+                std::fill(pointData, pointData + stride, value);
+                pointData += stride;
+            }
+        }
+        stride = blockSize;
+    }
+}
+
+}  // namespace
 
 template <class FromEndpoint, class ToEndpoint>
 Transform<FromEndpoint, ToEndpoint>::Transform(ast::Mapping const &mapping, bool simplify)
@@ -91,6 +149,18 @@ typename ToEndpoint::Array Transform<FromEndpoint, ToEndpoint>::applyForward(
     return _toEndpoint.arrayFromData(rawToData);
 }
 
+template <class FromEndpoint, class ToEndpoint>
+void Transform<FromEndpoint, ToEndpoint>::applyForwardGrid(std::vector<double> const &start,
+                                                           std::vector<double> const &step,
+                                                           std::vector<int> const &count,
+                                                           ndarray::Array<double, 2, 2> const &from,
+                                                           ndarray::Array<double, 2, 2> const &to) const {
+    fillGrid(_fromEndpoint.getNAxes(), _toEndpoint.getNAxes(), start, step, count, from, to);
+    if (from.getSize<1>() > 0) {
+        _mapping->applyForward(from, to);
+    }
+}
+
 template <class FromEndpoint, class ToEndpoint>
 typename FromEndpoint::Point Transform<FromEndpoint, ToEndpoint>::applyInverse(
         typename ToEndpoint::Point const &point) const {
@@ -107,6 +177,18 @@ typename FromEndpoint::Array Transform<FromEndpoint, ToEndpoint>::applyInverse(
     return _fromEndpoint.arrayFromData(rawToData);
 }
 
+template <class FromEndpoint, class ToEndpoint>
+void Transform<FromEndpoint, ToEndpoint>::applyInverseGrid(std::vector<double> const &start,
+                                                           std::vector<double> const &step,
+                                                           std::vector<int> const &count,
+                                                           ndarray::Array<double, 2, 2> const &to,
+                                                           ndarray::Array<double, 2, 2> const &from) const {
+    fillGrid(_toEndpoint.getNAxes(), _fromEndpoint.getNAxes(), start, step, count, to, from);
+    if (to.getSize<1>() > 0) {
+        _mapping->applyInverse(to, from);
+    }
+}
+
 template <class FromEndpoint, class ToEndpoint>
 std::shared_ptr<Transform<ToEndpoint, FromEndpoint>> Transform<FromEndpoint, ToEndpoint>::inverted() const {
     auto inverse = std::dynamic_pointer_cast<ast::Mapping>(_mapping->inverted());
@@ -25,6 +25,7 @@
 /*
  * Background estimation class code
  */
+#include <algorithm>
 #include <iostream>
 #include <limits>
 #include <vector>
@@ -34,6 +35,7 @@
 #include "lsst/afw/math/Approximate.h"
 #include "lsst/afw/math/Background.h"
 #include "lsst/afw/math/Statistics.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace lsst {
 namespace ex = pex::exceptions;
@@ -75,14 +77,57 @@ void cullNan(std::vector<double> const& values, std::vector<double> const& refs,
         }
     }
 }
+
+//@{
+/*
+ * Compute the statistics of every cell of the grid in a single pass over the image, if the
+ * image type, statistic and StatisticsControl allow it (see makeGridStatistics)
+ *
+ * Returns true iff the statistics were computed (and stored in `stats`)
+ */
+template <typename ImageT>
+bool tryGridStatistics(ImageT const&, std::vector<int> const&, std::vector<int> const&,
+                       std::vector<int> const&, std::vector<int> const&, int const, StatisticsControl const&,
+                       std::vector<Statistics>&) {
+    return false;
+}
+
+template <typename ImageT>
+bool tryFloatGridStatistics(ImageT const& img, std::vector<int> const& xorig, std::vector<int> const& xsize,
+                            std::vector<int> const& yorig, std::vector<int> const& ysize, int const flags,
+                            StatisticsControl const& sctrl, std::vector<Statistics>& stats) {
+    if (!canMakeGridStatistics(flags, sctrl)) {
+        return false;
+    }
+    stats = makeGridStatistics(img, xorig, xsize, yorig, ysize, flags, sctrl);
+    return true;
+}
+
+bool tryGridStatistics(image::Image<float> const& img, std::vector<int> const& xorig,
+                       std::vector<int> const& xsize, std::vector<int> const& yorig,
+                       std::vector<int> const& ysize, int const flags, StatisticsControl const& sctrl,
+                       std::vector<Statistics>& stats) {
+    return tryFloatGridStatistics(img, xorig, xsize, yorig, ysize, flags, sctrl, stats);
+}
+
+bool tryGridStatistics(image::MaskedImage<float> const& img, std::vector<int> const& xorig,
+                       std::vector<int> const& xsize, std::vector<int> const& yorig,
+                       std::vector<int> const& ysize, int const flags, StatisticsControl const& sctrl,
+                       std::vector<Statistics>& stats) {
+    return tryFloatGridStatistics(img, xorig, xsize, yorig, ysize, flags, sctrl, stats);
+}
+//@}
 }  // namespace
 
 template <typename ImageT>
 BackgroundMI::BackgroundMI(ImageT const& img, BackgroundControl const& bgCtrl)
-        : Background(img, bgCtrl), _statsImage(image::MaskedImage<InternalPixelT>()) {
+        : Background(img, bgCtrl),
+          _statsImage(image::MaskedImage<InternalPixelT>()),
+          _cachedInterpStyle(Interpolate::UNKNOWN),
+          _cachedUndersampleStyle(THROW_EXCEPTION) {
     // =============================================================
-    // Loop over the cells in the image, computing statistical properties
-    // of each cell in turn and using them to set _statsImage
+    // Compute statistical properties of each cell in the image
+    // and use them to set _statsImage
     int const nxSample = bgCtrl.getNxSample();
     int const nySample = bgCtrl.getNySample();
     _statsImage = image::MaskedImage<InternalPixelT>(nxSample, nySample);
@@ -90,28 +135,46 @@ BackgroundMI::BackgroundMI(ImageT const& img, BackgroundControl const& bgCtrl)
     image::MaskedImage<InternalPixelT>::Image& im = *_statsImage.getImage();
     image::MaskedImage<InternalPixelT>::Variance& var = *_statsImage.getVariance();
 
-    for (int iX = 0; iX < nxSample; ++iX) {
+    int const flags = bgCtrl.getStatisticsProperty() | ERRORS;
+    StatisticsControl const& sctrl = *bgCtrl.getStatisticsControl();
+
+    // If the statistic can be computed in a single pass, do all the cells at once, a row at a time
+    std::vector<Statistics> gridStats;
+    if (tryGridStatistics(img, _xorig, _xsize, _yorig, _ysize, flags, sctrl, gridStats)) {
         for (int iY = 0; iY < nySample; ++iY) {
-            ImageT subimg = ImageT(img,
-                                   lsst::geom::Box2I(lsst::geom::Point2I(_xorig[iX], _yorig[iY]),
-                                                     lsst::geom::Extent2I(_xsize[iX], _ysize[iY])),
-                                   image::LOCAL);
-
-            std::pair<double, double> res = makeStatistics(subimg, bgCtrl.getStatisticsProperty() | ERRORS,
-                                                           *bgCtrl.getStatisticsControl())
-                                                    .getResult();
-            im(iX, iY) = res.first;
-            var(iX, iY) = res.second;
+            for (int iX = 0; iX < nxSample; ++iX) {
+                std::pair<double, double> res = gridStats[iY * nxSample + iX].getResult();
+                im(iX, iY) = res.first;
+                var(iX, iY) = res.second;
+            }
         }
+        return;
     }
+
+    // Otherwise process the cells independently, in parallel; each writes only its own pixel
+    // of _statsImage, so the results do not depend on the number of threads
+    detail::parallelFor(nxSample * nySample, sctrl.getNThreads(), [&](int cell, int) {
+        int const iX = cell % nxSample;
+        int const iY = cell / nxSample;
+        ImageT subimg = ImageT(img,
+                               lsst::geom::Box2I(lsst::geom::Point2I(_xorig[iX], _yorig[iY]),
+                                                 lsst::geom::Extent2I(_xsize[iX], _ysize[iY])),
+                               image::LOCAL);
+
+        std::pair<double, double> res = makeStatistics(subimg, flags, sctrl).getResult();
+        im(iX, iY) = res.first;
+        var(iX, iY) = res.second;
+    });
 }
 BackgroundMI::BackgroundMI(lsst::geom::Box2I const imageBBox,
                            image::MaskedImage<InternalPixelT> const& statsImage)
-        : Background(imageBBox, statsImage.getWidth(), statsImage.getHeight()), _statsImage(statsImage) {}
+        : Background(imageBBox, statsImage.getWidth(), statsImage.getHeight()),
+          _statsImage(statsImage),
+          _cachedInterpStyle(Interpolate::UNKNOWN),
+          _cachedUndersampleStyle(THROW_EXCEPTION) {}
 
 void BackgroundMI::_setGridColumns(Interpolate::Style const interpStyle,
-                                   UndersampleStyle const undersampleStyle, int const iX,
-                                   std::vector<int> const& ypix) const {
+                                   UndersampleStyle const undersampleStyle, int const iX) const {
     image::MaskedImage<InternalPixelT>::Image& im = *_statsImage.getImage();
 
     int const height = _imgBBox.getHeight();
@@ -144,7 +207,7 @@ void BackgroundMI::_setGridColumns(Interpolate::Style const interpStyle,
                     intobj = makeInterpolate(ycenTmp, gridTmp, Interpolate::CONSTANT);
                     break;
                 } else {
-                    return _setGridColumns(lookupMaxInterpStyle(gridTmp.size()), undersampleStyle, iX, ypix);
+                    return _setGridColumns(lookupMaxInterpStyle(gridTmp.size()), undersampleStyle, iX);
                 }
             }
             case INCREASE_NXNYSAMPLE:
@@ -162,9 +225,101 @@ void BackgroundMI::_setGridColumns(Interpolate::Style const interpStyle,
         throw;
     }
 
-    for (int iY = 0; iY < height; ++iY) {
-        _gridColumns[iX][iY] = intobj->interpolate(ypix[iY]);
+    intobj->interpolateRange(0, height, _gridColumns[iX].data());
+}
+
+void BackgroundMI::_setInterpolation(Interpolate::Style const interpStyle,
+                                     UndersampleStyle const undersampleStyle) const {
+    image::MaskedImage<InternalPixelT>::Image const& im = *_statsImage.getImage();
+    int const nxSample = im.getWidth();
+    int const nySample = im.getHeight();
+
+    // The statsImage may have been modified (e.g. to replace NaNs) since we last interpolated it
+    bool statsUnchanged = (_cachedStatsValues.size() == static_cast<std::size_t>(nxSample * nySample));
+    for (int iY = 0; statsUnchanged && iY < nySample; ++iY) {
+        statsUnchanged = std::equal(im.row_begin(iY), im.row_end(iY),
+                                    _cachedStatsValues.begin() + iY * nxSample,
+                                    [](InternalPixelT a, InternalPixelT b) {
+                                        return a == b || (std::isnan(a) && std::isnan(b));
+                                    });
+    }
+    if (statsUnchanged && interpStyle == _cachedInterpStyle && undersampleStyle == _cachedUndersampleStyle) {
+        return;
+    }
+
+    _cachedInterpStyle = Interpolate::UNKNOWN;  // in case we fail
+    _cachedStatsValues.resize(nxSample * nySample);
+    for (int iY = 0; iY < nySample; ++iY) {
+        std::copy(im.row_begin(iY), im.row_end(iY), _cachedStatsValues.begin() + iY * nxSample);
+    }
+
+    _gridColumns.resize(_imgBBox.getWidth());
+    for (int iX = 0; iX < nxSample; ++iX) {
+        _setGridColumns(interpStyle, undersampleStyle, iX);
+    }
+    _rowInterpolates.assign(_imgBBox.getHeight(), nullptr);
+
+    _cachedInterpStyle = interpStyle;
+    _cachedUndersampleStyle = undersampleStyle;
+}
+
+Interpolate const& BackgroundMI::_getRowInterpolate(int const iY) const {
+    if (_rowInterpolates[iY]) {
+        return *_rowInterpolates[iY];
+    }
+    Interpolate::Style const interpStyle = _cachedInterpStyle;
+    UndersampleStyle const undersampleStyle = _cachedUndersampleStyle;
+
+    // N.b. There's no API to set defaultValue to other than NaN (due to issues with persistence
+    // that I don't feel like fixing;  #2825).  If we want to address this, this is the place
+    // to start, but note that NaN is treated specially -- it means, "Interpolate" so to allow
+    // us to put a NaN into the outputs some changes will be needed
+    double defaultValue = std::numeric_limits<double>::quiet_NaN();
+
+    // build an interp object for this row
+    int const nxSample = _statsImage.getWidth();
+    std::vector<double> bg_x(nxSample);
+    for (int iX = 0; iX < nxSample; iX++) {
+        bg_x[iX] = static_cast<double>(_gridColumns[iX][iY]);
+    }
+    std::vector<double> xcenTmp, bgTmp;
+    cullNan(_xcen, bg_x, xcenTmp, bgTmp, defaultValue);
+
+    std::shared_ptr<Interpolate> intobj;
+    try {
+        intobj = makeInterpolate(xcenTmp, bgTmp, interpStyle);
+    } catch (pex::exceptions::OutOfRangeError& e) {
+        switch (undersampleStyle) {
+            case THROW_EXCEPTION:
+                LSST_EXCEPT_ADD(e, str(boost::format("Interpolating in y (iY = %d)") % iY));
+                throw;
+            case REDUCE_INTERP_ORDER: {
+                if (bgTmp.empty()) {
+                    xcenTmp.push_back(0);
+                    bgTmp.push_back(defaultValue);
+
+                    intobj = makeInterpolate(xcenTmp, bgTmp, Interpolate::CONSTANT);
+                    break;
+                } else {
+                    intobj = makeInterpolate(xcenTmp, bgTmp, lookupMaxInterpStyle(bgTmp.size()));
+                }
+            } break;
+            case INCREASE_NXNYSAMPLE:
+                LSST_EXCEPT_ADD(
+                        e, "The BackgroundControl UndersampleStyle INCREASE_NXNYSAMPLE is not supported.");
+                throw;
+            default:
+                LSST_EXCEPT_ADD(e, str(boost::format("The selected BackgroundControl "
+                                                     "UndersampleStyle %d is not defined.") %
+                                       undersampleStyle));
+                throw;
+        }
+    } catch (ex::Exception& e) {
+        LSST_EXCEPT_ADD(e, str(boost::format("Interpolating in y (iY = %d)") % iY));
+        throw;
     }
+    _rowInterpolates[iY] = intobj;
+    return *intobj;
 }
 
 BackgroundMI& BackgroundMI::operator+=(float const delta) {
@@ -273,85 +428,24 @@ std::shared_ptr<image::Image<PixelT>> BackgroundMI::doGetImage(
     }
 
     // =============================================================
-    // --> We'll store nxSample fully-interpolated columns to interpolate the rows over
-    // make a vector containing the y pixel coords for the column
-    int const width = _imgBBox.getWidth();
-    int const height = _imgBBox.getHeight();
+    // --> We'll store nxSample fully-interpolated columns to interpolate the rows over,
+    // and the interpolants along the rows; both are reused if we're called again
+    _setInterpolation(interpStyle, undersampleStyle);
     auto const bboxOff = bbox.getMin() - _imgBBox.getMin();
 
-    std::vector<int> ypix(height);
-    for (int iY = 0; iY < height; ++iY) {
-        ypix[iY] = iY;
-    }
-
-    _gridColumns.resize(width);
-    for (int iX = 0; iX < nxSample; ++iX) {
-        _setGridColumns(interpStyle, undersampleStyle, iX, ypix);
-    }
-
     // create a shared_ptr to put the background image in and return to caller
     // start with xy0 = 0 and set final xy0 later
     std::shared_ptr<image::Image<PixelT>> bg =
             std::shared_ptr<image::Image<PixelT>>(new image::Image<PixelT>(bbox.getDimensions()));
 
     // go through row by row
-    // - interpolate on the gridcolumns that were pre-computed by the constructor
+    // - interpolate on the gridcolumns that were pre-computed by _setInterpolation
     // - copy the values to an ImageT to return to the caller.
-    std::vector<double> xcenTmp, bgTmp;
-
-    // N.b. There's no API to set defaultValue to other than NaN (due to issues with persistence
-    // that I don't feel like fixing;  #2825).  If we want to address this, this is the place
-    // to start, but note that NaN is treated specially -- it means, "Interpolate" so to allow
-    // us to put a NaN into the outputs some changes will be needed
-    double defaultValue = std::numeric_limits<double>::quiet_NaN();
-
+    std::vector<double> row(bbox.getWidth());
     for (int y = 0, iY = bboxOff.getY(); y < bbox.getHeight(); ++y, ++iY) {
-        // build an interp object for this row
-        std::vector<double> bg_x(nxSample);
-        for (int iX = 0; iX < nxSample; iX++) {
-            bg_x[iX] = static_cast<double>(_gridColumns[iX][iY]);
-        }
-        cullNan(_xcen, bg_x, xcenTmp, bgTmp, defaultValue);
-
-        std::shared_ptr<Interpolate> intobj;
-        try {
-            intobj = makeInterpolate(xcenTmp, bgTmp, interpStyle);
-        } catch (pex::exceptions::OutOfRangeError& e) {
-            switch (undersampleStyle) {
-                case THROW_EXCEPTION:
-                    LSST_EXCEPT_ADD(e, str(boost::format("Interpolating in y (iY = %d)") % iY));
-                    throw;
-                case REDUCE_INTERP_ORDER: {
-                    if (bgTmp.empty()) {
-                        xcenTmp.push_back(0);
-                        bgTmp.push_back(defaultValue);
-
-                        intobj = makeInterpolate(xcenTmp, bgTmp, Interpolate::CONSTANT);
-                        break;
-                    } else {
-                        intobj = makeInterpolate(xcenTmp, bgTmp, lookupMaxInterpStyle(bgTmp.size()));
-                    }
-                } break;
-                case INCREASE_NXNYSAMPLE:
-                    LSST_EXCEPT_ADD(
-                            e,
-                            "The BackgroundControl UndersampleStyle INCREASE_NXNYSAMPLE is not supported.");
-                    throw;
-                default:
-                    LSST_EXCEPT_ADD(e, str(boost::format("The selected BackgroundControl "
-                                                         "UndersampleStyle %d is not defined.") %
-                                           undersampleStyle));
-                    throw;
-            }
-        } catch (ex::Exception& e) {
-            LSST_EXCEPT_ADD(e, str(boost::format("Interpolating in y (iY = %d)") % iY));
-            throw;
-        }
-
-        // fill the image with interpolated values
-        for (int iX = bboxOff.getX(), x = 0; x < bbox.getWidth(); ++iX, ++x) {
-            (*bg)(x, y) = static_cast<PixelT>(intobj->interpolate(iX));
-        }
+        _getRowInterpolate(iY).interpolateRange(bboxOff.getX(), bbox.getWidth(), row.data());
+        std::transform(row.begin(), row.end(), bg->row_begin(y),
+                       [](double value) { return static_cast<PixelT>(value); });
     }
     bg->setXY0(bbox.getMin());
 
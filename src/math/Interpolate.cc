@@ -25,6 +25,7 @@
 /*
  * Interpolate values for a set of x,y vector<>s
  */
+#include <cmath>
 #include <limits>
 #include <algorithm>
 #include <map>
@@ -175,6 +176,7 @@ class InterpolateGsl : public Interpolate {
 public:
     ~InterpolateGsl() override;
     double interpolate(double const x) const override;
+    void interpolateRange(double const x0, int const n, double *out) const override;
 
 private:
     InterpolateGsl(std::vector<double> const &x, std::vector<double> const &y,
@@ -183,6 +185,9 @@ private:
     ::gsl_interp_type const *_interpType;
     ::gsl_interp_accel *_acc;
     ::gsl_interp *_interp;
+    // The interpolant on [_x[i], _x[i + 1]) is the cubic polynomial in t = x - _x[i] with coefficients
+    // _coeffs[4*i], ..., _coeffs[4*i + 3] (in order of increasing power)
+    std::vector<double> _coeffs;
 };
 
 InterpolateGsl::InterpolateGsl(std::vector<double> const &x,   ///< the x-values of points
@@ -214,6 +219,20 @@ InterpolateGsl::InterpolateGsl(std::vector<double> const &x,   ///< the x-values
                 pex::exceptions::RuntimeError,
                 str(boost::format("gsl_interp_init failed: %s [%d]") % ::gsl_strerror(status) % status));
     }
+    // All the gsl interpolants are cubic (or lower order) in each interval; the value and first two
+    // derivatives at the start of the interval give three of the coefficients, and the value at the
+    // end gives the fourth
+    std::size_t const nInterval = _x.size() - 1;
+    _coeffs.resize(4 * nInterval);
+    for (std::size_t i = 0; i < nInterval; ++i) {
+        double const h = _x[i + 1] - _x[i];
+        double const b = ::gsl_interp_eval_deriv(_interp, &_x[0], &_y[0], _x[i], _acc);
+        double const c = 0.5 * ::gsl_interp_eval_deriv2(_interp, &_x[0], &_y[0], _x[i], _acc);
+        _coeffs[4 * i] = _y[i];
+        _coeffs[4 * i + 1] = b;
+        _coeffs[4 * i + 2] = c;
+        _coeffs[4 * i + 3] = (_y[i + 1] - _y[i] - h * (b + h * c)) / (h * h * h);
+    }
 }
 
 InterpolateGsl::~InterpolateGsl() {
@@ -254,6 +273,50 @@ double InterpolateGsl::interpolate(double const xInterp) const {
     return ::gsl_interp_eval(_interp, &_x[0], &_y[0], xInterp, _acc);
 }
 
+void InterpolateGsl::interpolateRange(double const x0, int const n, double *out) const {
+    // Return the index of the first point at or after i that isn't < xEnd (or <= xEnd if inclusive)
+    auto findEnd = [x0, n](int const i, double const xEnd, bool const inclusive) {
+        int end = std::max(i, static_cast<int>(std::min<double>(n, std::max(0.0, std::ceil(xEnd - x0)))));
+        while (end > i && (inclusive ? x0 + (end - 1) > xEnd : x0 + (end - 1) >= xEnd)) {
+            --end;
+        }
+        while (end < n && (inclusive ? x0 + end <= xEnd : x0 + end < xEnd)) {
+            ++end;
+        }
+        return end;
+    };
+
+    int i = 0;
+    for (int const end = findEnd(i, _x.front(), false); i < end; ++i) {  // extrapolate to the left
+        out[i] = interpolate(x0 + i);
+    }
+    std::size_t const nInterval = _x.size() - 1;
+    for (std::size_t interval = 0; interval < nInterval && i < n; ++interval) {
+        // as for gsl_interp_eval, the last interval includes its upper end
+        int const end = findEnd(i, _x[interval + 1], interval + 1 == nInterval);
+        double const xStart = _x[interval];
+        if (_interpType == ::gsl_interp_linear) {
+            // evaluate the expression gsl's linear interpolant does, so the values are identical
+            // to those returned by interpolate()
+            double const yStart = _y[interval];
+            double const dx = _x[interval + 1] - xStart;
+            double const dy = _y[interval + 1] - yStart;
+            for (; i < end; ++i) {
+                out[i] = yStart + ((x0 + i) - xStart) / dx * dy;
+            }
+            continue;
+        }
+        double const *const c = &_coeffs[4 * interval];
+        for (; i < end; ++i) {
+            double const t = (x0 + i) - xStart;
+            out[i] = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+        }
+    }
+    for (; i < n; ++i) {  // extrapolate to the right
+        out[i] = interpolate(x0 + i);
+    }
+}
+
 Interpolate::Style stringToInterpStyle(std::string const &style) {
     static std::map<std::string, Interpolate::Style> gslInterpTypeStrings;
     if (gslInterpTypeStrings.empty()) {
@@ -301,6 +364,12 @@ std::vector<double> Interpolate::interpolate(std::vector<double> const &x) const
     return out;
 }
 
+void Interpolate::interpolateRange(double const x0, int const n, double *out) const {
+    for (int i = 0; i < n; ++i) {
+        out[i] = interpolate(x0 + i);
+    }
+}
+
 ndarray::Array<double, 1> Interpolate::interpolate(ndarray::Array<double const, 1> const &x) const {
     int const num = x.getShape()[0];
     ndarray::Array<double, 1> out = ndarray::allocate(ndarray::makeVector(num));
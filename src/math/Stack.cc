@@ -26,6 +26,7 @@
  * Provide functions to stack images
  *
  */
+#include <algorithm>
 #include <vector>
 #include <cassert>
 #include <memory>
@@ -34,6 +35,7 @@
 #include "lsst/pex/exceptions.h"
 #include "lsst/afw/math/Stack.h"
 #include "lsst/afw/math/MaskedVector.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace pexExcept = lsst::pex::exceptions;
 
@@ -56,6 +58,24 @@ int bitcount(unsigned int x) {
     return b;
 }
 
+// Number of output rows handed to a worker thread at a time when stacking images
+int const StackRowBlockHeight = 8;
+
+/**
+ * @internal Scratch space for one worker thread of computeMaskedImageStack
+ */
+template <typename PixelT>
+struct StackWorkspace {
+    StackWorkspace(std::size_t nImages, WeightVector const &weights_)
+            : pixelSet(nImages), weights(weights_), rows() {
+        rows.reserve(nImages);
+    }
+
+    MaskedVector<PixelT> pixelSet;  // a pixel from x,y for each image
+    WeightVector weights;           // weights; non-const version
+    std::vector<typename image::MaskedImage<PixelT>::x_iterator> rows;  // row_begin iterator per image
+};
+
 /**
  * @internal Check that only one type of statistics has been requested.
  */
@@ -118,13 +138,9 @@ void computeMaskedImageStack(image::MaskedImage<PixelT> &imgStack,
                              Property flags, StatisticsControl const &sctrl, image::MaskPixel const clipped,
                              std::vector<std::pair<image::MaskPixel, image::MaskPixel>> const &maskMap,
                              WeightVector const &wvector = WeightVector()) {
-    // get a list of row_begin iterators
     typedef typename image::MaskedImage<PixelT>::x_iterator x_iterator;
-    std::vector<x_iterator> rows;
-    rows.reserve(images.size());
 
-    MaskedVector<PixelT> pixelSet(images.size());  // a pixel from x,y for each image
-    WeightVector weights;                          // weights; non-const version
+    WeightVector initialWeights;  // initial value of each worker's weights
     //
     StatisticsControl sctrlTmp(sctrl);
 
@@ -132,73 +148,87 @@ void computeMaskedImageStack(image::MaskedImage<PixelT> &imgStack,
         assert(isWeighted);
         assert(wvector.empty());
 
-        weights.resize(images.size());
+        initialWeights.resize(images.size());
 
         sctrlTmp.setWeighted(true);
     } else if (isWeighted) {
-        weights.assign(wvector.begin(), wvector.end());
+        initialWeights.assign(wvector.begin(), wvector.end());
 
         sctrlTmp.setWeighted(true);
     }
-    assert(weights.empty() || weights.size() == images.size());
+    assert(initialWeights.empty() || initialWeights.size() == images.size());
+
+    Property const eflags = static_cast<Property>(flags | NPOINT | ERRORS | NCLIPPED | NMASKED);
+
+    // The output is computed in blocks of rows, each handed to one worker with its own scratch space
+    int const nRowBlocks = (imgStack.getHeight() + StackRowBlockHeight - 1) / StackRowBlockHeight;
+    int const nWorkers = detail::getNWorkers(nRowBlocks, sctrl.getNThreads());
+    std::vector<std::unique_ptr<StackWorkspace<PixelT>>> workspaceList;
+    workspaceList.reserve(nWorkers);
+    for (int worker = 0; worker < nWorkers; ++worker) {
+        workspaceList.emplace_back(new StackWorkspace<PixelT>(images.size(), initialWeights));
+    }
 
     // loop over x,y ... the loop over the stack to fill pixelSet
     // - get the stats on pixelSet and put the value in the output image at x,y
-    for (int y = 0; y != imgStack.getHeight(); ++y) {
-        for (unsigned int i = 0; i < images.size(); ++i) {
-            x_iterator ptr = images[i]->row_begin(y);
-            if (y == 0) {
-                rows.push_back(ptr);
-            } else {
-                rows[i] = ptr;
+    detail::parallelFor(nRowBlocks, sctrl.getNThreads(), [&](int rowBlock, int worker) {
+        MaskedVector<PixelT> &pixelSet = workspaceList[worker]->pixelSet;  // a pixel from x,y for each image
+        WeightVector &weights = workspaceList[worker]->weights;
+        std::vector<x_iterator> &rows = workspaceList[worker]->rows;  // row_begin iterators
+
+        int const yBegin = rowBlock * StackRowBlockHeight;
+        int const yEnd = std::min(yBegin + StackRowBlockHeight, imgStack.getHeight());
+        for (int y = yBegin; y != yEnd; ++y) {
+            rows.clear();
+            for (unsigned int i = 0; i < images.size(); ++i) {
+                rows.push_back(images[i]->row_begin(y));
             }
-        }
 
-        for (x_iterator ptr = imgStack.row_begin(y), end = imgStack.row_end(y); ptr != end; ++ptr) {
-            typename MaskedVector<PixelT>::iterator psPtr = pixelSet.begin();
-            WeightVector::iterator wtPtr = weights.begin();
-            for (unsigned int i = 0; i < images.size(); ++rows[i], ++i, ++psPtr, ++wtPtr) {
-                *psPtr = *rows[i];
-                if (useVariance) {  // we're weighting using the variance
-                    *wtPtr = 1.0 / rows[i].variance();
+            for (x_iterator ptr = imgStack.row_begin(y), end = imgStack.row_end(y); ptr != end; ++ptr) {
+                typename MaskedVector<PixelT>::iterator psPtr = pixelSet.begin();
+                WeightVector::iterator wtPtr = weights.begin();
+                for (unsigned int i = 0; i < images.size(); ++rows[i], ++i, ++psPtr, ++wtPtr) {
+                    *psPtr = *rows[i];
+                    if (useVariance) {  // we're weighting using the variance
+                        *wtPtr = 1.0 / rows[i].variance();
+                    }
                 }
-            }
 
-            Property const eflags = static_cast<Property>(flags | NPOINT | ERRORS | NCLIPPED | NMASKED);
-            Statistics stat = isWeighted ? makeStatistics(pixelSet, weights, eflags, sctrlTmp)
-                                         : makeStatistics(pixelSet, eflags, sctrlTmp);
-
-            PixelT variance = ::pow(stat.getError(flags), 2);
-            image::MaskPixel msk(stat.getOrMask());
-            int const npoint = stat.getValue(NPOINT);
-            if (npoint == 0) {
-                msk = sctrlTmp.getNoGoodPixelsMask();
-            } else if (npoint == 1) {
-                /*
-                 * you should be using sctrl.setCalcErrorFromInputVariance(true) if you want to avoid
-                 * getting a variance of NaN when you only have one input
-                 */
-            }
-            // Check to see if any pixels were rejected due to clipping
-            if (stat.getValue(NCLIPPED) > 0) {
-                msk |= clipped;
-            }
-            // Check to see if any pixels were rejected by masking, and apply
-            // any associated masks to the result.
-            if (stat.getValue(NMASKED) > 0) {
-                for (auto const &pair : maskMap) {
-                    for (auto pp = pixelSet.begin(); pp != pixelSet.end(); ++pp) {
-                        if ((*pp).mask() & pair.first) {
-                            msk |= pair.second;
-                            break;
+                Statistics stat = isWeighted ? makeStatistics(pixelSet, weights, eflags, sctrlTmp)
+                                             : makeStatistics(pixelSet, eflags, sctrlTmp);
+
+                PixelT variance = ::pow(stat.getError(flags), 2);
+                image::MaskPixel msk(stat.getOrMask());
+                int const npoint = stat.getValue(NPOINT);
+                if (npoint == 0) {
+                    msk = sctrlTmp.getNoGoodPixelsMask();
+                } else if (npoint == 1) {
+                    /*
+                     * you should be using sctrl.setCalcErrorFromInputVariance(true) if you want to avoid
+                     * getting a variance of NaN when you only have one input
+                     */
+                }
+                // Check to see if any pixels were rejected due to clipping
+                if (stat.getValue(NCLIPPED) > 0) {
+                    msk |= clipped;
+                }
+                // Check to see if any pixels were rejected by masking, and apply
+                // any associated masks to the result.
+                if (stat.getValue(NMASKED) > 0) {
+                    for (auto const &pair : maskMap) {
+                        for (auto pp = pixelSet.begin(); pp != pixelSet.end(); ++pp) {
+                            if ((*pp).mask() & pair.first) {
+                                msk |= pair.second;
+                                break;
+                            }
                         }
                     }
                 }
-            }
 
-            *ptr = typename image::MaskedImage<PixelT>::Pixel(stat.getValue(flags), msk, variance);
+                *ptr = typename image::MaskedImage<PixelT>::Pixel(stat.getValue(flags), msk, variance);
+            }
         }
-    }
+    });
 }
 template <typename PixelT, bool isWeighted, bool useVariance>
 void computeMaskedImageStack(image::MaskedImage<PixelT> &imgStack,
@@ -286,6 +316,96 @@ void statisticsStack(image::MaskedImage<PixelT> &out,
     }
 }
 
+namespace {
+/**
+ * @internal Stack the strips of bbox read from each of the readers
+ *
+ * `getStripOutput(stripBBox)` returns the MaskedImage that the strip is stacked into, and
+ * `finishStrip(strip)` is called once it has been filled.
+ */
+template <typename PixelT, typename GetStripOutputT, typename FinishStripT>
+void streamMaskedImageStack(std::vector<std::shared_ptr<image::MaskedImageFitsReader>> const &readers,
+                            lsst::geom::Box2I const &bbox, Property flags, StatisticsControl const &sctrl,
+                            WeightVector const &wvector, image::MaskPixel clipped,
+                            std::vector<std::pair<image::MaskPixel, image::MaskPixel>> const &maskMap,
+                            int stripHeight, GetStripOutputT getStripOutput, FinishStripT finishStrip) {
+    checkObjectsAndWeights(readers, wvector);
+    checkOnlyOneFlag(flags);
+    if (stripHeight < 1) {
+        throw LSST_EXCEPT(pexExcept::InvalidParameterError,
+                          (boost::format("stripHeight = %d < 1") % stripHeight).str());
+    }
+    for (unsigned int i = 0; i < readers.size(); ++i) {
+        lsst::geom::Box2I const inputBBox = readers[i]->readBBox(image::PARENT);
+        if (!inputBBox.contains(bbox)) {
+            throw LSST_EXCEPT(pexExcept::InvalidParameterError,
+                              (boost::format("Input %d (%s) with bbox %s does not contain %s") % i %
+                               readers[i]->getFileName() % inputBBox % bbox)
+                                      .str());
+        }
+    }
+
+    std::vector<std::shared_ptr<image::MaskedImage<PixelT>>> strips(readers.size());
+    for (int y0 = bbox.getMinY(); y0 <= bbox.getMaxY(); y0 += stripHeight) {
+        int const y1 = std::min(y0 + stripHeight - 1, bbox.getMaxY());
+        lsst::geom::Box2I const stripBBox(lsst::geom::Point2I(bbox.getMinX(), y0),
+                                          lsst::geom::Point2I(bbox.getMaxX(), y1));
+        for (unsigned int i = 0; i < readers.size(); ++i) {
+            // release the previous strip before reading the next, to bound the memory in use
+            strips[i].reset();
+            strips[i] = std::make_shared<image::MaskedImage<PixelT>>(
+                    readers[i]->read<PixelT>(stripBBox, image::PARENT));
+        }
+        image::MaskedImage<PixelT> stripOut = getStripOutput(stripBBox);
+        statisticsStack(stripOut, strips, flags, sctrl, wvector, clipped, maskMap);
+        finishStrip(stripOut);
+    }
+}
+}  // end anonymous namespace
+
+template <typename PixelT>
+void streamStatisticsStack(std::vector<std::shared_ptr<image::MaskedImageFitsReader>> const &readers,
+                           lsst::geom::Box2I const &bbox, Property flags, StatisticsControl const &sctrl,
+                           WeightVector const &wvector, image::MaskPixel clipped,
+                           std::vector<std::pair<image::MaskPixel, image::MaskPixel>> const &maskMap,
+                           int stripHeight,
+                           std::function<void(image::MaskedImage<PixelT> const &)> const &sink) {
+    if (bbox.isEmpty()) {
+        return;
+    }
+    // A single buffer holds the output strip; the last strip may use only part of it
+    image::MaskedImage<PixelT> buffer(
+            lsst::geom::Extent2I(bbox.getWidth(), std::min(std::max(stripHeight, 1), bbox.getHeight())));
+    streamMaskedImageStack<PixelT>(
+            readers, bbox, flags, sctrl, wvector, clipped, maskMap, stripHeight,
+            [&buffer](lsst::geom::Box2I const &stripBBox) {
+                image::MaskedImage<PixelT> stripOut(
+                        buffer, lsst::geom::Box2I(lsst::geom::Point2I(0, 0), stripBBox.getDimensions()),
+                        image::LOCAL, false);
+                stripOut.setXY0(stripBBox.getMin());
+                return stripOut;
+            },
+            [&sink](image::MaskedImage<PixelT> const &stripOut) { sink(stripOut); });
+}
+
+template <typename PixelT>
+void streamStatisticsStack(image::MaskedImage<PixelT> &out,
+                           std::vector<std::shared_ptr<image::MaskedImageFitsReader>> const &readers,
+                           Property flags, StatisticsControl const &sctrl, WeightVector const &wvector,
+                           image::MaskPixel clipped,
+                           std::vector<std::pair<image::MaskPixel, image::MaskPixel>> const &maskMap,
+                           int stripHeight) {
+    if (out.getBBox().isEmpty()) {
+        return;
+    }
+    streamMaskedImageStack<PixelT>(
+            readers, out.getBBox(), flags, sctrl, wvector, clipped, maskMap, stripHeight,
+            [&out](lsst::geom::Box2I const &stripBBox) {
+                return image::MaskedImage<PixelT>(out, stripBBox, image::PARENT, false);
+            },
+            [](image::MaskedImage<PixelT> const &) {});
+}
+
 namespace {
 /* ************************************************************************** *
  *
@@ -306,30 +426,41 @@ template <typename PixelT, bool isWeighted>
 void computeImageStack(image::Image<PixelT> &imgStack,
                        std::vector<std::shared_ptr<image::Image<PixelT>>> &images, Property flags,
                        StatisticsControl const &sctrl, WeightVector const &weights = WeightVector()) {
-    MaskedVector<PixelT> pixelSet(images.size());  // a pixel from x,y for each image
     StatisticsControl sctrlTmp(sctrl);
 
-    // set the mask to be an infinite iterator
-    MaskImposter<image::MaskPixel> msk;
-
     if (!weights.empty()) {
         sctrlTmp.setWeighted(true);
     }
 
+    // The output is computed in blocks of rows, each handed to one worker with its own scratch space
+    int const nRowBlocks = (imgStack.getHeight() + StackRowBlockHeight - 1) / StackRowBlockHeight;
+    int const nWorkers = detail::getNWorkers(nRowBlocks, sctrl.getNThreads());
+    std::vector<std::unique_ptr<MaskedVector<PixelT>>> pixelSetList;
+    pixelSetList.reserve(nWorkers);
+    for (int worker = 0; worker < nWorkers; ++worker) {
+        pixelSetList.emplace_back(new MaskedVector<PixelT>(images.size()));
+    }
+
     // get the desired statistic
-    for (int y = 0; y != imgStack.getHeight(); ++y) {
-        for (int x = 0; x != imgStack.getWidth(); ++x) {
-            for (unsigned int i = 0; i != images.size(); ++i) {
-                (*pixelSet.getImage())(i, 0) = (*images[i])(x, y);
-            }
+    detail::parallelFor(nRowBlocks, sctrl.getNThreads(), [&](int rowBlock, int worker) {
+        MaskedVector<PixelT> &pixelSet = *pixelSetList[worker];  // a pixel from x,y for each image
+
+        int const yBegin = rowBlock * StackRowBlockHeight;
+        int const yEnd = std::min(yBegin + StackRowBlockHeight, imgStack.getHeight());
+        for (int y = yBegin; y != yEnd; ++y) {
+            for (int x = 0; x != imgStack.getWidth(); ++x) {
+                for (unsigned int i = 0; i != images.size(); ++i) {
+                    (*pixelSet.getImage())(i, 0) = (*images[i])(x, y);
+                }
 
-            if (isWeighted) {
-                imgStack(x, y) = makeStatistics(pixelSet, weights, flags, sctrlTmp).getValue();
-            } else {
-                imgStack(x, y) = makeStatistics(pixelSet, weights, flags, sctrlTmp).getValue();
+                if (isWeighted) {
+                    imgStack(x, y) = makeStatistics(pixelSet, weights, flags, sctrlTmp).getValue();
+                } else {
+                    imgStack(x, y) = makeStatistics(pixelSet, weights, flags, sctrlTmp).getValue();
+                }
             }
         }
-    }
+    });
 }
 
 }  // end anonymous namespace
@@ -549,6 +680,17 @@ std::shared_ptr<image::MaskedImage<PixelT>> statisticsStack(image::MaskedImage<P
     template std::vector<TYPE> statisticsStack<TYPE>(                                       \
             std::vector<std::vector<TYPE>> & vectors, Property flags,                       \
             StatisticsControl const &sctrl, WeightVector const &wvector);                                    \
+    template void streamStatisticsStack<TYPE>(                                                               \
+            std::vector<std::shared_ptr<image::MaskedImageFitsReader>> const &readers,                       \
+            lsst::geom::Box2I const &bbox, Property flags, StatisticsControl const &sctrl,                   \
+            WeightVector const &wvector, image::MaskPixel,                                                   \
+            std::vector<std::pair<image::MaskPixel, image::MaskPixel>> const &, int,                         \
+            std::function<void(image::MaskedImage<TYPE> const &)> const &);                                 \
+    template void streamStatisticsStack<TYPE>(                                                               \
+            image::MaskedImage<TYPE> & out,                                                                  \
+            std::vector<std::shared_ptr<image::MaskedImageFitsReader>> const &readers, Property flags,       \
+            StatisticsControl const &sctrl, WeightVector const &wvector, image::MaskPixel,                   \
+            std::vector<std::pair<image::MaskPixel, image::MaskPixel>> const &, int);                        \
     template std::shared_ptr<image::MaskedImage<TYPE>> statisticsStack(image::Image<TYPE> const &image,      \
                                                                        Property flags, char dimension,       \
                                                                        StatisticsControl const &sctrl);      \
@@ -25,9 +25,11 @@
 /*
  * Support statistical operations on images
  */
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <memory>
@@ -37,6 +39,8 @@
 #include "lsst/pex/exceptions.h"
 #include "lsst/afw/image/Image.h"
 #include "lsst/afw/math/Statistics.h"
+#include "lsst/afw/math/detail/Parallel.h"
+#include "lsst/afw/math/detail/RowStatistics.h"
 #include "lsst/geom/Angle.h"
 
 using namespace std;
@@ -449,278 +453,705 @@ StandardReturn getStandard(ImageT const &img, MaskT const &msk, VarianceT const
 }
 
 /**
- * @internal A wrapper using the nth_element() built-in to compute percentiles for an image
+ * @internal Return the value to subtract from the pixels of a float image before summing them
  *
- * @param img       an afw::Image
- * @param fraction the desired percentile.
+ * This is the median of a small sample of the good pixels, or 0 if none of the sample is good.
  *
- * Specialisation for non-integral types (where ties are not a problem)
+ * @param data    first pixel of the image
+ * @param stride  stride between rows of the image
+ * @param mskData first pixel of the mask, or nullptr if there is no mask
+ * @param mskStride stride between rows of the mask
+ * @param width   width of the image
+ * @param height  height of the image
+ * @param andMask mask of bad pixels
  */
-template <typename Pixel>
-typename enable_if<!is_integral<Pixel>::value, double>::type 
-percentile(std::vector<Pixel> &img, double const fraction) {
-    assert(fraction >= 0.0 && fraction <= 1.0);
+template <bool hasMask>
+double getFusedShift(float const *data, int const stride, image::MaskPixel const *mskData,
+                     int const mskStride, int const width, int const height,
+                     image::MaskPixel const andMask) {
+    int const nSample = 33;
+    std::vector<float> sample;
+    sample.reserve(nSample);
+    long const nPix = static_cast<long>(width) * height;
+    for (int i = 0; i < nSample; ++i) {
+        long const ind = i * (nPix - 1) / (nSample - 1);
+        int const x = ind % width;
+        int const y = ind / width;
+        float const value = data[y * static_cast<long>(stride) + x];
+        image::MaskPixel const mask = hasMask ? mskData[y * static_cast<long>(mskStride) + x] : 0x0;
+        if (std::isfinite(value) && !(mask & andMask)) {
+            sample.push_back(value);
+        }
+    }
+    if (sample.empty()) {
+        return 0.0;
+    }
+    std::nth_element(sample.begin(), sample.begin() + sample.size() / 2, sample.end());
+    return sample[sample.size() / 2];
+}
 
-    int const n = img.size();
+/**
+ * @internal Turn the sums accumulated about shift by accumulateRowStatistics into the standard stats
+ *
+ * @param sums  the sums
+ * @param shift the value that was subtracted from each pixel
+ */
+StandardReturn finishFusedStandard(detail::RowStatisticsSums const &sums, double const shift) {
+    int n = 0;
+    double sumx = 0.0;
+    double sumx2 = 0.0;
+    double min = MAX_DOUBLE;
+    double max = -MAX_DOUBLE;
+    image::MaskPixel allPixelOrMask = 0x0;
+    for (int l = 0; l < detail::RowStatisticsSums::nLanes; ++l) {
+        n += sums.n[l];
+        sumx += sums.sum[l];
+        sumx2 += sums.sum2[l];
+        min = std::min(min, static_cast<double>(sums.min[l]));
+        max = std::max(max, static_cast<double>(sums.max[l]));
+        allPixelOrMask |= sums.orMask[l];
+    }
+    if (n == 0) {
+        min = NaN;
+        max = NaN;
+    }
 
-    if (n > 1) {
-        double const idx = fraction * (n - 1);
+    // as in processPixels, with all weights 1
+    double const sumw = n;
+    double const sumw2 = n;
+    double mean = sumx / sumw;
+    double variance = sumx2 / sumw - ::pow(mean, 2);  // biased estimator
+    variance *= sumw * sumw / (sumw * sumw - sumw2);  // debias
+    double const meanVar = variance * sumw2 / (sumw * sumw);
+    double const varVar = varianceError(variance, n);
 
-        // interpolate linearly between the adjacent values
-        // For efficiency:
-        // - if we're asked for a fraction > 0.5,
-        //    we'll do the second partial sort on shorter (upper) portion
-        // - otherwise, the shorter portion will be the lower one, we'll partial-sort that.
-
-        int const q1 = static_cast<int>(idx);
-        int const q2 = q1 + 1;
-
-        auto mid1 = img.begin() + q1;
-        auto mid2 = img.begin() + q2;
-        if (fraction > 0.5) {
-            std::nth_element(img.begin(), mid1, img.end());
-            std::nth_element(mid1, mid2, img.end());
-        } else {
-            std::nth_element(img.begin(), mid2, img.end());
-            std::nth_element(img.begin(), mid1, mid2);
-        }
+    sumx += sumw * shift;
+    mean += shift;
 
-        double val1 = static_cast<double>(*mid1);
-        double val2 = static_cast<double>(*mid2);
-        double w1 = (static_cast<double>(q2) - idx);
-        double w2 = (idx - static_cast<double>(q1));
-        return w1 * val1 + w2 * val2;
+    return StandardReturn(n, sumx, Statistics::Value(mean, meanVar), Statistics::Value(variance, varVar), min,
+                          max, allPixelOrMask);
+}
 
-    } else if (n == 1) {
-        return img[0];
-    } else {
-        return NaN;
+/**
+ * @internal Compute the standard stats of a float image in a single pass over the pixels
+ *
+ * Equivalent to getStandard with no weights, no errors from the input variance,
+ * doCheckFinite == true, and no mask propagation thresholds.
+ *
+ * The sums are accumulated about the median of a small sample of the pixels,
+ * rather than about a crude mean computed by an additional pass through the data.
+ *
+ * @param img     the image
+ * @param mskData start of the mask pixels, or nullptr if there is no mask
+ * @param mskStride stride between rows of the mask
+ * @param andMask mask of bad pixels
+ */
+template <bool hasMask>
+StandardReturn getFusedStandard(image::Image<float> const &img, image::MaskPixel const *mskData,
+                                int const mskStride, image::MaskPixel const andMask) {
+    image::Image<float>::ConstArray const array = img.getArray();
+    float const *const data = array.getData();
+    int const stride = array.getStride<0>();
+    int const width = img.getWidth();
+    int const height = img.getHeight();
+
+    double const shift = getFusedShift<hasMask>(data, stride, mskData, mskStride, width, height, andMask);
+
+    detail::RowStatisticsSums sums;
+    for (int y = 0; y < height; ++y) {
+        detail::accumulateRowStatistics(data + y * static_cast<long>(stride),
+                                        hasMask ? mskData + y * static_cast<long>(mskStride) : nullptr,
+                                        width, shift, andMask, sums);
     }
+    return finishFusedStandard(sums, shift);
 }
 
-namespace {
-    //
-    // Helper function to estimate a floating-point quantile from integer data
-    //
-    // The data has been partially sorted, using nth_element
-    //
-    // begin:   iterator to a point which we know to be below our median
-    // end:     iterator to a point which we know to be beyond our median
-    // naive:   the integer value of the desired quantile
-    // target:  the number of points that should be to the left of the quantile.
-    //          N.b. if begin isn't the start of the data, this may not be the
-    //          desired number of points.  Caveat Callor
-    template<typename T>
-    double
-    computeQuantile(typename std::vector<T>::const_iterator begin,
-                    typename std::vector<T>::const_iterator end,
-                    T const naive,
-                    double const target
-                   )
-    {
-        // investigate the cumulative histogram near naive
-        std::size_t left = 0;           // number of values less than naive
-        std::size_t middle = 0;         // number of values equal to naive
-
-        for (auto ptr = begin; ptr != end; ++ptr) {
-            auto const val = *ptr;
-            if (val < naive) {
-                ++left;
-            } else if (val == naive) {
-                ++middle;
+//@{
+/**
+ * @internal Compute the standard stats in a single pass, if the image and mask types support it
+ *
+ * @param[in]  img     the image
+ * @param[in]  msk     the mask
+ * @param[in]  andMask mask of bad pixels
+ * @param[out] result  the standard stats; only set if true is returned
+ *
+ * @returns true iff the stats were computed
+ */
+template <typename ImageT, typename MaskT>
+bool tryFusedStandard(ImageT const &, MaskT const &, int const, StandardReturn &) {
+    return false;
+}
+
+bool tryFusedStandard(image::Image<float> const &img, image::Mask<image::MaskPixel> const &msk,
+                      int const andMask, StandardReturn &result) {
+    image::Mask<image::MaskPixel>::ConstArray const mskArray = msk.getArray();
+    result = getFusedStandard<true>(img, mskArray.getData(), mskArray.getStride<0>(), andMask);
+    return true;
+}
+
+bool tryFusedStandard(image::Image<float> const &img, MaskImposter<image::MaskPixel> const &,
+                      int const andMask, StandardReturn &result) {
+    result = getFusedStandard<false>(img, nullptr, 0, andMask);
+    return true;
+}
+//@}
+
+/**
+ * @internal Compute the standard stats of each cell of a grid on a float image, in a single pass
+ *
+ * Each row of cells is processed by streaming through its rows of pixels once, adding each
+ * pixel row's segments to the sums of the cells they fall in; the results are identical to calling
+ * getFusedStandard on each cell's subimage.  Rows of cells are processed in parallel.
+ *
+ * @param img     the image
+ * @param mskData start of the mask pixels, or nullptr if there is no mask
+ * @param mskStride stride between rows of the mask
+ * @param xOrigins, xSizes, yOrigins, ySizes the grid, as passed to makeGridStatistics
+ * @param andMask mask of bad pixels
+ * @param nThreads number of threads to use; 0 for one per core
+ *
+ * @returns the stats of cell (iX, iY) at index iY*xOrigins.size() + iX
+ */
+template <bool hasMask>
+std::vector<StandardReturn> getGridFusedStandard(image::Image<float> const &img,
+                                                 image::MaskPixel const *mskData, int const mskStride,
+                                                 std::vector<int> const &xOrigins,
+                                                 std::vector<int> const &xSizes,
+                                                 std::vector<int> const &yOrigins,
+                                                 std::vector<int> const &ySizes,
+                                                 image::MaskPixel const andMask, int const nThreads) {
+    image::Image<float>::ConstArray const array = img.getArray();
+    float const *const data = array.getData();
+    int const stride = array.getStride<0>();
+    int const nX = xOrigins.size();
+    int const nY = yOrigins.size();
+
+    std::vector<StandardReturn> results(nX * nY);
+    detail::parallelFor(nY, nThreads, [&](int iY, int) {
+        int const y0 = yOrigins[iY];
+        int const height = ySizes[iY];
+
+        std::vector<double> shifts(nX);
+        for (int iX = 0; iX < nX; ++iX) {
+            int const x0 = xOrigins[iX];
+            shifts[iX] = getFusedShift<hasMask>(
+                    data + y0 * static_cast<long>(stride) + x0, stride,
+                    hasMask ? mskData + y0 * static_cast<long>(mskStride) + x0 : nullptr, mskStride,
+                    xSizes[iX], height, andMask);
+        }
+
+        std::vector<detail::RowStatisticsSums> sums(nX);
+        for (int y = y0; y < y0 + height; ++y) {
+            float const *const row = data + y * static_cast<long>(stride);
+            image::MaskPixel const *const maskRow =
+                    hasMask ? mskData + y * static_cast<long>(mskStride) : nullptr;
+            for (int iX = 0; iX < nX; ++iX) {
+                int const x0 = xOrigins[iX];
+                detail::accumulateRowStatistics(row + x0, hasMask ? maskRow + x0 : nullptr, xSizes[iX],
+                                                shifts[iX], andMask, sums[iX]);
+            }
+        }
+
+        for (int iX = 0; iX < nX; ++iX) {
+            results[iY * nX + iX] = finishFusedStandard(sums[iX], shifts[iX]);
+        }
+    });
+    return results;
+}
+
+// Check that makeGridStatistics can compute flags with sctrl, on the given grid on a width x height image
+void checkGrid(int const width, int const height, std::vector<int> const &xOrigins,
+               std::vector<int> const &xSizes, std::vector<int> const &yOrigins,
+               std::vector<int> const &ySizes, int const flags, StatisticsControl const &sctrl) {
+    if (!canMakeGridStatistics(flags, sctrl)) {
+        throw LSST_EXCEPT(pexExceptions::InvalidParameterError,
+                          (boost::format("makeGridStatistics cannot compute flags 0x%x with the given "
+                                         "StatisticsControl; use makeStatistics on each cell") %
+                           flags)
+                                  .str());
+    }
+    if (xOrigins.size() != xSizes.size() || yOrigins.size() != ySizes.size()) {
+        throw LSST_EXCEPT(pexExceptions::InvalidParameterError,
+                          (boost::format("Grid has %d x origins and %d x sizes, %d y origins and %d y "
+                                         "sizes") %
+                           xOrigins.size() % xSizes.size() % yOrigins.size() % ySizes.size())
+                                  .str());
+    }
+    auto checkAxis = [](std::vector<int> const &origins, std::vector<int> const &sizes, int const length,
+                        char const *axis) {
+        for (std::size_t i = 0; i < origins.size(); ++i) {
+            if (sizes[i] <= 0 || origins[i] < 0 || origins[i] + sizes[i] > length) {
+                throw LSST_EXCEPT(pexExceptions::LengthError,
+                                  (boost::format("Grid cell %d in %s covers [%d, %d), outside [0, %d)") % i %
+                                   axis % origins[i] % (origins[i] + sizes[i]) % length)
+                                          .str());
             }
         }
+    };
+    checkAxis(xOrigins, xSizes, width, "x");
+    checkAxis(yOrigins, ySizes, height, "y");
+}
+
+/**
+ * @internal An order-preserving map from pixel values to unsigned integers, for radix selection
+ *
+ * `toKey(a) < toKey(b)` iff `a < b` (except that -0.0 sorts below +0.0).
+ */
+template <typename T, typename Enable = void>
+struct RadixKey;
+
+template <typename T>
+struct RadixKey<T, typename enable_if<is_integral<T>::value && is_unsigned<T>::value>::type> {
+    typedef T Key;
+    static Key toKey(T value) { return value; }
+    static T fromKey(Key key) { return key; }
+};
 
-        return naive - 0.5 + (target - left)/middle;
+template <typename T>
+struct RadixKey<T, typename enable_if<is_integral<T>::value && is_signed<T>::value>::type> {
+    typedef typename make_unsigned<T>::type Key;
+    static Key signBit() { return Key(1) << (8 * sizeof(Key) - 1); }
+    static Key toKey(T value) { return static_cast<Key>(value) ^ signBit(); }
+    static T fromKey(Key key) { return static_cast<T>(key ^ signBit()); }
+};
+
+template <typename T>
+struct RadixKey<T, typename enable_if<is_floating_point<T>::value>::type> {
+    typedef typename conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type Key;
+    static_assert(sizeof(T) == sizeof(Key), "Unsupported floating point type");
+
+    static Key signBit() { return Key(1) << (8 * sizeof(Key) - 1); }
+    // flip all the bits of negative numbers, and just the sign bit of positive ones
+    static Key toKey(T value) {
+        Key bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (bits & signBit()) ? ~bits : (bits | signBit());
     }
+    static T fromKey(Key key) {
+        Key const bits = (key & signBit()) ? (key & ~signBit()) : ~key;
+        T value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+/**
+ * @internal Select values of given ranks from the good pixels of an image, without copying them
+ *
+ * This is a radix select on RadixKey<Pixel>::Key, 16 bits at a time.  Each pass through the
+ * pixels histograms the next 16 bits of those keys that match the leading bits already found
+ * for one of the requested ranks, so all the ranks are found together in sizeof(Key)/2 passes
+ * (one for uint16 images, two for float and int images, and four for double images).
+ * The constructor makes the first pass, which also counts the good pixels.
+ *
+ * A pixel is good if it passes IsFinite and none of the bits in andMask are set in its mask.
+ */
+template <typename IsFinite, typename ImageT, typename MaskT>
+class RadixSelector {
+public:
+    typedef typename ImageT::Pixel Pixel;
+    typedef typename RadixKey<Pixel>::Key Key;
+
+    /// The value of the pixel of a given rank (in increasing order of value)
+    struct Rank {
+        Pixel value;         // value of the pixel
+        std::size_t nBelow;  // number of pixels less than value
+        std::size_t nEqual;  // number of pixels equal to value
+    };
+
+    RadixSelector(ImageT const &img, MaskT const &msk, int const andMask)
+            : _img(img), _msk(msk), _andMask(andMask), _topHistogram(NBIN, 0) {
+        int const topShift = getShift(0);
+        forEachGoodKey([this, topShift](Key key) { ++_topHistogram[key >> topShift]; });
+        _n = 0;
+        for (auto count : _topHistogram) {
+            _n += count;
+        }
+    }
+
+    /// Return the number of good pixels
+    std::size_t getN() const { return _n; }
 
     /**
-     * A wrapper using the nth_element() built-in to compute percentiles for a vector
+     * Return the pixels of the given ranks
      *
-     * @param img       an afw::Image
-     * @param fraction the desired percentile.
-     *
-     * This is the specialisation for integral types where we have to handle ties carefully.
+     * @param ranks  desired ranks; 0 is the smallest value, and all must be < getN()
      */
-    template <typename Pixel>
-    typename enable_if<is_integral<Pixel>::value, double>::type 
-    percentile(std::vector<Pixel> &img, double const fraction) {
-        assert(fraction >= 0.0 && fraction <= 1.0);
+    std::vector<Rank> select(std::vector<std::size_t> const &ranks) const {
+        std::vector<Target> targets(ranks.size());
+        for (std::size_t i = 0; i < ranks.size(); ++i) {
+            assert(ranks[i] < _n);
+            targets[i].rank = ranks[i];
+            targets[i].nBelow = 0;
+            targets[i].prefix = 0;
+            resolveDigit(targets[i], _topHistogram);
+        }
 
-        auto const n = img.size();
+        for (int digit = 1; digit < NDIGIT; ++digit) {
+            // One histogram for each distinct set of leading bits
+            std::vector<Key> prefixes;
+            for (auto const &target : targets) {
+                if (std::find(prefixes.begin(), prefixes.end(), target.prefix) == prefixes.end()) {
+                    prefixes.push_back(target.prefix);
+                }
+            }
+            std::vector<std::vector<std::uint32_t>> histograms(prefixes.size(),
+                                                               std::vector<std::uint32_t>(NBIN, 0));
+            int const prefixShift = getShift(digit - 1);
+            int const shift = getShift(digit);
+            forEachGoodKey([&prefixes, &histograms, prefixShift, shift](Key key) {
+                Key const prefix = key >> prefixShift;
+                for (std::size_t i = 0; i < prefixes.size(); ++i) {
+                    if (prefix == prefixes[i]) {
+                        ++histograms[i][(key >> shift) & (NBIN - 1)];
+                        break;
+                    }
+                }
+            });
 
-        if (n == 0) {
-            return NaN;
-        } else if (n == 1) {
-            return img[0];
-        } else {
-            // We need to handle ties.  The proper way to do this is to analyse the cumulative curve after
-            // building the histograms (which is faster than a generic partitioning algorithm), but it's a
-            // nuisance as we don't know the range of values
-            //
-            // This code looks clean enough, but actually the call to nth_element is expensive
-            // and we *still* have to go through the array a second time
+            for (auto &target : targets) {
+                auto const i = std::find(prefixes.begin(), prefixes.end(), target.prefix) - prefixes.begin();
+                resolveDigit(target, histograms[i]);
+            }
+        }
 
-            double const idx = fraction*(n - 1);
+        std::vector<Rank> result(targets.size());
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            result[i].value = RadixKey<Pixel>::fromKey(targets[i].prefix);
+            result[i].nBelow = targets[i].nBelow;
+            result[i].nEqual = targets[i].nEqual;
+        }
+        return result;
+    }
 
-            auto midP = img.begin() + static_cast<int>(idx);
-            std::nth_element(img.begin(), midP, img.end());
-            auto const naiveP = *midP;           // value of desired element
+private:
+    static int const DIGIT_BITS = 16;                              // number of bits handled per pass
+    static int const NBIN = 1 << DIGIT_BITS;                       // number of bins in each histogram
+    static int const NDIGIT = (8 * sizeof(Key)) / DIGIT_BITS;  // number of passes
+    static_assert(NDIGIT * DIGIT_BITS == 8 * sizeof(Key), "Key size must be a multiple of DIGIT_BITS");
+
+    struct Target {
+        std::size_t rank;    // desired rank
+        std::size_t nBelow;  // number of pixels whose keys are less than those starting with prefix
+        Key prefix;          // leading bits of the key found so far
+        std::size_t nEqual;  // number of pixels whose keys start with prefix
+    };
+
+    // Number of bits to the right of the given digit of a key
+    static int getShift(int digit) { return 8 * sizeof(Key) - DIGIT_BITS * (digit + 1); }
+
+    // Find the next digit of target's key, given the histogram of that digit for keys matching its prefix
+    static void resolveDigit(Target &target, std::vector<std::uint32_t> const &histogram) {
+        std::size_t const remaining = target.rank - target.nBelow;
+        std::size_t cumulative = 0;
+        int bin = 0;
+        while (cumulative + histogram[bin] <= remaining) {
+            cumulative += histogram[bin];
+            ++bin;
+        }
+        target.nBelow += cumulative;
+        target.prefix = static_cast<Key>((target.prefix << DIGIT_BITS) | static_cast<Key>(bin));
+        target.nEqual = histogram[bin];
+    }
 
-            return computeQuantile(img.begin(), img.end(), naiveP, fraction*n);
+    template <typename Function>
+    void forEachGoodKey(Function function) const {
+        for (int iY = 0; iY < _img.getHeight(); ++iY) {
+            typename MaskT::x_iterator mptr = _msk.row_begin(iY);
+            for (typename ImageT::x_iterator ptr = _img.row_begin(iY), end = ptr + _img.getWidth();
+                 ptr != end; ++ptr, ++mptr) {
+                if (IsFinite()(*ptr) && !(*mptr & _andMask)) {
+                    function(RadixKey<Pixel>::toKey(*ptr));
+                }
+            }
         }
     }
-}
 
-typedef std::tuple<double, double, double> MedianQuartileReturn;
-namespace {
-    /**
-     * A wrapper using the nth_element() built-in to compute median and Quartiles for an image
-     *
-     * @param img       an afw::Image
-     *
-     * Specialisation for non-integral types (where ties are not a problem)
-     */
-    template <typename Pixel>
-    typename enable_if<!is_integral<Pixel>::value, MedianQuartileReturn>::type
-    medianAndQuartiles(std::vector<Pixel> &img) {
-        int const n = img.size();
-
-        if (n > 1) {
-            double const idx50 = 0.50 * (n - 1);
-            double const idx25 = 0.25 * (n - 1);
-            double const idx75 = 0.75 * (n - 1);
-
-            // For efficiency:
-            // - partition at 50th, then partition the two half further to get 25th and 75th
-            // - to get the adjacent points (for interpolation), partition between 25/50, 50/75, 75/end
-            //   these should be much smaller partitions
-
-            int const q50a = static_cast<int>(idx50);
-            int const q50b = q50a + 1;
-            int const q25a = static_cast<int>(idx25);
-            int const q25b = q25a + 1;
-            int const q75a = static_cast<int>(idx75);
-            int const q75b = q75a + 1;
-
-            auto mid50a = img.begin() + q50a;
-            auto mid50b = img.begin() + q50b;
-            auto mid25a = img.begin() + q25a;
-            auto mid25b = img.begin() + q25b;
-            auto mid75a = img.begin() + q75a;
-            auto mid75b = img.begin() + q75b;
-
-            // get the 50th percentile, then get the 25th and 75th on the smaller partitions
-            std::nth_element(img.begin(), mid50a, img.end());
-            std::nth_element(mid50a, mid75a, img.end());
-            std::nth_element(img.begin(), mid25a, mid50a);
-
-            // and the adjacent points for each ... use the smallest segments available.
-            std::nth_element(mid50a, mid50b, mid75a);
-            std::nth_element(mid25a, mid25b, mid50a);
-            std::nth_element(mid75a, mid75b, img.end());
-
-            // interpolate linearly between the adjacent values
-            double val50a = static_cast<double>(*mid50a);
-            double val50b = static_cast<double>(*mid50b);
-            double w50a = (static_cast<double>(q50b) - idx50);
-            double w50b = (idx50 - static_cast<double>(q50a));
-            double median = w50a * val50a + w50b * val50b;
-
-            double val25a = static_cast<double>(*mid25a);
-            double val25b = static_cast<double>(*mid25b);
-            double w25a = (static_cast<double>(q25b) - idx25);
-            double w25b = (idx25 - static_cast<double>(q25a));
-            double q1 = w25a * val25a + w25b * val25b;
-
-            double val75a = static_cast<double>(*mid75a);
-            double val75b = static_cast<double>(*mid75b);
-            double w75a = (static_cast<double>(q75b) - idx75);
-            double w75b = (idx75 - static_cast<double>(q75a));
-            double q3 = w75a * val75a + w75b * val75b;
-
-            return MedianQuartileReturn(median, q1, q3);
-        } else if (n == 1) {
-            return MedianQuartileReturn(img[0], img[0], img[0]);
-        } else {
-            return MedianQuartileReturn(NaN, NaN, NaN);
+    ImageT const &_img;
+    MaskT const &_msk;
+    int const _andMask;
+    std::vector<std::uint32_t> _topHistogram;  // histogram of the first digit of all the good keys
+    std::size_t _n;                            // number of good pixels
+};
+
+/**
+ * @internal Select values of given ranks from a copy of the good pixels of an image
+ *
+ * This has the same interface as RadixSelector, and is used instead for small images: the copy is
+ * partitioned with nth_element for each rank, which is cheaper than clearing and scanning
+ * RadixSelector's histograms unless there are tens of thousands of pixels.
+ */
+template <typename IsFinite, typename ImageT, typename MaskT>
+class CopySelector {
+public:
+    typedef typename ImageT::Pixel Pixel;
+
+    /// The value of the pixel of a given rank (in increasing order of value)
+    struct Rank {
+        Pixel value;         // value of the pixel
+        std::size_t nBelow;  // number of pixels less than value
+        std::size_t nEqual;  // number of pixels equal to value
+    };
+
+    CopySelector(ImageT const &img, MaskT const &msk, int const andMask) {
+        _values.reserve(static_cast<std::size_t>(img.getWidth()) * img.getHeight());
+        for (int iY = 0; iY < img.getHeight(); ++iY) {
+            typename MaskT::x_iterator mptr = msk.row_begin(iY);
+            for (typename ImageT::x_iterator ptr = img.row_begin(iY), end = ptr + img.getWidth();
+                 ptr != end; ++ptr, ++mptr) {
+                if (IsFinite()(*ptr) && !(*mptr & andMask)) {
+                    _values.push_back(*ptr);
+                }
+            }
         }
     }
 
+    /// Return the number of good pixels
+    std::size_t getN() const { return _values.size(); }
+
     /**
-     * A wrapper using the nth_element() built-in to compute median and Quartiles for an image
-     *
-     * @param img       an afw::Image
+     * Return the pixels of the given ranks
      *
-     * This is the specialisation for integral types where we have to handle ties carefully.
+     * @param ranks  desired ranks; 0 is the smallest value, and all must be < getN()
      */
-    template <typename Pixel>
-    typename enable_if<is_integral<Pixel>::value, MedianQuartileReturn>::type
-    medianAndQuartiles(std::vector<Pixel> &img) {
-        auto const n = img.size();
-
-        if (n == 0) {
-            return MedianQuartileReturn(NaN, NaN, NaN);
-        } else if (n == 1) {
-            return MedianQuartileReturn(img[0], img[0], img[0]);
-        } else {
-            // We need to handle ties.  The proper way to do this is to analyse the cumulative curve after
-            // building the histograms (which is faster than a generic partitioning algorithm), but it's a
-            // nuisance as we don't know the range of values
-            //
-            // This code looks clean enough, but actually the call to nth_element is expensive
-            // and we *still* have to go through the array a second time.
-        
-            // For efficiency:
-            // - partition at 50th, then partition the two halves further to get 25th and 75th
-
-            auto mid25 = img.begin() + static_cast<int>(0.25*(n - 1));
-            auto mid50 = img.begin() + static_cast<int>(0.50*(n - 1));
-            auto mid75 = img.begin() + static_cast<int>(0.75*(n - 1));
-
-            // get the 50th percentile, then get the 25th and 75th on the smaller partitions
-            std::nth_element(img.begin(), mid50, img.end());
-            std::nth_element(img.begin(), mid25, mid50);
-            std::nth_element(mid50,       mid75, img.end());
-
-            double const q1     = computeQuantile(img.begin(), mid50,     *mid25,
-                                                  0.25*n);
-            double const median = computeQuantile(mid25,       mid75,     *mid50,
-                                                  0.50*n - (mid25 - img.begin()));
-            double const q3     = computeQuantile(mid50,       img.end(), *mid75,
-                                                  0.75*n - (mid50 - img.begin()));
-
-            return MedianQuartileReturn(median, q1, q3);
+    std::vector<Rank> select(std::vector<std::size_t> const &ranks) const {
+        std::vector<Rank> result(ranks.size());
+        for (std::size_t i = 0; i < ranks.size(); ++i) {
+            assert(ranks[i] < _values.size());
+            std::nth_element(_values.begin(), _values.begin() + ranks[i], _values.end());
+            Pixel const value = _values[ranks[i]];
+            result[i].value = value;
+            result[i].nBelow = 0;
+            result[i].nEqual = 0;
+            for (Pixel const v : _values) {
+                if (v < value) {
+                    ++result[i].nBelow;
+                } else if (v == value) {
+                    ++result[i].nEqual;
+                }
+            }
         }
+        return result;
+    }
+
+private:
+    mutable std::vector<Pixel> _values;  // the good pixels, partially ordered by select()
+};
+
+// Images with fewer pixels than this use CopySelector rather than RadixSelector
+std::size_t const MIN_RADIX_SELECT_PIXELS = 1 << 15;
+
+/**
+ * @internal Compute a percentile of the good pixels in an image
+ *
+ * @param selector  selector for the good pixels
+ * @param fraction  the desired percentile.
+ *
+ * Specialisation for non-integral types (where ties are not a problem);
+ * interpolates linearly between the values either side of fraction*(n - 1)
+ */
+template <typename Selector>
+typename enable_if<!is_integral<typename Selector::Pixel>::value, double>::type percentile(
+        Selector const &selector, double const fraction) {
+    assert(fraction >= 0.0 && fraction <= 1.0);
+
+    std::size_t const n = selector.getN();
+
+    if (n > 1) {
+        double const idx = fraction * (n - 1);
+
+        std::size_t const q1 = static_cast<std::size_t>(idx);
+        std::size_t const q2 = q1 + 1;
+
+        auto const ranks = selector.select({q1, std::min(q2, n - 1)});  // q2 has no weight if q2 == n
+
+        double val1 = static_cast<double>(ranks[0].value);
+        double val2 = static_cast<double>(ranks[1].value);
+        double w1 = (static_cast<double>(q2) - idx);
+        double w2 = (idx - static_cast<double>(q1));
+        return w1 * val1 + w2 * val2;
+
+    } else if (n == 1) {
+        return selector.select({0})[0].value;
+    } else {
+        return NaN;
+    }
+}
+
+//
+// Helper function to estimate a floating-point quantile from integer data
+//
+// Only the pixels with ranks in [begin, end) are considered (in the old implementation these were
+// the pixels between two iterators of a partially sorted copy of the data).
+//
+// naive:   the pixel (of known rank) with the integer value of the desired quantile
+// target:  the number of points that should be to the left of the quantile.
+//          N.b. if begin isn't 0, this may not be the desired number of points.  Caveat Callor
+template <typename RankT>
+double computeQuantile(std::size_t const begin, std::size_t const end, RankT const &naive,
+                       double const target) {
+    // investigate the cumulative histogram near naive; the values less than naive have ranks
+    // [0, naive.nBelow), and those equal to it [naive.nBelow, naive.nBelow + naive.nEqual)
+    auto countInRange = [begin, end](std::size_t first, std::size_t last) -> std::size_t {
+        first = std::max(first, begin);
+        last = std::min(last, end);
+        return (last > first) ? last - first : 0;
+    };
+    std::size_t const left = countInRange(0, naive.nBelow);  // number of values less than naive
+    std::size_t const middle =
+            countInRange(naive.nBelow, naive.nBelow + naive.nEqual);  // number of values equal to naive
+
+    return naive.value - 0.5 + (target - left) / middle;
+}
+
+/**
+ * @internal Compute a percentile of the good pixels in an image
+ *
+ * @param selector  selector for the good pixels
+ * @param fraction the desired percentile.
+ *
+ * This is the specialisation for integral types where we have to handle ties carefully.
+ */
+template <typename Selector>
+typename enable_if<is_integral<typename Selector::Pixel>::value, double>::type percentile(
+        Selector const &selector, double const fraction) {
+    assert(fraction >= 0.0 && fraction <= 1.0);
+
+    auto const n = selector.getN();
+
+    if (n == 0) {
+        return NaN;
+    } else if (n == 1) {
+        return selector.select({0})[0].value;
+    } else {
+        // We handle ties by analysing the cumulative histogram around the value of the desired rank
+        double const idx = fraction * (n - 1);
+
+        auto const naiveP = selector.select({static_cast<std::size_t>(idx)})[0];  // desired element
+
+        return computeQuantile(0, n, naiveP, fraction * n);
+    }
+}
+
+typedef std::tuple<double, double, double> MedianQuartileReturn;
+
+/**
+ * @internal Compute the median and quartiles of the good pixels in an image
+ *
+ * @param selector  selector for the good pixels
+ *
+ * Specialisation for non-integral types (where ties are not a problem)
+ */
+template <typename Selector>
+typename enable_if<!is_integral<typename Selector::Pixel>::value, MedianQuartileReturn>::type
+medianAndQuartiles(Selector const &selector) {
+    std::size_t const n = selector.getN();
+
+    if (n > 1) {
+        double const idx50 = 0.50 * (n - 1);
+        double const idx25 = 0.25 * (n - 1);
+        double const idx75 = 0.75 * (n - 1);
+
+        std::size_t const q50a = static_cast<std::size_t>(idx50);
+        std::size_t const q50b = q50a + 1;
+        std::size_t const q25a = static_cast<std::size_t>(idx25);
+        std::size_t const q25b = q25a + 1;
+        std::size_t const q75a = static_cast<std::size_t>(idx75);
+        std::size_t const q75b = q75a + 1;
+
+        // all six values in one set of passes through the data
+        auto const ranks = selector.select({q50a, q50b, q25a, q25b, q75a, std::min(q75b, n - 1)});
+
+        // interpolate linearly between the adjacent values
+        double val50a = static_cast<double>(ranks[0].value);
+        double val50b = static_cast<double>(ranks[1].value);
+        double w50a = (static_cast<double>(q50b) - idx50);
+        double w50b = (idx50 - static_cast<double>(q50a));
+        double median = w50a * val50a + w50b * val50b;
+
+        double val25a = static_cast<double>(ranks[2].value);
+        double val25b = static_cast<double>(ranks[3].value);
+        double w25a = (static_cast<double>(q25b) - idx25);
+        double w25b = (idx25 - static_cast<double>(q25a));
+        double q1 = w25a * val25a + w25b * val25b;
+
+        double val75a = static_cast<double>(ranks[4].value);
+        double val75b = static_cast<double>(ranks[5].value);
+        double w75a = (static_cast<double>(q75b) - idx75);
+        double w75b = (idx75 - static_cast<double>(q75a));
+        double q3 = w75a * val75a + w75b * val75b;
+
+        return MedianQuartileReturn(median, q1, q3);
+    } else if (n == 1) {
+        double const value = selector.select({0})[0].value;
+        return MedianQuartileReturn(value, value, value);
+    } else {
+        return MedianQuartileReturn(NaN, NaN, NaN);
     }
 }
 
 /**
- * @internal A function to copy an image into a vector
+ * @internal Compute the median and quartiles of the good pixels in an image
+ *
+ * @param selector  selector for the good pixels
+ *
+ * This is the specialisation for integral types where we have to handle ties carefully.
+ */
+template <typename Selector>
+typename enable_if<is_integral<typename Selector::Pixel>::value, MedianQuartileReturn>::type
+medianAndQuartiles(Selector const &selector) {
+    auto const n = selector.getN();
+
+    if (n == 0) {
+        return MedianQuartileReturn(NaN, NaN, NaN);
+    } else if (n == 1) {
+        double const value = selector.select({0})[0].value;
+        return MedianQuartileReturn(value, value, value);
+    } else {
+        // We handle ties by analysing the cumulative histogram around the value of each desired rank.
+        // Each quantile only considers the pixels between the neighbouring quantiles' ranks, as the
+        // previous implementation (which partitioned a copy of the data using nth_element) did
+        std::size_t const mid25 = static_cast<std::size_t>(0.25 * (n - 1));
+        std::size_t const mid50 = static_cast<std::size_t>(0.50 * (n - 1));
+        std::size_t const mid75 = static_cast<std::size_t>(0.75 * (n - 1));
+
+        auto const ranks = selector.select({mid25, mid50, mid75});
+
+        double const q1 = computeQuantile(0, mid50, ranks[0], 0.25 * n);
+        double const median = computeQuantile(mid25, mid75, ranks[1], 0.50 * n - mid25);
+        double const q3 = computeQuantile(mid50, n, ranks[2], 0.75 * n - mid50);
+
+        return MedianQuartileReturn(median, q1, q3);
+    }
+}
+
+// Compute the median, and the quartiles unless onlyMedian, of the pixels of a selector
+template <typename Selector>
+MedianQuartileReturn getMedianAndQuartiles(Selector const &selector, bool const onlyMedian) {
+    if (onlyMedian) {
+        return MedianQuartileReturn(percentile(selector, 0.5), NaN, NaN);
+    }
+    return medianAndQuartiles(selector);
+}
+
+/**
+ * @internal Compute the median, and the quartiles unless only the median is wanted
  *
- * This is used for percentile and iq_range as these must reorder the values.
  * Because it loops over the pixels, it's been templated over the NaN test to avoid
  * code repetition of the loops.
+ *
+ * @param img  image
+ * @param msk  mask
+ * @param andMask  mask of bad pixels
+ * @param onlyMedian  if true, the quartiles are returned as NaN
  */
-template <typename IsFinite, typename ImageT, typename MaskT, typename VarianceT>
-std::shared_ptr<std::vector<typename ImageT::Pixel> > makeVectorCopy(ImageT const &img, MaskT const &msk,
-                                                                     VarianceT const &, int const andMask) {
-    // Note need to keep track of allPixelOrMask here ... processPixels() does that
-    // and it always gets called
-    std::shared_ptr<std::vector<typename ImageT::Pixel> > imgcp(new std::vector<typename ImageT::Pixel>(0));
-
-    for (int i_y = 0; i_y < img.getHeight(); ++i_y) {
-        typename MaskT::x_iterator mptr = msk.row_begin(i_y);
-        for (typename ImageT::x_iterator ptr = img.row_begin(i_y), end = img.row_end(i_y); ptr != end;
-             ++ptr) {
-            if (IsFinite()(*ptr) && !(*mptr & andMask)) {
-                imgcp->push_back(*ptr);
-            }
-            ++mptr;
-        }
+template <typename IsFinite, typename ImageT, typename MaskT>
+MedianQuartileReturn getMedianAndQuartiles(ImageT const &img, MaskT const &msk, int const andMask,
+                                           bool const onlyMedian) {
+    if (static_cast<std::size_t>(img.getWidth()) * img.getHeight() < MIN_RADIX_SELECT_PIXELS) {
+        return getMedianAndQuartiles(CopySelector<IsFinite, ImageT, MaskT>(img, msk, andMask), onlyMedian);
     }
-
-    return imgcp;
+    return getMedianAndQuartiles(RadixSelector<IsFinite, ImageT, MaskT>(img, msk, andMask), onlyMedian);
 }
 }  // namespace
 
@@ -789,6 +1220,26 @@ Statistics::Statistics(ImageT const &img, MaskT const &msk, VarianceT const &var
     doStatistics(img, msk, var, var, _flags, _sctrl);
 }
 
+Statistics::Statistics(int const flags, StatisticsControl const &sctrl, int const num, int const n,
+                       double const sum, Value const &mean, Value const &variance, double const min,
+                       double const max, image::MaskPixel const allPixelOrMask)
+        : _flags(flags),
+          _n(n),
+          _mean(mean),
+          _variance(variance),
+          _min(min),
+          _max(max),
+          _sum(sum),
+          _meanclip(NaN, NaN),
+          _varianceclip(NaN, NaN),
+          _median(NaN, NaN),
+          _nClipped(0),
+          _nMasked((flags & NMASKED) ? num - n : 0),
+          _iqrange(NaN),
+          _allPixelOrMask(allPixelOrMask),
+          _sctrl(sctrl),
+          _weightsAreMultiplicative(false) {}
+
 namespace {
 template <typename T>
 bool isEmpty(T const &t) {
@@ -863,11 +1314,16 @@ void Statistics::doStatistics(ImageT const &img, MaskT const &msk, VarianceT con
     // Check that an int's large enough to hold the number of pixels
     assert(img.getWidth() * static_cast<double>(img.getHeight()) < std::numeric_limits<int>::max());
 
-    // get the standard statistics
-    StandardReturn standard =
-            getStandard(img, msk, var, weights, flags, _weightsAreMultiplicative, _sctrl.getAndMask(),
-                        _sctrl.getCalcErrorFromInputVariance(), _sctrl.getNanSafe(), _sctrl.getWeighted(),
-                        _sctrl._maskPropagationThresholds);
+    // get the standard statistics, in a single pass over the data if we can
+    StandardReturn standard;
+    bool const canUseFused = _sctrl.getNanSafe() && !_sctrl.getWeighted() &&
+                             !_sctrl.getCalcErrorFromInputVariance() &&
+                             _sctrl._maskPropagationThresholds.empty();
+    if (!(canUseFused && tryFusedStandard(img, msk, _sctrl.getAndMask(), standard))) {
+        standard = getStandard(img, msk, var, weights, flags, _weightsAreMultiplicative, _sctrl.getAndMask(),
+                               _sctrl.getCalcErrorFromInputVariance(), _sctrl.getNanSafe(),
+                               _sctrl.getWeighted(), _sctrl._maskPropagationThresholds);
+    }
 
     _n = std::get<0>(standard);
     _sum = std::get<1>(standard);
@@ -886,20 +1342,18 @@ void Statistics::doStatistics(ImageT const &img, MaskT const &msk, VarianceT con
 
     // copy the image for any routines that will use median or quantiles
     if (flags & (MEDIAN | IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP)) {
-        // make a vector copy of the image to get the median and quartiles (will move values)
-        std::shared_ptr<std::vector<typename ImageT::Pixel> > imgcp;
+        // select the median and quartiles directly from the image; there's no need to copy it
+        // if we *only* want the median, just use percentile(), otherwise use medianAndQuartiles()
+        bool const onlyMedian =
+                (flags & (MEDIAN)) && !(flags & (IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP));
+        MedianQuartileReturn mq;
         if (_sctrl.getNanSafe()) {
-            imgcp = makeVectorCopy<ChkFin>(img, msk, var, _sctrl.getAndMask());
+            mq = getMedianAndQuartiles<ChkFin>(img, msk, _sctrl.getAndMask(), onlyMedian);
         } else {
-            imgcp = makeVectorCopy<AlwaysT>(img, msk, var, _sctrl.getAndMask());
+            mq = getMedianAndQuartiles<AlwaysT>(img, msk, _sctrl.getAndMask(), onlyMedian);
         }
-
-        // if we *only* want the median, just use percentile(), otherwise use medianAndQuartiles()
-        if ((flags & (MEDIAN)) && !(flags & (IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP))) {
-            _median = Value(percentile(*imgcp, 0.5), NaN);
-        } else {
-            MedianQuartileReturn mq = medianAndQuartiles(*imgcp);
-            _median = Value(std::get<0>(mq), NaN);
+        _median = Value(std::get<0>(mq), NaN);
+        if (!onlyMedian) {
             _iqrange = std::get<2>(mq) - std::get<1>(mq);
         }
 
@@ -1115,6 +1569,54 @@ Statistics makeStatistics(image::Mask<image::MaskPixel> const &msk, int const fl
     return Statistics(msk, msk, msk, flags, sctrl);
 }
 
+bool canMakeGridStatistics(int const flags, StatisticsControl const &sctrl) {
+    return !(flags & (MEDIAN | IQRANGE | MEANCLIP | STDEVCLIP | VARIANCECLIP)) && sctrl.getNanSafe() &&
+           !sctrl.getWeighted() && !sctrl.getCalcErrorFromInputVariance() &&
+           sctrl._maskPropagationThresholds.empty();
+}
+
+std::vector<Statistics> makeGridStatistics(image::Image<float> const &img, std::vector<int> const &xOrigins,
+                                           std::vector<int> const &xSizes, std::vector<int> const &yOrigins,
+                                           std::vector<int> const &ySizes, int const flags,
+                                           StatisticsControl const &sctrl) {
+    checkGrid(img.getWidth(), img.getHeight(), xOrigins, xSizes, yOrigins, ySizes, flags, sctrl);
+    std::vector<StandardReturn> const standard = getGridFusedStandard<false>(
+            img, nullptr, 0, xOrigins, xSizes, yOrigins, ySizes, sctrl.getAndMask(), sctrl.getNThreads());
+
+    std::vector<Statistics> results;
+    results.reserve(standard.size());
+    for (std::size_t i = 0; i < standard.size(); ++i) {
+        StandardReturn const &cell = standard[i];
+        int const num = xSizes[i % xSizes.size()] * ySizes[i / xSizes.size()];
+        results.push_back(Statistics(flags, sctrl, num, std::get<0>(cell), std::get<1>(cell),
+                                     std::get<2>(cell), std::get<3>(cell), std::get<4>(cell),
+                                     std::get<5>(cell), std::get<6>(cell)));
+    }
+    return results;
+}
+
+std::vector<Statistics> makeGridStatistics(image::MaskedImage<float> const &mimg,
+                                           std::vector<int> const &xOrigins, std::vector<int> const &xSizes,
+                                           std::vector<int> const &yOrigins, std::vector<int> const &ySizes,
+                                           int const flags, StatisticsControl const &sctrl) {
+    checkGrid(mimg.getWidth(), mimg.getHeight(), xOrigins, xSizes, yOrigins, ySizes, flags, sctrl);
+    image::Mask<image::MaskPixel>::ConstArray const mskArray = mimg.getMask()->getArray();
+    std::vector<StandardReturn> const standard = getGridFusedStandard<true>(
+            *mimg.getImage(), mskArray.getData(), mskArray.getStride<0>(), xOrigins, xSizes, yOrigins, ySizes,
+            sctrl.getAndMask(), sctrl.getNThreads());
+
+    std::vector<Statistics> results;
+    results.reserve(standard.size());
+    for (std::size_t i = 0; i < standard.size(); ++i) {
+        StandardReturn const &cell = standard[i];
+        int const num = xSizes[i % xSizes.size()] * ySizes[i / xSizes.size()];
+        results.push_back(Statistics(flags, sctrl, num, std::get<0>(cell), std::get<1>(cell),
+                                     std::get<2>(cell), std::get<3>(cell), std::get<4>(cell),
+                                     std::get<5>(cell), std::get<6>(cell)));
+    }
+    return results;
+}
+
 /*
  * Explicit instantiations
  *
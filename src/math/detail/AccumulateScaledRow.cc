@@ -0,0 +1,192 @@
+// -*- LSST-C++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Definition of accumulateScaledRow declared in detail/Convolve.h
+ */
+#include <cstddef>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LSST_AFW_MATH_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#include "lsst/afw/math/detail/Convolve.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+
+namespace {
+
+template <typename OutPixelT, typename InPixelT>
+using RowFunction = void (*)(OutPixelT*, InPixelT const*, int, double);
+
+/*
+ * Portable version; also used for the pixels left over at the end of a row by the vectorized versions.
+ * It is not inlined into those, because the compiler may fuse the multiply and add when
+ * compiling for a target that has FMA instructions (such as AVX-512), which would change the result.
+ */
+template <typename OutPixelT, typename InPixelT>
+__attribute__((noinline)) void accumulateScaledRowScalar(OutPixelT* outRow, InPixelT const* inRow, int width,
+                                                         double scale) {
+    for (int i = 0; i < width; ++i) {
+        outRow[i] += static_cast<OutPixelT>(inRow[i] * scale);
+    }
+}
+
+#ifdef LSST_AFW_MATH_HAVE_X86_SIMD
+
+/*
+ * AVX2 versions
+ *
+ * Note that multiplication and addition must be kept separate (no fused multiply-add)
+ * so that the results match the scalar code. AVX2 does not include FMA, so this is automatic.
+ */
+__attribute__((target("avx2"))) void accumulateScaledRowAvx2(float* outRow, float const* inRow, int width,
+                                                              double scale) {
+    __m256d const scaleVec = _mm256_set1_pd(scale);
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        __m128 const lowProd =
+                _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(inRow + i)), scaleVec));
+        __m128 const highProd =
+                _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(inRow + i + 4)), scaleVec));
+        __m256 const prod = _mm256_insertf128_ps(_mm256_castps128_ps256(lowProd), highProd, 1);
+        _mm256_storeu_ps(outRow + i, _mm256_add_ps(_mm256_loadu_ps(outRow + i), prod));
+    }
+    accumulateScaledRowScalar(outRow + i, inRow + i, width - i, scale);
+}
+
+__attribute__((target("avx2"))) void accumulateScaledRowAvx2(double* outRow, float const* inRow, int width,
+                                                              double scale) {
+    __m256d const scaleVec = _mm256_set1_pd(scale);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        __m256d const prod = _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(inRow + i)), scaleVec);
+        _mm256_storeu_pd(outRow + i, _mm256_add_pd(_mm256_loadu_pd(outRow + i), prod));
+    }
+    accumulateScaledRowScalar(outRow + i, inRow + i, width - i, scale);
+}
+
+__attribute__((target("avx2"))) void accumulateScaledRowAvx2(double* outRow, double const* inRow, int width,
+                                                              double scale) {
+    __m256d const scaleVec = _mm256_set1_pd(scale);
+    int i = 0;
+    for (; i + 4 <= width; i += 4) {
+        __m256d const prod = _mm256_mul_pd(_mm256_loadu_pd(inRow + i), scaleVec);
+        _mm256_storeu_pd(outRow + i, _mm256_add_pd(_mm256_loadu_pd(outRow + i), prod));
+    }
+    accumulateScaledRowScalar(outRow + i, inRow + i, width - i, scale);
+}
+
+/*
+ * AVX-512 versions
+ *
+ * AVX-512 implies FMA, so use the explicit-rounding forms of multiply and add,
+ * which the compiler cannot fuse.
+ */
+__attribute__((target("avx512f"))) void accumulateScaledRowAvx512(float* outRow, float const* inRow,
+                                                                   int width, double scale) {
+    __m512d const scaleVec = _mm512_set1_pd(scale);
+    int const rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        __m512d const prod =
+                _mm512_mul_round_pd(_mm512_cvtps_pd(_mm256_loadu_ps(inRow + i)), scaleVec, rounding);
+        _mm256_storeu_ps(outRow + i, _mm256_add_ps(_mm256_loadu_ps(outRow + i), _mm512_cvtpd_ps(prod)));
+    }
+    accumulateScaledRowScalar(outRow + i, inRow + i, width - i, scale);
+}
+
+__attribute__((target("avx512f"))) void accumulateScaledRowAvx512(double* outRow, float const* inRow,
+                                                                   int width, double scale) {
+    __m512d const scaleVec = _mm512_set1_pd(scale);
+    int const rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        __m512d const prod =
+                _mm512_mul_round_pd(_mm512_cvtps_pd(_mm256_loadu_ps(inRow + i)), scaleVec, rounding);
+        _mm512_storeu_pd(outRow + i, _mm512_add_round_pd(_mm512_loadu_pd(outRow + i), prod, rounding));
+    }
+    accumulateScaledRowScalar(outRow + i, inRow + i, width - i, scale);
+}
+
+__attribute__((target("avx512f"))) void accumulateScaledRowAvx512(double* outRow, double const* inRow,
+                                                                   int width, double scale) {
+    __m512d const scaleVec = _mm512_set1_pd(scale);
+    int const rounding = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        __m512d const prod = _mm512_mul_round_pd(_mm512_loadu_pd(inRow + i), scaleVec, rounding);
+        _mm512_storeu_pd(outRow + i, _mm512_add_round_pd(_mm512_loadu_pd(outRow + i), prod, rounding));
+    }
+    accumulateScaledRowScalar(outRow + i, inRow + i, width - i, scale);
+}
+
+/*
+ * Select the best version supported by this CPU
+ */
+template <typename OutPixelT, typename InPixelT>
+RowFunction<OutPixelT, InPixelT> selectAccumulateScaledRow() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return static_cast<RowFunction<OutPixelT, InPixelT>>(&accumulateScaledRowAvx512);
+    } else if (__builtin_cpu_supports("avx2")) {
+        return static_cast<RowFunction<OutPixelT, InPixelT>>(&accumulateScaledRowAvx2);
+    }
+    return &accumulateScaledRowScalar<OutPixelT, InPixelT>;
+}
+
+#else  // no explicitly vectorized versions
+
+template <typename OutPixelT, typename InPixelT>
+RowFunction<OutPixelT, InPixelT> selectAccumulateScaledRow() {
+    return &accumulateScaledRowScalar<OutPixelT, InPixelT>;
+}
+
+#endif
+
+}  // anonymous namespace
+
+template <typename OutPixelT, typename InPixelT>
+void accumulateScaledRow(OutPixelT* outRow, InPixelT const* inRow, int width, double scale) {
+    static RowFunction<OutPixelT, InPixelT> const rowFunction =
+            selectAccumulateScaledRow<OutPixelT, InPixelT>();
+    rowFunction(outRow, inRow, width, scale);
+}
+
+/*
+ * Explicit instantiation
+ */
+/// @cond
+template void accumulateScaledRow(float*, float const*, int, double);
+template void accumulateScaledRow(double*, float const*, int, double);
+template void accumulateScaledRow(double*, double const*, int, double);
+/// @endcond
+}  // namespace detail
+}  // namespace math
+}  // namespace afw
+}  // namespace lsst
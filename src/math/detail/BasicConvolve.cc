@@ -28,7 +28,9 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <memory>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 
 #include "lsst/pex/exceptions.h"
@@ -38,6 +40,7 @@
 #include "lsst/afw/math/ConvolveImage.h"
 #include "lsst/afw/math/Kernel.h"
 #include "lsst/afw/math/detail/Convolve.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace pexExcept = lsst::pex::exceptions;
 
@@ -138,6 +141,218 @@ namespace afw {
 namespace math {
 namespace detail {
 
+namespace {
+
+/**
+ * @internal Convolve the good region of an image one tile at a time, using several threads
+ *
+ * The good region is divided into tiles at most convolutionControl.getTileSize() pixels on a side
+ * (but at least one kernel height high), and tileConvolve is called for each tile on views
+ * of the images that just cover it.
+ * Each call gets its own clone of the kernel (kernels cache intermediate results in mutable members,
+ * so they may not be shared between threads) and a copy of convolutionControl that uses one thread
+ * and direct convolution (by the time an image is tiled, FFT convolution has already been ruled out).
+ * The low-level convolution functions compute each output pixel from the input pixels and kernel alone,
+ * so the result is identical to convolving the whole image at once.
+ *
+ * @param[out] convolvedImage convolved %image
+ * @param[in] inImage %image to convolve
+ * @param[in] kernel convolution kernel
+ * @param[in] convolutionControl convolution control parameters
+ * @param[in] tileConvolve low-level convolution function to apply to each tile
+ */
+template <typename OutImageT, typename InImageT>
+void convolveByTile(OutImageT& convolvedImage, InImageT const& inImage, math::Kernel const& kernel,
+                    math::ConvolutionControl const& convolutionControl,
+                    void (*tileConvolve)(OutImageT&, InImageT const&, math::Kernel const&,
+                                         math::ConvolutionControl const&)) {
+    if (convolutionControl.getTileSize() < 1) {
+        std::ostringstream os;
+        os << "tileSize = " << convolutionControl.getTileSize() << " < 1";
+        throw LSST_EXCEPT(pexExcept::InvalidParameterError, os.str());
+    }
+    // The tile height is a multiple of the kernel height so that the circular row buffer used
+    // for separable kernels is in the same phase for a tile as for the whole image;
+    // otherwise the y dot product would be summed in a different order. It is rounded down,
+    // so it only exceeds tileSize if the kernel is taller than that.
+    int const tileWidth = convolutionControl.getTileSize();
+    int const tileHeight = kernel.getHeight() * std::max(1, tileWidth / kernel.getHeight());
+    lsst::geom::Box2I const goodBBox = kernel.shrinkBBox(inImage.getBBox(image::LOCAL));
+    int const nTilesX = (goodBBox.getWidth() + tileWidth - 1) / tileWidth;
+    int const nTilesY = (goodBBox.getHeight() + tileHeight - 1) / tileHeight;
+    LOGL_DEBUG("TRACE3.afw.math.convolve.convolveByTile",
+               "convolveByTile: %d x %d tiles of up to %d x %d pixels on %d threads", nTilesX, nTilesY,
+               tileWidth, tileHeight, resolveNThreads(convolutionControl.getNThreads()));
+
+    math::ConvolutionControl tileControl(convolutionControl);
+    tileControl.setNThreads(1);
+    tileControl.setAlgorithm(math::ConvolutionControl::DIRECT);
+    parallelFor(nTilesX * nTilesY, convolutionControl.getNThreads(), [&](int tileInd, int) {
+        lsst::geom::Box2I tileBBox(
+                lsst::geom::Point2I(goodBBox.getMinX() + (tileInd % nTilesX) * tileWidth,
+                                    goodBBox.getMinY() + (tileInd / nTilesX) * tileHeight),
+                lsst::geom::Extent2I(tileWidth, tileHeight));
+        tileBBox.clip(goodBBox);
+        lsst::geom::Box2I const viewBBox = kernel.growBBox(tileBBox);
+        OutImageT convolvedView(convolvedImage, viewBBox, image::LOCAL);
+        InImageT const inView(inImage, viewBBox, image::LOCAL);
+        std::shared_ptr<math::Kernel> tileKernelPtr = kernel.clone();
+        tileConvolve(convolvedView, inView, *tileKernelPtr, tileControl);
+    });
+}
+
+/**
+ * @internal Convolve one plane of pixels with a spatially invariant separable kernel, a row at a time
+ *
+ * This uses the same algorithm as the generic code in basicConvolve for separable kernels
+ * (including the circular buffer and the rotation of the kernel y vector), so each output pixel
+ * is computed from the same terms in the same order, but every pass over a row is a single call
+ * to rowOp for each nonzero kernel value, which allows rowOp to be vectorized.
+ *
+ * @param[out] outArray output pixel plane
+ * @param[in] inArray input pixel plane
+ * @param[in] goodBBox good region of the output
+ * @param[in] kernelXVec kernel x vector
+ * @param[in] kernelYVec kernel y vector
+ * @param[in] rowOp functor called as rowOp(outRow, inRow, width, kernelValue) to accumulate one row
+ */
+template <typename OutPixelT, typename InPixelT, typename RowOp>
+void convolvePlaneByRow(ndarray::Array<OutPixelT, 2, 1> const& outArray,
+                        ndarray::Array<InPixelT const, 2, 1> const& inArray,
+                        lsst::geom::Box2I const& goodBBox, std::vector<Kernel::Pixel> const& kernelXVec,
+                        std::vector<Kernel::Pixel> kernelYVec, RowOp const& rowOp) {
+    int const width = goodBBox.getWidth();
+    int const kWidth = kernelXVec.size();
+    int const kHeight = kernelYVec.size();
+    int const inStride = inArray.template getStride<0>();
+    int const outStride = outArray.template getStride<0>();
+
+    // buffer for x-convolved data; a circular buffer along y, as in basicConvolve
+    std::vector<OutPixelT> buffer(static_cast<std::size_t>(width) * kHeight);
+    auto convolveRowX = [&](int inY, int bufY) {
+        OutPixelT* const bufRow = buffer.data() + static_cast<std::size_t>(bufY) * width;
+        InPixelT const* const inRow = inArray.getData() + static_cast<std::ptrdiff_t>(inY) * inStride;
+        std::fill(bufRow, bufRow + width, OutPixelT(0));
+        for (int kx = 0; kx < kWidth; ++kx) {
+            if (kernelXVec[kx] != 0) {
+                rowOp(bufRow, inRow + kx, width, kernelXVec[kx]);
+            }
+        }
+    };
+
+    // pre-fill x-convolved data buffer with all but one row of data
+    for (int yInd = 0; yInd < kHeight - 1; ++yInd) {
+        convolveRowX(yInd, yInd);
+    }
+
+    int inY = kHeight - 1;
+    int bufY = kHeight - 1;
+    int cnvY = goodBBox.getMinY();
+    while (true) {
+        convolveRowX(inY, bufY);
+        OutPixelT* const cnvRow =
+                outArray.getData() + static_cast<std::ptrdiff_t>(cnvY) * outStride + goodBBox.getMinX();
+        std::fill(cnvRow, cnvRow + width, OutPixelT(0));
+        for (int ky = 0; ky < kHeight; ++ky) {
+            if (kernelYVec[ky] != 0) {
+                rowOp(cnvRow, buffer.data() + static_cast<std::size_t>(ky) * width, width, kernelYVec[ky]);
+            }
+        }
+
+        if (cnvY >= goodBBox.getMaxY()) break;
+
+        ++inY;
+        bufY = (bufY + 1) % kHeight;
+        ++cnvY;
+        std::rotate(kernelYVec.begin(), kernelYVec.end() - 1, kernelYVec.end());
+    }
+}
+
+/// @internal Row functor for convolvePlaneByRow that accumulates scaled image or variance pixels
+struct ScaledRowAccumulator {
+    template <typename OutPixelT, typename InPixelT>
+    void operator()(OutPixelT* outRow, InPixelT const* inRow, int width, double scale) const {
+        accumulateScaledRow(outRow, inRow, width, scale);
+    }
+};
+
+/// @internal Row functor for convolvePlaneByRow that ORs together mask pixels
+struct MaskRowAccumulator {
+    void operator()(image::MaskPixel* outRow, image::MaskPixel const* inRow, int width, double) const {
+        for (int i = 0; i < width; ++i) {
+            outRow[i] |= inRow[i];
+        }
+    }
+};
+
+template <typename PixelT>
+using IsRowConvolvable = std::integral_constant<bool, std::is_same<PixelT, float>::value ||
+                                                              std::is_same<PixelT, double>::value>;
+
+/**
+ * @internal Convolve with a spatially invariant separable kernel using convolvePlaneByRow, if supported
+ *
+ * Only Images and MaskedImages with floating-point pixels are supported; this generic version
+ * handles all other types by doing nothing.
+ *
+ * @returns true if the image was convolved, false if the image type is not supported
+ */
+template <typename OutImageT, typename InImageT>
+bool convolveSeparableByRow(OutImageT&, InImageT const&, lsst::geom::Box2I const&,
+                            std::vector<Kernel::Pixel> const&, std::vector<Kernel::Pixel> const&) {
+    return false;
+}
+
+/**
+ * @internal Convolve an Image with a spatially invariant separable kernel using convolvePlaneByRow
+ *
+ * The result is identical to that of the generic code.
+ */
+template <typename OutPixelT, typename InPixelT>
+typename std::enable_if<IsRowConvolvable<OutPixelT>::value && IsRowConvolvable<InPixelT>::value, bool>::type
+convolveSeparableByRow(image::Image<OutPixelT>& convolvedImage, image::Image<InPixelT> const& inImage,
+                       lsst::geom::Box2I const& goodBBox, std::vector<Kernel::Pixel> const& kernelXVec,
+                       std::vector<Kernel::Pixel> const& kernelYVec) {
+    convolvePlaneByRow(convolvedImage.getArray(), inImage.getArray(), goodBBox, kernelXVec, kernelYVec,
+                       ScaledRowAccumulator());
+    return true;
+}
+
+/**
+ * @internal Convolve a MaskedImage with a spatially invariant separable kernel using convolvePlaneByRow
+ *
+ * The image plane is convolved with the kernel, the variance plane with the square of the kernel,
+ * and the mask plane is the OR of the mask pixels under nonzero kernel values.
+ * The generic code evaluates the image and variance with different intermediate precision,
+ * so the results may differ from it by roundoff.
+ */
+template <typename OutPixelT, typename InPixelT>
+typename std::enable_if<IsRowConvolvable<OutPixelT>::value && IsRowConvolvable<InPixelT>::value, bool>::type
+convolveSeparableByRow(image::MaskedImage<OutPixelT, image::MaskPixel, image::VariancePixel>& convolvedImage,
+                       image::MaskedImage<InPixelT, image::MaskPixel, image::VariancePixel> const& inImage,
+                       lsst::geom::Box2I const& goodBBox, std::vector<Kernel::Pixel> const& kernelXVec,
+                       std::vector<Kernel::Pixel> const& kernelYVec) {
+    std::vector<Kernel::Pixel> kernelXVec2(kernelXVec.size());
+    std::vector<Kernel::Pixel> kernelYVec2(kernelYVec.size());
+    std::transform(kernelXVec.begin(), kernelXVec.end(), kernelXVec2.begin(),
+                   [](Kernel::Pixel kVal) { return kVal * kVal; });
+    std::transform(kernelYVec.begin(), kernelYVec.end(), kernelYVec2.begin(),
+                   [](Kernel::Pixel kVal) { return kVal * kVal; });
+
+    image::Image<InPixelT> const& inImagePlane = *inImage.getImage();
+    image::Image<image::VariancePixel> const& inVariancePlane = *inImage.getVariance();
+    image::Mask<image::MaskPixel> const& inMaskPlane = *inImage.getMask();
+    convolvePlaneByRow(convolvedImage.getImage()->getArray(), inImagePlane.getArray(), goodBBox, kernelXVec,
+                       kernelYVec, ScaledRowAccumulator());
+    convolvePlaneByRow(convolvedImage.getVariance()->getArray(), inVariancePlane.getArray(), goodBBox,
+                       kernelXVec2, kernelYVec2, ScaledRowAccumulator());
+    convolvePlaneByRow(convolvedImage.getMask()->getArray(), inMaskPlane.getArray(), goodBBox, kernelXVec,
+                       kernelYVec, MaskRowAccumulator());
+    return true;
+}
+
+}  // anonymous namespace
+
 template <typename OutImageT, typename InImageT>
 void basicConvolve(OutImageT& convolvedImage, InImageT const& inImage, math::Kernel const& kernel,
                    math::ConvolutionControl const& convolutionControl) {
@@ -185,6 +400,12 @@ void basicConvolve(OutImageT& convolvedImage, InImageT const& inImage,
     assert(!kernel.isSpatiallyVarying());
     assertDimensionsOK(convolvedImage, inImage, kernel);
 
+    if (convolutionControl.getNThreads() != 1) {
+        convolveByTile<OutImageT, InImageT>(convolvedImage, inImage, kernel, convolutionControl,
+                                            &basicConvolve<OutImageT, InImageT>);
+        return;
+    }
+
     int const mImageWidth = inImage.getWidth();  // size of input region
     int const mImageHeight = inImage.getHeight();
     int const cnvWidth = mImageWidth + 1 - kernel.getWidth();
@@ -214,7 +435,7 @@ void basicConvolve(OutImageT& convolvedImage, InImageT const& inImage,
         // use the standard algorithm for the spatially invariant case
         LOGL_DEBUG("TRACE2.afw.math.convolve.basicConvolve",
                    "basicConvolve for LinearCombinationKernel: spatially invariant; using brute force");
-        return convolveWithBruteForce(convolvedImage, inImage, kernel, convolutionControl.getDoNormalize());
+        return convolveWithBruteForce(convolvedImage, inImage, kernel, convolutionControl);
     } else {
         // refactor the kernel if this is reasonable and possible;
         // then use the standard algorithm for the spatially varying case
@@ -229,7 +450,15 @@ void basicConvolve(OutImageT& convolvedImage, InImageT const& inImage,
             // too few basis kernels for refactoring to be worthwhile
             refKernelPtr = kernel.clone();
         }
-        if (convolutionControl.getMaxInterpolationDistance() > 1) {
+        if (convolutionControl.getDoBasisConvolution()) {
+            LOGL_DEBUG("TRACE2.afw.math.convolve.basicConvolve",
+                       "basicConvolve for LinearCombinationKernel: using basis convolution");
+            assertDimensionsOK(convolvedImage, inImage, kernel);
+            std::shared_ptr<math::LinearCombinationKernel const> refLCKernelPtr =
+                    std::dynamic_pointer_cast<math::LinearCombinationKernel>(refKernelPtr);
+            return convolveWithBasis(convolvedImage, inImage, refLCKernelPtr ? *refLCKernelPtr : kernel,
+                                     convolutionControl);
+        } else if (convolutionControl.getMaxInterpolationDistance() > 1) {
             LOGL_DEBUG("TRACE2.afw.math.convolve.basicConvolve",
                        "basicConvolve for LinearCombinationKernel: using interpolation");
             return convolveWithInterpolation(convolvedImage, inImage, *refKernelPtr, convolutionControl);
@@ -237,8 +466,7 @@ void basicConvolve(OutImageT& convolvedImage, InImageT const& inImage,
             LOGL_DEBUG("TRACE2.afw.math.convolve.basicConvolve",
                        "basicConvolve for LinearCombinationKernel: maxInterpolationError < 0; using brute "
                        "force");
-            return convolveWithBruteForce(convolvedImage, inImage, *refKernelPtr,
-                                          convolutionControl.getDoNormalize());
+            return convolveWithBruteForce(convolvedImage, inImage, *refKernelPtr, convolutionControl);
         }
     }
 }
@@ -257,6 +485,12 @@ void basicConvolve(OutImageT& convolvedImage, InImageT const& inImage, math::Sep
 
     assertDimensionsOK(convolvedImage, inImage, kernel);
 
+    if (convolutionControl.getNThreads() != 1) {
+        convolveByTile<OutImageT, InImageT>(convolvedImage, inImage, kernel, convolutionControl,
+                                            &basicConvolve<OutImageT, InImageT>);
+        return;
+    }
+
     lsst::geom::Box2I const fullBBox = inImage.getBBox(image::LOCAL);
     lsst::geom::Box2I const goodBBox = kernel.shrinkBBox(fullBBox);
 
@@ -300,6 +534,11 @@ void basicConvolve(OutImageT& convolvedImage, InImageT const& inImage, math::Sep
                    "SeparableKernel basicConvolve: kernel is spatially invariant");
 
         kernel.computeVectors(kernelXVec, kernelYVec, convolutionControl.getDoNormalize());
+        if (convolveSeparableByRow(convolvedImage, inImage, goodBBox, kernelXVec, kernelYVec)) {
+            LOGL_DEBUG("TRACE3.afw.math.convolve.basicConvolve",
+                       "SeparableKernel basicConvolve: convolved row by row");
+            return;
+        }
         KernelIterator const kernelXVecBegin = kernelXVec.begin();
         KernelIterator const kernelYVecBegin = kernelYVec.begin();
 
@@ -369,6 +608,16 @@ void convolveWithBruteForce(OutImageT& convolvedImage, InImageT const& inImage,
 
     assertDimensionsOK(convolvedImage, inImage, kernel);
 
+    if (convolveWithFft(convolvedImage, inImage, kernel, convolutionControl)) {
+        return;
+    }
+
+    if (convolutionControl.getNThreads() != 1) {
+        convolveByTile<OutImageT, InImageT>(convolvedImage, inImage, kernel, convolutionControl,
+                                            &convolveWithBruteForce<OutImageT, InImageT>);
+        return;
+    }
+
     int const inImageWidth = inImage.getWidth();
     int const inImageHeight = inImage.getHeight();
     int const kWidth = kernel.getWidth();
@@ -0,0 +1,307 @@
+// -*- LSST-C++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Definition of convolveWithBasis declared in detail/Convolve.h
+ */
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "lsst/log/Log.h"
+#include "lsst/geom.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/math/ConvolveImage.h"
+#include "lsst/afw/math/Kernel.h"
+#include "lsst/afw/math/detail/Convolve.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+namespace {
+
+/**
+ * @internal The basis kernels and spatial model of a LinearCombinationKernel, evaluated over the good region
+ * of an image
+ */
+class BasisModel {
+public:
+    template <typename ImageT>
+    BasisModel(LinearCombinationKernel const& kernel, ImageT const& inImage,
+               ConvolutionControl const& convolutionControl)
+            : _goodBBox(kernel.shrinkBBox(inImage.getBBox(image::LOCAL))),
+              _spatialFunctionList(kernel.getSpatialFunctionList()),
+              _kernelSumList(kernel.getKernelSumList()),
+              _basisControl(convolutionControl),
+              _colPosList(_goodBBox.getWidth()),
+              _rowPosList(_goodBBox.getHeight()) {
+        // Each basis kernel is applied separately, so give each the center of the combined kernel
+        for (std::shared_ptr<Kernel> const& basisKernelPtr : kernel.getKernelList()) {
+            _basisKernelList.push_back(basisKernelPtr->clone());
+            _basisKernelList.back()->setCtr(kernel.getCtr());
+        }
+        _basisControl.setDoNormalize(false);
+        for (int x = 0; x < _goodBBox.getWidth(); ++x) {
+            _colPosList[x] = inImage.indexToPosition(x + _goodBBox.getMinX(), image::X);
+        }
+        for (int y = 0; y < _goodBBox.getHeight(); ++y) {
+            _rowPosList[y] = inImage.indexToPosition(y + _goodBBox.getMinY(), image::Y);
+        }
+    }
+
+    lsst::geom::Box2I const& getGoodBBox() const { return _goodBBox; }
+    int getNBasisKernels() const { return _basisKernelList.size(); }
+    Kernel const& getBasisKernel(int i) const { return *_basisKernelList[i]; }
+    double getKernelSum(int i) const { return _kernelSumList[i]; }
+
+    /// Convolution control for convolving with one basis kernel
+    ConvolutionControl const& getBasisControl() const { return _basisControl; }
+
+    /// Compute the coefficient of basis kernel i at each pixel of row y of the good region
+    void computeCoefficients(std::vector<double>& coeffList, int i, int y) const {
+        Function2<double> const& func = *_spatialFunctionList[i];
+        coeffList.resize(_colPosList.size());
+        for (std::size_t x = 0; x < _colPosList.size(); ++x) {
+            coeffList[x] = func(_colPosList[x], _rowPosList[y]);
+        }
+    }
+
+private:
+    lsst::geom::Box2I _goodBBox;
+    std::vector<Kernel::SpatialFunctionPtr> _spatialFunctionList;
+    std::vector<double> _kernelSumList;
+    ConvolutionControl _basisControl;
+    KernelList _basisKernelList;
+    std::vector<double> _colPosList;
+    std::vector<double> _rowPosList;
+};
+
+/**
+ * @internal Add coeff * plane to sum over the good region, where coeff is the coefficient
+ * of basis kernel i (times that of basis kernel j, if j >= 0)
+ *
+ * Pixels with a coefficient of zero are skipped, so that non-finite values in the plane
+ * that the full kernel would not reach are ignored.
+ */
+template <typename PixelT>
+void accumulatePlane(image::Image<double>& sum, image::Image<PixelT> const& plane, BasisModel const& model,
+                     int i, int j, double scale) {
+    lsst::geom::Box2I const& goodBBox = model.getGoodBBox();
+    std::vector<double> coeffList, coeffList2;
+    for (int y = 0; y < goodBBox.getHeight(); ++y) {
+        model.computeCoefficients(coeffList, i, y);
+        if (j >= 0) {
+            model.computeCoefficients(coeffList2, j, y);
+            for (std::size_t x = 0; x < coeffList.size(); ++x) {
+                coeffList[x] *= coeffList2[x];
+            }
+        }
+        typename image::Image<PixelT>::const_x_iterator planeIter =
+                plane.x_at(goodBBox.getMinX(), y + goodBBox.getMinY());
+        image::Image<double>::x_iterator sumIter = sum.row_begin(y);
+        for (std::size_t x = 0; x < coeffList.size(); ++x, ++planeIter, ++sumIter) {
+            if (coeffList[x] != 0) {
+                *sumIter += scale * coeffList[x] * *planeIter;
+            }
+        }
+    }
+}
+
+/**
+ * @internal Compute the sum of the combined kernel at each pixel of the good region
+ */
+void computeKernelSums(image::Image<double>& kernelSum, BasisModel const& model) {
+    std::vector<double> coeffList;
+    for (int i = 0; i < model.getNBasisKernels(); ++i) {
+        double const basisSum = model.getKernelSum(i);
+        for (int y = 0; y < kernelSum.getHeight(); ++y) {
+            model.computeCoefficients(coeffList, i, y);
+            image::Image<double>::x_iterator sumIter = kernelSum.row_begin(y);
+            for (std::size_t x = 0; x < coeffList.size(); ++x, ++sumIter) {
+                *sumIter += coeffList[x] * basisSum;
+            }
+        }
+    }
+}
+
+/**
+ * @internal Convolve an Image by combining the images convolved by each basis kernel
+ */
+template <typename OutPixelT, typename InPixelT>
+void convolveImageWithBasis(image::Image<OutPixelT>& convolvedImage, image::Image<InPixelT> const& inImage,
+                            BasisModel const& model, bool doNormalize) {
+    lsst::geom::Box2I const& goodBBox = model.getGoodBBox();
+    image::Image<double> imageSum(goodBBox.getDimensions());
+    image::Image<double> basisImage(inImage.getDimensions());
+    for (int i = 0; i < model.getNBasisKernels(); ++i) {
+        basicConvolve(basisImage, inImage, model.getBasisKernel(i), model.getBasisControl());
+        accumulatePlane(imageSum, basisImage, model, i, -1, 1.0);
+    }
+
+    image::Image<double> kernelSum(goodBBox.getDimensions(), 1.0);
+    if (doNormalize) {
+        kernelSum = 0.0;
+        computeKernelSums(kernelSum, model);
+    }
+    for (int y = 0; y < goodBBox.getHeight(); ++y) {
+        image::Image<double>::const_x_iterator imageIter = imageSum.row_begin(y);
+        image::Image<double>::const_x_iterator sumIter = kernelSum.row_begin(y);
+        typename image::Image<OutPixelT>::x_iterator cnvIter =
+                convolvedImage.x_at(goodBBox.getMinX(), y + goodBBox.getMinY());
+        for (int x = 0; x < goodBBox.getWidth(); ++x, ++imageIter, ++sumIter, ++cnvIter) {
+            *cnvIter = static_cast<OutPixelT>(*imageIter / *sumIter);
+        }
+    }
+}
+
+/**
+ * @internal Convolve a MaskedImage by combining the images convolved by each basis kernel
+ *
+ * The variance plane is convolved by the square of the combined kernel, which is the sum over
+ * all pairs of basis kernels (i, j) of c_i c_j K_i K_j, so the variance plane is also convolved
+ * with the product of each pair of distinct basis kernels that overlap. The mask plane is the OR
+ * of the mask planes smeared by each basis kernel whose coefficient is nonzero.
+ */
+template <typename OutPixelT, typename InPixelT>
+void convolveImageWithBasis(
+        image::MaskedImage<OutPixelT, image::MaskPixel, image::VariancePixel>& convolvedImage,
+        image::MaskedImage<InPixelT, image::MaskPixel, image::VariancePixel> const& inImage,
+        BasisModel const& model, bool doNormalize) {
+    typedef image::Image<Kernel::Pixel> KernelImage;
+    lsst::geom::Box2I const& goodBBox = model.getGoodBBox();
+    int const nBasisKernels = model.getNBasisKernels();
+    image::Image<double> imageSum(goodBBox.getDimensions());
+    image::Image<double> varianceSum(goodBBox.getDimensions());
+    image::Mask<image::MaskPixel> maskSum(goodBBox.getDimensions());
+    image::MaskedImage<double, image::MaskPixel, image::VariancePixel> basisImage(inImage.getDimensions());
+
+    std::vector<double> coeffList;
+    for (int i = 0; i < nBasisKernels; ++i) {
+        basicConvolve(basisImage, inImage, model.getBasisKernel(i), model.getBasisControl());
+        accumulatePlane(imageSum, *basisImage.getImage(), model, i, -1, 1.0);
+        accumulatePlane(varianceSum, *basisImage.getVariance(), model, i, i, 1.0);
+        for (int y = 0; y < goodBBox.getHeight(); ++y) {
+            model.computeCoefficients(coeffList, i, y);
+            image::Mask<image::MaskPixel>::const_x_iterator basisIter =
+                    basisImage.getMask()->x_at(goodBBox.getMinX(), y + goodBBox.getMinY());
+            image::Mask<image::MaskPixel>::x_iterator maskIter = maskSum.row_begin(y);
+            for (std::size_t x = 0; x < coeffList.size(); ++x, ++basisIter, ++maskIter) {
+                if (coeffList[x] != 0) {
+                    *maskIter |= *basisIter;
+                }
+            }
+        }
+    }
+
+    std::vector<KernelImage> basisKernelImageList;
+    basisKernelImageList.reserve(nBasisKernels);
+    for (int i = 0; i < nBasisKernels; ++i) {
+        basisKernelImageList.emplace_back(model.getBasisKernel(i).getDimensions());
+        model.getBasisKernel(i).computeImage(basisKernelImageList.back(), false);
+    }
+    image::Image<double> crossVariance(inImage.getDimensions());
+    int nCrossTerms = 0;
+    for (int i = 0; i < nBasisKernels; ++i) {
+        for (int j = i + 1; j < nBasisKernels; ++j) {
+            KernelImage productImage(basisKernelImageList[i], true);
+            productImage *= basisKernelImageList[j];
+            if (std::all_of(productImage.begin(), productImage.end(),
+                            [](Kernel::Pixel value) { return value == 0; })) {
+                continue;  // e.g. a pair of delta function basis kernels
+            }
+            FixedKernel productKernel(productImage);
+            productKernel.setCtr(model.getBasisKernel(i).getCtr());
+            basicConvolve(crossVariance, *inImage.getVariance(), productKernel, model.getBasisControl());
+            accumulatePlane(varianceSum, crossVariance, model, i, j, 2.0);
+            ++nCrossTerms;
+        }
+    }
+    LOGL_DEBUG("TRACE3.afw.math.convolve.convolveWithBasis",
+               "convolveWithBasis: %d basis kernels and %d variance cross terms", nBasisKernels,
+               nCrossTerms);
+
+    image::Image<double> kernelSum(goodBBox.getDimensions(), 1.0);
+    if (doNormalize) {
+        kernelSum = 0.0;
+        computeKernelSums(kernelSum, model);
+    }
+    for (int y = 0; y < goodBBox.getHeight(); ++y) {
+        image::Image<double>::const_x_iterator imageIter = imageSum.row_begin(y);
+        image::Image<double>::const_x_iterator varianceIter = varianceSum.row_begin(y);
+        image::Image<double>::const_x_iterator sumIter = kernelSum.row_begin(y);
+        image::Mask<image::MaskPixel>::const_x_iterator maskIter = maskSum.row_begin(y);
+        typename image::MaskedImage<OutPixelT, image::MaskPixel, image::VariancePixel>::x_iterator cnvIter =
+                convolvedImage.x_at(goodBBox.getMinX(), y + goodBBox.getMinY());
+        for (int x = 0; x < goodBBox.getWidth();
+             ++x, ++imageIter, ++varianceIter, ++sumIter, ++maskIter, ++cnvIter) {
+            cnvIter.image() = static_cast<OutPixelT>(*imageIter / *sumIter);
+            cnvIter.mask() = *maskIter;
+            cnvIter.variance() = static_cast<image::VariancePixel>(*varianceIter / (*sumIter * *sumIter));
+        }
+    }
+}
+
+}  // anonymous namespace
+
+template <typename OutImageT, typename InImageT>
+void convolveWithBasis(OutImageT& convolvedImage, InImageT const& inImage,
+                       LinearCombinationKernel const& kernel, ConvolutionControl const& convolutionControl) {
+    LOGL_DEBUG("TRACE2.afw.math.convolve.convolveWithBasis", "convolveWithBasis: %d basis kernels",
+               static_cast<int>(kernel.getKernelList().size()));
+    BasisModel const model(kernel, inImage, convolutionControl);
+    convolveImageWithBasis(convolvedImage, inImage, model, convolutionControl.getDoNormalize());
+}
+
+/*
+ * Explicit instantiation
+ */
+/// @cond
+#define IMAGE(PIXTYPE) image::Image<PIXTYPE>
+#define MASKEDIMAGE(PIXTYPE) image::MaskedImage<PIXTYPE, image::MaskPixel, image::VariancePixel>
+#define NL /* */
+// Instantiate Image or MaskedImage versions
+#define INSTANTIATE_IM_OR_MI(IMGMACRO, OUTPIXTYPE, INPIXTYPE)                                  \
+    template void convolveWithBasis(IMGMACRO(OUTPIXTYPE)&, IMGMACRO(INPIXTYPE) const&,         \
+                                    LinearCombinationKernel const&, ConvolutionControl const&);
+// Instantiate both Image and MaskedImage versions
+#define INSTANTIATE(OUTPIXTYPE, INPIXTYPE)             \
+    INSTANTIATE_IM_OR_MI(IMAGE, OUTPIXTYPE, INPIXTYPE) \
+    INSTANTIATE_IM_OR_MI(MASKEDIMAGE, OUTPIXTYPE, INPIXTYPE)
+
+INSTANTIATE(double, double)
+INSTANTIATE(double, float)
+INSTANTIATE(double, int)
+INSTANTIATE(double, std::uint16_t)
+INSTANTIATE(float, float)
+INSTANTIATE(float, int)
+INSTANTIATE(float, std::uint16_t)
+INSTANTIATE(int, int)
+INSTANTIATE(std::uint16_t, std::uint16_t)
+/// @endcond
+}  // namespace detail
+}  // namespace math
+}  // namespace afw
+}  // namespace lsst
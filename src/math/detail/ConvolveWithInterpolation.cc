@@ -38,6 +38,7 @@
 #include "lsst/afw/image/MaskedImage.h"
 #include "lsst/afw/math/Kernel.h"
 #include "lsst/afw/math/detail/Convolve.h"
+#include "lsst/afw/math/detail/Parallel.h"
 
 namespace pexExcept = lsst::pex::exceptions;
 
@@ -76,17 +77,26 @@ void convolveWithInterpolation(OutImageT &outImage, InImageT const &inImage, mat
     LOGL_DEBUG("TRACE3.afw.math.convolve.convolveWithInterpolation",
                "convolveWithInterpolation: divide into %d x %d subregions", nx, ny);
 
-    ConvolveWithInterpolationWorkingImages workingImages(kernel.getDimensions());
+    // computeNextRow computes all the kernel images for a row of subregions, after which the subregions
+    // of that row only read them, so they may be convolved in parallel (each worker with its own
+    // working images); the subregions are the same regardless of the number of threads.
+    int const nThreads = convolutionControl.getNThreads();
+    int const nWorkers = getNWorkers(nx, nThreads);
+    std::vector<ConvolveWithInterpolationWorkingImages> workingImagesList;
+    workingImagesList.reserve(nWorkers);
+    for (int i = 0; i < nWorkers; ++i) {
+        workingImagesList.emplace_back(kernel.getDimensions());
+    }
     RowOfKernelImagesForRegion regionRow(nx, ny);
     while (goodRegion.computeNextRow(regionRow)) {
-        for (RowOfKernelImagesForRegion::ConstIterator rgnIter = regionRow.begin(), rgnEnd = regionRow.end();
-             rgnIter != rgnEnd; ++rgnIter) {
+        parallelFor(nx, nThreads, [&](int rgnInd, int worker) {
+            std::shared_ptr<KernelImagesForRegion const> regionPtr = regionRow.getRegion(rgnInd);
             LOGL_DEBUG("TRACE5.afw.math.convolve.convolveWithInterpolation",
                        "convolveWithInterpolation: bbox minimum=(%d, %d), extent=(%d, %d)",
-                       (*rgnIter)->getBBox().getMinX(), (*rgnIter)->getBBox().getMinY(),
-                       (*rgnIter)->getBBox().getWidth(), (*rgnIter)->getBBox().getHeight());
-            convolveRegionWithInterpolation(outImage, inImage, **rgnIter, workingImages);
-        }
+                       regionPtr->getBBox().getMinX(), regionPtr->getBBox().getMinY(),
+                       regionPtr->getBBox().getWidth(), regionPtr->getBBox().getHeight());
+            convolveRegionWithInterpolation(outImage, inImage, *regionPtr, workingImagesList[worker]);
+        });
     }
 }
 
@@ -0,0 +1,612 @@
+// -*- LSST-C++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Definition of convolveWithFft declared in detail/Convolve.h
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fftw3.h>
+
+#include "lsst/log/Log.h"
+#include "lsst/geom.h"
+#include "lsst/afw/image/MaskedImage.h"
+#include "lsst/afw/math/ConvolveImage.h"
+#include "lsst/afw/math/Kernel.h"
+#include "lsst/afw/math/detail/Convolve.h"
+#include "lsst/afw/math/detail/Parallel.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+namespace {
+
+typedef image::Image<Kernel::Pixel> KernelImage;
+
+/*
+ * Parameters of the cost model used to choose between direct and FFT convolution,
+ * in units of the time taken by one multiply-add of direct convolution
+ */
+double const FFT_FLOP_COST = 1.0;             ///< cost of one floating-point operation of an FFT
+double const FFT_PIXEL_COST = 16.0;           ///< cost of the per-pixel bookkeeping of one padded block
+double const MASK_PIXEL_ROW_COST = 2.0;       ///< cost per pixel per kernel row of smearing the mask plane
+double const MASKED_IMAGE_DIRECT_COST = 3.0;  ///< cost of a direct MaskedImage multiply-add
+
+/// Sizes of padded blocks, all of which FFTW transforms efficiently
+int const FFT_SIZES[] = {32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048};
+
+/// The FFTW planner is not thread-safe (though executing plans is)
+std::mutex fftwPlannerMutex;
+
+template <typename T>
+struct FftwDeleter {
+    void operator()(T* ptr) const { fftw_free(ptr); }
+};
+typedef std::unique_ptr<double[], FftwDeleter<double>> FftwRealArray;
+typedef std::unique_ptr<fftw_complex[], FftwDeleter<fftw_complex>> FftwComplexArray;
+
+FftwRealArray allocateReal(int size) {
+    FftwRealArray result(fftw_alloc_real(static_cast<std::size_t>(size) * size));
+    if (!result) {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+FftwComplexArray allocateComplex(int size) {
+    FftwComplexArray result(fftw_alloc_complex(static_cast<std::size_t>(size) * (size / 2 + 1)));
+    if (!result) {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+/**
+ * @internal Scratch space for transforming one block; all blocks use the same alignment, as FFTW requires
+ */
+struct FftWorkspace {
+    explicit FftWorkspace(int size) : real(allocateReal(size)), spectrum(allocateComplex(size)) {}
+
+    FftwRealArray real;
+    FftwComplexArray spectrum;
+};
+
+/**
+ * @internal The Fourier transform of a kernel image, zero-padded to a square block,
+ * and the plans needed to apply it to blocks of an image
+ *
+ * The kernel is flipped before it is transformed, so that multiplying by the transform cross-correlates
+ * a block with the kernel, as convolveAtAPoint does. Applying the transform to a block of
+ * (size - kernel width + 1) x (size - kernel height + 1) pixels gives the full (unclipped)
+ * result for that block, without wrap-around.
+ */
+class KernelSpectrum {
+public:
+    KernelSpectrum(KernelImage const& kernelImage, int size)
+            : _size(size),
+              _kernelDimensions(kernelImage.getDimensions()),
+              _spectrum(allocateComplex(size)) {
+        FftWorkspace workspace(size);
+        {
+            std::lock_guard<std::mutex> lock(fftwPlannerMutex);
+            _forward = fftw_plan_dft_r2c_2d(size, size, workspace.real.get(), workspace.spectrum.get(),
+                                            FFTW_ESTIMATE);
+            _inverse = fftw_plan_dft_c2r_2d(size, size, workspace.spectrum.get(), workspace.real.get(),
+                                            FFTW_ESTIMATE);
+        }
+        if (!_forward || !_inverse) {
+            destroyPlans();
+            throw LSST_EXCEPT(pex::exceptions::RuntimeError, "Could not create FFTW plans");
+        }
+
+        // Fold the normalization of the unnormalized inverse transform into the kernel
+        double const scale = 1.0 / (static_cast<double>(size) * size);
+        int const kWidth = _kernelDimensions.getX();
+        int const kHeight = _kernelDimensions.getY();
+        std::fill(workspace.real.get(), workspace.real.get() + size * size, 0.0);
+        for (int y = 0; y < kHeight; ++y) {
+            double* realRow = workspace.real.get() + (kHeight - 1 - y) * size + (kWidth - 1);
+            KernelImage::const_x_iterator kernelIter = kernelImage.row_begin(y);
+            for (int x = 0; x < kWidth; ++x, ++kernelIter) {
+                realRow[-x] = *kernelIter * scale;
+            }
+        }
+        fftw_execute_dft_r2c(_forward, workspace.real.get(), _spectrum.get());
+    }
+
+    KernelSpectrum(KernelSpectrum const&) = delete;
+    KernelSpectrum& operator=(KernelSpectrum const&) = delete;
+
+    ~KernelSpectrum() { destroyPlans(); }
+
+    int getSize() const { return _size; }
+    lsst::geom::Extent2I getKernelDimensions() const { return _kernelDimensions; }
+
+    /**
+     * Replace the block in workspace.real by its cross-correlation with the kernel
+     *
+     * Thread-safe, provided each thread has its own workspace.
+     */
+    void apply(FftWorkspace& workspace) const {
+        fftw_execute_dft_r2c(_forward, workspace.real.get(), workspace.spectrum.get());
+        fftw_complex* blockPtr = workspace.spectrum.get();
+        fftw_complex const* kernelPtr = _spectrum.get();
+        int const nComplex = _size * (_size / 2 + 1);
+        for (int i = 0; i < nComplex; ++i, ++blockPtr, ++kernelPtr) {
+            double const re = (*blockPtr)[0] * (*kernelPtr)[0] - (*blockPtr)[1] * (*kernelPtr)[1];
+            double const im = (*blockPtr)[0] * (*kernelPtr)[1] + (*blockPtr)[1] * (*kernelPtr)[0];
+            (*blockPtr)[0] = re;
+            (*blockPtr)[1] = im;
+        }
+        fftw_execute_dft_c2r(_inverse, workspace.spectrum.get(), workspace.real.get());
+    }
+
+private:
+    void destroyPlans() {
+        std::lock_guard<std::mutex> lock(fftwPlannerMutex);
+        if (_forward) {
+            fftw_destroy_plan(_forward);
+        }
+        if (_inverse) {
+            fftw_destroy_plan(_inverse);
+        }
+    }
+
+    int _size;
+    lsst::geom::Extent2I _kernelDimensions;
+    FftwComplexArray _spectrum;
+    fftw_plan _forward = nullptr;
+    fftw_plan _inverse = nullptr;
+};
+
+/**
+ * @internal Estimate the cost of convolving an image by overlap-add with blocks of a given size
+ *
+ * @returns the cost, in units of one multiply-add of direct convolution,
+ *  or a negative value if the block size is too small for the kernel
+ */
+double computeFftCost(lsst::geom::Extent2I const& imageDimensions,
+                      lsst::geom::Extent2I const& kernelDimensions, int size) {
+    // Blocks must be at least as wide as the kernel for overlap-add to be thread-safe (see convolvePlane)
+    int const blockWidth = size + 1 - kernelDimensions.getX();
+    int const blockHeight = size + 1 - kernelDimensions.getY();
+    if (blockWidth < kernelDimensions.getX() || blockHeight < kernelDimensions.getY()) {
+        return -1.0;
+    }
+    double const nBlocks = static_cast<double>((imageDimensions.getX() + blockWidth - 1) / blockWidth) *
+                           ((imageDimensions.getY() + blockHeight - 1) / blockHeight);
+    double const nPixels = static_cast<double>(size) * size;
+    // a real-to-complex transform and its inverse each take about 2.5 n log2(n) flops
+    return nBlocks * (FFT_FLOP_COST * 5.0 * nPixels * std::log2(nPixels) + FFT_PIXEL_COST * nPixels);
+}
+
+/**
+ * @internal Choose the block size for FFT convolution
+ *
+ * @param[in] imageDimensions dimensions of the input image
+ * @param[in] kernelDimensions dimensions of the kernel
+ * @param[in] isMaskedImage is the image a MaskedImage?
+ * @param[in] algorithm requested algorithm
+ * @returns the block size, or 0 to convolve directly
+ */
+int chooseFftSize(lsst::geom::Extent2I const& imageDimensions, lsst::geom::Extent2I const& kernelDimensions,
+                  bool isMaskedImage, ConvolutionControl::Algorithm algorithm) {
+    if (algorithm == ConvolutionControl::DIRECT) {
+        return 0;
+    }
+    int bestSize = 0;
+    double bestCost = 0.0;
+    for (int size : FFT_SIZES) {
+        double const cost = computeFftCost(imageDimensions, kernelDimensions, size);
+        if (cost >= 0.0 && (bestSize == 0 || cost < bestCost)) {
+            bestSize = size;
+            bestCost = cost;
+        }
+    }
+    if (bestSize == 0 || algorithm == ConvolutionControl::FFT) {
+        if (bestSize == 0 && algorithm == ConvolutionControl::FFT) {
+            LOGL_WARN("afw.math.convolve.convolveWithFft",
+                      "Kernel is too large for FFT convolution; convolving directly");
+        }
+        return bestSize;
+    }
+
+    double const nGoodPixels =
+            static_cast<double>(imageDimensions.getX() + 1 - kernelDimensions.getX()) *
+            (imageDimensions.getY() + 1 - kernelDimensions.getY());
+    double directCost = nGoodPixels * kernelDimensions.getX() * kernelDimensions.getY();
+    if (isMaskedImage) {
+        // FFTs are needed for the image and variance planes; the mask plane is smeared directly
+        directCost *= MASKED_IMAGE_DIRECT_COST;
+        bestCost = 2.0 * bestCost + MASK_PIXEL_ROW_COST * nGoodPixels * kernelDimensions.getY();
+    }
+    return bestCost < directCost ? bestSize : 0;
+}
+
+/**
+ * @internal Convolve the good region of one plane of pixels with a kernel by overlap-add
+ *
+ * Non-finite input pixels are treated as 0; the caller must fix the output pixels that depend on them.
+ *
+ * Overlap-add is done one row of blocks at a time, accumulating the full (unclipped) results
+ * in a strip of double-precision pixels. Each block's result overlaps only its immediate neighbours,
+ * so the even-numbered blocks of a row are handled in parallel, then the odd-numbered blocks;
+ * the order of summation, and hence the result, does not depend on the number of threads.
+ */
+template <typename OutPixelT, typename InPixelT>
+void convolvePlane(ndarray::Array<OutPixelT, 2, 1> const& outArray,
+                   ndarray::Array<InPixelT const, 2, 1> const& inArray, KernelSpectrum const& kernelSpectrum,
+                   lsst::geom::Point2I const& kernelCtr, int nThreads) {
+    int const size = kernelSpectrum.getSize();
+    int const kWidth = kernelSpectrum.getKernelDimensions().getX();
+    int const kHeight = kernelSpectrum.getKernelDimensions().getY();
+    int const width = inArray.template getSize<1>();
+    int const height = inArray.template getSize<0>();
+    int const inStride = inArray.template getStride<0>();
+    int const outStride = outArray.template getStride<0>();
+    int const blockWidth = size + 1 - kWidth;
+    int const blockHeight = size + 1 - kHeight;
+    int const nBlocksX = (width + blockWidth - 1) / blockWidth;
+    int const fullWidth = width + kWidth - 1;
+    int const nGoodX = width + 1 - kWidth;
+
+    std::vector<double> strip(static_cast<std::size_t>(blockHeight + kHeight - 1) * fullWidth, 0.0);
+    int const nWorkers = getNWorkers((nBlocksX + 1) / 2, nThreads);
+    std::vector<std::unique_ptr<FftWorkspace>> workspaces;
+    workspaces.reserve(nWorkers);
+    for (int i = 0; i < nWorkers; ++i) {
+        workspaces.emplace_back(new FftWorkspace(size));
+    }
+
+    for (int y0 = 0; y0 < height; y0 += blockHeight) {
+        int const nRows = std::min(blockHeight, height - y0);
+        for (int parity = 0; parity < 2; ++parity) {
+            parallelFor((nBlocksX + 1 - parity) / 2, nThreads, [&](int item, int worker) {
+                FftWorkspace& workspace = *workspaces[worker];
+                double* real = workspace.real.get();
+                int const x0 = (2 * item + parity) * blockWidth;
+                int const nCols = std::min(blockWidth, width - x0);
+
+                std::fill(real, real + size * size, 0.0);
+                for (int y = 0; y < nRows; ++y) {
+                    InPixelT const* inPtr = inArray.getData() + (y0 + y) * inStride + x0;
+                    double* realRow = real + y * size;
+                    for (int x = 0; x < nCols; ++x) {
+                        double const value = inPtr[x];
+                        realRow[x] = std::isfinite(value) ? value : 0.0;
+                    }
+                }
+                kernelSpectrum.apply(workspace);
+                for (int y = 0; y < nRows + kHeight - 1; ++y) {
+                    double const* realRow = real + y * size;
+                    double* stripRow = strip.data() + static_cast<std::size_t>(y) * fullWidth + x0;
+                    for (int x = 0; x < nCols + kWidth - 1; ++x) {
+                        stripRow[x] += realRow[x];
+                    }
+                }
+            });
+        }
+
+        // Full result row y0 + y is complete; it is good output row y0 + y - (kHeight - 1) (less the center)
+        for (int y = std::max(0, kHeight - 1 - y0); y < nRows; ++y) {
+            double const* stripRow = strip.data() + static_cast<std::size_t>(y) * fullWidth + (kWidth - 1);
+            OutPixelT* outPtr = outArray.getData() + (y0 + y - (kHeight - 1) + kernelCtr.getY()) * outStride +
+                                kernelCtr.getX();
+            for (int x = 0; x < nGoodX; ++x) {
+                outPtr[x] = static_cast<OutPixelT>(stripRow[x]);
+            }
+        }
+        std::copy(strip.begin() + static_cast<std::size_t>(nRows) * fullWidth,
+                  strip.begin() + static_cast<std::size_t>(nRows + kHeight - 1) * fullWidth, strip.begin());
+        std::fill(strip.begin() + static_cast<std::size_t>(kHeight - 1) * fullWidth, strip.end(), 0.0);
+    }
+}
+
+/**
+ * @internal Set windowOr[i] to the OR of row[i, i + length) for i in [0, width - length]
+ *
+ * Uses the van Herk/Gil-Werman algorithm, which takes 3 operations per pixel whatever the length.
+ */
+void computeWindowOr(image::MaskPixel const* row, int width, int length,
+                     std::vector<image::MaskPixel>& prefix, std::vector<image::MaskPixel>& suffix,
+                     std::vector<image::MaskPixel>& windowOr) {
+    for (int i = 0; i < width; ++i) {
+        prefix[i] = (i % length == 0) ? row[i] : (prefix[i - 1] | row[i]);
+    }
+    for (int i = width - 1; i >= 0; --i) {
+        suffix[i] = (i % length == length - 1 || i == width - 1) ? row[i] : (suffix[i + 1] | row[i]);
+    }
+    for (int i = 0; i + length <= width; ++i) {
+        windowOr[i] = suffix[i] | prefix[i + length - 1];
+    }
+}
+
+/**
+ * @internal Set each good output mask pixel to the OR of the input mask pixels under nonzero kernel pixels
+ *
+ * The nonzero pixels of each kernel row are described as runs, and each input row is smeared once
+ * for each distinct run length, so the cost barely depends on the kernel width.
+ */
+void smearMask(image::Mask<image::MaskPixel>& outMask, image::Mask<image::MaskPixel> const& inMask,
+               KernelImage const& kernelImage, lsst::geom::Point2I const& kernelCtr) {
+    struct Run {
+        int kernelY;  ///< kernel row
+        int start;    ///< first kernel column
+        int length;   ///< number of kernel columns
+    };
+    int const kWidth = kernelImage.getWidth();
+    int const kHeight = kernelImage.getHeight();
+    std::vector<Run> runs;
+    for (int y = 0; y < kHeight; ++y) {
+        KernelImage::const_x_iterator const kernelRow = kernelImage.row_begin(y);
+        for (int x = 0; x < kWidth;) {
+            if (kernelRow[x] == 0) {
+                ++x;
+                continue;
+            }
+            int const start = x;
+            while (x < kWidth && kernelRow[x] != 0) {
+                ++x;
+            }
+            runs.push_back(Run{y, start, x - start});
+        }
+    }
+    std::vector<int> lengths;
+    for (Run const& run : runs) {
+        lengths.push_back(run.length);
+    }
+    std::sort(lengths.begin(), lengths.end());
+    lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+
+    int const width = inMask.getWidth();
+    int const height = inMask.getHeight();
+    int const nGoodX = width + 1 - kWidth;
+    int const nGoodY = height + 1 - kHeight;
+    for (int y = 0; y < nGoodY; ++y) {
+        std::fill(outMask.x_at(kernelCtr.getX(), y + kernelCtr.getY()),
+                  outMask.x_at(kernelCtr.getX(), y + kernelCtr.getY()) + nGoodX, 0);
+    }
+
+    std::vector<image::MaskPixel> prefix(width), suffix(width);
+    std::vector<std::vector<image::MaskPixel>> windowOrs(lengths.size(),
+                                                         std::vector<image::MaskPixel>(width));
+    for (int inY = 0; inY < height; ++inY) {
+        image::MaskPixel const* inRow = &*inMask.row_begin(inY);
+        for (std::size_t i = 0; i < lengths.size(); ++i) {
+            computeWindowOr(inRow, width, lengths[i], prefix, suffix, windowOrs[i]);
+        }
+        for (Run const& run : runs) {
+            int const goodY = inY - run.kernelY;  // good output row to which this input row contributes
+            if (goodY < 0 || goodY >= nGoodY) {
+                continue;
+            }
+            std::vector<image::MaskPixel> const& windowOr =
+                    windowOrs[std::lower_bound(lengths.begin(), lengths.end(), run.length) - lengths.begin()];
+            image::MaskPixel* outRow = &*outMask.x_at(kernelCtr.getX(), goodY + kernelCtr.getY());
+            image::MaskPixel const* windowRow = windowOr.data() + run.start;
+            for (int x = 0; x < nGoodX; ++x) {
+                outRow[x] |= windowRow[x];
+            }
+        }
+    }
+}
+
+/**
+ * @internal Recompute directly the good output pixels that depend on non-finite input pixels
+ *
+ * @param[in,out] convolvedImage convolved %image
+ * @param[in] inImage %image that was convolved
+ * @param[in] kernelImage kernel %image
+ * @param[in] kernelCtr kernel center
+ * @param[in] isBad callable as isBad(x, y), returns true if input pixel (x, y) is non-finite
+ */
+template <typename OutImageT, typename InImageT, typename IsBad>
+void fixNonFinitePixels(OutImageT& convolvedImage, InImageT const& inImage, KernelImage const& kernelImage,
+                        lsst::geom::Point2I const& kernelCtr, IsBad const& isBad) {
+    int const width = inImage.getWidth();
+    int const height = inImage.getHeight();
+    int const kWidth = kernelImage.getWidth();
+    int const kHeight = kernelImage.getHeight();
+    int const nGoodX = width + 1 - kWidth;
+    int const nGoodY = height + 1 - kHeight;
+
+    std::vector<lsst::geom::Extent2I> kernelOffsets;  // offsets of nonzero kernel pixels
+    for (int y = 0; y < kHeight; ++y) {
+        KernelImage::const_x_iterator kernelIter = kernelImage.row_begin(y);
+        for (int x = 0; x < kWidth; ++x, ++kernelIter) {
+            if (*kernelIter != 0) {
+                kernelOffsets.emplace_back(x, y);
+            }
+        }
+    }
+
+    std::vector<bool> isAffected;  // is good output pixel (x, y) affected? allocated on demand
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (!isBad(x, y)) {
+                continue;
+            }
+            if (isAffected.empty()) {
+                isAffected.resize(static_cast<std::size_t>(nGoodX) * nGoodY, false);
+            }
+            for (lsst::geom::Extent2I const& offset : kernelOffsets) {
+                int const goodX = x - offset.getX();
+                int const goodY = y - offset.getY();
+                if (goodX >= 0 && goodX < nGoodX && goodY >= 0 && goodY < nGoodY) {
+                    isAffected[static_cast<std::size_t>(goodY) * nGoodX + goodX] = true;
+                }
+            }
+        }
+    }
+    if (isAffected.empty()) {
+        return;
+    }
+
+    typename KernelImage::const_xy_locator const kernelLoc = kernelImage.xy_at(0, 0);
+    for (int goodY = 0; goodY < nGoodY; ++goodY) {
+        for (int goodX = 0; goodX < nGoodX; ++goodX) {
+            if (isAffected[static_cast<std::size_t>(goodY) * nGoodX + goodX]) {
+                typename InImageT::const_xy_locator const inLoc = inImage.xy_at(goodX, goodY);
+                *convolvedImage.xy_at(goodX + kernelCtr.getX(), goodY + kernelCtr.getY()) =
+                        convolveAtAPoint<OutImageT, InImageT>(inLoc, kernelLoc, kWidth, kHeight);
+            }
+        }
+    }
+}
+
+template <typename PixelT>
+bool isNonFinite(PixelT value) {
+    return !std::isfinite(static_cast<double>(value));
+}
+
+/**
+ * @internal Convolve an Image using FFTs
+ */
+template <typename OutPixelT, typename InPixelT>
+void convolveImageWithFft(image::Image<OutPixelT>& convolvedImage, image::Image<InPixelT> const& inImage,
+                          KernelImage const& kernelImage, lsst::geom::Point2I const& kernelCtr, int size,
+                          int nThreads) {
+    KernelSpectrum kernelSpectrum(kernelImage, size);
+    convolvePlane(convolvedImage.getArray(), inImage.getArray(), kernelSpectrum, kernelCtr, nThreads);
+    if (std::is_floating_point<InPixelT>::value) {
+        fixNonFinitePixels(convolvedImage, inImage, kernelImage, kernelCtr,
+                           [&inImage](int x, int y) { return isNonFinite(inImage(x, y)); });
+    }
+}
+
+/**
+ * @internal Convolve a MaskedImage using FFTs
+ */
+template <typename OutPixelT, typename InPixelT>
+void convolveImageWithFft(
+        image::MaskedImage<OutPixelT, image::MaskPixel, image::VariancePixel>& convolvedImage,
+        image::MaskedImage<InPixelT, image::MaskPixel, image::VariancePixel> const& inImage,
+        KernelImage const& kernelImage, lsst::geom::Point2I const& kernelCtr, int size, int nThreads) {
+    image::Image<InPixelT> const& inImagePlane = *inImage.getImage();
+    image::Image<image::VariancePixel> const& inVariancePlane = *inImage.getVariance();
+    {
+        KernelSpectrum kernelSpectrum(kernelImage, size);
+        convolvePlane(convolvedImage.getImage()->getArray(), inImagePlane.getArray(), kernelSpectrum,
+                      kernelCtr, nThreads);
+    }
+    {
+        KernelImage kernelImage2(kernelImage, true);
+        kernelImage2 *= kernelImage;
+        KernelSpectrum kernelSpectrum2(kernelImage2, size);
+        convolvePlane(convolvedImage.getVariance()->getArray(), inVariancePlane.getArray(), kernelSpectrum2,
+                      kernelCtr, nThreads);
+    }
+    smearMask(*convolvedImage.getMask(), *inImage.getMask(), kernelImage, kernelCtr);
+    fixNonFinitePixels(convolvedImage, inImage, kernelImage, kernelCtr,
+                       [&inImagePlane, &inVariancePlane](int x, int y) {
+                           return isNonFinite(inImagePlane(x, y)) || isNonFinite(inVariancePlane(x, y));
+                       });
+}
+
+template <typename ImageT>
+struct IsMaskedImage : std::is_same<typename ImageT::image_category, image::detail::MaskedImage_tag> {};
+
+template <typename OutImageT>
+using IsFftConvolvable = std::is_floating_point<typename OutImageT::Image::SinglePixel>;
+
+/**
+ * @internal Convolve using FFTs, if the cost model and image types allow it
+ *
+ * This generic version handles output images with integer pixels, which are always convolved directly.
+ */
+template <typename OutImageT, typename InImageT>
+typename std::enable_if<!IsFftConvolvable<OutImageT>::value, bool>::type convolveWithFftIfSupported(
+        OutImageT&, InImageT const&, Kernel const&, ConvolutionControl const&) {
+    return false;
+}
+
+template <typename OutImageT, typename InImageT>
+typename std::enable_if<IsFftConvolvable<OutImageT>::value, bool>::type convolveWithFftIfSupported(
+        OutImageT& convolvedImage, InImageT const& inImage, Kernel const& kernel,
+        ConvolutionControl const& convolutionControl) {
+    if (kernel.isSpatiallyVarying()) {
+        return false;
+    }
+    int const size = chooseFftSize(inImage.getDimensions(), kernel.getDimensions(),
+                                   IsMaskedImage<InImageT>::value, convolutionControl.getAlgorithm());
+    if (size == 0) {
+        return false;
+    }
+    LOGL_DEBUG("TRACE2.afw.math.convolve.convolveWithFft", "convolveWithFft: using %dx%d blocks", size,
+               size);
+
+    KernelImage kernelImage(kernel.getDimensions());
+    (void)kernel.computeImage(kernelImage, convolutionControl.getDoNormalize());
+    convolveImageWithFft(convolvedImage, inImage, kernelImage, kernel.getCtr(), size,
+                         convolutionControl.getNThreads());
+    return true;
+}
+
+}  // anonymous namespace
+
+template <typename OutImageT, typename InImageT>
+bool convolveWithFft(OutImageT& convolvedImage, InImageT const& inImage, Kernel const& kernel,
+                     ConvolutionControl const& convolutionControl) {
+    return convolveWithFftIfSupported(convolvedImage, inImage, kernel, convolutionControl);
+}
+
+/*
+ * Explicit instantiation
+ */
+/// @cond
+#define IMAGE(PIXTYPE) image::Image<PIXTYPE>
+#define MASKEDIMAGE(PIXTYPE) image::MaskedImage<PIXTYPE, image::MaskPixel, image::VariancePixel>
+#define NL /* */
+// Instantiate Image or MaskedImage versions
+#define INSTANTIATE_IM_OR_MI(IMGMACRO, OUTPIXTYPE, INPIXTYPE)                                       \
+    template bool convolveWithFft(IMGMACRO(OUTPIXTYPE)&, IMGMACRO(INPIXTYPE) const&, Kernel const&, \
+                                  ConvolutionControl const&);
+// Instantiate both Image and MaskedImage versions
+#define INSTANTIATE(OUTPIXTYPE, INPIXTYPE)             \
+    INSTANTIATE_IM_OR_MI(IMAGE, OUTPIXTYPE, INPIXTYPE) \
+    INSTANTIATE_IM_OR_MI(MASKEDIMAGE, OUTPIXTYPE, INPIXTYPE)
+
+INSTANTIATE(double, double)
+INSTANTIATE(double, float)
+INSTANTIATE(double, int)
+INSTANTIATE(double, std::uint16_t)
+INSTANTIATE(float, float)
+INSTANTIATE(float, int)
+INSTANTIATE(float, std::uint16_t)
+INSTANTIATE(int, int)
+INSTANTIATE(std::uint16_t, std::uint16_t)
+/// @endcond
+}  // namespace detail
+}  // namespace math
+}  // namespace afw
+}  // namespace lsst
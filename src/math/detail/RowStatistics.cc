@@ -0,0 +1,199 @@
+// -*- LSST-C++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Definition of accumulateRowStatistics declared in detail/RowStatistics.h
+ */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LSST_AFW_MATH_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#include "lsst/afw/math/detail/RowStatistics.h"
+
+namespace lsst {
+namespace afw {
+namespace math {
+namespace detail {
+
+using image::MaskPixel;
+
+RowStatisticsSums::RowStatisticsSums() {
+    for (int l = 0; l < nLanes; ++l) {
+        n[l] = 0;
+        sum[l] = 0.0;
+        sum2[l] = 0.0;
+        min[l] = std::numeric_limits<float>::infinity();
+        max[l] = -std::numeric_limits<float>::infinity();
+        orMask[l] = 0x0;
+    }
+}
+
+namespace {
+
+using RowFunction = void (*)(float const*, MaskPixel const*, int, double, MaskPixel, RowStatisticsSums&);
+
+/*
+ * Portable version; also used for the pixels left over at the end of a row by the vectorized version.
+ * It is not inlined into that, so that the compiler cannot fuse the multiply and add of the sum of
+ * squares when compiling it for a target that has FMA instructions, which would change the result.
+ */
+template <bool hasMask>
+__attribute__((noinline)) void accumulateRowStatisticsScalar(float const* row, MaskPixel const* maskRow,
+                                                             int width, double shift, MaskPixel andMask,
+                                                             RowStatisticsSums& sums) {
+    float const maxFinite = std::numeric_limits<float>::max();
+    for (int i = 0; i < width; ++i) {
+        float const value = row[i];
+        MaskPixel const mask = hasMask ? maskRow[i] : 0x0;
+        if (std::abs(value) <= maxFinite && !(mask & andMask)) {  // false for NaN
+            int const l = i % RowStatisticsSums::nLanes;
+            double const delta = static_cast<double>(value) - shift;
+
+            sums.n[l] += 1;
+            sums.sum[l] += delta;
+            sums.sum2[l] += delta * delta;
+            sums.min[l] = std::min(sums.min[l], value);
+            sums.max[l] = std::max(sums.max[l], value);
+            sums.orMask[l] |= mask;
+        }
+    }
+}
+
+#ifdef LSST_AFW_MATH_HAVE_X86_SIMD
+
+/*
+ * AVX2 version
+ *
+ * Each of the eight lanes accumulates the same pixels in the same order as the scalar version,
+ * and bad pixels contribute exactly zero to the sums, so the results are identical.
+ */
+template <bool hasMask>
+__attribute__((target("avx2"))) void accumulateRowStatisticsAvx2(float const* row, MaskPixel const* maskRow,
+                                                                  int width, double shift, MaskPixel andMask,
+                                                                  RowStatisticsSums& sums) {
+    static_assert(RowStatisticsSums::nLanes == 8, "Each lane must be one float in an AVX2 register");
+    static_assert(sizeof(MaskPixel) == 4, "Each lane must be one MaskPixel in an AVX2 register");
+
+    __m256 const absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 const maxFinite = _mm256_set1_ps(std::numeric_limits<float>::max());
+    __m256 const posInf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256 const negInf = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+    __m256i const andMaskVec = _mm256_set1_epi32(andMask);
+    __m256i const zero = _mm256_setzero_si256();
+    __m256d const shiftVec = _mm256_set1_pd(shift);
+
+    __m256i n = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(sums.n));
+    __m256d sumLow = _mm256_loadu_pd(sums.sum);
+    __m256d sumHigh = _mm256_loadu_pd(sums.sum + 4);
+    __m256d sum2Low = _mm256_loadu_pd(sums.sum2);
+    __m256d sum2High = _mm256_loadu_pd(sums.sum2 + 4);
+    __m256 min = _mm256_loadu_ps(sums.min);
+    __m256 max = _mm256_loadu_ps(sums.max);
+    __m256i orMask = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(sums.orMask));
+
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        __m256 const value = _mm256_loadu_ps(row + i);
+        // all bits set for good pixels; the ordered comparison is false for NaN
+        __m256i good = _mm256_castps_si256(
+                _mm256_cmp_ps(_mm256_and_ps(value, absMask), maxFinite, _CMP_LE_OQ));
+        __m256i mask = zero;
+        if (hasMask) {
+            mask = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(maskRow + i));
+            good = _mm256_and_si256(good, _mm256_cmpeq_epi32(_mm256_and_si256(mask, andMaskVec), zero));
+        }
+        __m256 const goodPs = _mm256_castsi256_ps(good);
+        __m256d const goodLow = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(good)));
+        __m256d const goodHigh =
+                _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm256_extracti128_si256(good, 1)));
+
+        // (value - shift) for good pixels, and exactly 0 for bad ones (even if value is NaN)
+        __m256d const deltaLow = _mm256_and_pd(
+                _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(value)), shiftVec), goodLow);
+        __m256d const deltaHigh = _mm256_and_pd(
+                _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(value, 1)), shiftVec), goodHigh);
+
+        n = _mm256_sub_epi32(n, good);  // good is -1 for good pixels
+        sumLow = _mm256_add_pd(sumLow, deltaLow);
+        sumHigh = _mm256_add_pd(sumHigh, deltaHigh);
+        sum2Low = _mm256_add_pd(sum2Low, _mm256_mul_pd(deltaLow, deltaLow));
+        sum2High = _mm256_add_pd(sum2High, _mm256_mul_pd(deltaHigh, deltaHigh));
+        min = _mm256_min_ps(min, _mm256_blendv_ps(posInf, value, goodPs));
+        max = _mm256_max_ps(max, _mm256_blendv_ps(negInf, value, goodPs));
+        orMask = _mm256_or_si256(orMask, _mm256_and_si256(mask, good));
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums.n), n);
+    _mm256_storeu_pd(sums.sum, sumLow);
+    _mm256_storeu_pd(sums.sum + 4, sumHigh);
+    _mm256_storeu_pd(sums.sum2, sum2Low);
+    _mm256_storeu_pd(sums.sum2 + 4, sum2High);
+    _mm256_storeu_ps(sums.min, min);
+    _mm256_storeu_ps(sums.max, max);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums.orMask), orMask);
+
+    // i is a multiple of nLanes, so the remaining pixels go into the right lanes
+    accumulateRowStatisticsScalar<hasMask>(row + i, hasMask ? maskRow + i : nullptr, width - i, shift,
+                                           andMask, sums);
+}
+
+/*
+ * Select the best version supported by this CPU
+ */
+template <bool hasMask>
+RowFunction selectAccumulateRowStatistics() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &accumulateRowStatisticsAvx2<hasMask>;
+    }
+    return &accumulateRowStatisticsScalar<hasMask>;
+}
+
+#else  // no explicitly vectorized versions
+
+template <bool hasMask>
+RowFunction selectAccumulateRowStatistics() {
+    return &accumulateRowStatisticsScalar<hasMask>;
+}
+
+#endif
+
+}  // anonymous namespace
+
+void accumulateRowStatistics(float const* row, MaskPixel const* maskRow, int width, double shift,
+                             MaskPixel andMask, RowStatisticsSums& sums) {
+    static RowFunction const withMask = selectAccumulateRowStatistics<true>();
+    static RowFunction const withoutMask = selectAccumulateRowStatistics<false>();
+    (maskRow ? withMask : withoutMask)(row, maskRow, width, shift, andMask, sums);
+}
+
+}  // namespace detail
+}  // namespace math
+}  // namespace afw
+}  // namespace lsst
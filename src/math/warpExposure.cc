@@ -25,6 +25,7 @@
  * Support for warping an %image to a new Wcs.
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -48,6 +49,7 @@
 #include "lsst/afw/geom.h"
 #include "lsst/afw/math/Kernel.h"
 #include "lsst/afw/image/PhotoCalib.h"
+#include "lsst/afw/math/detail/Parallel.h"
 #include "lsst/afw/math/detail/WarpAtOnePoint.h"
 
 namespace pexExcept = lsst::pex::exceptions;
@@ -105,6 +107,69 @@ void LanczosWarpingKernel::setKernelParameter(unsigned int ind, double value) co
     SeparableKernel::setKernelParameter(ind, value);
 }
 
+LanczosLutWarpingKernel::LanczosLutWarpingKernel(int order, int oversample)
+        : LanczosLutWarpingKernel(LanczosLutFunction1(order, oversample)) {}
+
+LanczosLutWarpingKernel::LanczosLutWarpingKernel(LanczosLutFunction1 const &function)
+        : SeparableKernel(2 * function.getOrder(), 2 * function.getOrder(), function, function) {}
+
+std::shared_ptr<Kernel> LanczosLutWarpingKernel::clone() const {
+    // share the table of the original
+    auto const functionPtr = std::dynamic_pointer_cast<LanczosLutFunction1>(getKernelColFunction());
+    return std::shared_ptr<Kernel>(new LanczosLutWarpingKernel(*functionPtr));
+}
+
+int LanczosLutWarpingKernel::getOrder() const { return this->getWidth() / 2; }
+
+int LanczosLutWarpingKernel::getOversample() const {
+    return std::dynamic_pointer_cast<LanczosLutFunction1>(getKernelColFunction())->getOversample();
+}
+
+void LanczosLutWarpingKernel::setKernelParameter(unsigned int ind, double value) const {
+    checkWarpingKernelParameter(this, ind, value);
+    SeparableKernel::setKernelParameter(ind, value);
+}
+
+LanczosLutWarpingKernel::LanczosLutFunction1::LanczosLutFunction1(int order, int oversample, double xOffset)
+        : Function1<Kernel::Pixel>(1), _order(order), _oversample(oversample), _table() {
+    if (order < 1) {
+        std::ostringstream os;
+        os << "order = " << order << " < 1";
+        throw LSST_EXCEPT(pexExcept::InvalidParameterError, os.str());
+    }
+    if (oversample < 1) {
+        std::ostringstream os;
+        os << "oversample = " << oversample << " < 1";
+        throw LSST_EXCEPT(pexExcept::InvalidParameterError, os.str());
+    }
+    this->_params[0] = xOffset;
+
+    LanczosFunction1<double> lanczosFunction(order);
+    std::size_t const tableSize = static_cast<std::size_t>(order) * oversample + 1;
+    auto table = std::make_shared<std::vector<double>>(tableSize);
+    for (std::size_t i = 0; i < tableSize; ++i) {
+        (*table)[i] = lanczosFunction(static_cast<double>(i) / static_cast<double>(oversample));
+    }
+    _table = table;
+}
+
+LanczosLutWarpingKernel::LanczosLutFunction1::LanczosLutFunction1(
+        int order, int oversample, std::shared_ptr<std::vector<double> const> table, double xOffset)
+        : Function1<Kernel::Pixel>(1), _order(order), _oversample(oversample), _table(table) {
+    this->_params[0] = xOffset;
+}
+
+std::shared_ptr<Function1<Kernel::Pixel>> LanczosLutWarpingKernel::LanczosLutFunction1::clone() const {
+    return Function1Ptr(new LanczosLutFunction1(_order, _oversample, _table, this->_params[0]));
+}
+
+std::string LanczosLutWarpingKernel::LanczosLutFunction1::toString(std::string const &prefix) const {
+    std::ostringstream os;
+    os << "_LanczosLutFunction1 [" << _order << ", " << _oversample << "]: ";
+    os << Function1<Kernel::Pixel>::toString(prefix);
+    return os.str();
+}
+
 std::shared_ptr<Kernel> BilinearWarpingKernel::clone() const {
     return std::shared_ptr<Kernel>(new BilinearWarpingKernel());
 }
@@ -162,8 +227,20 @@ std::shared_ptr<SeparableKernel> makeWarpingKernel(std::string name) {
     typedef std::shared_ptr<SeparableKernel> KernelPtr;
     boost::cmatch matches;
     static const boost::regex LanczosRE("lanczos(\\d+)");
+    static const boost::regex LanczosLutRE("lanczos(\\d+)-lut(\\d*)");
     if (name == "bilinear") {
         return KernelPtr(new BilinearWarpingKernel());
+    } else if (boost::regex_match(name.c_str(), matches, LanczosLutRE)) {
+        std::string orderStr(matches[1].first, matches[1].second);
+        int order;
+        std::istringstream(orderStr) >> order;
+        if (matches[2].length() == 0) {
+            return KernelPtr(new LanczosLutWarpingKernel(order));
+        }
+        std::string oversampleStr(matches[2].first, matches[2].second);
+        int oversample;
+        std::istringstream(oversampleStr) >> oversample;
+        return KernelPtr(new LanczosLutWarpingKernel(order, oversample));
     } else if (boost::regex_match(name.c_str(), matches, LanczosRE)) {
         std::string orderStr(matches[1].first, matches[1].second);
         int order;
@@ -253,6 +330,19 @@ int warpExposure(DestExposureT &destExposure, SrcExposureT const &srcExposure, W
 
 namespace {
 
+// Number of destination rows in each unit of work handed to a thread when not interpolating
+int const NoInterpBandHeight = 16;
+
+// Scratch space for one thread of warpImage when interpolating
+struct InterpWorkspace {
+    InterpWorkspace(int destWidth, int nEdgeCols) : srcPosList(1 + destWidth), yDeltaSrcPosList(nEdgeCols) {}
+
+    // Source positions for the current or previous row of the destination image, starting at column -1
+    std::vector<lsst::geom::Point2D> srcPosList;
+    // Delta source positions along the edge columns of the current horizontal interpolation band
+    std::vector<lsst::geom::Extent2D> yDeltaSrcPosList;
+};
+
 inline lsst::geom::Point2D computeSrcPos(
         int destCol,                         ///< @internal destination column index
         int destRow,                         ///< @internal destination row index
@@ -315,8 +405,6 @@ int warpImage(DestImageT &destImage, SrcImageT const &srcImage,
     std::shared_ptr<LanczosWarpingKernel const> const lanczosKernelPtr =
             std::dynamic_pointer_cast<LanczosWarpingKernel>(warpingKernelPtr);
 
-    int numGoodPixels = 0;
-
     // compute a transform from local destination pixels to parent source pixels
     auto const parentDestToParentSrc = srcToDest.inverted();
     std::vector<double> const localDestToParentDestVec = {static_cast<double>(destImage.getX0()),
@@ -339,7 +427,25 @@ int warpImage(DestImageT &destImage, SrcImageT const &srcImage,
     int const maxCol = destWidth - 1;
     int const maxRow = destHeight - 1;
 
-    detail::WarpAtOnePoint<DestImageT, SrcImageT> warpAtOnePoint(srcImage, control, padValue);
+    // One WarpAtOnePoint per worker thread, each with its own clone of the warping kernels
+    // (the kernels hold the current fractional pixel position as mutable state).
+    int const nRowBands = (interpLength > 0) ? (destHeight + interpLength - 1) / interpLength
+                                             : (destHeight + NoInterpBandHeight - 1) / NoInterpBandHeight;
+    int const nWorkers = detail::getNWorkers(nRowBands, control.getNThreads());
+    std::vector<std::unique_ptr<detail::WarpAtOnePoint<DestImageT, SrcImageT>>> warpAtOnePointList;
+    warpAtOnePointList.reserve(nWorkers);
+    warpAtOnePointList.emplace_back(
+            new detail::WarpAtOnePoint<DestImageT, SrcImageT>(srcImage, control, padValue));
+    for (int worker = 1; worker < nWorkers; ++worker) {
+        WarpingControl workerControl(control);
+        workerControl.setWarpingKernel(*control.getWarpingKernel());
+        if (control.hasMaskWarpingKernel()) {
+            workerControl.setMaskWarpingKernel(*control.getMaskWarpingKernel());
+        }
+        warpAtOnePointList.emplace_back(
+                new detail::WarpAtOnePoint<DestImageT, SrcImageT>(srcImage, workerControl, padValue));
+    }
+    std::vector<int> numGoodPixelsList(nWorkers, 0);
 
     if (interpLength > 0) {
         // Use interpolation. Note that 1 produces the same result as no interpolation
@@ -371,72 +477,76 @@ int warpImage(DestImageT &destImage, SrcImageT const &srcImage,
             invWidthList.push_back(1.0 / static_cast<double>(endCol - prevEndCol));
         }
         assert(edgeColList.back() == maxCol);
-
-        // A list of delta source positions along the edge columns of the horizontal interpolation bands
-        std::vector<lsst::geom::Extent2D> yDeltaSrcPosList(edgeColList.size());
-
-        // A cache of pixel positions on the source corresponding to the previous or current row
-        // of the destination image.
-        // The first value is for column -1 because the previous source position is used to compute relative
-        // area To simplify the indexing, use an iterator that starts at begin+1, thus: srcPosView =
-        // srcPosList.begin() + 1 srcPosView[col-1] and lower indices are for this row srcPosView[col] and
-        // higher indices are for the previous row
-        std::vector<lsst::geom::Point2D> srcPosList(1 + destWidth);
-        std::vector<lsst::geom::Point2D>::iterator const srcPosView = srcPosList.begin() + 1;
-
-        std::vector<lsst::geom::Point2D> endColPosList;
-        endColPosList.reserve(numColEdges);
-
-        // Initialize srcPosList for row -1
-        for (int colBand = 0, endBand = edgeColList.size(); colBand < endBand; ++colBand) {
-            int const endCol = edgeColList[colBand];
-            endColPosList.emplace_back(lsst::geom::Point2D(endCol, -1));
+        int const nEdgeCols = edgeColList.size();
+
+        // A list of edge row indices for the horizontal interpolation bands, constructed like edgeColList;
+        // row band i covers rows edgeRowList[i] + 1 through edgeRowList[i + 1]
+        std::vector<int> edgeRowList;
+        edgeRowList.reserve(nRowBands + 1);
+        edgeRowList.push_back(-1);
+        for (int prevEndRow = -1; prevEndRow < maxRow; prevEndRow += interpLength) {
+            edgeRowList.push_back(std::min(prevEndRow + interpLength, maxRow));
         }
-        auto rightSrcPosList = localDestToParentSrc->applyForward(endColPosList);
-        srcPosView[-1] = rightSrcPosList[0];
-        for (int colBand = 1, endBand = edgeColList.size(); colBand < endBand; ++colBand) {
-            int const prevEndCol = edgeColList[colBand - 1];
-            int const endCol = edgeColList[colBand];
-            lsst::geom::Point2D leftSrcPos = srcPosView[prevEndCol];
-
-            lsst::geom::Extent2D xDeltaSrcPos =
-                    (rightSrcPosList[colBand] - leftSrcPos) * invWidthList[colBand];
-
-            for (int col = prevEndCol + 1; col <= endCol; ++col) {
-                srcPosView[col] = srcPosView[col - 1] + xDeltaSrcPos;
+        assert(static_cast<int>(edgeRowList.size()) == nRowBands + 1);
+
+        // Source positions at the corners of all interpolation bands, computed in one call;
+        // the entry for edge row i and edge column j is edgeSrcPosList[i * nEdgeCols + j]
+        std::vector<lsst::geom::Point2D> edgeDestPosList;
+        edgeDestPosList.reserve(edgeRowList.size() * nEdgeCols);
+        for (int edgeRow : edgeRowList) {
+            for (int edgeCol : edgeColList) {
+                edgeDestPosList.emplace_back(lsst::geom::Point2D(edgeCol, edgeRow));
             }
         }
-
-        int endRow = -1;
-        while (endRow < maxRow) {
-            // Next horizontal interpolation band
-
-            int prevEndRow = endRow;
-            endRow = prevEndRow + interpLength;
-            if (endRow > maxRow) {
-                endRow = maxRow;
+        auto const edgeSrcPosList = localDestToParentSrc->applyForward(edgeDestPosList);
+
+        // Scratch space for each worker, allocated here so the row band loop does no heap allocation.
+        // srcPosList is a cache of pixel positions on the source corresponding to the previous or current
+        // row of the destination image. The first value is for column -1 because the previous source
+        // position is used to compute relative area. To simplify the indexing, use an iterator that starts
+        // at begin+1, thus: srcPosView = srcPosList.begin() + 1; srcPosView[col-1] and lower indices are
+        // for this row; srcPosView[col] and higher indices are for the previous row
+        std::vector<InterpWorkspace> workspaceList(nWorkers, InterpWorkspace(destWidth, nEdgeCols));
+
+        detail::parallelFor(nRowBands, control.getNThreads(), [&](int rowBand, int worker) {
+            detail::WarpAtOnePoint<DestImageT, SrcImageT>& warpAtOnePoint = *warpAtOnePointList[worker];
+            InterpWorkspace& workspace = workspaceList[worker];
+            std::vector<lsst::geom::Point2D>::iterator const srcPosView = workspace.srcPosList.begin() + 1;
+            std::vector<lsst::geom::Extent2D>& yDeltaSrcPosList = workspace.yDeltaSrcPosList;
+            auto const topSrcPosIter = edgeSrcPosList.begin() + rowBand * nEdgeCols;
+            auto const bottomSrcPosIter = topSrcPosIter + nEdgeCols;
+
+            // Initialize srcPosView for the row above the band
+            srcPosView[-1] = topSrcPosIter[0];
+            for (int colBand = 1; colBand < nEdgeCols; ++colBand) {
+                int const prevEndCol = edgeColList[colBand - 1];
+                int const endCol = edgeColList[colBand];
+                lsst::geom::Point2D leftSrcPos = srcPosView[prevEndCol];
+
+                lsst::geom::Extent2D xDeltaSrcPos =
+                        (topSrcPosIter[colBand] - leftSrcPos) * invWidthList[colBand];
+
+                for (int col = prevEndCol + 1; col <= endCol; ++col) {
+                    srcPosView[col] = srcPosView[col - 1] + xDeltaSrcPos;
+                }
             }
+
+            int const prevEndRow = edgeRowList[rowBand];
+            int const endRow = edgeRowList[rowBand + 1];
             assert(endRow - prevEndRow > 0);
             double interpInvHeight = 1.0 / static_cast<double>(endRow - prevEndRow);
 
             // Set yDeltaSrcPosList for this horizontal interpolation band
-            std::vector<lsst::geom::Point2D> destRowPosList;
-            destRowPosList.reserve(edgeColList.size());
-            for (int colBand = 0, endBand = edgeColList.size(); colBand < endBand; ++colBand) {
-                int endCol = edgeColList[colBand];
-                destRowPosList.emplace_back(lsst::geom::Point2D(endCol, endRow));
-            }
-            auto bottomSrcPosList = localDestToParentSrc->applyForward(destRowPosList);
-            for (int colBand = 0, endBand = edgeColList.size(); colBand < endBand; ++colBand) {
+            for (int colBand = 0; colBand < nEdgeCols; ++colBand) {
                 int endCol = edgeColList[colBand];
                 yDeltaSrcPosList[colBand] =
-                        (bottomSrcPosList[colBand] - srcPosView[endCol]) * interpInvHeight;
+                        (bottomSrcPosIter[colBand] - srcPosView[endCol]) * interpInvHeight;
             }
 
             for (int row = prevEndRow + 1; row <= endRow; ++row) {
                 typename DestImageT::x_iterator destXIter = destImage.row_begin(row);
                 srcPosView[-1] += yDeltaSrcPosList[0];
-                for (int colBand = 1, endBand = edgeColList.size(); colBand < endBand; ++colBand) {
+                for (int colBand = 1; colBand < nEdgeCols; ++colBand) {
                     // Next vertical interpolation band
 
                     int const prevEndCol = edgeColList[colBand - 1];
@@ -459,50 +569,79 @@ int warpImage(DestImageT &destImage, SrcImageT const &srcImage,
                         if (warpAtOnePoint(
                                     destXIter, srcPos, relativeArea,
                                     typename image::detail::image_traits<DestImageT>::image_category())) {
-                            ++numGoodPixels;
+                            ++numGoodPixelsList[worker];
                         }
                     }  // for col
                 }      // for col band
             }          // for row
-        }              // while next row band
+        });            // for row band
 
     } else {
         // No interpolation
 
-        // prevSrcPosList = source positions from the previous row; these are used to compute pixel area;
-        // to begin, compute sources positions corresponding to destination row = -1
-        std::vector<lsst::geom::Point2D> destPosList;
-        destPosList.reserve(1 + destWidth);
-        for (int col = -1; col < destWidth; ++col) {
-            destPosList.emplace_back(lsst::geom::Point2D(col, -1));
-        }
-        auto prevSrcPosList = localDestToParentSrc->applyForward(destPosList);
+        // Source positions are computed by this thread (transforms may not be shared between threads)
+        // for a chunk of row bands at a time; the row bands of each chunk are then warped in parallel.
+        // For each chunk the grid of source positions covers columns -1 through destWidth - 1
+        // of rows startRow - 1 through endRow - 1; row startRow - 1 is used to compute pixel area.
+        // The grid is held as separate x and y arrays in buffers that are reused for every chunk.
+        int const chunkHeight = std::min(nWorkers * NoInterpBandHeight, destHeight);
+        int const gridWidth = 1 + destWidth;
+        std::vector<double> destGridBuffer(2 * gridWidth * (1 + chunkHeight));
+        std::vector<double> srcGridBuffer(destGridBuffer.size());
+        std::vector<double> const gridStep = {1.0, 1.0};
+        std::vector<double> gridStart = {-1.0, 0.0};
+        std::vector<int> gridCount = {gridWidth, 0};
+        for (int startRow = 0; startRow < destHeight; startRow += chunkHeight) {
+            int const endRow = std::min(startRow + chunkHeight, destHeight);
+            int const nGridPoints = gridWidth * (1 + endRow - startRow);
+            auto const gridShape = ndarray::makeVector(2, nGridPoints);
+            auto const gridStrides = ndarray::makeVector(nGridPoints, 1);
+            ndarray::Array<double, 2, 2> const destGrid =
+                    ndarray::external(destGridBuffer.data(), gridShape, gridStrides);
+            ndarray::Array<double, 2, 2> const srcGrid =
+                    ndarray::external(srcGridBuffer.data(), gridShape, gridStrides);
+            gridStart[1] = startRow - 1;
+            gridCount[1] = 1 + endRow - startRow;
+            localDestToParentSrc->applyForwardGrid(gridStart, gridStep, gridCount, destGrid, srcGrid);
+            double const* const srcXList = srcGridBuffer.data();
+            double const* const srcYList = srcXList + nGridPoints;
+
+            int const nChunkBands = (endRow - startRow + NoInterpBandHeight - 1) / NoInterpBandHeight;
+            detail::parallelFor(nChunkBands, control.getNThreads(), [&](int chunkBand, int worker) {
+                detail::WarpAtOnePoint<DestImageT, SrcImageT>& warpAtOnePoint = *warpAtOnePointList[worker];
+                int const bandStartRow = startRow + chunkBand * NoInterpBandHeight;
+                int const bandEndRow = std::min(bandStartRow + NoInterpBandHeight, endRow);
+                for (int row = bandStartRow; row < bandEndRow; ++row) {
+                    // grid index of column -1 of the previous row and of this row
+                    int const prevRowStart = (row - startRow) * gridWidth;
+                    int const rowStart = prevRowStart + gridWidth;
+
+                    typename DestImageT::x_iterator destXIter = destImage.row_begin(row);
+                    for (int col = 0; col < destWidth; ++col, ++destXIter) {
+                        // grid index = column + 1 because the first entry for each row is for column -1
+                        // pixel area is computed from the previous row's positions at columns col - 1 and col
+                        int const ind = rowStart + col + 1;
+                        int const upInd = prevRowStart + col + 1;
+                        lsst::geom::Point2D const srcPos(srcXList[ind], srcYList[ind]);
+                        lsst::geom::Point2D const upLeftSrcPos(srcXList[upInd - 1], srcYList[upInd - 1]);
+                        lsst::geom::Point2D const upSrcPos(srcXList[upInd], srcYList[upInd]);
+                        double relativeArea = computeRelativeArea(srcPos, upLeftSrcPos, upSrcPos);
 
-        for (int row = 0; row < destHeight; ++row) {
-            destPosList.clear();
-            for (int col = -1; col < destWidth; ++col) {
-                destPosList.emplace_back(lsst::geom::Point2D(col, row));
-            }
-            auto srcPosList = localDestToParentSrc->applyForward(destPosList);
-
-            typename DestImageT::x_iterator destXIter = destImage.row_begin(row);
-            for (int col = 0; col < destWidth; ++col, ++destXIter) {
-                // column index = column + 1 because the first entry in srcPosList is for column -1
-                auto srcPos = srcPosList[col + 1];
-                double relativeArea =
-                        computeRelativeArea(srcPos, prevSrcPosList[col], prevSrcPosList[col + 1]);
-
-                if (warpAtOnePoint(destXIter, srcPos, relativeArea,
-                                   typename image::detail::image_traits<DestImageT>::image_category())) {
-                    ++numGoodPixels;
-                }
-            }  // for col
-            // move points from srcPosList to prevSrcPosList (we don't care about what ends up in srcPosList
-            // because it will be reallocated anyway)
-            swap(srcPosList, prevSrcPosList);
-        }  // for row
-    }      // if interp
+                        if (warpAtOnePoint(
+                                    destXIter, srcPos, relativeArea,
+                                    typename image::detail::image_traits<DestImageT>::image_category())) {
+                            ++numGoodPixelsList[worker];
+                        }
+                    }  // for col
+                }      // for row
+            });        // for row band
+        }              // for chunk
+    }                  // if interp
 
+    int numGoodPixels = 0;
+    for (int workerNumGoodPixels : numGoodPixelsList) {
+        numGoodPixels += workerNumGoodPixels;
+    }
     return numGoodPixels;
 }
 
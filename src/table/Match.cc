@@ -24,80 +24,29 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
 
 #include "lsst/pex/exceptions.h"
 #include "lsst/log/Log.h"
 #include "lsst/geom/Angle.h"
 #include "lsst/afw/table/Match.h"
+#include "lsst/afw/table/MatchIndex.h"
 
 namespace lsst {
 namespace afw {
 namespace table {
 namespace {
 
-template <typename RecordT>
-struct RecordPos {
-    double dec;
-    double x;
-    double y;
-    double z;
-    // JFB removed extra pointer here; this may have performance implications, but hopefully not
-    // significant ones.  BaseCatalog iterators yield temporary BaseRecord shared_ptrs, so storing
-    // their address was no longer an option.
-    std::shared_ptr<RecordT> src;
-};
-
-template <typename Record1, typename Record2>
-bool operator<(RecordPos<Record1> const &s1, RecordPos<Record2> const &s2) {
-    return (s1.dec < s2.dec);
+/// @internal Order neighbours (index, squared distance) by index
+bool compareNeighbourIndices(std::pair<std::size_t, double> const &n1,
+                             std::pair<std::size_t, double> const &n2) {
+    return n1.first < n2.first;
 }
 
-struct CmpRecordPtr {
-    bool operator()(std::shared_ptr<SourceRecord> const s1, std::shared_ptr<SourceRecord> const s2) {
-        return s1->getY() < s2->getY();
-    }
-};
-
-/**
- * @internal Extract source positions from `set`, convert them to cartesian coordinates
- * (for faster distance checks) and sort the resulting array of `RecordPos`
- * instances by declination. Records with positions containing a NaN are skipped.
- *
- * @param[in] set          set of sources to process
- * @param[out] positions   pointer to an array of at least `set.size()`
- *                         RecordPos instances
- * @returns                 The number of sources with positions not containing a NaN.
- */
-template <typename Cat>
-size_t makeRecordPositions(Cat const &cat, RecordPos<typename Cat::Record> *positions) {
-    size_t n = 0;
-    Key<lsst::geom::Angle> raKey = Cat::Table::getCoordKey().getRa();
-    Key<lsst::geom::Angle> decKey = Cat::Table::getCoordKey().getDec();
-    for (typename Cat::const_iterator i(cat.begin()), e(cat.end()); i != e; ++i) {
-        lsst::geom::Angle ra = i->get(raKey);
-        lsst::geom::Angle dec = i->get(decKey);
-        if (std::isnan(ra.asRadians()) || std::isnan(dec.asRadians())) {
-            continue;
-        }
-        double cosDec = std::cos(dec);
-        positions[n].dec = dec.asRadians();
-        positions[n].x = std::cos(ra) * cosDec;
-        positions[n].y = std::sin(ra) * cosDec;
-        positions[n].z = std::sin(dec);
-        positions[n].src = i;
-        ++n;
-    }
-    std::sort(positions, positions + n);
-    if (n < cat.size()) {
-        LOGLS_WARN("afw.table.matchRaDec", "At least one source had ra or dec equal to NaN");
-    }
-    return n;
-}
-
-template size_t makeRecordPositions(SimpleCatalog const &, RecordPos<SimpleRecord> *);
-template size_t makeRecordPositions(SourceCatalog const &, RecordPos<SourceRecord> *);
-
 template <typename Cat1, typename Cat2>
 bool doSelfMatchIfSame(std::vector<Match<typename Cat1::Record, typename Cat2::Record> > &result,
                        Cat1 const &cat1, Cat2 const &cat2, lsst::geom::Angle radius) {
@@ -115,30 +64,175 @@ bool doSelfMatchIfSame(std::vector<Match<typename Cat::Record, typename Cat::Rec
     return false;
 }
 
+// A match between the records with two indices, and the squared distance between them
+struct IndexMatch {
+    std::size_t first;
+    std::size_t second;  // NONE for a failed match
+    double d2;
+};
+
+std::size_t const NONE = std::numeric_limits<std::size_t>::max();
+
 /**
- * @internal Return the squared distance between two unit vectors separated by an angle.
- *
- * This distance is given by @f$ |\vec{u} - \vec{v}| = 2 \sin(\theta/2) @f$.
+ * @internal Extract the centroids of the records in `cat` into contiguous arrays.
+ * Records with centroids containing a NaN are skipped.
  *
- * @param theta the angle between two unit vectors
- * @returns the squared distance between the two vectors
+ * @param[in] cat   catalog of sources to process
+ * @param[out] x    the x coordinates of the sources with centroids not containing a NaN
+ * @param[out] y    the y coordinates of the sources with centroids not containing a NaN
+ * @returns         the index in `cat` of each of `x` and `y`
  */
-double toUnitSphereDistanceSquared(lsst::geom::Angle theta) noexcept {
-    return 2. * (1. - std::cos(theta.asRadians()));
-    // == 4.0 * pow(std::sin(0.5 * theta.asRadians()), 2.0)
+std::vector<std::size_t> makeXyPositions(SourceCatalog const &cat, std::vector<double> &x,
+                                         std::vector<double> &y) {
+    std::vector<std::size_t> indices;
+    indices.reserve(cat.size());
+    x.clear();
+    x.reserve(cat.size());
+    y.clear();
+    y.reserve(cat.size());
+    Point2DKey const centroidKey = cat.getTable()->getCentroidSlot().getMeasKey();
+    Key<double> const xKey = centroidKey.getX();
+    Key<double> const yKey = centroidKey.getY();
+    for (std::size_t i = 0; i < cat.size(); ++i) {
+        double const xi = cat[i].get(xKey);
+        double const yi = cat[i].get(yKey);
+        if (std::isnan(xi) || std::isnan(yi)) {
+            continue;
+        }
+        x.push_back(xi);
+        y.push_back(yi);
+        indices.push_back(i);
+    }
+    return indices;
 }
 
 /**
- * @internal Return the angle between two unit vectors.
- *
- * This angle is given by @f$ \sin(\theta/2) = |\vec{u} - \vec{v}|/2 @f$.
+ * @internal A uniform grid of square cells, each listing the points that fall in it.
  *
- * @param d2 the squared distance between two unit vectors
- * @returns the angle between the two vectors
+ * The cells are no smaller than the match radius, so a query only has to look at the few cells
+ * overlapping a box of side 2*radius, and there are no more cells than about three times the number
+ * of points.  Points with infinite coordinates can't match anything, so are left out.
  */
-lsst::geom::Angle fromUnitSphereDistanceSquared(double d2) noexcept {
-    // acos(1 - 0.5*d2) doesn't require sqrt but isn't as precise for small d2
-    return 2.0 * std::asin(0.5 * std::sqrt(d2)) * lsst::geom::radians;
+class XyGrid final {
+public:
+    XyGrid(std::vector<double> const &x, std::vector<double> const &y, double radius)
+            : _radius(radius), _cellSize(0.0), _x0(0.0), _y0(0.0), _nx(0), _ny(0) {
+        double x1 = 0.0, y1 = 0.0;
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            if (!std::isfinite(x[i]) || !std::isfinite(y[i])) {
+                continue;
+            }
+            if (n == 0) {
+                _x0 = x1 = x[i];
+                _y0 = y1 = y[i];
+            }
+            _x0 = std::min(_x0, x[i]);
+            x1 = std::max(x1, x[i]);
+            _y0 = std::min(_y0, y[i]);
+            y1 = std::max(y1, y[i]);
+            ++n;
+        }
+        if (n == 0) {
+            return;
+        }
+        double const width = x1 - _x0;
+        double const height = y1 - _y0;
+        _cellSize = std::max({radius, std::sqrt(width * height / n), std::max(width, height) / n});
+        if (!(_cellSize > 0.0)) {
+            _cellSize = 1.0;  // all the points are in the same place, and radius is 0
+        }
+        _nx = static_cast<std::size_t>(width / _cellSize) + 1;
+        _ny = static_cast<std::size_t>(height / _cellSize) + 1;
+
+        // Counting sort of the points by cell; the points in each cell stay in index order
+        std::vector<std::size_t> cells(x.size(), NONE);
+        _cellStart.assign(_nx * _ny + 1, 0);
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            if (std::isfinite(x[i]) && std::isfinite(y[i])) {
+                cells[i] = getCell(x[i], y[i]);
+                ++_cellStart[cells[i] + 1];
+            }
+        }
+        std::partial_sum(_cellStart.begin(), _cellStart.end(), _cellStart.begin());
+        std::vector<std::size_t> next(_cellStart.begin(), _cellStart.end() - 1);
+        _indices.resize(n);
+        _x.resize(n);
+        _y.resize(n);
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            if (cells[i] != NONE) {
+                std::size_t const j = next[cells[i]]++;
+                _indices[j] = i;
+                _x[j] = x[i];
+                _y[j] = y[i];
+            }
+        }
+    }
+
+    /**
+     * Call `function(index, d2)` for every point whose squared distance d2 from (x, y) is
+     * less than radius^2
+     */
+    template <typename Function>
+    void forEachWithin(double x, double y, Function &&function) const {
+        if (_indices.empty()) {
+            return;
+        }
+        // Cells overlapping [x - radius, x + radius] x [y - radius, y + radius], computed in
+        // floating point as the coordinates may be far outside the grid
+        double const ix0 = std::max(0.0, std::floor((x - _radius - _x0) / _cellSize));
+        double const ix1 = std::min(_nx - 1.0, std::floor((x + _radius - _x0) / _cellSize));
+        double const iy0 = std::max(0.0, std::floor((y - _radius - _y0) / _cellSize));
+        double const iy1 = std::min(_ny - 1.0, std::floor((y + _radius - _y0) / _cellSize));
+        if (!(ix0 <= ix1 && iy0 <= iy1)) {
+            return;
+        }
+        double const r2 = _radius * _radius;
+        for (std::size_t iy = static_cast<std::size_t>(iy0); iy <= static_cast<std::size_t>(iy1); ++iy) {
+            std::size_t const begin = _cellStart[iy * _nx + static_cast<std::size_t>(ix0)];
+            std::size_t const end = _cellStart[iy * _nx + static_cast<std::size_t>(ix1) + 1];
+            for (std::size_t j = begin; j < end; ++j) {
+                double const dx = x - _x[j];
+                double const dy = y - _y[j];
+                double const d2 = dx * dx + dy * dy;
+                if (d2 < r2) {
+                    function(_indices[j], d2);
+                }
+            }
+        }
+    }
+
+private:
+    std::size_t getCell(double x, double y) const {
+        std::size_t const ix = std::min(static_cast<std::size_t>((x - _x0) / _cellSize), _nx - 1);
+        std::size_t const iy = std::min(static_cast<std::size_t>((y - _y0) / _cellSize), _ny - 1);
+        return iy * _nx + ix;
+    }
+
+    double _radius;
+    double _cellSize;
+    double _x0, _y0;                       // the lower left corner of cell 0
+    std::size_t _nx, _ny;                  // the number of cells in each direction
+    std::vector<std::size_t> _cellStart;   // the points in cell c are [_cellStart[c], _cellStart[c + 1])
+    std::vector<std::size_t> _indices;     // the index of each point in the arrays the grid was built from
+    std::vector<double> _x, _y;            // the coordinates of each point
+};
+
+/// @internal Turn index matches into a SourceMatchVector
+SourceMatchVector makeSourceMatches(std::vector<IndexMatch> const &indexMatches, SourceCatalog const &cat1,
+                                    std::vector<std::size_t> const &index1, SourceCatalog const &cat2,
+                                    std::vector<std::size_t> const &index2) {
+    SourceMatchVector matches;
+    matches.reserve(indexMatches.size());
+    for (auto const &match : indexMatches) {
+        if (match.second == NONE) {
+            matches.push_back(SourceMatch(cat1.get(index1[match.first]), nullptr, NAN));
+        } else {
+            matches.push_back(SourceMatch(cat1.get(index1[match.first]), cat2.get(index2[match.second]),
+                                          std::sqrt(match.d2)));
+        }
+    }
+    return matches;
 }
 
 }  // namespace
@@ -170,59 +264,7 @@ std::vector<Match<typename Cat1::Record, typename Cat2::Record> > matchRaDec(Cat
     if (cat1.size() == 0 || cat2.size() == 0) {
         return matches;
     }
-    // setup match parameters
-    double const d2Limit = toUnitSphereDistanceSquared(radius);
-
-    // Build position lists
-    size_t len1 = cat1.size();
-    size_t len2 = cat2.size();
-
-    typedef RecordPos<typename Cat1::Record> Pos1;
-    typedef RecordPos<typename Cat2::Record> Pos2;
-    std::unique_ptr<Pos1[]> pos1(new Pos1[len1]);
-    std::unique_ptr<Pos2[]> pos2(new Pos2[len2]);
-    len1 = makeRecordPositions(cat1, pos1.get());
-    len2 = makeRecordPositions(cat2, pos2.get());
-    std::shared_ptr<typename Cat2::Record> nullRecord = std::shared_ptr<typename Cat2::Record>();
-
-    for (size_t i = 0, start = 0; i < len1; ++i) {
-        double minDec = pos1[i].dec - radius.asRadians();
-        while (start < len2 && pos2[start].dec < minDec) {
-            ++start;
-        }
-        if (start == len2) {
-            break;
-        }
-        double maxDec = pos1[i].dec + radius.asRadians();
-        size_t closestIndex = -1;    // Index of closest match (if any)
-        double d2Include = d2Limit;  // Squared distance for inclusion of match
-        bool found = false;          // Found anything?
-        size_t nMatches = 0;         // Number of matches
-        for (size_t j = start; j < len2 && pos2[j].dec <= maxDec; ++j) {
-            double dx = pos1[i].x - pos2[j].x;
-            double dy = pos1[i].y - pos2[j].y;
-            double dz = pos1[i].z - pos2[j].z;
-            double d2 = dx * dx + dy * dy + dz * dz;
-            if (d2 < d2Include) {
-                if (mc.findOnlyClosest) {
-                    d2Include = d2;
-                    closestIndex = j;
-                    found = true;
-                } else {
-                    matches.push_back(MatchT(pos1[i].src, pos2[j].src, fromUnitSphereDistanceSquared(d2)));
-                }
-                ++nMatches;
-            }
-        }
-        if (mc.includeMismatches && nMatches == 0) {
-            matches.push_back(MatchT(pos1[i].src, nullRecord, NAN));
-        }
-        if (mc.findOnlyClosest && found) {
-            matches.push_back(
-                    MatchT(pos1[i].src, pos2[closestIndex].src, fromUnitSphereDistanceSquared(d2Include)));
-        }
-    }
-    return matches;
+    return MatchIndex(cat2).match(cat1, cat2, radius, mc);
 }
 
 #define LSST_MATCH_RADEC(RTYPE, C1, C2)                                         \
@@ -258,32 +300,7 @@ std::vector<Match<typename Cat::Record, typename Cat::Record> > matchRaDec(Cat c
     if (cat.size() == 0) {
         return matches;
     }
-    // setup match parameters
-    double const d2Limit = toUnitSphereDistanceSquared(radius);
-
-    // Build position list
-    size_t len = cat.size();
-    typedef RecordPos<typename Cat::Record> Pos;
-    std::unique_ptr<Pos[]> pos(new Pos[len]);
-    len = makeRecordPositions(cat, pos.get());
-
-    for (size_t i = 0; i < len; ++i) {
-        double maxDec = pos[i].dec + radius.asRadians();
-        for (size_t j = i + 1; j < len && pos[j].dec <= maxDec; ++j) {
-            double dx = pos[i].x - pos[j].x;
-            double dy = pos[i].y - pos[j].y;
-            double dz = pos[i].z - pos[j].z;
-            double d2 = dx * dx + dy * dy + dz * dz;
-            if (d2 < d2Limit) {
-                lsst::geom::Angle d = fromUnitSphereDistanceSquared(d2);
-                matches.push_back(MatchT(pos[i].src, pos[j].src, d));
-                if (mc.symmetricMatch) {
-                    matches.push_back(MatchT(pos[j].src, pos[i].src, d));
-                }
-            }
-        }
-    }
-    return matches;
+    return MatchIndex(cat).match(cat, radius, mc);
 }
 
 #define LSST_MATCH_RADEC(RTYPE, C)                                 \
@@ -307,77 +324,38 @@ SourceMatchVector matchXy(SourceCatalog const &cat1, SourceCatalog const &cat2,
     if (&cat1 == &cat2) {
         return matchXy(cat1, radius);
     }
-    // setup match parameters
-    double const r2 = radius * radius;
-
-    // copy and sort array of pointers on y
-    size_t len1 = cat1.size();
-    size_t len2 = cat2.size();
-    std::unique_ptr<std::shared_ptr<SourceRecord>[]> pos1(new std::shared_ptr<SourceRecord>[len1]);
-    std::unique_ptr<std::shared_ptr<SourceRecord>[]> pos2(new std::shared_ptr<SourceRecord>[len2]);
-    std::shared_ptr<SourceRecord> nullRecord = std::shared_ptr<SourceRecord>();
-    size_t n = 0;
-    for (SourceCatalog::const_iterator i(cat1.begin()), e(cat1.end()); i != e; ++i) {
-        if (std::isnan(i->getX()) || std::isnan(i->getY())) {
-            continue;
-        }
-        pos1[n] = i;
-        ++n;
-    }
-    len1 = n;
-    n = 0;
-    for (SourceCatalog::const_iterator i(cat2.begin()), e(cat2.end()); i != e; ++i) {
-        if (std::isnan(i->getX()) || std::isnan(i->getY())) {
-            continue;
-        }
-        pos2[n] = i;
-        ++n;
-    }
-    len2 = n;
-
-    std::sort(pos1.get(), pos1.get() + len1, CmpRecordPtr());
-    std::sort(pos2.get(), pos2.get() + len2, CmpRecordPtr());
-
-    SourceMatchVector matches;
-    for (size_t i = 0, start = 0; i < len1; ++i) {
-        double y = pos1[i]->getY();
-        double minY = y - radius;
-        while (start < len2 && pos2[start]->getY() < minY) {
-            ++start;
-        }
-        if (start == len2) {
-            break;
-        }
-        double x = pos1[i]->getX();
-        double maxY = y + radius;
-        double y2;
-        size_t closestIndex = -1;  // Index of closest match (if any)
-        double r2Include = r2;     // Squared radius for inclusion of match
-        bool found = false;        // Found anything?
-        size_t nMatches = 0;       // Number of matches
-        for (size_t j = start; j < len2 && (y2 = pos2[j]->getY()) <= maxY; ++j) {
-            double dx = x - pos2[j]->getX();
-            double dy = y - y2;
-            double d2 = dx * dx + dy * dy;
-            if (d2 < r2Include) {
-                if (mc.findOnlyClosest) {
-                    r2Include = d2;
-                    closestIndex = j;
-                    found = true;
-                } else {
-                    matches.push_back(SourceMatch(pos1[i], pos2[j], std::sqrt(d2)));
-                }
-                ++nMatches;
+    // extract the positions, and bucket the second catalog's
+    std::vector<double> x1, y1, x2, y2;
+    std::vector<std::size_t> const index1 = makeXyPositions(cat1, x1, y1);
+    std::vector<std::size_t> const index2 = makeXyPositions(cat2, x2, y2);
+    XyGrid const grid(x2, y2, radius);
+
+    std::vector<IndexMatch> indexMatches;
+    std::vector<std::pair<std::size_t, double> > neighbours;
+    for (std::size_t i = 0; i < x1.size(); ++i) {
+        neighbours.clear();
+        grid.forEachWithin(x1[i], y1[i], [&neighbours](std::size_t j, double d2) {
+            neighbours.push_back(std::make_pair(j, d2));
+        });
+        std::sort(neighbours.begin(), neighbours.end(), compareNeighbourIndices);
+        if (mc.findOnlyClosest && !neighbours.empty()) {
+            // the first of the closest, so that ties are resolved by index
+            auto const closest = std::min_element(
+                    neighbours.begin(), neighbours.end(),
+                    [](std::pair<std::size_t, double> const &n1, std::pair<std::size_t, double> const &n2) {
+                        return n1.second < n2.second;
+                    });
+            indexMatches.push_back(IndexMatch{i, closest->first, closest->second});
+        } else {
+            for (auto const &neighbour : neighbours) {
+                indexMatches.push_back(IndexMatch{i, neighbour.first, neighbour.second});
             }
         }
-        if (mc.includeMismatches && nMatches == 0) {
-            matches.push_back(SourceMatch(pos1[i], nullRecord, NAN));
-        }
-        if (mc.findOnlyClosest && found) {
-            matches.push_back(SourceMatch(pos1[i], pos2[closestIndex], std::sqrt(r2Include)));
+        if (mc.includeMismatches && neighbours.empty()) {
+            indexMatches.push_back(IndexMatch{i, NONE, NAN});
         }
     }
-    return matches;
+    return makeSourceMatches(indexMatches, cat1, index1, cat2, index2);
 }
 
 SourceMatchVector matchXy(SourceCatalog const &cat, double radius, bool symmetric) {
@@ -388,44 +366,29 @@ SourceMatchVector matchXy(SourceCatalog const &cat, double radius, bool symmetri
 }
 
 SourceMatchVector matchXy(SourceCatalog const &cat, double radius, MatchControl const &mc) {
-    // setup match parameters
-    double const r2 = radius * radius;
-
-    // copy and sort array of pointers on y
-    size_t len = cat.size();
-    std::unique_ptr<std::shared_ptr<SourceRecord>[]> pos(new std::shared_ptr<SourceRecord>[len]);
-    size_t n = 0;
-    for (SourceCatalog::const_iterator i(cat.begin()), e(cat.end()); i != e; ++i) {
-        if (std::isnan(i->getX()) || std::isnan(i->getY())) {
-            continue;
-        }
-        pos[n] = i;
-        ++n;
-    }
-    len = n;
-
-    std::sort(pos.get(), pos.get() + len, CmpRecordPtr());
-
-    SourceMatchVector matches;
-    for (size_t i = 0; i < len; ++i) {
-        double x = pos[i]->getX();
-        double y = pos[i]->getY();
-        double maxY = y + radius;
-        double y2;
-        for (size_t j = i + 1; j < len && (y2 = pos[j]->getY()) <= maxY; ++j) {
-            double dx = x - pos[j]->getX();
-            double dy = y - y2;
-            double d2 = dx * dx + dy * dy;
-            if (d2 < r2) {
-                double d = std::sqrt(d2);
-                matches.push_back(SourceMatch(pos[i], pos[j], d));
-                if (mc.symmetricMatch) {
-                    matches.push_back(SourceMatch(pos[j], pos[i], d));
-                }
+    // extract and bucket the positions
+    std::vector<double> x, y;
+    std::vector<std::size_t> const index = makeXyPositions(cat, x, y);
+    XyGrid const grid(x, y, radius);
+
+    std::vector<IndexMatch> indexMatches;
+    std::vector<std::pair<std::size_t, double> > neighbours;
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        neighbours.clear();
+        grid.forEachWithin(x[i], y[i], [i, &neighbours](std::size_t j, double d2) {
+            if (j > i) {
+                neighbours.push_back(std::make_pair(j, d2));
+            }
+        });
+        std::sort(neighbours.begin(), neighbours.end(), compareNeighbourIndices);
+        for (auto const &neighbour : neighbours) {
+            indexMatches.push_back(IndexMatch{i, neighbour.first, neighbour.second});
+            if (mc.symmetricMatch) {
+                indexMatches.push_back(IndexMatch{neighbour.first, i, neighbour.second});
             }
         }
     }
-    return matches;
+    return makeSourceMatches(indexMatches, cat, index, cat, index);
 }
 
 template <typename Record1, typename Record2>
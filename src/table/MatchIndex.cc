@@ -0,0 +1,474 @@
+// -*- lsst-c++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/log/Log.h"
+#include "lsst/afw/table/MatchIndex.h"
+#include "lsst/afw/table/io/InputArchive.h"
+#include "lsst/afw/table/io/OutputArchive.h"
+#include "lsst/afw/table/io/CatalogVector.h"
+#include "lsst/afw/table/io/Persistable.cc"
+#include "lsst/afw/math/detail/Parallel.h"
+
+namespace lsst {
+namespace afw {
+namespace table {
+namespace {
+
+typedef detail::UnitVectorTree::Point UnitVector;
+
+// Number of records of the first catalog handed to a thread at a time when matching
+std::size_t const MATCH_CHUNK_SIZE = 4096;
+
+/// @internal Return the unit vector of a position
+UnitVector toUnitVector(lsst::geom::Angle ra, lsst::geom::Angle dec) noexcept {
+    double cosDec = std::cos(dec);
+    return {{std::cos(ra) * cosDec, std::sin(ra) * cosDec, std::sin(dec)}};
+}
+
+/**
+ * @internal Extract source positions from `cat` and convert them to unit vectors
+ * (for faster distance checks). Records with positions containing a NaN are skipped.
+ *
+ * @param[in] cat          catalog of sources to process
+ * @param[out] positions   the unit vectors of the sources with positions not containing a NaN
+ * @returns                the index in `cat` of each of `positions`
+ */
+template <typename Cat>
+std::vector<std::size_t> makeRecordPositions(Cat const &cat, std::vector<UnitVector> &positions) {
+    std::vector<std::size_t> indices;
+    indices.reserve(cat.size());
+    positions.clear();
+    positions.reserve(cat.size());
+    Key<lsst::geom::Angle> raKey = Cat::Table::getCoordKey().getRa();
+    Key<lsst::geom::Angle> decKey = Cat::Table::getCoordKey().getDec();
+    for (std::size_t i = 0; i < cat.size(); ++i) {
+        lsst::geom::Angle ra = cat[i].get(raKey);
+        lsst::geom::Angle dec = cat[i].get(decKey);
+        if (std::isnan(ra.asRadians()) || std::isnan(dec.asRadians())) {
+            continue;
+        }
+        positions.push_back(toUnitVector(ra, dec));
+        indices.push_back(i);
+    }
+    if (indices.size() < cat.size()) {
+        LOGLS_WARN("afw.table.matchRaDec", "At least one source had ra or dec equal to NaN");
+    }
+    return indices;
+}
+
+/**
+ * @internal Call `matchOne(i, matches, neighbours)` for each i in [0, n) using up to `nThreads`
+ * threads, and return all the matches the calls append to `matches`.
+ *
+ * The matches are returned in order of i, whatever the number of threads.
+ * `neighbours` is scratch space belonging to the calling thread.
+ */
+template <typename MatchT, typename Function>
+std::vector<MatchT> matchInParallel(std::size_t n, int nThreads, Function const &matchOne) {
+    int const nChunks = (n + MATCH_CHUNK_SIZE - 1) / MATCH_CHUNK_SIZE;
+    std::vector<std::vector<MatchT> > chunkMatches(nChunks);
+    std::vector<std::vector<std::pair<std::size_t, double> > > neighbours(
+            math::detail::getNWorkers(nChunks, nThreads));
+    math::detail::parallelFor(nChunks, nThreads, [&](int chunk, int worker) {
+        std::size_t const end = std::min(n, (chunk + 1) * MATCH_CHUNK_SIZE);
+        for (std::size_t i = chunk * MATCH_CHUNK_SIZE; i < end; ++i) {
+            matchOne(i, chunkMatches[chunk], neighbours[worker]);
+        }
+    });
+
+    std::size_t nMatches = 0;
+    for (auto const &matches : chunkMatches) {
+        nMatches += matches.size();
+    }
+    std::vector<MatchT> matches;
+    matches.reserve(nMatches);
+    for (auto &chunk : chunkMatches) {
+        std::move(chunk.begin(), chunk.end(), std::back_inserter(matches));
+        std::vector<MatchT>().swap(chunk);
+    }
+    return matches;
+}
+
+/// @internal Order neighbours (index, squared distance) by index
+bool compareNeighbourIndices(std::pair<std::size_t, double> const &n1,
+                             std::pair<std::size_t, double> const &n2) {
+    return n1.first < n2.first;
+}
+
+/// @internal Order neighbours (index, squared distance) by distance, then index
+bool compareNeighbourDistances(std::pair<std::size_t, double> const &n1,
+                               std::pair<std::size_t, double> const &n2) {
+    return n1.second < n2.second || (n1.second == n2.second && n1.first < n2.first);
+}
+
+/**
+ * @internal Return the squared distance between two unit vectors separated by an angle.
+ *
+ * This distance is given by @f$ |\vec{u} - \vec{v}| = 2 \sin(\theta/2) @f$.
+ *
+ * @param theta the angle between two unit vectors
+ * @returns the squared distance between the two vectors
+ */
+double toUnitSphereDistanceSquared(lsst::geom::Angle theta) noexcept {
+    return 2. * (1. - std::cos(theta.asRadians()));
+    // == 4.0 * pow(std::sin(0.5 * theta.asRadians()), 2.0)
+}
+
+/**
+ * @internal Return the angle between two unit vectors.
+ *
+ * This angle is given by @f$ \sin(\theta/2) = |\vec{u} - \vec{v}|/2 @f$.
+ *
+ * @param d2 the squared distance between two unit vectors
+ * @returns the angle between the two vectors
+ */
+lsst::geom::Angle fromUnitSphereDistanceSquared(double d2) noexcept {
+    // acos(1 - 0.5*d2) doesn't require sqrt but isn't as precise for small d2
+    return 2.0 * std::asin(0.5 * std::sqrt(d2)) * lsst::geom::radians;
+}
+
+
+void checkRadius(lsst::geom::Angle radius) {
+    if (radius < 0.0 || radius > (45.0 * lsst::geom::degrees)) {
+        throw LSST_EXCEPT(pex::exceptions::RangeError, "match radius out of range (0 to 45 degrees)");
+    }
+}
+
+struct PersistenceHelper {
+    static PersistenceHelper const &get() {
+        static PersistenceHelper const instance;
+        return instance;
+    }
+
+    // Schema and key for the catalog holding the size of the indexed catalog
+    Schema sizeSchema;
+    Key<std::int64_t> catalogSize;
+
+    // Schema and keys for the catalog holding the indexed records, in the order they are stored
+    // in the tree
+    Schema recordSchema;
+    Key<std::int64_t> index;
+    Key<RecordId> id;
+    Key<double> x;
+    Key<double> y;
+    Key<double> z;
+
+private:
+    PersistenceHelper()
+            : sizeSchema(),
+              catalogSize(sizeSchema.addField<std::int64_t>("catalogSize", "number of records in catalog")),
+              recordSchema(),
+              index(recordSchema.addField<std::int64_t>("index", "index of record in catalog")),
+              id(recordSchema.addField<RecordId>("id", "ID of record")),
+              x(recordSchema.addField<double>("x", "x component of unit vector of record's position")),
+              y(recordSchema.addField<double>("y", "y component of unit vector of record's position")),
+              z(recordSchema.addField<double>("z", "z component of unit vector of record's position")) {
+        sizeSchema.getCitizen().markPersistent();
+        recordSchema.getCitizen().markPersistent();
+    }
+
+    PersistenceHelper(PersistenceHelper const &) = delete;
+    PersistenceHelper(PersistenceHelper &&) = delete;
+    PersistenceHelper &operator=(PersistenceHelper const &) = delete;
+    PersistenceHelper &operator=(PersistenceHelper &&) = delete;
+};
+
+}  // namespace
+
+template <typename Cat>
+MatchIndex::MatchIndex(Cat const &catalog)
+        : _catalogSize(catalog.size()), _catalogIndices(), _ids(), _tree(std::vector<UnitVector>()) {
+    std::vector<UnitVector> positions;
+    _catalogIndices = makeRecordPositions(catalog, positions);
+    _ids.reserve(_catalogIndices.size());
+    for (std::size_t i : _catalogIndices) {
+        _ids.push_back(catalog[i].getId());
+    }
+    _tree = detail::UnitVectorTree(positions);
+}
+
+MatchIndex::MatchIndex(std::size_t catalogSize, std::vector<std::size_t> &&catalogIndices,
+                       std::vector<RecordId> &&ids, detail::UnitVectorTree &&tree)
+        : _catalogSize(catalogSize),
+          _catalogIndices(std::move(catalogIndices)),
+          _ids(std::move(ids)),
+          _tree(std::move(tree)) {}
+
+MatchIndex::MatchIndex(MatchIndex const &) = default;
+MatchIndex::MatchIndex(MatchIndex &&) = default;
+MatchIndex &MatchIndex::operator=(MatchIndex const &) = default;
+MatchIndex &MatchIndex::operator=(MatchIndex &&) = default;
+MatchIndex::~MatchIndex() = default;
+
+std::vector<MatchIndex::Neighbour> MatchIndex::findWithin(lsst::geom::SpherePoint const &point,
+                                                          lsst::geom::Angle radius) const {
+    checkRadius(radius);
+    std::vector<std::pair<std::size_t, double> > neighbours;
+    _tree.forEachWithin(toUnitVector(point.getLongitude(), point.getLatitude()),
+                        toUnitSphereDistanceSquared(radius), [&neighbours](std::size_t j, double d2) {
+                            neighbours.push_back(std::make_pair(j, d2));
+                        });
+    std::sort(neighbours.begin(), neighbours.end(), compareNeighbourDistances);
+    std::vector<Neighbour> result;
+    result.reserve(neighbours.size());
+    for (auto const &neighbour : neighbours) {
+        result.push_back(Neighbour(_catalogIndices[neighbour.first],
+                                   fromUnitSphereDistanceSquared(neighbour.second)));
+    }
+    return result;
+}
+
+std::vector<MatchIndex::Neighbour> MatchIndex::findNearest(lsst::geom::SpherePoint const &point,
+                                                           std::size_t k) const {
+    auto const neighbours = _tree.findNearest(toUnitVector(point.getLongitude(), point.getLatitude()), k);
+    std::vector<Neighbour> result;
+    result.reserve(neighbours.size());
+    for (auto const &neighbour : neighbours) {
+        result.push_back(Neighbour(_catalogIndices[neighbour.first],
+                                   fromUnitSphereDistanceSquared(neighbour.second)));
+    }
+    return result;
+}
+
+template <typename Cat>
+void MatchIndex::checkCatalog(Cat const &catalog) const {
+    if (catalog.size() != _catalogSize) {
+        std::ostringstream os;
+        os << "Catalog has " << catalog.size() << " records, but the indexed catalog had " << _catalogSize;
+        throw LSST_EXCEPT(pex::exceptions::InvalidParameterError, os.str());
+    }
+    for (std::size_t j = 0; j < _ids.size(); ++j) {
+        if (catalog[_catalogIndices[j]].getId() != _ids[j]) {
+            std::ostringstream os;
+            os << "Record " << _catalogIndices[j] << " of catalog has ID "
+               << catalog[_catalogIndices[j]].getId() << ", but the indexed record had ID " << _ids[j];
+            throw LSST_EXCEPT(pex::exceptions::InvalidParameterError, os.str());
+        }
+    }
+}
+
+template <typename Cat1, typename Cat2>
+std::vector<Match<typename Cat1::Record, typename Cat2::Record> > MatchIndex::match(
+        Cat1 const &cat1, Cat2 const &catalog, lsst::geom::Angle radius, MatchControl const &mc) const {
+    typedef Match<typename Cat1::Record, typename Cat2::Record> MatchT;
+
+    checkRadius(radius);
+    checkCatalog(catalog);
+    if (cat1.size() == 0 || _catalogSize == 0) {
+        return std::vector<MatchT>();
+    }
+    // setup match parameters
+    double const d2Limit = toUnitSphereDistanceSquared(radius);
+
+    // Build position list
+    std::vector<UnitVector> pos1;
+    std::vector<std::size_t> const index1 = makeRecordPositions(cat1, pos1);
+    std::shared_ptr<typename Cat2::Record> nullRecord = std::shared_ptr<typename Cat2::Record>();
+
+    auto matchOne = [&](std::size_t i, std::vector<MatchT> &results,
+                        std::vector<std::pair<std::size_t, double> > &neighbours) {
+        std::size_t nMatches = 0;  // Number of matches
+        if (mc.findOnlyClosest) {
+            auto const closest = _tree.findClosest(pos1[i], d2Limit);
+            if (closest.first != detail::UnitVectorTree::NONE) {
+                results.push_back(MatchT(cat1.get(index1[i]), catalog.get(_catalogIndices[closest.first]),
+                                         fromUnitSphereDistanceSquared(closest.second)));
+                ++nMatches;
+            }
+        } else {
+            neighbours.clear();
+            _tree.forEachWithin(pos1[i], d2Limit, [&neighbours](std::size_t j, double d2) {
+                neighbours.push_back(std::make_pair(j, d2));
+            });
+            std::sort(neighbours.begin(), neighbours.end(), compareNeighbourIndices);
+            for (auto const &neighbour : neighbours) {
+                results.push_back(MatchT(cat1.get(index1[i]), catalog.get(_catalogIndices[neighbour.first]),
+                                         fromUnitSphereDistanceSquared(neighbour.second)));
+                ++nMatches;
+            }
+        }
+        if (mc.includeMismatches && nMatches == 0) {
+            results.push_back(MatchT(cat1.get(index1[i]), nullRecord, NAN));
+        }
+    };
+    return matchInParallel<MatchT>(pos1.size(), mc.nThreads, matchOne);
+}
+
+template <typename Cat>
+std::vector<Match<typename Cat::Record, typename Cat::Record> > MatchIndex::match(
+        Cat const &catalog, lsst::geom::Angle radius, MatchControl const &mc) const {
+    typedef Match<typename Cat::Record, typename Cat::Record> MatchT;
+
+    checkRadius(radius);
+    checkCatalog(catalog);
+    // setup match parameters
+    double const d2Limit = toUnitSphereDistanceSquared(radius);
+    // The positions are stored in the tree; find where each indexed record's is, so that the
+    // records can be matched in catalog order
+    std::vector<UnitVector> const &pos = _tree.getPoints();
+    std::vector<std::size_t> treeOrder(pos.size());
+    for (std::size_t t = 0; t < pos.size(); ++t) {
+        treeOrder[_tree.getIndices()[t]] = t;
+    }
+
+    auto matchOne = [&](std::size_t i, std::vector<MatchT> &results,
+                        std::vector<std::pair<std::size_t, double> > &neighbours) {
+        neighbours.clear();
+        _tree.forEachWithin(pos[treeOrder[i]], d2Limit, [i, &neighbours](std::size_t j, double d2) {
+            if (j > i) {
+                neighbours.push_back(std::make_pair(j, d2));
+            }
+        });
+        std::sort(neighbours.begin(), neighbours.end(), compareNeighbourIndices);
+        for (auto const &neighbour : neighbours) {
+            lsst::geom::Angle d = fromUnitSphereDistanceSquared(neighbour.second);
+            auto const record1 = catalog.get(_catalogIndices[i]);
+            auto const record2 = catalog.get(_catalogIndices[neighbour.first]);
+            results.push_back(MatchT(record1, record2, d));
+            if (mc.symmetricMatch) {
+                results.push_back(MatchT(record2, record1, d));
+            }
+        }
+    };
+    return matchInParallel<MatchT>(pos.size(), mc.nThreads, matchOne);
+}
+
+std::string MatchIndex::getPersistenceName() const { return "MatchIndex"; }
+
+std::string MatchIndex::getPythonModule() const { return "lsst.afw.table"; }
+
+void MatchIndex::write(OutputArchiveHandle &handle) const {
+    auto const &keys = PersistenceHelper::get();
+
+    BaseCatalog sizeCat = handle.makeCatalog(keys.sizeSchema);
+    sizeCat.addNew()->set(keys.catalogSize, _catalogSize);
+    handle.saveCatalog(sizeCat);
+
+    BaseCatalog recordCat = handle.makeCatalog(keys.recordSchema);
+    recordCat.reserve(_tree.size());
+    for (std::size_t t = 0; t < _tree.size(); ++t) {
+        std::size_t const i = _tree.getIndices()[t];
+        UnitVector const &point = _tree.getPoints()[t];
+        auto record = recordCat.addNew();
+        record->set(keys.index, _catalogIndices[i]);
+        record->set(keys.id, _ids[i]);
+        record->set(keys.x, point[0]);
+        record->set(keys.y, point[1]);
+        record->set(keys.z, point[2]);
+    }
+    handle.saveCatalog(recordCat);
+}
+
+class MatchIndex::Factory : public io::PersistableFactory {
+public:
+    Factory() : PersistableFactory("MatchIndex") {}
+
+    std::shared_ptr<Persistable> read(InputArchive const &archive,
+                                      CatalogVector const &catalogs) const override {
+        auto const &keys = PersistenceHelper::get();
+
+        LSST_ARCHIVE_ASSERT(catalogs.size() == 2u);
+        auto const &sizeCat = catalogs[0];
+        auto const &recordCat = catalogs[1];
+        LSST_ARCHIVE_ASSERT(sizeCat.getSchema() == keys.sizeSchema);
+        LSST_ARCHIVE_ASSERT(recordCat.getSchema() == keys.recordSchema);
+        LSST_ARCHIVE_ASSERT(sizeCat.size() == 1u);
+        std::size_t const catalogSize = sizeCat.front().get(keys.catalogSize);
+        std::size_t const n = recordCat.size();
+
+        // The points were numbered in catalog order when the index was built, so we can
+        // recover that numbering by sorting the catalog indices.
+        std::vector<std::size_t> order(n);
+        for (std::size_t t = 0; t < n; ++t) {
+            order[t] = t;
+        }
+        std::sort(order.begin(), order.end(), [&recordCat, &keys](std::size_t t1, std::size_t t2) {
+            return recordCat[t1].get(keys.index) < recordCat[t2].get(keys.index);
+        });
+        std::vector<std::size_t> catalogIndices(n);
+        std::vector<RecordId> ids(n);
+        std::vector<std::size_t> treeIndices(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            auto const &record = recordCat[order[i]];
+            catalogIndices[i] = record.get(keys.index);
+            ids[i] = record.get(keys.id);
+            treeIndices[order[i]] = i;
+            LSST_ARCHIVE_ASSERT(catalogIndices[i] < catalogSize);
+            LSST_ARCHIVE_ASSERT(i == 0 || catalogIndices[i] > catalogIndices[i - 1]);
+        }
+        std::vector<UnitVector> points;
+        points.reserve(n);
+        for (auto const &record : recordCat) {
+            points.push_back({{record.get(keys.x), record.get(keys.y), record.get(keys.z)}});
+        }
+
+        auto tree = detail::UnitVectorTree::fromTreeOrder(std::move(points), std::move(treeIndices));
+        return std::shared_ptr<MatchIndex>(
+                new MatchIndex(catalogSize, std::move(catalogIndices), std::move(ids), std::move(tree)));
+    }
+};
+
+MatchIndex::Factory const MatchIndex::registration;
+
+#define LSST_MATCH_INDEX(C) template MatchIndex::MatchIndex(C const &)
+
+LSST_MATCH_INDEX(SimpleCatalog);
+LSST_MATCH_INDEX(SourceCatalog);
+
+#undef LSST_MATCH_INDEX
+
+#define LSST_MATCH_INDEX_MATCH(RTYPE, C1, C2) \
+    template RTYPE MatchIndex::match(C1 const &, C2 const &, lsst::geom::Angle, MatchControl const &) const
+
+LSST_MATCH_INDEX_MATCH(SimpleMatchVector, SimpleCatalog, SimpleCatalog);
+LSST_MATCH_INDEX_MATCH(ReferenceMatchVector, SimpleCatalog, SourceCatalog);
+LSST_MATCH_INDEX_MATCH(SourceMatchVector, SourceCatalog, SourceCatalog);
+
+#undef LSST_MATCH_INDEX_MATCH
+
+#define LSST_MATCH_INDEX_SELF_MATCH(RTYPE, C) \
+    template RTYPE MatchIndex::match(C const &, lsst::geom::Angle, MatchControl const &) const
+
+LSST_MATCH_INDEX_SELF_MATCH(SimpleMatchVector, SimpleCatalog);
+LSST_MATCH_INDEX_SELF_MATCH(SourceMatchVector, SourceCatalog);
+
+#undef LSST_MATCH_INDEX_SELF_MATCH
+
+namespace io {
+
+template class PersistableFacade<MatchIndex>;
+
+}  // namespace io
+}  // namespace table
+}  // namespace afw
+}  // namespace lsst
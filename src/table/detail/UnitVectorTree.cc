@@ -0,0 +1,252 @@
+// -*- lsst-c++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "boost/format.hpp"
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/afw/table/detail/UnitVectorTree.h"
+
+namespace lsst {
+namespace afw {
+namespace table {
+namespace detail {
+namespace {
+
+// Leaves are split until they hold no more than about this many points
+std::size_t const MAX_LEAF_SIZE = 16;
+
+// Return the index of the first leaf of a tree of n points
+std::size_t getFirstLeaf(std::size_t n) {
+    int depth = 0;
+    while ((n >> depth) > MAX_LEAF_SIZE) {
+        ++depth;
+    }
+    return (static_cast<std::size_t>(1) << depth) - 1;
+}
+
+}  // namespace
+
+std::size_t const UnitVectorTree::NONE;
+
+UnitVectorTree::UnitVectorTree(std::vector<Point> const &points)
+        : _points(), _indices(), _nodes(), _firstLeaf(0) {
+    std::size_t const n = points.size();
+    if (n == 0) {
+        return;
+    }
+    _firstLeaf = getFirstLeaf(n);
+    _nodes.resize(2 * _firstLeaf + 1);
+
+    std::vector<Entry> entries;
+    entries.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        entries.push_back(Entry{points[i], i});
+    }
+    build(0, 0, n, entries);
+
+    _points.reserve(n);
+    _indices.reserve(n);
+    for (auto const &entry : entries) {
+        _points.push_back(entry.point);
+        _indices.push_back(entry.index);
+    }
+}
+
+void UnitVectorTree::build(std::size_t index, std::size_t begin, std::size_t end,
+                           std::vector<Entry> &entries) {
+    Node &node = _nodes[index];
+    node.begin = begin;
+    node.end = end;
+    node.min.fill(std::numeric_limits<double>::infinity());
+    node.max.fill(-std::numeric_limits<double>::infinity());
+    for (std::size_t i = begin; i < end; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            node.min[k] = std::min(node.min[k], entries[i].point[k]);
+            node.max[k] = std::max(node.max[k], entries[i].point[k]);
+        }
+    }
+    if (index >= _firstLeaf) {
+        return;
+    }
+
+    // split the points in two at the median of the dimension with the largest extent
+    int dim = 0;
+    for (int k = 1; k < 3; ++k) {
+        if (node.max[k] - node.min[k] > node.max[dim] - node.min[dim]) {
+            dim = k;
+        }
+    }
+    std::size_t const mid = begin + (end - begin) / 2;
+    std::nth_element(entries.begin() + begin, entries.begin() + mid, entries.begin() + end,
+                     [dim](Entry const &e1, Entry const &e2) { return e1.point[dim] < e2.point[dim]; });
+    build(2 * index + 1, begin, mid, entries);
+    build(2 * index + 2, mid, end, entries);
+}
+
+UnitVectorTree UnitVectorTree::fromTreeOrder(std::vector<Point> points, std::vector<std::size_t> indices) {
+    if (points.size() != indices.size()) {
+        throw LSST_EXCEPT(pex::exceptions::LengthError,
+                          (boost::format("Number of points (%d) does not match number of indices (%d)") %
+                           points.size() % indices.size())
+                                  .str());
+    }
+    std::vector<bool> seen(indices.size(), false);
+    for (std::size_t i : indices) {
+        if (i >= indices.size() || seen[i]) {
+            throw LSST_EXCEPT(pex::exceptions::InvalidParameterError,
+                              "Indices are not a permutation of [0, number of points)");
+        }
+        seen[i] = true;
+    }
+
+    UnitVectorTree tree;
+    tree._points = std::move(points);
+    tree._indices = std::move(indices);
+    if (!tree._points.empty()) {
+        tree._firstLeaf = getFirstLeaf(tree._points.size());
+        tree._nodes.resize(2 * tree._firstLeaf + 1);
+        tree.computeBoxes(0, 0, tree._points.size());
+    }
+    return tree;
+}
+
+void UnitVectorTree::computeBoxes(std::size_t index, std::size_t begin, std::size_t end) {
+    Node &node = _nodes[index];
+    node.begin = begin;
+    node.end = end;
+    if (index >= _firstLeaf) {
+        node.min.fill(std::numeric_limits<double>::infinity());
+        node.max.fill(-std::numeric_limits<double>::infinity());
+        for (std::size_t i = begin; i < end; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                node.min[k] = std::min(node.min[k], _points[i][k]);
+                node.max[k] = std::max(node.max[k], _points[i][k]);
+            }
+        }
+        return;
+    }
+    std::size_t const mid = begin + (end - begin) / 2;
+    computeBoxes(2 * index + 1, begin, mid);
+    computeBoxes(2 * index + 2, mid, end);
+    Node const &child1 = _nodes[2 * index + 1];
+    Node const &child2 = _nodes[2 * index + 2];
+    for (int k = 0; k < 3; ++k) {
+        node.min[k] = std::min(child1.min[k], child2.min[k]);
+        node.max[k] = std::max(child1.max[k], child2.max[k]);
+    }
+}
+
+std::pair<std::size_t, double> UnitVectorTree::findClosest(Point const &point, double d2Limit) const {
+    std::pair<std::size_t, double> best(NONE, d2Limit);
+    if (_nodes.empty()) {
+        return best;
+    }
+    std::size_t stack[std::numeric_limits<std::size_t>::digits + 1];
+    int nStack = 0;
+    stack[nStack++] = 0;
+    while (nStack > 0) {
+        std::size_t const index = stack[--nStack];
+        Node const &node = _nodes[index];
+        if (boxDistanceSquared(node, point) >= best.second) {
+            continue;
+        }
+        if (index >= _firstLeaf) {
+            for (std::size_t i = node.begin; i < node.end; ++i) {
+                double const d2 = distanceSquared(point, _points[i]);
+                if (d2 < best.second) {
+                    best = std::make_pair(_indices[i], d2);
+                }
+            }
+        } else {
+            // visit the nearer child first, as it's likely to shrink the search radius the most
+            std::size_t nearChild = 2 * index + 1;
+            std::size_t farChild = 2 * index + 2;
+            if (boxDistanceSquared(_nodes[farChild], point) < boxDistanceSquared(_nodes[nearChild], point)) {
+                std::swap(nearChild, farChild);
+            }
+            stack[nStack++] = farChild;
+            stack[nStack++] = nearChild;
+        }
+    }
+    return best;
+}
+
+std::vector<std::pair<std::size_t, double> > UnitVectorTree::findNearest(Point const &point,
+                                                                        std::size_t k) const {
+    if (_nodes.empty() || k == 0) {
+        return {};
+    }
+    // a max-heap of the k closest points found so far, ordered by (d2, index)
+    std::vector<std::pair<double, std::size_t> > heap;
+    heap.reserve(std::min(k, size()));
+    auto bound = [&heap, k]() {
+        return heap.size() < k ? std::numeric_limits<double>::infinity() : heap.front().first;
+    };
+    std::size_t stack[std::numeric_limits<std::size_t>::digits + 1];
+    int nStack = 0;
+    stack[nStack++] = 0;
+    while (nStack > 0) {
+        std::size_t const index = stack[--nStack];
+        Node const &node = _nodes[index];
+        if (boxDistanceSquared(node, point) > bound()) {
+            continue;
+        }
+        if (index >= _firstLeaf) {
+            for (std::size_t i = node.begin; i < node.end; ++i) {
+                auto const candidate = std::make_pair(distanceSquared(point, _points[i]), _indices[i]);
+                if (heap.size() < k) {
+                    heap.push_back(candidate);
+                    std::push_heap(heap.begin(), heap.end());
+                } else if (candidate < heap.front()) {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.back() = candidate;
+                    std::push_heap(heap.begin(), heap.end());
+                }
+            }
+        } else {
+            std::size_t nearChild = 2 * index + 1;
+            std::size_t farChild = 2 * index + 2;
+            if (boxDistanceSquared(_nodes[farChild], point) < boxDistanceSquared(_nodes[nearChild], point)) {
+                std::swap(nearChild, farChild);
+            }
+            stack[nStack++] = farChild;
+            stack[nStack++] = nearChild;
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+    std::vector<std::pair<std::size_t, double> > result;
+    result.reserve(heap.size());
+    for (auto const &entry : heap) {
+        result.push_back(std::make_pair(entry.second, entry.first));
+    }
+    return result;
+}
+
+}  // namespace detail
+}  // namespace table
+}  // namespace afw
+}  // namespace lsst
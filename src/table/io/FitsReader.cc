@@ -52,6 +52,52 @@ void FitsReader::_setupArchive(afw::fits::Fits& fits, FitsSchemaInputMapper& map
         }
     }
 }
+
+std::size_t FitsReader::_findRunEnd(std::vector<std::size_t> const& rows, std::size_t i) {
+    std::size_t j = i + 1;
+    while (j < rows.size() && rows[j] == rows[j - 1] + 1) {
+        ++j;
+    }
+    return rows[j - 1] + 1;
+}
+
+std::vector<std::size_t> FitsReader::_selectRows(afw::fits::Fits& fits, FitsSchemaInputMapper& mapper,
+                                                 BaseTable& table, FitsReadOptions const& options) {
+    std::size_t const nRows = fits.countRows();
+    std::vector<std::size_t> rows;
+    if (!options.rows.empty()) {
+        for (std::size_t row : options.rows) {
+            if (row >= nRows) {
+                throw LSST_EXCEPT(pex::exceptions::OutOfRangeError,
+                                  (boost::format("Row %d is out of range for a table with %d rows") % row %
+                                   nRows)
+                                          .str());
+            }
+        }
+        rows = options.rows;
+    } else {
+        std::size_t const end = std::min(options.endRow, nRows);
+        for (std::size_t row = options.beginRow; row < end; ++row) {
+            rows.push_back(row);
+        }
+    }
+    if (options.filter) {
+        std::shared_ptr<BaseRecord> scratch = table.makeRecord();
+        std::vector<std::size_t> passed;
+        std::size_t runEnd = 0;
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            if (i == 0 || rows[i] != rows[i - 1] + 1) {
+                runEnd = _findRunEnd(rows, i);
+            }
+            mapper.readFilterColumn(*scratch, fits, rows[i], runEnd);
+            if (options.filter(*scratch)) {
+                passed.push_back(rows[i]);
+            }
+        }
+        rows.swap(passed);
+    }
+    return rows;
+}
 }  // namespace io
 }  // namespace table
 }  // namespace afw
@@ -4,6 +4,7 @@
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <set>
 #include <string>
 #include <algorithm>
 #include <cctype>
@@ -41,6 +42,46 @@ private:
     std::string const &_v;
 };
 
+// The values of a fixed-size column over a range of rows, read with a single call to CFITSIO.
+// The elements of each row are contiguous, as they are in the FITS table, and rows start `stride`
+// elements apart.  That is the number of elements in a row, except that the stride of a bit column
+// is padded to a whole number of bytes, because CFITSIO only moves on to the next row at a byte boundary.
+template <typename T>
+class ColumnCache {
+public:
+    ColumnCache(int column, std::size_t stride)
+            : _column(column), _stride(stride), _firstRow(0), _nRows(0), _capacity(0), _values() {}
+
+    // Read the values in rows [firstRow, firstRow + nRows).
+    void read(afw::fits::Fits &fits, std::size_t firstRow, std::size_t nRows) {
+        if (nRows * _stride > _capacity) {
+            _capacity = nRows * _stride;
+            _values.reset(new T[_capacity]);
+        }
+        _firstRow = firstRow;
+        _nRows = nRows;
+        if (nRows * _stride > 0) {
+            fits.readTableArray(firstRow, _column, nRows * _stride, _values.get());
+        }
+    }
+
+    // Return the values in `row`, reading them alone if they are not already cached.
+    T const *get(afw::fits::Fits &fits, std::size_t row) {
+        if (row < _firstRow || row >= _firstRow + _nRows) {
+            read(fits, row, 1);
+        }
+        return _values.get() + (row - _firstRow) * _stride;
+    }
+
+private:
+    int _column;
+    std::size_t _stride;
+    std::size_t _firstRow;
+    std::size_t _nRows;
+    std::size_t _capacity;
+    std::unique_ptr<T[]> _values;
+};
+
 }  // namespace
 
 class FitsSchemaInputMapper::Impl {
@@ -89,10 +130,19 @@ public:
     Schema schema;
     std::vector<std::unique_ptr<FitsColumnReader>> readers;
     std::vector<Key<Flag>> flagKeys;
-    std::unique_ptr<bool[]> flagWorkspace;
+    std::unique_ptr<ColumnCache<bool>> flagCache;
     std::shared_ptr<io::InputArchive> archive;
     InputContainer inputs;
     std::size_t nRowsToPrep = 1;
+    std::size_t preppedBegin = 0;  // the readers have cached rows [preppedBegin, preppedEnd)
+    std::size_t preppedEnd = 0;
+    bool selecting = false;        // whether only the fields in `selected` are to be read
+    std::set<std::string> selected;
+    std::string filterName;        // field read by readFilterColumn; empty if none
+    int filterReader = -1;         // index of the filter field's reader, or -1 if it is a Flag
+    int filterBit = -1;            // bit of the filter field, or -1 if it is not a Flag
+    std::size_t filterBegin = 0;   // the filter field's reader has cached rows [filterBegin, filterEnd)
+    std::size_t filterEnd = 0;
 };
 
 std::size_t FitsSchemaInputMapper::PREPPED_ROWS_FACTOR = 1 << 15;  // determined empirically; see DM-19461.
@@ -290,7 +340,7 @@ FitsSchemaInputMapper::FitsSchemaInputMapper(daf::base::PropertyList &metadata,
             nFlags = std::stoi(m[1].str());
         }
         _impl->flagKeys.resize(nFlags);
-        _impl->flagWorkspace.reset(new bool[nFlags]);
+        _impl->flagCache.reset(new ColumnCache<bool>(_impl->flagColumn, 8 * ((nFlags + 7) / 8)));
         // Delete the flag column from the input list so we don't interpret it as a
         // regular field.
         _impl->byColumn().erase(iter);
@@ -376,40 +426,21 @@ public:
     }
 
     StandardReader(Schema &schema, FitsSchemaItem const &item, FieldBase<T> const &base)
-            : _column(item.column), _key(schema.addField<T>(item.ttype, item.doc, item.tunit, base)),
-              _cache(), _cacheFirstRow(0)
-    {}
-
-    void prepRead(std::size_t firstRow, std::size_t nRows, fits::Fits & fits) override {
-        // We only prep and cache scalar-valued columns, not array-valued
-        // columns, as apparently the order CFITSIO reads array-valued columns
-        // is not the order we want.
-        if (_key.getElementCount() == 1u) {
-            std::size_t nElements = nRows*_key.getElementCount();
-            _cache.resize(nElements);
-            _cacheFirstRow = firstRow;
-            fits.readTableArray(firstRow, _column, nElements, &_cache.front());
-        }
+            : _key(schema.addField<T>(item.ttype, item.doc, item.tunit, base)),
+              _cache(item.column, _key.getElementCount()) {}
+
+    void prepRead(std::size_t firstRow, std::size_t nRows, fits::Fits &fits) override {
+        _cache.read(fits, firstRow, nRows);
     }
 
     void readCell(BaseRecord &record, std::size_t row, afw::fits::Fits &fits,
                   std::shared_ptr<InputArchive> const &archive) const override {
-        if (_cache.empty()) {
-            fits.readTableArray(row, _column, _key.getElementCount(), record.getElement(_key));
-        } else {
-            assert(row >= _cacheFirstRow);
-            std::size_t offset = row - _cacheFirstRow;
-            assert(offset < _cache.size());
-            std::copy_n(_cache.begin() + offset, _key.getElementCount(), record.getElement(_key));
-        }
+        std::copy_n(_cache.get(fits, row), _key.getElementCount(), record.getElement(_key));
     }
 
 private:
-    int _column;
     Key<T> _key;
-    std::vector<typename FieldBase<T>::Element> _cache;
-    std::size_t _cacheFirstRow;
-    std::size_t _nRowsToPrep;
+    mutable ColumnCache<typename FieldBase<T>::Element> _cache;
 };
 
 class AngleReader : public FitsColumnReader {
@@ -421,7 +452,8 @@ public:
     }
 
     AngleReader(Schema &schema, FitsSchemaItem const &item, FieldBase<lsst::geom::Angle> const &base)
-            : _column(item.column), _key(schema.addField<lsst::geom::Angle>(item.ttype, item.doc, "", base)) {
+            : _key(schema.addField<lsst::geom::Angle>(item.ttype, item.doc, "", base)),
+              _cache(item.column, 1) {
         // We require an LSST-specific key in the headers before parsing a column
         // as Angle at all, so we don't need to worry about other units or other
         // spellings of radians.  We do continue to support no units for backwards
@@ -432,32 +464,18 @@ public:
         }
     }
 
-    void prepRead(std::size_t firstRow, std::size_t nRows, fits::Fits & fits) override {
-        assert(_key.getElementCount() == 1u);
-        _cache.resize(nRows);
-        _cacheFirstRow = firstRow;
-        fits.readTableArray(firstRow, _column, nRows, &_cache.front());
+    void prepRead(std::size_t firstRow, std::size_t nRows, fits::Fits &fits) override {
+        _cache.read(fits, firstRow, nRows);
     }
 
     void readCell(BaseRecord &record, std::size_t row, afw::fits::Fits &fits,
                   std::shared_ptr<InputArchive> const &archive) const override {
-        if (_cache.empty()) {
-            double tmp = 0;
-            fits.readTableScalar(row, _column, tmp);
-            record.set(_key, tmp * lsst::geom::radians);
-        } else {
-            assert(row >= _cacheFirstRow);
-            std::size_t offset = row - _cacheFirstRow;
-            assert(offset < _cache.size());
-            record.set(_key, _cache[offset] * lsst::geom::radians);
-        }
+        record.set(_key, *_cache.get(fits, row) * lsst::geom::radians);
     }
 
 private:
-    int _column;
     Key<lsst::geom::Angle> _key;
-    std::vector<double> _cache;
-    std::size_t _cacheFirstRow;
+    mutable ColumnCache<double> _cache;
 };
 
 class StringReader : public FitsColumnReader {
@@ -469,19 +487,36 @@ public:
     StringReader(Schema &schema, FitsSchemaItem const &item, int size)
             : _column(item.column),
               _key(schema.addField<std::string>(item.ttype, item.doc, item.tunit, size)),
-              _isVariableLength(size == 0) {}
+              _isVariableLength(size == 0),
+              _cache(),
+              _cacheFirstRow(0) {}
+
+    void prepRead(std::size_t firstRow, std::size_t nRows, fits::Fits &fits) override {
+        // CFITSIO can only read variable-length strings one row at a time.
+        if (!_isVariableLength) {
+            _cache.resize(nRows);
+            _cacheFirstRow = firstRow;
+            fits.readTableStrings(firstRow, _column, nRows, _cache.data());
+        }
+    }
 
     void readCell(BaseRecord &record, std::size_t row, afw::fits::Fits &fits,
                   std::shared_ptr<InputArchive> const &archive) const override {
-        std::string s;
-        fits.readTableScalar(row, _column, s, _isVariableLength);
-        record.set(_key, s);
+        if (row >= _cacheFirstRow && row < _cacheFirstRow + _cache.size()) {
+            record.set(_key, _cache[row - _cacheFirstRow]);
+        } else {
+            std::string s;
+            fits.readTableScalar(row, _column, s, _isVariableLength);
+            record.set(_key, s);
+        }
     }
 
 private:
     int _column;
     Key<std::string> _key;
     bool _isVariableLength;
+    std::vector<std::string> _cache;
+    std::size_t _cacheFirstRow;
 };
 
 template <typename T>
@@ -517,18 +552,22 @@ public:
     }
 
     PointConversionReader(Schema &schema, FitsSchemaItem const &item)
-            : _column(item.column), _key(PointKey<T>::addFields(schema, item.ttype, item.doc, item.tunit)) {}
+            : _key(PointKey<T>::addFields(schema, item.ttype, item.doc, item.tunit)),
+              _cache(item.column, 2) {}
+
+    void prepRead(std::size_t firstRow, std::size_t nRows, fits::Fits &fits) override {
+        _cache.read(fits, firstRow, nRows);
+    }
 
     void readCell(BaseRecord &record, std::size_t row, afw::fits::Fits &fits,
                   std::shared_ptr<InputArchive> const &archive) const override {
-        std::array<T, 2> buffer;
-        fits.readTableArray(row, _column, 2, buffer.data());
+        T const *buffer = _cache.get(fits, row);
         record.set(_key, lsst::geom::Point<T, 2>(buffer[0], buffer[1]));
     }
 
 private:
-    int _column;
     PointKey<T> _key;
+    mutable ColumnCache<T> _cache;
 };
 
 // Read a 2-element FITS array column as separate ra and dec Schema fields (hence converting
@@ -540,18 +579,21 @@ public:
     }
 
     CoordConversionReader(Schema &schema, FitsSchemaItem const &item)
-            : _column(item.column), _key(CoordKey::addFields(schema, item.ttype, item.doc)) {}
+            : _key(CoordKey::addFields(schema, item.ttype, item.doc)), _cache(item.column, 2) {}
+
+    void prepRead(std::size_t firstRow, std::size_t nRows, fits::Fits &fits) override {
+        _cache.read(fits, firstRow, nRows);
+    }
 
     void readCell(BaseRecord &record, std::size_t row, afw::fits::Fits &fits,
                   std::shared_ptr<InputArchive> const &archive) const override {
-        std::array<lsst::geom::Angle, 2> buffer;
-        fits.readTableArray(row, _column, 2, buffer.data());
+        lsst::geom::Angle const *buffer = _cache.get(fits, row);
         record.set(_key, lsst::geom::SpherePoint(buffer[0], buffer[1]));
     }
 
 private:
-    int _column;
     CoordKey _key;
+    mutable ColumnCache<lsst::geom::Angle> _cache;
 };
 
 // Read a 3-element FITS array column as separate xx, yy, and xy Schema fields (hence converting
@@ -563,19 +605,22 @@ public:
     }
 
     MomentsConversionReader(Schema &schema, FitsSchemaItem const &item)
-            : _column(item.column),
-              _key(QuadrupoleKey::addFields(schema, item.ttype, item.doc, CoordinateType::PIXEL)) {}
+            : _key(QuadrupoleKey::addFields(schema, item.ttype, item.doc, CoordinateType::PIXEL)),
+              _cache(item.column, 3) {}
+
+    void prepRead(std::size_t firstRow, std::size_t nRows, fits::Fits &fits) override {
+        _cache.read(fits, firstRow, nRows);
+    }
 
     void readCell(BaseRecord &record, std::size_t row, afw::fits::Fits &fits,
                   std::shared_ptr<InputArchive> const &archive) const override {
-        std::array<double, 3> buffer;
-        fits.readTableArray(row, _column, 3, buffer.data());
+        double const *buffer = _cache.get(fits, row);
         record.set(_key, geom::ellipses::Quadrupole(buffer[0], buffer[1], buffer[2], false));
     }
 
 private:
-    int _column;
     QuadrupoleKey _key;
+    mutable ColumnCache<double> _cache;
 };
 
 // Read a FITS array column representing a packed symmetric matrix into
@@ -602,26 +647,28 @@ public:
 
     CovarianceConversionReader(Schema &schema, FitsSchemaItem const &item,
                                std::vector<std::string> const &names)
-            : _column(item.column),
-              _size(names.size()),
+            : _size(names.size()),
               _key(CovarianceMatrixKey<T, N>::addFields(schema, item.ttype, names, guessUnits(item.tunit))),
-              _buffer(new T[detail::computeCovariancePackedSize(names.size())]) {}
+              _cache(item.column, detail::computeCovariancePackedSize(names.size())) {}
+
+    void prepRead(std::size_t firstRow, std::size_t nRows, fits::Fits &fits) override {
+        _cache.read(fits, firstRow, nRows);
+    }
 
     void readCell(BaseRecord &record, std::size_t row, afw::fits::Fits &fits,
                   std::shared_ptr<InputArchive> const &archive) const override {
-        fits.readTableArray(row, _column, detail::computeCovariancePackedSize(_size), _buffer.get());
+        T const *buffer = _cache.get(fits, row);
         for (int i = 0; i < _size; ++i) {
             for (int j = i; j < _size; ++j) {
-                _key.setElement(record, i, j, _buffer[detail::indexCovariance(i, j)]);
+                _key.setElement(record, i, j, buffer[detail::indexCovariance(i, j)]);
             }
         }
     }
 
 private:
-    int _column;
     int _size;
     CovarianceMatrixKey<T, N> _key;
-    std::unique_ptr<T[]> _buffer;
+    mutable ColumnCache<T> _cache;
 };
 
 std::unique_ptr<FitsColumnReader> makeColumnReader(Schema &schema, FitsSchemaItem const &item) {
@@ -779,6 +826,17 @@ std::string replace(std::string full, std::string const & from, std::string cons
 
 }  // namespace
 
+void FitsSchemaInputMapper::selectColumns(std::vector<std::string> const &names,
+                                          std::string const &filterColumn) {
+    _impl->selecting = true;
+    _impl->selected.insert(names.begin(), names.end());
+    if (!filterColumn.empty()) {
+        _impl->selected.insert(filterColumn);
+    }
+}
+
+void FitsSchemaInputMapper::setFilterColumn(std::string const &name) { _impl->filterName = name; }
+
 Schema FitsSchemaInputMapper::finalize() {
     if (_impl->version == 0) {
         AliasMap &aliases = *_impl->schema.getAliasMap();
@@ -845,10 +903,19 @@ Schema FitsSchemaInputMapper::finalize() {
             }
         }
     }
+    std::set<std::string> unmatched = _impl->selected;
+    bool anyFlags = false;
     for (auto iter = _impl->asList().begin(); iter != _impl->asList().end(); ++iter) {
+        if (_impl->selecting && !_impl->selected.count(iter->ttype)) {
+            continue;  // not selected; don't add a field, so its column is never read
+        }
+        unmatched.erase(iter->ttype);
         if (iter->bit < 0) {  // not a Flag column
             std::unique_ptr<FitsColumnReader> reader = makeColumnReader(_impl->schema, *iter);
             if (reader) {
+                if (iter->ttype == _impl->filterName) {
+                    _impl->filterReader = _impl->readers.size();
+                }
                 _impl->readers.push_back(std::move(reader));
             } else {
                 LOGLS_WARN("afw.FitsSchemaInputMapper", "Format " << iter->tform << " for column "
@@ -863,32 +930,84 @@ Schema FitsSchemaInputMapper::finalize() {
                                           .str());
             }
             _impl->flagKeys[iter->bit] = _impl->schema.addField<Flag>(iter->ttype, iter->doc);
+            if (iter->ttype == _impl->filterName) {
+                _impl->filterBit = iter->bit;
+            }
+            anyFlags = true;
         }
     }
+    if (!unmatched.empty()) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError,
+                          (boost::format("Field '%s' not found in FITS table") % *unmatched.begin()).str());
+    }
+    if (!_impl->filterName.empty() && _impl->filterReader < 0 && _impl->filterBit < 0) {
+        throw LSST_EXCEPT(pex::exceptions::NotFoundError,
+                          (boost::format("Filter field '%s' not found in FITS table") % _impl->filterName)
+                                  .str());
+    }
+    if (_impl->selecting && !anyFlags) {
+        // none of the flags were selected, so there's no need to read the flag column at all
+        _impl->flagKeys.clear();
+        _impl->flagCache.reset();
+    }
     _impl->asList().clear();
     _impl->nRowsToPrep = std::max(PREPPED_ROWS_FACTOR / _impl->schema.getRecordSize(), std::size_t(1));
     return _impl->schema;
 }
 
-void FitsSchemaInputMapper::readRecord(BaseRecord &record, afw::fits::Fits &fits, std::size_t row) {
-    if (!_impl->flagKeys.empty()) {
-        fits.readTableArray<bool>(row, _impl->flagColumn, _impl->flagKeys.size(), _impl->flagWorkspace.get());
-        for (std::size_t bit = 0; bit < _impl->flagKeys.size(); ++bit) {
-            record.set(_impl->flagKeys[bit], _impl->flagWorkspace[bit]);
-        }
-    }
-    if (_impl->nRowsToPrep != 1 && row % _impl->nRowsToPrep == 0) {
+void FitsSchemaInputMapper::readRecord(BaseRecord &record, afw::fits::Fits &fits, std::size_t row,
+                                       std::size_t endRow) {
+    if (_impl->nRowsToPrep != 1 && (row < _impl->preppedBegin || row >= _impl->preppedEnd)) {
         // Give readers a chance to read and cache up to nRowsToPrep rows-
-        // worth of values.
-        std::size_t size = std::min(_impl->nRowsToPrep, fits.countRows() - row);
+        // worth of values, of the rows that will actually be read.
+        std::size_t size = std::min(_impl->nRowsToPrep, std::min(endRow, fits.countRows()) - row);
+        if (_impl->flagCache) {
+            _impl->flagCache->read(fits, row, size);
+        }
         for (auto & reader : _impl->readers) {
             reader->prepRead(row, size, fits);
         }
+        _impl->preppedBegin = row;
+        _impl->preppedEnd = row + size;
+        _impl->filterEnd = _impl->filterBegin;  // the filter field's cache has been replaced
+    }
+    if (!_impl->flagKeys.empty()) {
+        bool const *flags = _impl->flagCache->get(fits, row);
+        for (std::size_t bit = 0; bit < _impl->flagKeys.size(); ++bit) {
+            if (_impl->flagKeys[bit].isValid()) {
+                record.set(_impl->flagKeys[bit], flags[bit]);
+            }
+        }
     }
     for (auto const & reader : _impl->readers) {
         reader->readCell(record, row, fits, _impl->archive);
     }
 }
+
+void FitsSchemaInputMapper::readFilterColumn(BaseRecord &record, afw::fits::Fits &fits, std::size_t row,
+                                             std::size_t endRow) {
+    if (_impl->filterReader < 0 && _impl->filterBit < 0) {
+        throw LSST_EXCEPT(pex::exceptions::LogicError, "No filter field has been set.");
+    }
+    if (_impl->nRowsToPrep != 1 && (row < _impl->filterBegin || row >= _impl->filterEnd)) {
+        // Only the filter field's column is read ahead, so the rest of the rows are never decoded
+        // if they're rejected.
+        std::size_t size = std::min(_impl->nRowsToPrep, std::min(endRow, fits.countRows()) - row);
+        if (_impl->filterBit >= 0) {
+            _impl->flagCache->read(fits, row, size);
+        } else {
+            _impl->readers[_impl->filterReader]->prepRead(row, size, fits);
+        }
+        _impl->filterBegin = row;
+        _impl->filterEnd = row + size;
+        _impl->preppedEnd = _impl->preppedBegin;  // readRecord's caches are no longer complete
+    }
+    if (_impl->filterBit >= 0) {
+        record.set(_impl->flagKeys[_impl->filterBit], _impl->flagCache->get(fits, row)[_impl->filterBit]);
+    } else {
+        _impl->readers[_impl->filterReader]->readCell(record, row, fits, _impl->archive);
+    }
+}
 }  // namespace io
 }  // namespace table
 }  // namespace afw
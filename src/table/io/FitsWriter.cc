@@ -1,6 +1,8 @@
 // -*- lsst-c++ -*-
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "lsst/afw/table/io/FitsWriter.h"
 #include "lsst/afw/table/BaseTable.h"
@@ -122,7 +124,7 @@ void FitsWriter::_writeTable(std::shared_ptr<BaseTable const> const& table, std:
     metadata->remove("AFW_TABLE_VERSION");
     _row = -1;
     _fits->addRows(nRows);
-    _processor = std::make_shared<ProcessRecords>(_fits, schema, nFlags, _row);
+    _processor = std::make_shared<ProcessRecords>(_fits, schema, nFlags, nRows);
 }
 
 //----- Code for writing FITS records -----------------------------------------------------------------------
@@ -130,66 +132,201 @@ void FitsWriter::_writeTable(std::shared_ptr<BaseTable const> const& table, std:
 // The driver code is at the bottom of this section; it's easier to understand if you start there
 // and work your way up.
 
-// A Schema::forEach functor that writes table data for a single record when it is called.
-// We instantiate one of these, then reuse it on all the records after updating the data
-// members that tell it which record and row number it's on.
+namespace {
+
+// Buffers the values of one column over a block of rows.
+class ColumnWriter {
+public:
+    // Copy the column's value in `record` to row `i` of the block.
+    virtual void copy(BaseRecord const& record, std::size_t i) = 0;
+
+    // Write the first `n` rows of the block to the table, starting at table row `row`.
+    virtual void write(Fits& fits, std::size_t row, std::size_t n) = 0;
+
+    virtual ~ColumnWriter() = default;
+};
+
+// Writer for scalar and fixed-length array fields, which are stored contiguously in the record.
+template <typename T>
+class FixedColumnWriter : public ColumnWriter {
+public:
+    typedef typename Field<T>::Element Element;
+
+    FixedColumnWriter(Key<T> const& key, int col, std::size_t blockRows)
+            : _key(key), _col(col), _size(key.getElementCount()), _buffer(new Element[blockRows * _size]) {}
+
+    void copy(BaseRecord const& record, std::size_t i) override {
+        std::copy_n(record.getElement(_key), _size, _buffer.get() + i * _size);
+    }
+
+    void write(Fits& fits, std::size_t row, std::size_t n) override {
+        fits.writeTableArray(row, _col, n * _size, _buffer.get());
+    }
+
+private:
+    Key<T> _key;
+    int _col;
+    std::size_t _size;
+    std::unique_ptr<Element[]> _buffer;
+};
+
+// Writer for variable-length array fields; cfitsio can only write these one row at a time.
+template <typename T>
+class VariableArrayColumnWriter : public ColumnWriter {
+public:
+    VariableArrayColumnWriter(Key<Array<T> > const& key, int col, std::size_t blockRows)
+            : _key(key), _col(col), _buffer(blockRows) {}
+
+    void copy(BaseRecord const& record, std::size_t i) override {
+        _buffer[i] = ndarray::copy(record.get(_key));
+    }
+
+    void write(Fits& fits, std::size_t row, std::size_t n) override {
+        for (std::size_t i = 0; i < n; ++i) {
+            fits.writeTableArray(row + i, _col, _buffer[i].template getSize<0>(), _buffer[i].getData());
+            _buffer[i] = ndarray::Array<T, 1, 1>();
+        }
+    }
+
+private:
+    Key<Array<T> > _key;
+    int _col;
+    std::vector<ndarray::Array<T, 1, 1> > _buffer;
+};
+
+// Writer for string fields; fixed-length strings are written a block at a time.
+class StringColumnWriter : public ColumnWriter {
+public:
+    StringColumnWriter(Key<std::string> const& key, int col, std::size_t blockRows)
+            : _key(key), _col(col), _buffer(blockRows) {}
+
+    void copy(BaseRecord const& record, std::size_t i) override { _buffer[i] = record.get(_key); }
+
+    void write(Fits& fits, std::size_t row, std::size_t n) override {
+        if (_key.isVariableLength()) {
+            for (std::size_t i = 0; i < n; ++i) {
+                fits.writeTableScalar(row + i, _col, _buffer[i]);
+            }
+        } else {
+            fits.writeTableStrings(row, _col, n, _buffer.data());
+        }
+    }
+
+private:
+    Key<std::string> _key;
+    int _col;
+    std::vector<std::string> _buffer;
+};
+
+// Writer for the single column that holds the bits of all Flag fields.
+//
+// CFITSIO only moves to the next row of a bit column at a byte boundary, so each row of the buffer is
+// padded to a whole number of bytes; the padding bits are always false.
+class FlagColumnWriter : public ColumnWriter {
+public:
+    FlagColumnWriter(std::vector<Key<Flag> > const& keys, std::size_t blockRows)
+            : _keys(keys),
+              _stride(8 * ((keys.size() + 7) / 8)),
+              _buffer(new bool[blockRows * _stride]()) {}
+
+    void copy(BaseRecord const& record, std::size_t i) override {
+        bool* flags = _buffer.get() + i * _stride;
+        for (std::size_t bit = 0; bit < _keys.size(); ++bit) {
+            flags[bit] = record.get(_keys[bit]);
+        }
+    }
+
+    void write(Fits& fits, std::size_t row, std::size_t n) override {
+        fits.writeTableArray(row, 0, n * _stride, _buffer.get());
+    }
+
+private:
+    std::vector<Key<Flag> > _keys;
+    std::size_t _stride;  // number of bits in each row of _buffer, including padding
+    std::unique_ptr<bool[]> _buffer;
+};
+
+}  // namespace
+
+// A Schema::forEach functor that makes a ColumnWriter for each field when it is called, in the same
+// order ProcessSchema added the columns.  We instantiate one of these per table, and then copy
+// each record into its ColumnWriters, writing them out whenever a block of rows is complete.
 struct FitsWriter::ProcessRecords {
     template <typename T>
     void operator()(SchemaItem<T> const& item) const {
-        fits->writeTableArray(row, col, item.key.getElementCount(), record->getElement(item.key));
+        columns.push_back(std::make_shared<FixedColumnWriter<T> >(item.key, col, blockRows));
         ++col;
     }
 
     template <typename T>
     void operator()(SchemaItem<Array<T> > const& item) const {
         if (item.key.isVariableLength()) {
-            ndarray::Array<T const, 1, 1> array = record->get(item.key);
-            fits->writeTableArray(row, col, array.template getSize<0>(), array.getData());
+            columns.push_back(std::make_shared<VariableArrayColumnWriter<T> >(item.key, col, blockRows));
         } else {
-            fits->writeTableArray(row, col, item.key.getElementCount(), record->getElement(item.key));
+            columns.push_back(std::make_shared<FixedColumnWriter<Array<T> > >(item.key, col, blockRows));
         }
         ++col;
     }
 
     void operator()(SchemaItem<std::string> const& item) const {
-        // Write fixed-length and variable-length strings the same way
-        fits->writeTableScalar(row, col, record->get(item.key));
+        columns.push_back(std::make_shared<StringColumnWriter>(item.key, col, blockRows));
         ++col;
     }
 
-    void operator()(SchemaItem<Flag> const& item) const {
-        flags[bit] = record->get(item.key);
-        ++bit;
+    void operator()(SchemaItem<Flag> const& item) const { flagKeys.push_back(item.key); }
+
+    ProcessRecords(Fits* fits_, Schema const& schema, int nFlags, std::size_t nRows)
+            : col(0), blockRows(0), blockStart(0), blockSize(0), fits(fits_) {
+        std::size_t const recordSize = std::max(schema.getRecordSize(), 1);
+        blockRows = std::max<std::size_t>(1, std::min(nRows, WRITTEN_ROWS_FACTOR / recordSize));
+        if (nFlags) ++col;
+        schema.forEach(*this);
+        if (nFlags) {
+            columns.push_back(std::make_shared<FlagColumnWriter>(flagKeys, blockRows));
+        }
     }
 
-    ProcessRecords(Fits* fits_, Schema const& schema_, int nFlags_, std::size_t const& row_)
-            : row(row_), col(0), bit(0), nFlags(nFlags_), fits(fits_), schema(schema_) {
-        if (nFlags) flags.reset(new bool[nFlags]);
+    void apply(BaseRecord const* record) {
+        for (auto const& column : columns) {
+            column->copy(*record, blockSize);
+        }
+        ++blockSize;
+        if (blockSize == blockRows) {
+            flush();
+        }
     }
 
-    void apply(BaseRecord const* r) {
-        record = r;
-        col = 0;
-        bit = 0;
-        if (nFlags) ++col;
-        schema.forEach(*this);
-        if (nFlags) fits->writeTableArray(row, 0, nFlags, flags.get());
+    void flush() {
+        if (blockSize == 0) return;
+        for (auto const& column : columns) {
+            column->write(*fits, blockStart, blockSize);
+        }
+        blockStart += blockSize;
+        blockSize = 0;
     }
 
-    std::size_t const& row;
     mutable int col;
-    mutable int bit;
-    int nFlags;
+    mutable std::vector<std::shared_ptr<ColumnWriter> > columns;
+    mutable std::vector<Key<Flag> > flagKeys;
+    std::size_t blockRows;   // the number of rows buffered before they are written
+    std::size_t blockStart;  // the table row of the first buffered record
+    std::size_t blockSize;   // the number of buffered records
     Fits* fits;
-    std::unique_ptr<bool[]> flags;
-    BaseRecord const* record;
-    Schema schema;
 };
 
+std::size_t FitsWriter::WRITTEN_ROWS_FACTOR = 1 << 23;
+
 void FitsWriter::_writeRecord(BaseRecord const& record) {
     ++_row;
     _processor->apply(&record);
 }
+
+void FitsWriter::_flushRecords() {
+    if (_processor) {
+        _processor->flush();
+    }
+}
+
 }  // namespace io
 }  // namespace table
 }  // namespace afw
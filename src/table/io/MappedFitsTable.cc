@@ -0,0 +1,272 @@
+// -*- lsst-c++ -*-
+/*
+ * This file is part of afw.
+ *
+ * Developed for the LSST Data Management System.
+ * This product includes software developed by the LSST Project
+ * (https://www.lsst.org).
+ * See the COPYRIGHT file at the top-level directory of this distribution
+ * for details of code ownership.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "boost/format.hpp"
+
+#include "lsst/pex/exceptions.h"
+#include "lsst/afw/table/io/MappedFitsTable.h"
+
+namespace lsst {
+namespace afw {
+namespace table {
+namespace io {
+namespace {
+
+// The FITS TFORM type code each stored element type is written with (see getFormatCode in fits.cc);
+// 'U' stands for 'I' with TZERO = 32768.
+char getStorageCode(std::uint8_t *) { return 'B'; }
+char getStorageCode(std::uint16_t *) { return 'U'; }
+char getStorageCode(std::int32_t *) { return 'J'; }
+char getStorageCode(std::int64_t *) { return 'K'; }
+char getStorageCode(float *) { return 'E'; }
+char getStorageCode(double *) { return 'D'; }
+char getStorageCode(bool *) { return 'X'; }
+
+template <typename T>
+char getStorageCode() {
+    typedef typename detail::MappedStorage<typename Field<T>::Element>::Stored Stored;
+    return getStorageCode(static_cast<Stored *>(nullptr));
+}
+
+// Return true if columns with the given TFORM type code hold values that getStorageCode can describe;
+// strings, variable-length arrays, logicals and complex values cannot be mapped.
+bool isMappableCode(char code) {
+    switch (code) {
+        case 'B':
+        case 'U':
+        case 'J':
+        case 'K':
+        case 'E':
+        case 'D':
+            return true;
+    }
+    return false;
+}
+
+// Throw if an Array field is variable-length; such fields are stored in the heap, not in the row.
+template <typename T>
+void checkFixedSize(Key<T> const &, std::string const &) {}
+
+template <typename U>
+void checkFixedSize(Key<Array<U> > const &key, std::string const &name) {
+    if (key.getSize() == 0) {
+        throw LSST_EXCEPT(pex::exceptions::TypeError,
+                          (boost::format("Field '%s' is a variable-length array, which cannot be mapped") %
+                           name)
+                                  .str());
+    }
+}
+
+// Return the number of bytes taken by `count` elements with the given TFORM type code in each row,
+// or 0 if the code is one that cannot be mapped.
+std::size_t getColumnWidth(char code, int count) {
+    switch (code) {
+        case 'X':
+            return (count + 7) / 8;
+        case 'L':
+        case 'A':
+        case 'B':
+            return count;
+        case 'I':
+            return 2 * count;
+        case 'J':
+        case 'E':
+            return 4 * count;
+        case 'K':
+        case 'D':
+        case 'C':
+        case 'P':
+            return 8 * count;
+        case 'M':
+        case 'Q':
+            return 16 * count;
+    }
+    return 0;
+}
+
+std::string makeKey(std::string const &prefix, int n) { return prefix + std::to_string(n); }
+
+// Map a whole file read-only, returning a pointer to its first byte that unmaps it when the last
+// copy is destroyed.
+std::shared_ptr<std::uint8_t const> mapFile(std::string const &filename, std::size_t &size) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw LSST_EXCEPT(fits::FitsError, (boost::format("Could not open '%s' for mapping: %s") %
+                                            filename % std::strerror(errno))
+                                                   .str());
+    }
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || status.st_size == 0) {
+        ::close(fd);
+        throw LSST_EXCEPT(fits::FitsError,
+                          (boost::format("Could not map '%s': not a non-empty regular file") % filename)
+                                  .str());
+    }
+    size = status.st_size;
+    void *address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw LSST_EXCEPT(fits::FitsError,
+                          (boost::format("Could not map '%s': %s") % filename % std::strerror(errno)).str());
+    }
+    return std::shared_ptr<std::uint8_t const>(
+            static_cast<std::uint8_t const *>(address),
+            [size](std::uint8_t const *data) { ::munmap(const_cast<std::uint8_t *>(data), size); });
+}
+
+}  // namespace
+
+MappedFitsTable::MappedFitsTable(std::string const &filename, int hdu)
+        : _schema(), _metadata(), _data(), _nRows(0), _rowSize(0), _columns() {
+    std::size_t dataOffset = 0;
+    auto header = std::make_shared<daf::base::PropertyList>();  // including the keys cfitsio manages
+    _metadata = std::make_shared<daf::base::PropertyList>();
+    {
+        fits::Fits fitsfile(filename, "r", fits::Fits::AUTO_CLOSE | fits::Fits::AUTO_CHECK);
+        fitsfile.setHdu(hdu);
+        fitsfile.readMetadata(*header, false);
+        fitsfile.readMetadata(*_metadata, true);
+        if (header->get("XTENSION", std::string()) != "BINTABLE" || header->exists("ZTABLE")) {
+            throw LSST_EXCEPT(fits::FitsError,
+                              (boost::format("HDU %d of '%s' is not an uncompressed binary table") %
+                               fitsfile.getHdu() % filename)
+                                      .str());
+        }
+        _nRows = fitsfile.countRows();
+        dataOffset = fitsfile.getDataOffset();
+    }
+    _rowSize = header->getAsInt64("NAXIS1");
+
+    // Work out where each column is in a row, and which can be mapped.
+    std::map<int, Column> byNumber;  // 1-indexed, like the header keys
+    int const nColumns = header->getAsInt("TFIELDS");
+    std::size_t offset = 0;
+    for (int n = 1; n <= nColumns; ++n) {
+        std::string const tform = header->get<std::string>(makeKey("TFORM", n));
+        std::size_t codePos = tform.find_first_not_of("0123456789");
+        if (codePos == std::string::npos) {
+            throw LSST_EXCEPT(fits::FitsError,
+                              (boost::format("Invalid TFORM%d '%s' in '%s'") % n % tform % filename).str());
+        }
+        Column column{offset, tform[codePos], codePos > 0 ? std::atoi(tform.c_str()) : 1, -1};
+        offset += getColumnWidth(column.code, column.count);
+        std::string const tscal = makeKey("TSCAL", n);
+        std::string const tzero = makeKey("TZERO", n);
+        if (header->exists(tscal) && header->getAsDouble(tscal) != 1.0) {
+            continue;
+        }
+        double const zero = header->exists(tzero) ? header->getAsDouble(tzero) : 0.0;
+        if (column.code == 'I' && zero == 32768.0) {
+            column.code = 'U';
+        } else if (zero != 0.0) {
+            continue;
+        }
+        byNumber[n] = column;
+    }
+    if (offset != _rowSize) {
+        throw LSST_EXCEPT(fits::FitsError, (boost::format("Columns in '%s' take %d bytes, but rows have %d") %
+                                            filename % offset % _rowSize)
+                                                   .str());
+    }
+
+    // Match them to fields by name; the flag column holds a bit for each Flag field.
+    int const flagColumn = header->exists("FLAGCOL") ? header->getAsInt("FLAGCOL") : 0;
+    for (auto const &entry : byNumber) {
+        if (entry.first == flagColumn) {
+            for (int bit = 0; bit < entry.second.count; ++bit) {
+                std::string const key = makeKey("TFLAG", bit + 1);
+                if (header->exists(key)) {
+                    Column column = entry.second;
+                    column.bit = bit;
+                    _columns[header->get<std::string>(key)] = column;
+                }
+            }
+        } else if (isMappableCode(entry.second.code) && header->exists(makeKey("TTYPE", entry.first))) {
+            _columns[header->get<std::string>(makeKey("TTYPE", entry.first))] = entry.second;
+        }
+    }
+
+    _schema = Schema::fromFitsMetadata(*_metadata, true);
+
+    std::size_t size = 0;
+    std::shared_ptr<std::uint8_t const> mapping = mapFile(filename, size);
+    // cfitsio reads files that are gzipped or given with extended filename syntax, but those can't
+    // be mapped; make sure what we've mapped is what cfitsio read.
+    if (size < 9 || std::memcmp(mapping.get(), "SIMPLE  =", 9) != 0 ||
+        dataOffset + _nRows * _rowSize > size) {
+        throw LSST_EXCEPT(fits::FitsError,
+                          (boost::format("'%s' is not an uncompressed FITS file") % filename).str());
+    }
+    _data = std::shared_ptr<std::uint8_t const>(mapping, mapping.get() + dataOffset);
+}
+
+template <typename T>
+MappedColumn<T> MappedFitsTable::getColumn(Key<T> const &key) const {
+    std::string const name = _schema.find(key).field.getName();
+    checkFixedSize(key, name);
+    auto iter = _columns.find(name);
+    if (iter == _columns.end() || iter->second.code != getStorageCode<T>()) {
+        throw LSST_EXCEPT(pex::exceptions::TypeError,
+                          (boost::format("Field '%s' is not stored in a form that can be mapped") % name)
+                                  .str());
+    }
+    Column const &column = iter->second;
+    if (column.bit >= 0) {
+        // a Flag: point at the byte holding the bit, and pass the bit within that byte
+        return MappedColumn<T>(std::shared_ptr<std::uint8_t const>(_data, _data.get() + column.offset +
+                                                                                  column.bit / 8),
+                               _nRows, _rowSize, column.bit % 8);
+    }
+    return MappedColumn<T>(std::shared_ptr<std::uint8_t const>(_data, _data.get() + column.offset), _nRows,
+                           _rowSize, column.count);
+}
+
+// =============== Explicit instantiations ==================================================================
+
+#define INSTANTIATE_MAPPED_SCALAR(r, data, elem) \
+    template MappedColumn<elem> MappedFitsTable::getColumn(Key<elem> const &) const;
+
+BOOST_PP_SEQ_FOR_EACH(INSTANTIATE_MAPPED_SCALAR, _,
+                      BOOST_PP_TUPLE_TO_SEQ(AFW_TABLE_SCALAR_FIELD_TYPE_N, AFW_TABLE_SCALAR_FIELD_TYPE_TUPLE))
+
+#define INSTANTIATE_MAPPED_ARRAY(r, data, elem) \
+    template MappedColumn<Array<elem> > MappedFitsTable::getColumn(Key<Array<elem> > const &) const;
+
+BOOST_PP_SEQ_FOR_EACH(INSTANTIATE_MAPPED_ARRAY, _,
+                      BOOST_PP_TUPLE_TO_SEQ(AFW_TABLE_ARRAY_FIELD_TYPE_N, AFW_TABLE_ARRAY_FIELD_TYPE_TUPLE))
+
+template MappedColumn<Flag> MappedFitsTable::getColumn(Key<Flag> const &) const;
+
+}  // namespace io
+}  // namespace table
+}  // namespace afw
+}  // namespace lsst
@@ -25,6 +25,7 @@
 #include <iostream>
 #include <limits>
 #include <cmath>
+#include <string>
 
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE StatisticsSpeed
@@ -38,6 +39,7 @@
 
 #include "lsst/geom.h"
 #include "lsst/afw/image/Image.h"
+#include "lsst/afw/image/MaskedImage.h"
 #include "lsst/afw/math/Statistics.h"
 
 using namespace std;
@@ -46,6 +48,20 @@ namespace image = lsst::afw::image;
 namespace math = lsst::afw::math;
 
 typedef image::Image<float> Image;
+typedef image::MaskedImage<float> MaskedImage;
+
+namespace {
+/*
+ * Report the time taken to process nBytes, and the corresponding throughput
+ */
+void reportThroughput(std::string const& what, double nBytes, double seconds) {
+    std::cout << what << ": " << seconds << " s";
+    if (seconds > 0) {
+        std::cout << " (" << nBytes / seconds * 1e-9 << " GB/s)";
+    }
+    std::cout << std::endl;
+}
+}  // namespace
 
 /*
  * This test verifies that turning off NanSafe will slow down the Statistics computation.
@@ -115,7 +131,10 @@ BOOST_AUTO_TEST_CASE(StatisticsNanSafeSlower) { /* parasoft-suppress  LsstDm-3-2
         bool isFasterWithSimple = (tSimple < tNanSafe && tSimple < tMinMax);
         bool isSlowerWithMinMax = (tMinMax > tNanSafe && tMinMax > tSimple);
 
-        std::cout << tSimple << " " << tNanSafe << " " << tMinMax << std::endl;
+        double const nBytes = static_cast<double>(nx) * ny * sizeof(Image::Pixel);
+        reportThroughput("NanSafe=false, MEAN", nBytes, tSimple);
+        reportThroughput("NanSafe=true, MEAN", nBytes, tNanSafe);
+        reportThroughput("NanSafe=true, MEAN | MIN", nBytes, tMinMax);
 
         if (!isFasterWithSimple) {
             std::cerr << "Warning: statistics were faster with nanSafe=true." << std::endl;
@@ -132,3 +151,40 @@ BOOST_AUTO_TEST_CASE(StatisticsNanSafeSlower) { /* parasoft-suppress  LsstDm-3-2
 #endif
     }
 }
+
+/*
+ * Report the throughput of the standard statistics of a MaskedImage, which read the image and mask planes.
+ */
+BOOST_AUTO_TEST_CASE(StatisticsMaskedImageThroughput) { /* parasoft-suppress  LsstDm-3-2a LsstDm-3-4a
+                                                           LsstDm-4-6 LsstDm-5-25 "Boost non-Std" */
+    int const nx = 8192;
+    int const ny = nx;
+    MaskedImage mimg(lsst::geom::Extent2I(nx, ny));
+    image::MaskPixel const badBit = image::Mask<image::MaskPixel>::getPlaneBitMask("BAD");
+    for (int iY = 0; iY < ny; ++iY) {
+        int x = 0;
+        for (MaskedImage::x_iterator ptr = mimg.row_begin(iY); ptr != mimg.row_end(iY); ++ptr, ++x) {
+            ptr.image() = x % 2;                           // half 0, half 1
+            ptr.mask() = (iY == 0 && x == 0) ? badBit : 0;  // ignore the first pixel
+            ptr.variance() = 1.0;
+        }
+    }
+    math::StatisticsControl sctrl;
+    sctrl.setAndMask(badBit);
+
+    boost::timer timer;
+    math::Statistics stats = math::makeStatistics(
+            mimg, math::NPOINT | math::MEAN | math::STDEV | math::MIN | math::MAX | math::ORMASK, sctrl);
+    double const tMasked = timer.elapsed();
+
+    double const nPoint = static_cast<double>(nx) * ny - 1;
+    BOOST_CHECK_EQUAL(stats.getValue(math::NPOINT), nPoint);
+    BOOST_CHECK_CLOSE(stats.getValue(math::MEAN), (nPoint + 1) / 2 / nPoint, 1e-10);
+    BOOST_CHECK_EQUAL(stats.getValue(math::MIN), 0.0);
+    BOOST_CHECK_EQUAL(stats.getValue(math::MAX), 1.0);
+    BOOST_CHECK_EQUAL(stats.getValue(math::ORMASK), 0.0);
+
+    double const nBytes = static_cast<double>(nx) * ny * (sizeof(MaskedImage::Image::Pixel) +
+                                                          sizeof(MaskedImage::Mask::Pixel));
+    reportThroughput("MaskedImage, MEAN | STDEV | MIN | MAX", nBytes, tMasked);
+}
@@ -661,6 +661,63 @@ class BackgroundTestCase(lsst.utils.tests.TestCase):
                 else:
                     self.assertTrue(np.isnan(val))
 
+    def testThreadsAndSinglePass(self):
+        """Test that the statistics of the cells don't depend on the number of threads, or on whether
+        they're computed a cell at a time or (for single-pass statistics) in a single pass"""
+        np.random.seed(2)
+        mi = afwImage.MaskedImageF(237, 161)
+        mi.image.array[:] = np.random.normal(50.0, 3.0, mi.image.array.shape)
+        mi.image.array[100:120, 10:40] = np.nan
+        badBit = mi.mask.getPlaneBitMask("BAD")
+        mi.mask.array[:] = np.where(np.random.uniform(size=mi.mask.array.shape) < 0.05, badBit, 0)
+
+        for prop in (afwMath.MEANCLIP, afwMath.MEAN, afwMath.MEDIAN):
+            statsImages = []
+            for nThreads in (1, 4):
+                sctrl = afwMath.StatisticsControl()
+                sctrl.setAndMask(badBit)
+                sctrl.setNThreads(nThreads)
+                bctrl = afwMath.BackgroundControl(9, 7, sctrl, prop)
+                statsImages.append(afwMath.makeBackground(mi, bctrl).getStatsImage())
+            self.assertMaskedImagesEqual(statsImages[0], statsImages[1])
+            statsImage = statsImages[0]
+
+            if prop != afwMath.MEAN:
+                continue
+            # compare with the statistics of each cell, computed separately
+            nx, ny = statsImage.getWidth(), statsImage.getHeight()
+            xEnds = [0] + [min(((i + 1)*mi.getWidth() + nx//2)//nx, mi.getWidth()) for i in range(nx)]
+            yEnds = [0] + [min(((i + 1)*mi.getHeight() + ny//2)//ny, mi.getHeight()) for i in range(ny)]
+            for iY in range(ny):
+                for iX in range(nx):
+                    box = lsst.geom.Box2I(lsst.geom.Point2I(xEnds[iX], yEnds[iY]),
+                                          lsst.geom.Point2I(xEnds[iX + 1] - 1, yEnds[iY + 1] - 1))
+                    cell = afwMath.makeStatistics(mi.subset(box), prop | afwMath.ERRORS, sctrl)
+                    self.assertEqual(statsImage.image[iX, iY, afwImage.LOCAL], np.float32(cell.getValue()))
+
+    def testCachedInterpolation(self):
+        """Test that getImage gives the same results when it reuses the interpolation of an earlier call"""
+        np.random.seed(4)
+        image = afwImage.ImageF(lsst.geom.Box2I(lsst.geom.Point2I(10, 20), lsst.geom.Extent2I(300, 250)))
+        yy, xx = np.mgrid[0:250, 0:300]
+        image.array[:] = 100.0 + 0.1*xx - 0.05*yy + 1e-4*xx*yy + np.random.normal(0.0, 1.0, xx.shape)
+        bctrl = afwMath.BackgroundControl(7, 6, afwMath.StatisticsControl(), afwMath.MEAN)
+        subBBox = lsst.geom.Box2I(lsst.geom.Point2I(50, 70), lsst.geom.Extent2I(123, 57))
+
+        for style in (afwMath.Interpolate.LINEAR, afwMath.Interpolate.NATURAL_SPLINE,
+                      afwMath.Interpolate.AKIMA_SPLINE):
+            bkgd = afwMath.makeBackground(image, bctrl)
+            first = bkgd.getImageF(style)
+            self.assertImagesEqual(bkgd.getImageF(style), first)
+            self.assertImagesEqual(bkgd.getImageF(subBBox, style), first.subset(subBBox))
+            # a different style shouldn't reuse the interpolation
+            fresh = afwMath.makeBackground(image, bctrl)
+            self.assertImagesEqual(bkgd.getImageF(afwMath.Interpolate.CONSTANT),
+                                   fresh.getImageF(afwMath.Interpolate.CONSTANT))
+            # nor should a modified background
+            bkgd += 5.0
+            self.assertFloatsAlmostEqual(bkgd.getImageF(style).array, first.array + 5.0, rtol=1e-6)
+
     def testBackgroundFromStatsImage(self):
         """Check that we can rebuild a Background from a BackgroundMI.getStatsImage()"""
         bgCtrl = afwMath.BackgroundControl(10, 10)
@@ -383,6 +383,27 @@ class ConvolveTestCase(lsst.utils.tests.TestCase):
             self.assertEqual(
                 convControl.getMaxInterpolationDistance(), maxInterpDist)
 
+        self.assertEqual(convControl.getNThreads(), 1)
+        for nThreads in (0, 1, 4):
+            convControl.setNThreads(nThreads)
+            self.assertEqual(convControl.getNThreads(), nThreads)
+
+        self.assertEqual(convControl.getTileSize(), 256)
+        for tileSize in (1, 16, 1024):
+            convControl.setTileSize(tileSize)
+            self.assertEqual(convControl.getTileSize(), tileSize)
+
+        self.assertEqual(convControl.getAlgorithm(), afwMath.ConvolutionControl.AUTO)
+        for algorithm in (afwMath.ConvolutionControl.DIRECT, afwMath.ConvolutionControl.FFT,
+                          afwMath.ConvolutionControl.AUTO):
+            convControl.setAlgorithm(algorithm)
+            self.assertEqual(convControl.getAlgorithm(), algorithm)
+
+        self.assertFalse(convControl.getDoBasisConvolution())
+        for doBasisConvolution in (True, False):
+            convControl.setDoBasisConvolution(doBasisConvolution)
+            self.assertEqual(convControl.getDoBasisConvolution(), doBasisConvolution)
+
     @unittest.skipIf(dataDir is None, "afwdata not setup")
     def testUnityConvolution(self):
         """Verify that convolution with a centered delta function reproduces the original.
@@ -442,6 +463,43 @@ class ConvolveTestCase(lsst.utils.tests.TestCase):
             refKernel=analyticKernel,
             kernelDescr="Gaussian Separable Kernel (compared to AnalyticKernel equivalent)")
 
+    def testSeparableConvolveImageTypes(self):
+        """Test separable convolution of all supported floating-point image types
+
+        Separable convolution of these types is vectorized; use a range of
+        image widths to exercise the code that handles leftover pixels.
+        """
+        kWidth = 7
+        kHeight = 6
+        gaussFunc1 = afwMath.GaussianFunction1D(1.5)
+        gaussFunc2 = afwMath.GaussianFunction2D(1.5, 1.5, 0.0)
+        separableKernel = afwMath.SeparableKernel(kWidth, kHeight, gaussFunc1, gaussFunc1)
+        analyticKernel = afwMath.AnalyticKernel(kWidth, kHeight, gaussFunc2)
+        rng = numpy.random.RandomState(5)
+        for width in (kWidth, 15, 16, 17, 40):
+            dims = lsst.geom.Extent2I(width, 20)
+            for OutImageClass, InImageClass in ((afwImage.ImageD, afwImage.ImageD),
+                                                (afwImage.ImageD, afwImage.ImageF),
+                                                (afwImage.ImageF, afwImage.ImageF),
+                                                (afwImage.MaskedImageD, afwImage.MaskedImageD),
+                                                (afwImage.MaskedImageF, afwImage.MaskedImageF)):
+                inImage = InImageClass(dims)
+                if hasattr(inImage, "getImage"):
+                    inImage.getImage().getArray()[:] = rng.normal(size=(20, width))
+                    inImage.getVariance().getArray()[:] = rng.uniform(1.0, 2.0, size=(20, width))
+                    inImage.getMask().getArray()[:] = rng.randint(0, 4, size=(20, width))
+                else:
+                    inImage.getArray()[:] = rng.normal(size=(20, width))
+                cnvImage = OutImageClass(dims)
+                refImage = OutImageClass(dims)
+                afwMath.convolve(cnvImage, inImage, separableKernel)
+                afwMath.convolve(refImage, inImage, analyticKernel)
+                msg = "%s -> %s, width=%d" % (InImageClass.__name__, OutImageClass.__name__, width)
+                if hasattr(cnvImage, "getImage"):
+                    self.assertMaskedImagesAlmostEqual(cnvImage, refImage, rtol=1e-5, atol=1e-8, msg=msg)
+                else:
+                    self.assertImagesAlmostEqual(cnvImage, refImage, rtol=1e-5, atol=1e-8, msg=msg)
+
     @unittest.skipIf(dataDir is None, "afwdata not setup")
     def testSpatiallyInvariantConvolve(self):
         """Test convolution with a spatially invariant Gaussian function
@@ -620,6 +678,286 @@ class ConvolveTestCase(lsst.utils.tests.TestCase):
                 maxInterpDist=maxInterpDist,
                 rtol=rtol)
 
+    @unittest.skipIf(dataDir is None, "afwdata not setup")
+    def testBasisConvolve(self):
+        """Test convolution with spatially varying LinearCombinationKernels by combining basis convolutions
+        """
+        sFunc = afwMath.PolynomialFunction2D(1)
+        sParams = (
+            (1.0, -0.01/self.width, -0.01/self.height),
+            (0.0, 0.01/self.width, 0.0/self.height),
+            (0.0, 0.0/self.width, 0.01/self.height),
+            (0.5, 0.005/self.width, -0.005/self.height),
+        )
+        kernelList = []
+        for nBasisKernels in (3, 4):
+            # at 3 the kernel will not be refactored, at 4 it will be
+            gaussParamsList = ((1.5, 1.5, 0.0), (2.5, 1.5, 0.0), (2.5, 1.5, math.pi / 2.0),
+                               (2.5, 2.5, 0.0))[:nBasisKernels]
+            kernel = afwMath.LinearCombinationKernel(makeGaussianKernelList(5, 6, gaussParamsList), sFunc)
+            kernel.setSpatialParameters(sParams[:nBasisKernels])
+            kernelList.append(("Gaussian LinearCombinationKernel with %d basis kernels" % (nBasisKernels,),
+                               kernel))
+        kernel = afwMath.LinearCombinationKernel(makeDeltaFunctionKernelList(2, 2), sFunc)
+        kernel.setSpatialParameters(sParams)
+        kernelList.append(("delta function LinearCombinationKernel", kernel))
+
+        for kernelDescr, kernel in kernelList:
+            for doNormalize in (False, True):
+                convControl = afwMath.ConvolutionControl()
+                convControl.setDoNormalize(doNormalize)
+                convControl.setDoBasisConvolution(True)
+                self.runBasicTest(kernel, convControl, kernelDescr="%s using basis convolution" %
+                                  (kernelDescr,))
+
+                refMaskedImage = afwImage.MaskedImageF(self.cnvMaskedImage, True)
+                convControl.setNThreads(3)
+                afwMath.convolve(self.cnvMaskedImage, self.maskedImage, kernel, convControl)
+                self.assertMaskedImagesEqual(self.cnvMaskedImage, refMaskedImage, msg=kernelDescr)
+
+    def testBasisConvolveSynthetic(self):
+        """Test basis convolution of a synthetic image against the reference
+
+        Unlike testBasisConvolve this does not need afwdata.
+        """
+        width = 37
+        height = 31
+        rng = numpy.random.RandomState(4)
+        inMaskedImage = afwImage.MaskedImageF(lsst.geom.Extent2I(width, height))
+        inMaskedImage.getImage().getArray()[:] = rng.normal(100.0, 10.0, size=(height, width))
+        inMaskedImage.getVariance().getArray()[:] = rng.uniform(1.0, 2.0, size=(height, width))
+        inMaskedImage.getMask().getArray()[:] = rng.randint(0, 4, size=(height, width))
+        inMaskedImage.setXY0(300, 200)
+        inMaskedImage.getImage()[18, 15, afwImage.LOCAL] = numpy.nan
+
+        sFunc = afwMath.PolynomialFunction2D(1)
+        sParams = (
+            (1.0, -0.01/width, -0.01/height),
+            (0.0, 0.01/width, 0.0/height),
+            (0.0, 0.0/width, 0.01/height),
+            (0.5, 0.005/width, -0.005/height),
+        )
+        kernelList = []
+        for nBasisKernels in (3, 4):
+            gaussParamsList = ((1.5, 1.5, 0.0), (2.5, 1.5, 0.0), (2.5, 1.5, math.pi / 2.0),
+                               (2.5, 2.5, 0.0))[:nBasisKernels]
+            kernel = afwMath.LinearCombinationKernel(makeGaussianKernelList(5, 6, gaussParamsList), sFunc)
+            kernel.setSpatialParameters(sParams[:nBasisKernels])
+            kernelList.append(("Gaussian LinearCombinationKernel with %d basis kernels" % (nBasisKernels,),
+                               kernel))
+        kernel = afwMath.LinearCombinationKernel(makeDeltaFunctionKernelList(2, 2), sFunc)
+        kernel.setSpatialParameters(sParams)
+        kernelList.append(("delta function LinearCombinationKernel", kernel))
+
+        for kernelDescr, kernel in kernelList:
+            for doNormalize in (False, True):
+                msg = "%s, doNormalize=%s" % (kernelDescr, doNormalize)
+                refMaskedImage = afwImage.makeMaskedImageFromArrays(
+                    *refConvolve(inMaskedImage.getArrays(), inMaskedImage.getXY0(), kernel, doNormalize,
+                                 False))
+                convControl = afwMath.ConvolutionControl()
+                convControl.setDoNormalize(doNormalize)
+                convControl.setDoBasisConvolution(True)
+                cnvMaskedImage = afwImage.MaskedImageF(inMaskedImage.getDimensions())
+                afwMath.convolve(cnvMaskedImage, inMaskedImage, kernel, convControl)
+                self.assertMaskedImagesAlmostEqual(cnvMaskedImage, refMaskedImage, rtol=1e-5, atol=1e-8,
+                                                   msg=msg)
+
+                convControl.setNThreads(3)
+                threadedMaskedImage = afwImage.MaskedImageF(inMaskedImage.getDimensions())
+                afwMath.convolve(threadedMaskedImage, inMaskedImage, kernel, convControl)
+                self.assertMaskedImagesEqual(threadedMaskedImage, cnvMaskedImage, msg=msg)
+
+    @unittest.skipIf(dataDir is None, "afwdata not setup")
+    def testMultiThreadedConvolve(self):
+        """Test that convolving with several threads exactly matches convolving with one
+        """
+        kWidth = 5
+        kHeight = 6
+        sFunc = afwMath.PolynomialFunction2D(1)
+        sParams = (
+            (1.0, -0.01/self.width, -0.01/self.height),
+            (0.0, 0.01/self.width, 0.0/self.height),
+            (0.0, 0.0/self.width, 0.01/self.height),
+        )
+        basisKernelList = makeGaussianKernelList(
+            kWidth, kHeight, ((1.5, 1.5, 0.0), (2.5, 1.5, 0.0), (2.5, 1.5, math.pi / 2.0)))
+        lcKernel = afwMath.LinearCombinationKernel(basisKernelList, sFunc)
+        lcKernel.setSpatialParameters(sParams)
+
+        gaussFunc1 = afwMath.GaussianFunction1D(1.0)
+        kernelList = [
+            ("FixedKernel", afwMath.FixedKernel(afwImage.ImageD(basisKernelList[1].getDimensions(), 1.0))),
+            ("AnalyticKernel", afwMath.AnalyticKernel(
+                kWidth, kHeight, afwMath.GaussianFunction2D(2.5, 1.5, 0.5))),
+            ("SeparableKernel", afwMath.SeparableKernel(kWidth, kHeight, gaussFunc1, gaussFunc1)),
+            ("DeltaFunctionKernel", afwMath.DeltaFunctionKernel(kWidth, kHeight, lsst.geom.Point2I(1, 2))),
+            ("spatially varying LinearCombinationKernel", lcKernel),
+        ]
+        for kernelDescr, kernel in kernelList:
+            for maxInterpDist in (0, 10):
+                convControl = afwMath.ConvolutionControl()
+                convControl.setMaxInterpolationDistance(maxInterpDist)
+                refMaskedImage = afwImage.MaskedImageF(self.cnvMaskedImage, True)
+                afwMath.convolve(refMaskedImage, self.maskedImage, kernel, convControl)
+                for nThreads, tileSize in ((2, 16), (3, 7), (0, 256)):
+                    convControl.setNThreads(nThreads)
+                    convControl.setTileSize(tileSize)
+                    afwMath.convolve(self.cnvMaskedImage, self.maskedImage, kernel, convControl)
+                    self.assertMaskedImagesEqual(
+                        self.cnvMaskedImage, refMaskedImage,
+                        msg="%s, maxInterpDist=%d, nThreads=%d, tileSize=%d" %
+                        (kernelDescr, maxInterpDist, nThreads, tileSize))
+
+    def testMultiThreadedConvolveSynthetic(self):
+        """Test that convolving a synthetic image with several threads exactly matches convolving with one
+
+        Unlike testMultiThreadedConvolve this does not need afwdata. The tile sizes include
+        one smaller than the kernel height and one that is not a multiple of it.
+        """
+        kWidth = 5
+        kHeight = 6
+        width = 61
+        height = 47
+        rng = numpy.random.RandomState(12)
+        inMaskedImage = afwImage.MaskedImageF(lsst.geom.Extent2I(width, height))
+        inMaskedImage.getImage().getArray()[:] = rng.normal(size=(height, width))
+        inMaskedImage.getVariance().getArray()[:] = rng.uniform(1.0, 2.0, size=(height, width))
+        inMaskedImage.getMask().getArray()[:] = rng.randint(0, 4, size=(height, width))
+        inMaskedImage.setXY0(300, 200)
+
+        sFunc = afwMath.PolynomialFunction2D(1)
+        sParams = (
+            (1.0, -0.01/width, -0.01/height),
+            (0.0, 0.01/width, 0.0/height),
+            (0.0, 0.0/width, 0.01/height),
+        )
+        basisKernelList = makeGaussianKernelList(
+            kWidth, kHeight, ((1.5, 1.5, 0.0), (2.5, 1.5, 0.0), (2.5, 1.5, math.pi / 2.0)))
+        lcKernel = afwMath.LinearCombinationKernel(basisKernelList, sFunc)
+        lcKernel.setSpatialParameters(sParams)
+
+        gaussFunc1 = afwMath.GaussianFunction1D(1.0)
+        kernelList = [
+            ("FixedKernel", afwMath.FixedKernel(afwImage.ImageD(basisKernelList[1].getDimensions(), 1.0))),
+            ("SeparableKernel", afwMath.SeparableKernel(kWidth, kHeight, gaussFunc1, gaussFunc1)),
+            ("spatially varying LinearCombinationKernel", lcKernel),
+        ]
+        for kernelDescr, kernel in kernelList:
+            for maxInterpDist in (0, 10):
+                convControl = afwMath.ConvolutionControl()
+                convControl.setMaxInterpolationDistance(maxInterpDist)
+                refMaskedImage = afwImage.MaskedImageF(inMaskedImage.getDimensions())
+                afwMath.convolve(refMaskedImage, inMaskedImage, kernel, convControl)
+                for nThreads, tileSize in ((2, 4), (3, 13), (4, 16), (0, 256)):
+                    convControl.setNThreads(nThreads)
+                    convControl.setTileSize(tileSize)
+                    cnvMaskedImage = afwImage.MaskedImageF(inMaskedImage.getDimensions())
+                    afwMath.convolve(cnvMaskedImage, inMaskedImage, kernel, convControl)
+                    self.assertMaskedImagesEqual(
+                        cnvMaskedImage, refMaskedImage,
+                        msg="%s, maxInterpDist=%d, nThreads=%d, tileSize=%d" %
+                        (kernelDescr, maxInterpDist, nThreads, tileSize))
+
+    @unittest.skipIf(dataDir is None, "afwdata not setup")
+    def testFftConvolve(self):
+        """Test convolution using FFTs against the reference and against direct convolution
+        """
+        kWidth = 21
+        kHeight = 25
+        analyticKernel = afwMath.AnalyticKernel(kWidth, kHeight, afwMath.GaussianFunction2D(4.5, 3.0, 0.5))
+        kernelImage = afwImage.ImageD(analyticKernel.getDimensions())
+        analyticKernel.computeImage(kernelImage, False)
+        kernelImage[2, 3, afwImage.LOCAL] = 0.0
+        basisKernelList = makeGaussianKernelList(kWidth, kHeight, ((1.5, 1.5, 0.0), (4.5, 2.5, 0.5)))
+        kernelList = [
+            ("AnalyticKernel", analyticKernel),
+            ("FixedKernel", afwMath.FixedKernel(kernelImage)),
+            ("spatially invariant LinearCombinationKernel",
+             afwMath.LinearCombinationKernel(basisKernelList, [0.7, 0.3])),
+        ]
+
+        # add some non-finite pixels, which must not spread beyond the kernel footprint
+        badMaskedImage = afwImage.MaskedImageF(self.maskedImage, True)
+        badMaskedImage.getImage()[30, 40, afwImage.LOCAL] = numpy.nan
+        badMaskedImage.getImage()[3, 70, afwImage.LOCAL] = numpy.inf
+        badMaskedImage.getVariance()[60, 10, afwImage.LOCAL] = numpy.nan
+
+        for kernelDescr, kernel in kernelList:
+            for doNormalize in (False, True):
+                convControl = afwMath.ConvolutionControl()
+                convControl.setDoNormalize(doNormalize)
+                convControl.setAlgorithm(afwMath.ConvolutionControl.FFT)
+                self.runBasicTest(kernel, convControl, kernelDescr="%s using FFTs" % (kernelDescr,))
+
+                for inMaskedImage in (self.maskedImage, badMaskedImage):
+                    convControl.setAlgorithm(afwMath.ConvolutionControl.DIRECT)
+                    refMaskedImage = afwImage.MaskedImageF(self.cnvMaskedImage, True)
+                    afwMath.convolve(refMaskedImage, inMaskedImage, kernel, convControl)
+                    refImage = afwImage.ImageD(refMaskedImage.getDimensions())
+                    afwMath.convolve(refImage, inMaskedImage.getImage(), kernel, convControl)
+
+                    convControl.setAlgorithm(afwMath.ConvolutionControl.FFT)
+                    afwMath.convolve(self.cnvMaskedImage, inMaskedImage, kernel, convControl)
+                    self.assertMaskedImagesAlmostEqual(self.cnvMaskedImage, refMaskedImage,
+                                                       rtol=1e-5, atol=1e-8, msg=kernelDescr)
+                    self.assertImagesEqual(self.cnvMaskedImage.getMask(), refMaskedImage.getMask())
+                    cnvImage = afwImage.ImageD(refMaskedImage.getDimensions())
+                    afwMath.convolve(cnvImage, inMaskedImage.getImage(), kernel, convControl)
+                    self.assertImagesAlmostEqual(cnvImage, refImage, rtol=1e-9, atol=1e-9, msg=kernelDescr)
+
+                    # the result does not depend on the number of threads
+                    convControl.setNThreads(3)
+                    cnvMaskedImage = afwImage.MaskedImageF(self.cnvMaskedImage, True)
+                    afwMath.convolve(cnvMaskedImage, inMaskedImage, kernel, convControl)
+                    self.assertMaskedImagesEqual(cnvMaskedImage, self.cnvMaskedImage, msg=kernelDescr)
+                    convControl.setNThreads(1)
+
+    def testFftConvolveSynthetic(self):
+        """Test convolution of a synthetic image with a large kernel using FFTs against direct convolution
+
+        Unlike testFftConvolve this does not need afwdata, and the kernel is large enough that
+        the default algorithm may use FFTs.
+        """
+        kWidth = 41
+        kHeight = 41
+        width = 97
+        height = 83
+        rng = numpy.random.RandomState(41)
+        inMaskedImage = afwImage.MaskedImageF(lsst.geom.Extent2I(width, height))
+        inMaskedImage.getImage().getArray()[:] = rng.normal(100.0, 10.0, size=(height, width))
+        inMaskedImage.getVariance().getArray()[:] = rng.uniform(1.0, 2.0, size=(height, width))
+        inMaskedImage.getMask().getArray()[:] = rng.randint(0, 4, size=(height, width))
+        inMaskedImage.setXY0(300, 200)
+        # non-finite pixels, which must not spread beyond the kernel footprint
+        inMaskedImage.getImage()[45, 40, afwImage.LOCAL] = numpy.nan
+        inMaskedImage.getImage()[70, 25, afwImage.LOCAL] = numpy.inf
+        inMaskedImage.getVariance()[30, 60, afwImage.LOCAL] = numpy.nan
+
+        analyticKernel = afwMath.AnalyticKernel(kWidth, kHeight, afwMath.GaussianFunction2D(6.0, 4.0, 0.3))
+        kernelImage = afwImage.ImageD(analyticKernel.getDimensions())
+        analyticKernel.computeImage(kernelImage, False)
+        kernelImage[2, 3, afwImage.LOCAL] = 0.0
+        kernelList = [
+            ("AnalyticKernel", analyticKernel),
+            ("FixedKernel", afwMath.FixedKernel(kernelImage)),
+        ]
+        for kernelDescr, kernel in kernelList:
+            for doNormalize in (False, True):
+                convControl = afwMath.ConvolutionControl()
+                convControl.setDoNormalize(doNormalize)
+                convControl.setAlgorithm(afwMath.ConvolutionControl.DIRECT)
+                refMaskedImage = afwImage.MaskedImageF(inMaskedImage.getDimensions())
+                afwMath.convolve(refMaskedImage, inMaskedImage, kernel, convControl)
+                for algorithm in (afwMath.ConvolutionControl.FFT, afwMath.ConvolutionControl.AUTO):
+                    msg = "%s, doNormalize=%s, algorithm=%s" % (kernelDescr, doNormalize, algorithm)
+                    convControl.setAlgorithm(algorithm)
+                    cnvMaskedImage = afwImage.MaskedImageF(inMaskedImage.getDimensions())
+                    afwMath.convolve(cnvMaskedImage, inMaskedImage, kernel, convControl)
+                    self.assertMaskedImagesAlmostEqual(cnvMaskedImage, refMaskedImage,
+                                                       rtol=1e-5, atol=1e-8, msg=msg)
+                    self.assertImagesEqual(cnvMaskedImage.getMask(), refMaskedImage.getMask(), msg=msg)
+
     @unittest.skipIf(dataDir is None, "afwdata not setup")
     def testZeroWidthKernel(self):
         """Convolution by a 0x0 kernel should raise an exception.
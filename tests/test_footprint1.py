@@ -37,6 +37,7 @@ import numpy as np
 
 import lsst.utils.tests
 import lsst.geom
+import lsst.pex.exceptions
 import lsst.afw.geom as afwGeom
 import lsst.afw.geom.ellipses as afwGeomEllipses
 import lsst.afw.image as afwImage
@@ -1204,6 +1205,43 @@ class FootprintSetTestCase(unittest.TestCase):
 
         self.assertEqual(len(foot.getPeaks()), 5)
 
+    def testParallelDetection(self):
+        """Test that splitting detection between threads doesn't change the FootprintSet"""
+        mi = afwImage.MaskedImageF(lsst.geom.Box2I(lsst.geom.Point2I(10, 20), lsst.geom.Extent2I(150, 600)))
+        rand = np.random.RandomState(12345)
+        im = mi.getImage().getArray()
+        im[:] = rand.normal(0.0, 1.0, im.shape)
+        im[rand.uniform(size=im.shape) < 0.01] = np.nan
+        # long objects that cross the seams between strips, some of which join up below the seams
+        im[:, 30:33] += 10.0
+        im[100:500, 80] += 10.0
+        im[240:250, 81:120] += 10.0
+        im[::7, 120:140] += np.linspace(5.0, 20.0, 20)
+        mi.getVariance().set(1.0)
+
+        thresholds = [afwDetect.Threshold(2.0), afwDetect.Threshold(2.0, afwDetect.Threshold.VALUE, False),
+                      afwDetect.Threshold(2.5, afwDetect.Threshold.PIXEL_STDEV, True, 2.0)]
+        for threshold in thresholds:
+            expected = afwDetect.FootprintSet(mi, threshold, "", 2).getFootprints()
+            self.assertGreater(len(expected), 10)
+            for nThreads in (2, 3, 0):
+                fs = afwDetect.FootprintSet(mi, threshold, "", 2, True, nThreads)
+                footprints = fs.getFootprints()
+                self.assertEqual(len(footprints), len(expected))
+                for foot, expectedFoot in zip(footprints, expected):
+                    self.assertEqual(foot.getSpans(), expectedFoot.getSpans())
+                    self.assertEqual([(p.getIx(), p.getIy(), p.getPeakValue()) for p in foot.getPeaks()],
+                                     [(p.getIx(), p.getIy(), p.getPeakValue())
+                                      for p in expectedFoot.getPeaks()])
+
+        expected = afwDetect.FootprintSet(mi.getImage(), afwDetect.Threshold(2.0)).getFootprints()
+        footprints = afwDetect.FootprintSet(mi.getImage(), afwDetect.Threshold(2.0),
+                                            nThreads=4).getFootprints()
+        self.assertEqual([foot.getSpans() for foot in footprints], [foot.getSpans() for foot in expected])
+
+        with self.assertRaises(lsst.pex.exceptions.InvalidParameterError):
+            afwDetect.FootprintSet(mi, afwDetect.Threshold(2.0), "", 1, True, -1)
+
 
 class MaskFootprintSetTestCase(unittest.TestCase):
     """A test case for generating FootprintSet from Masks"""
@@ -1298,6 +1336,100 @@ class NaNFootprintSetTestCase(unittest.TestCase):
             self.assertEqual(objects[i], self.objects[i])
 
 
+class RunFootprintSetTestCase(unittest.TestCase):
+    """A test case for the runs of pixels that FootprintSet labels, with each threshold type"""
+
+    def getSpans(self, fs):
+        """Return the spans of each Footprint in fs as (y, x0, x1)"""
+        return [[(span.getY(), span.getMinX(), span.getMaxX()) for span in foot.getSpans()]
+                for foot in fs.getFootprints()]
+
+    def testPixelStdevBadVariance(self):
+        """Check that pixels with NaN or negative variance are never detected with PIXEL_STDEV"""
+        mi = afwImage.MaskedImageF(lsst.geom.Extent2I(12, 6))
+        im = mi.getImage().getArray()
+        var = mi.getVariance().getArray()
+        im[:] = 0.0
+        var[:] = 1.0
+        im[1, 2:6] = 10.0
+        var[1, 3] = np.nan
+        var[1, 4] = -1.0
+        im[1, 9] = 10.0
+        var[1, 9] = 4.0                 # exactly at threshold
+        im[4, 7:10] = -10.0
+        var[4, 8] = np.nan
+
+        fs = afwDetect.FootprintSet(mi, afwDetect.Threshold(5.0, afwDetect.Threshold.PIXEL_STDEV))
+        self.assertEqual(self.getSpans(fs), [[(1, 2, 2)], [(1, 5, 5)], [(1, 9, 9)]])
+        fs = afwDetect.FootprintSet(mi, afwDetect.Threshold(5.0, afwDetect.Threshold.PIXEL_STDEV, False))
+        self.assertEqual(self.getSpans(fs), [[(4, 7, 7)], [(4, 9, 9)]])
+
+    def testNegativePolarityInteger(self):
+        """Check negative polarity detection on integer images and with a Mask VALUE threshold"""
+        img = afwImage.ImageI(lsst.geom.Extent2I(10, 5))
+        arr = img.getArray()
+        arr[:] = 0
+        arr[1, 2:5] = -10
+        arr[2, 6] = -5                  # exactly at threshold
+        arr[3, 1] = -4
+        arr[3, 8] = 10
+        fs = afwDetect.FootprintSet(img, afwDetect.Threshold(5, afwDetect.Threshold.VALUE, False))
+        self.assertEqual(self.getSpans(fs), [[(1, 2, 4)], [(2, 6, 6)]])
+
+        img = afwImage.ImageU(lsst.geom.Extent2I(10, 5))
+        arr = img.getArray()
+        arr[:] = 100
+        arr[1, 2:5] = 3
+        arr[2, 6] = 0
+        arr[3, 1] = 4
+        fs = afwDetect.FootprintSet(img, afwDetect.Threshold(-3, afwDetect.Threshold.VALUE, False))
+        self.assertEqual(self.getSpans(fs), [[(1, 2, 4)], [(2, 6, 6)]])
+
+        msk = afwImage.Mask(lsst.geom.Extent2I(8, 5))
+        arr = msk.getArray()
+        arr[:] = 0x4
+        arr[1, 1:3] = 0x1
+        arr[2, 3] = 0x2
+        arr[3, 5] = 0x0
+        fs = afwDetect.FootprintSet(msk, afwDetect.Threshold(-3, afwDetect.Threshold.VALUE, False))
+        self.assertEqual(self.getSpans(fs), [[(1, 1, 2), (2, 3, 3)], [(3, 5, 5)]])
+
+    def testDiagonalRuns(self):
+        """Check that runs that touch only diagonally are joined, and that runs one pixel apart aren't"""
+        img = afwImage.ImageF(lsst.geom.Extent2I(10, 7))
+        arr = img.getArray()
+        arr[:] = 0.0
+        for y, x0, x1 in [(1, 1, 2), (2, 3, 4),                 # down and to the right
+                          (1, 8, 8), (2, 6, 7),                 # down and to the left
+                          (4, 1, 2), (5, 4, 5),                 # one pixel apart
+                          (4, 7, 7), (4, 9, 9), (5, 8, 8)]:     # two runs joined by the row below
+            arr[y, x0:x1 + 1] = 10.0
+        fs = afwDetect.FootprintSet(img, afwDetect.Threshold(5.0))
+        self.assertEqual(self.getSpans(fs), [[(1, 1, 2), (2, 3, 4)],
+                                             [(1, 8, 8), (2, 6, 7)],
+                                             [(4, 1, 2)],
+                                             [(4, 7, 7), (4, 9, 9), (5, 8, 8)],
+                                             [(5, 4, 5)]])
+
+    def testIncludeMultiplier(self):
+        """Check that only Footprints with a run that reaches the inclusion threshold are kept,
+        when there are several runs in a row"""
+        img = afwImage.ImageF(lsst.geom.Extent2I(12, 7))
+        arr = img.getArray()
+        arr[:] = 0.0
+        arr[2, 1:4] = [6.0, 12.0, 6.0]
+        arr[2, 5:7] = 6.0
+        arr[2, 8:10] = [9.9, 6.0]
+        arr[4, 1:3] = 6.0               # joined to a run that reaches the inclusion threshold
+        arr[5, 2:4] = [6.0, 11.0]
+        arr[5, 6:8] = [6.0, 10.0]       # exactly at the inclusion threshold
+        threshold = afwDetect.Threshold(5.0, afwDetect.Threshold.VALUE, True, 2.0)
+        fs = afwDetect.FootprintSet(img, threshold)
+        self.assertEqual(self.getSpans(fs), [[(2, 1, 3)], [(4, 1, 2), (5, 2, 3)], [(5, 6, 7)]])
+        fs = afwDetect.FootprintSet(img, afwDetect.Threshold(5.0))
+        self.assertEqual(len(fs.getFootprints()), 5)
+
+
 class MemoryTester(lsst.utils.tests.MemoryTestCase):
     pass
 
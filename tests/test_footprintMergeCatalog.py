@@ -28,6 +28,7 @@ import lsst.pex.exceptions
 import lsst.geom
 import lsst.afw.image as afwImage
 import lsst.afw.detection as afwDetect
+import lsst.afw.geom as afwGeom
 import lsst.afw.table as afwTable
 
 
@@ -338,6 +339,40 @@ class FootprintMergeCatalogTestCase(lsst.utils.tests.TestCase):
             for peak in record.getFootprint().getPeaks():
                 self.assertTrue(isPeakInCatalog(peak, merge))
 
+    def testMergeAcrossGridCells(self):
+        """Test merging Footprints that are far apart, or at negative coordinates, or only touch
+
+        FootprintMergeList only tests the FootprintMerges near each Footprint; make sure that
+        doesn't miss any.
+        """
+        schema = afwTable.SourceTable.makeMinimalSchema()
+        idFactory = afwTable.IdFactory.makeSimple()
+        table = afwTable.SourceTable.make(schema, idFactory)
+
+        def makeCatalog(boxes):
+            catalog = afwTable.SourceCatalog(table)
+            for x0, y0, x1, y1 in boxes:
+                box = lsst.geom.Box2I(lsst.geom.Point2I(x0, y0), lsst.geom.Point2I(x1, y1))
+                footprint = afwDetect.Footprint(afwGeom.SpanSet(box))
+                footprint.addPeak((x0 + x1)//2, (y0 + y1)//2, 1.0)
+                catalog.addNew().setFootprint(footprint)
+            return catalog
+
+        # a row of small, separate boxes, across many grid cells and both sides of zero
+        row = [(x, -3, x + 4, 1) for x in range(-600, 600, 40)]
+        # a box on its own, ending at the edge of a grid cell
+        single = [(200, 500, 255, 520)]
+        cat1 = makeCatalog(row + single)
+        # a long box that joins up the row, and one that overlaps the single box by a column
+        cat2 = makeCatalog([(-600, -1, 564, -1), (255, 505, 300, 506)])
+        # boxes that overlap nothing
+        cat3 = makeCatalog([(-5000, -5000, -4990, -4990), (5000, 5000, 5010, 5010)])
+
+        merge, nob, npeak = mergeCatalogs([cat1, cat2, cat3], ["1", "2", "3"], -1, idFactory)
+        self.assertEqual(nob, 4)
+        areas = sorted(record.getFootprint().getArea() for record in merge)
+        self.assertEqual(areas, sorted([121, 121, 56*21 + 45*2, 20*len(row) + 1165]))
+
 
 class MemoryTester(lsst.utils.tests.MemoryTestCase):
     pass
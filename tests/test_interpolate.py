@@ -126,6 +126,25 @@ class InterpolateTestCase(lsst.utils.tests.TestCase):
         for x in np.arange(xvec_c[i], xvec_c[i + 1], 10):
             self.assertEqual(interp.interpolate(x), yvec_c[i])
 
+    def testInterpolateRange(self):
+        """Test that interpolating to a range of points matches interpolating to each in turn"""
+        np.random.seed(3)
+        xvec = np.array([2.5, 10.0, 17.5, 25.0, 32.5, 40.0, 47.5])
+        yvec = np.random.normal(100.0, 10.0, len(xvec))
+        for style in (afwMath.Interpolate.CONSTANT, afwMath.Interpolate.LINEAR,
+                      afwMath.Interpolate.NATURAL_SPLINE, afwMath.Interpolate.CUBIC_SPLINE,
+                      afwMath.Interpolate.AKIMA_SPLINE):
+            interp = afwMath.makeInterpolate(xvec, yvec, style)
+            for x0, n in ((0, 50), (-7, 70), (11, 5), (47, 1), (60, 3)):
+                # extrapolating off both ends, and starting and ending at and between the knots
+                expected = [interp.interpolate(float(x0 + i)) for i in range(n)]
+                if style in (afwMath.Interpolate.CONSTANT, afwMath.Interpolate.LINEAR):
+                    self.assertFloatsEqual(interp.interpolateRange(x0, n), np.array(expected))
+                else:
+                    self.assertFloatsAlmostEqual(interp.interpolateRange(x0, n), np.array(expected),
+                                                 rtol=1e-13)
+            self.assertEqual(len(interp.interpolateRange(0, 0)), 0)
+
     def testInvalidInputs(self):
         """Test that invalid inputs cause an abort"""
 
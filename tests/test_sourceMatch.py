@@ -380,6 +380,168 @@ class SourceMatchTestCase(lsst.utils.tests.TestCase):
         self.assertLess(diff.std(), tol)  # I get 4e-12
         self.assertFloatsAlmostEqual(dist1, dist2, atol=tol)
 
+    def testThreads(self):
+        """Test that matching near the pole gives the same results with any number of threads,
+        and that they agree with a brute-force match
+        """
+        rng = np.random.RandomState(54321)
+        coordKey = afwTable.SourceTable.getCoordKey()
+        unitVectors = []
+        for ss, num in ((self.ss1, 5000), (self.ss2, 2000)):
+            ra = rng.uniform(0.0, 2*np.pi, num)
+            dec = np.arcsin(rng.uniform(np.sin(np.radians(85.0)), 1.0, num))
+            for ii in range(num):
+                src = ss.addNew()
+                src.setId(ii)
+                src.set(coordKey.getRa(), ra[ii]*lsst.geom.radians)
+                src.set(coordKey.getDec(), dec[ii]*lsst.geom.radians)
+            unitVectors.append(np.array([np.cos(ra)*np.cos(dec), np.sin(ra)*np.cos(dec), np.sin(dec)]).T)
+        radius = 0.1*lsst.geom.degrees
+
+        def summarize(matches):
+            return [(mm.first.getId(), mm.second.getId(), mm.distance) for mm in matches]
+
+        for closest in (True, False):
+            mc = afwTable.MatchControl()
+            mc.findOnlyClosest = closest
+            expected = summarize(afwTable.matchRaDec(self.ss1, self.ss2, radius, mc))
+            for nThreads in (0, 3):
+                mc.nThreads = nThreads
+                self.assertEqual(summarize(afwTable.matchRaDec(self.ss1, self.ss2, radius, mc)), expected)
+
+            d2 = ((unitVectors[0][:, np.newaxis, :] - unitVectors[1][np.newaxis, :, :])**2).sum(axis=2)
+            d2Limit = 2.0*(1.0 - np.cos(radius.asRadians()))
+            if closest:
+                first = np.where(d2.min(axis=1) < d2Limit)[0]
+                self.assertEqual([mm[:2] for mm in expected], list(zip(first, d2[first].argmin(axis=1))))
+            else:
+                self.assertEqual([mm[:2] for mm in expected], list(zip(*np.where(d2 < d2Limit))))
+
+        mc = afwTable.MatchControl()
+        expected = summarize(afwTable.matchRaDec(self.ss1, radius, mc))
+        self.assertGreater(len(expected), 0)
+        mc.nThreads = 4
+        self.assertEqual(summarize(afwTable.matchRaDec(self.ss1, radius, mc)), expected)
+        mc.nThreads = -1
+        with self.assertRaises(pexExcept.InvalidParameterError):
+            afwTable.matchRaDec(self.ss1, radius, mc)
+
+    def testMatchXy(self):
+        """Test matchXy against a brute-force match, including records with non-finite centroids"""
+        schema = afwTable.SourceTable.makeMinimalSchema()
+        afwTable.Point2DKey.addFields(schema, "centroid", "centroid", "pixel")
+        table = afwTable.SourceTable.make(schema)
+        table.defineCentroid("centroid")
+        rng = np.random.RandomState(31415)
+        catalogs = []
+        positions = []
+        for num in (3000, 2000):
+            cat = afwTable.SourceCatalog(table)
+            xy = rng.uniform(0.0, 500.0, (num, 2))
+            xy[7] = (np.nan, 3.0)
+            xy[9] = (np.inf, 3.0)
+            for ii in range(num):
+                src = cat.addNew()
+                src.setId(ii)
+                src.set(table.getCentroidKey(), lsst.geom.Point2D(*xy[ii]))
+            catalogs.append(cat)
+            positions.append(xy)
+        radius = 3.0
+
+        with np.errstate(invalid="ignore"):
+            d2 = ((positions[0][:, np.newaxis, :] - positions[1][np.newaxis, :, :])**2).sum(axis=2)
+            within = d2 < radius**2
+        for closest in (True, False):
+            mc = afwTable.MatchControl()
+            mc.findOnlyClosest = closest
+            mc.includeMismatches = True
+            matches = afwTable.matchXy(catalogs[0], catalogs[1], radius, mc)
+            mismatches = [mm.first.getId() for mm in matches if mm.second is None]
+            self.assertEqual(mismatches, [ii for ii in range(len(catalogs[0]))
+                                          if ii != 7 and not within[ii].any()])
+            found = [(mm.first.getId(), mm.second.getId()) for mm in matches if mm.second is not None]
+            if closest:
+                first = np.where(within.any(axis=1))[0]
+                self.assertEqual(found, list(zip(first, np.where(within, d2, np.inf)[first].argmin(axis=1))))
+            else:
+                self.assertEqual(found, list(zip(*np.where(within))))
+            for mm in matches:
+                if mm.second is not None:
+                    self.assertAlmostEqual(mm.distance, np.sqrt(d2[mm.first.getId(), mm.second.getId()]))
+
+        matches = afwTable.matchXy(catalogs[0], radius, afwTable.MatchControl())
+        with np.errstate(invalid="ignore"):
+            d2 = ((positions[0][:, np.newaxis, :] - positions[0][np.newaxis, :, :])**2).sum(axis=2)
+            within = d2 < radius**2
+        np.fill_diagonal(within, False)
+        self.assertEqual(sorted((mm.first.getId(), mm.second.getId()) for mm in matches),
+                         list(zip(*np.where(within))))
+
+    def testMatchIndex(self):
+        """Test that a MatchIndex matches like matchRaDec, finds neighbours of single positions,
+        and survives persistence
+        """
+        rng = np.random.RandomState(2718)
+        coordKey = afwTable.SourceTable.getCoordKey()
+        for ss, num in ((self.ss1, 1000), (self.ss2, 800)):
+            ra = rng.uniform(10.0, 11.0, num)
+            dec = rng.uniform(-1.0, 1.0, num)
+            for ii in range(num):
+                src = ss.addNew()
+                src.setId(ii + 100)
+                src.set(coordKey.getRa(), ra[ii]*lsst.geom.degrees)
+                src.set(coordKey.getDec(), dec[ii]*lsst.geom.degrees)
+        self.ss2[5].set(coordKey.getRa(), np.nan*lsst.geom.degrees)
+        radius = 1.0*lsst.geom.arcminutes
+
+        def summarize(matches):
+            return [(mm.first.getId(), mm.second.getId() if mm.second is not None else None, mm.distance)
+                    for mm in matches]
+
+        index = afwTable.MatchIndex(self.ss2)
+        self.assertEqual(index.getCatalogSize(), len(self.ss2))
+        self.assertEqual(len(index), len(self.ss2) - 1)
+        for closest in (True, False):
+            mc = afwTable.MatchControl()
+            mc.findOnlyClosest = closest
+            mc.includeMismatches = True
+            self.assertEqual(summarize(index.match(self.ss1, self.ss2, radius, mc)),
+                             summarize(afwTable.matchRaDec(self.ss1, self.ss2, radius, mc)))
+        selfIndex = afwTable.MatchIndex(self.ss1)
+        self.assertEqual(summarize(selfIndex.match(self.ss1, radius)),
+                         summarize(afwTable.matchRaDec(self.ss1, radius)))
+
+        point = lsst.geom.SpherePoint(10.5, 0.0, lsst.geom.degrees)
+        distances = np.array([np.inf if ii == 5 else point.separation(src.getCoord()).asRadians()
+                              for ii, src in enumerate(self.ss2)])
+        nearest = index.findNearest(point, 10)
+        self.assertEqual([ii for ii, _ in nearest], list(np.argsort(distances)[:10]))
+        for ii, distance in nearest:
+            self.assertAlmostEqual(distance.asRadians(), distances[ii], places=12)
+        within = index.findWithin(point, 3.0*radius)
+        expected = np.where(distances < 3.0*radius.asRadians())[0]
+        self.assertGreater(len(expected), 0)
+        self.assertEqual(sorted(ii for ii, _ in within), list(expected))
+        self.assertEqual([ii for ii, _ in within], [ii for ii, _ in nearest[:len(within)]])
+        self.assertEqual(len(index.findNearest(point, 10000)), len(index))
+
+        with lsst.utils.tests.getTempFilePath(".fits") as filename:
+            index.writeFits(filename)
+            readIndex = afwTable.MatchIndex.readFits(filename)
+        self.assertEqual(readIndex.getCatalogSize(), index.getCatalogSize())
+        self.assertEqual(len(readIndex), len(index))
+        self.assertEqual(readIndex.findNearest(point, 10), nearest)
+        self.assertEqual(summarize(readIndex.match(self.ss1, self.ss2, radius)),
+                         summarize(index.match(self.ss1, self.ss2, radius)))
+
+        with self.assertRaises(pexExcept.InvalidParameterError):
+            index.match(self.ss1, self.ss1, radius)
+        self.ss2[3].setId(1)
+        with self.assertRaises(pexExcept.InvalidParameterError):
+            index.match(self.ss1, self.ss2, radius)
+        with self.assertRaises(pexExcept.RangeError):
+            index.findWithin(point, 50.0*lsst.geom.degrees)
+
 
 class TestMemory(lsst.utils.tests.MemoryTestCase):
     pass
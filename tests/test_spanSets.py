@@ -97,6 +97,35 @@ class SpanSetTestCase(lsst.utils.tests.TestCase):
         for a, b in zip(spanSetTwo, spanSetSplit[1]):
             self.assertEqual(a, b)
 
+    def testSplitUShapes(self):
+        # The arms of each U are only joined at its bottom, which is reached after both arms
+        for y0 in (-20, 0, 20):
+            spanList = [afwGeom.Span(y0 + y, 0, 0) for y in range(5)]
+            spanList += [afwGeom.Span(y0 + y, 6, 6) for y in range(5)]
+            spanList += [afwGeom.Span(y0 + 5, 0, 6)]
+            spanSet = afwGeom.SpanSet(spanList)
+            self.assertTrue(spanSet.isContiguous())
+            self.assertEqual(len(spanSet.split()), 1)
+
+            # Hang a hook from the bottom of the U, and add a separate Span level with the hook's top
+            spanList += [afwGeom.Span(y0 + 6, 6, 12)]
+            spanList += [afwGeom.Span(y0 + y, 12, 12) for y in range(7, 10)]
+            spanList += [afwGeom.Span(y0 + 6, 20, 30)]
+            spanSet = afwGeom.SpanSet(spanList)
+            self.assertFalse(spanSet.isContiguous())
+            spanSetSplit = spanSet.split()
+            self.assertEqual(len(spanSetSplit), 2)
+            self.assertEqual(spanSetSplit[0].getArea(), spanSet.getArea() - 11)
+            self.assertEqual(spanSetSplit[1], afwGeom.SpanSet([afwGeom.Span(y0 + 6, 20, 30)]))
+
+        # Regions separated by an empty row
+        spanSet = afwGeom.SpanSet([afwGeom.Span(0, 0, 10), afwGeom.Span(2, 0, 10)])
+        self.assertFalse(spanSet.isContiguous())
+        self.assertEqual(len(spanSet.split()), 2)
+
+        self.assertTrue(afwGeom.SpanSet().isContiguous())
+        self.assertEqual(len(afwGeom.SpanSet().split()), 1)
+
     def testTransform(self):
         transform = lsst.geom.LinearTransform(np.array([[2.0, 0.0], [0.0, 2.0]]))
         spanSetPreScale = afwGeom.SpanSet.fromShape(2, afwGeom.Stencil.CIRCLE)
@@ -149,6 +178,25 @@ class SpanSetTestCase(lsst.utils.tests.TestCase):
         self.assertEqual(bBox.getMinX(), -1)
         self.assertEqual(bBox.getMinY(), -1)
 
+    def testMorphologyByShifts(self):
+        # Dilating is the union of the SpanSet shifted to each pixel of the structuring element, and
+        # eroding the intersection of the SpanSet shifted away from each
+        spanSet = afwGeom.SpanSet([afwGeom.Span(-3, -2, 4), afwGeom.Span(-2, -4, 6), afwGeom.Span(-1, -4, 0),
+                                   afwGeom.Span(-1, 3, 6), afwGeom.Span(0, -4, 6), afwGeom.Span(1, -3, 5),
+                                   afwGeom.Span(2, 0, 1), afwGeom.Span(5, 2, 9), afwGeom.Span(6, 2, 9)])
+        stencils = [afwGeom.SpanSet.fromShape(r, s) for r in range(3) for s in
+                    (afwGeom.Stencil.CIRCLE, afwGeom.Stencil.BOX, afwGeom.Stencil.MANHATTAN)]
+        stencils.append(afwGeom.SpanSet([afwGeom.Span(-1, 0, 2), afwGeom.Span(1, -1, -1)]))
+        for stencil in stencils:
+            yind, xind = stencil.indices()
+            truthDilated = afwGeom.SpanSet()
+            truthEroded = spanSet
+            for y, x in zip(yind, xind):
+                truthDilated = truthDilated.union(spanSet.shiftedBy(x, y))
+                truthEroded = truthEroded.intersect(spanSet.shiftedBy(-x, -y))
+            self.assertEqual(spanSet.dilated(stencil), truthDilated)
+            self.assertEqual(spanSet.eroded(stencil), truthEroded)
+
     def testFlatten(self):
         # Give an initial value to an input array
         inputArray = np.ones((6, 6)) * 9
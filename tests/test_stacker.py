@@ -27,6 +27,7 @@ Run with:
 or
    pytest test_stacker.py
 """
+import contextlib
 import unittest
 from functools import reduce
 
@@ -403,6 +404,100 @@ class StackTestCase(lsst.utils.tests.TestCase):
         self.assertEqual(stack.mask[1, 1, afwImage.LOCAL], clipped)
         self.assertEqual(stack.mask[1, 2, afwImage.LOCAL], rejected)
 
+    def testMultiThreaded(self):
+        """Test that stacking with several threads matches stacking with one thread"""
+        nX, nY = 37, 29  # the height is not a multiple of the rows handed to each thread
+        badBit = afwImage.Mask.getPlaneBitMask("BAD")
+        mimgList = []
+        for iImg in range(self.nImg):
+            mimg = afwImage.MaskedImageF(lsst.geom.Extent2I(nX, nY))
+            imArr, maskArr, varArr = mimg.getArrays()
+            imArr[:] = np.random.normal(10.0, 1.0, size=imArr.shape)
+            imArr[np.random.uniform(size=imArr.shape) < 0.05] += 100.0  # outliers to clip
+            maskArr[:] = np.where(np.random.uniform(size=maskArr.shape) < 0.1, badBit, 0)
+            varArr[:] = np.random.uniform(0.5, 2.0, size=varArr.shape)
+            mimgList.append(mimg)
+        imgList = [mimg.getImage() for mimg in mimgList]
+        weights = list(np.random.uniform(0.5, 1.5, size=self.nImg))
+
+        sctrl = afwMath.StatisticsControl()
+        sctrl.setAndMask(badBit)
+        self.assertEqual(sctrl.getNThreads(), 1)
+        for stat in (afwMath.MEAN, afwMath.MEANCLIP, afwMath.MEDIAN):
+            for weighted in (False, True):
+                sctrl.setWeighted(weighted)
+                sctrl.setNThreads(1)
+                serialMaskedStack = afwMath.statisticsStack(mimgList, stat, sctrl)
+                serialStack = afwMath.statisticsStack(imgList, stat, sctrl, weights if weighted else [])
+                for nThreads in (3, 0):
+                    sctrl.setNThreads(nThreads)
+                    self.assertEqual(sctrl.getNThreads(), nThreads)
+                    maskedStack = afwMath.statisticsStack(mimgList, stat, sctrl)
+                    self.assertMaskedImagesEqual(maskedStack, serialMaskedStack)
+                    stack = afwMath.statisticsStack(imgList, stat, sctrl, weights if weighted else [])
+                    self.assertImagesEqual(stack, serialStack)
+
+    def testStreamStack(self):
+        """Test that stacking strips read from FITS matches stacking in memory"""
+        nX, nY = 37, 29
+        xy0 = lsst.geom.Point2I(5, -3)
+        badBit = afwImage.Mask.getPlaneBitMask("BAD")
+        clipped = 1 << afwImage.Mask().addMaskPlane("CLIPPED")
+        maskMap = [(badBit, badBit)]
+        mimgList = []
+        for iImg in range(self.nImg):
+            mimg = afwImage.MaskedImageF(lsst.geom.Box2I(xy0, lsst.geom.Extent2I(nX, nY)))
+            imArr, maskArr, varArr = mimg.getArrays()
+            imArr[:] = np.random.normal(10.0, 1.0, size=imArr.shape)
+            imArr[np.random.uniform(size=imArr.shape) < 0.05] += 100.0
+            maskArr[:] = np.where(np.random.uniform(size=maskArr.shape) < 0.1, badBit, 0)
+            varArr[:] = np.random.uniform(0.5, 2.0, size=varArr.shape)
+            mimgList.append(mimg)
+        weights = list(np.random.uniform(0.5, 1.5, size=self.nImg))
+        sctrl = afwMath.StatisticsControl()
+        sctrl.setAndMask(badBit)
+
+        with contextlib.ExitStack() as stack:
+            readers = []
+            for mimg in mimgList:
+                fileName = stack.enter_context(lsst.utils.tests.getTempFilePath(".fits"))
+                mimg.writeFits(fileName)
+                readers.append(afwImage.MaskedImageFitsReader(fileName))
+
+            for stat in (afwMath.MEAN, afwMath.MEANCLIP, afwMath.MEDIAN):
+                expected = afwImage.MaskedImageF(mimgList[0].getBBox())
+                afwMath.statisticsStack(expected, mimgList, stat, sctrl, weights, clipped, maskMap)
+                for stripHeight in (1, 4, nY, 100):
+                    out = afwImage.MaskedImageF(mimgList[0].getBBox())
+                    afwMath.streamStatisticsStack(out, readers, stat, sctrl, weights, clipped, maskMap,
+                                                  stripHeight)
+                    self.assertMaskedImagesEqual(out, expected)
+
+            # stack part of the inputs, passing each strip to a sink
+            bbox = lsst.geom.Box2I(lsst.geom.Point2I(8, 0), lsst.geom.Extent2I(20, 11))
+            expected = afwImage.MaskedImageF(mimgList[0].getBBox())
+            afwMath.statisticsStack(expected, mimgList, afwMath.MEAN, sctrl, weights, clipped, maskMap)
+            out = afwImage.MaskedImageF(bbox)
+            strips = []
+
+            def sink(strip):
+                strips.append(strip.getBBox())
+                out.assign(strip, strip.getBBox())
+
+            afwMath.streamStatisticsStackF(readers, bbox, afwMath.MEAN, sctrl, weights, clipped, maskMap,
+                                           4, sink)
+            self.assertEqual([strip.getMinY() for strip in strips], [0, 4, 8])
+            self.assertEqual(strips[-1].getHeight(), 3)
+            self.assertMaskedImagesEqual(out, expected.subset(bbox))
+
+            # the region to stack must be contained in every input
+            with self.assertRaises(pexEx.InvalidParameterError):
+                afwMath.streamStatisticsStack(afwImage.MaskedImageF(nX, nY), readers, afwMath.MEAN, sctrl,
+                                              weights, clipped, maskMap)
+            with self.assertRaises(pexEx.InvalidParameterError):
+                afwMath.streamStatisticsStack(afwImage.MaskedImageF(bbox), readers, afwMath.MEAN, sctrl,
+                                              weights, clipped, maskMap, 0)
+
 #################################################################
 # Test suite boiler plate
 #################################################################
@@ -577,6 +577,126 @@ class StatisticsTestCase(lsst.utils.tests.TestCase):
             mask[1, 1] = maskVal
             self.assertEqual(afwMath.makeStatistics(image, mask, afwMath.NMASKED, ctrl).getValue(), 1)
 
+    def testFloatMatchesDouble(self):
+        """Test that the single-pass statistics of float images match those of double images"""
+        badBit = afwImage.Mask.getPlaneBitMask("BAD")
+        satBit = afwImage.Mask.getPlaneBitMask("SAT")
+        ctrl = afwMath.StatisticsControl()
+        ctrl.setAndMask(badBit)
+        flags = (afwMath.NPOINT | afwMath.MEAN | afwMath.STDEV | afwMath.VARIANCE | afwMath.MIN |
+                 afwMath.MAX | afwMath.SUM | afwMath.MEANSQUARE | afwMath.ORMASK | afwMath.NMASKED |
+                 afwMath.ERRORS)
+
+        np.random.seed(42)
+        bbox = lsst.geom.Box2I(lsst.geom.Point2I(0, 0), lsst.geom.Extent2I(131, 47))
+        imageF = afwImage.ImageF(bbox)
+        imageF.array[:] = np.random.normal(1000.0, 3.0, imageF.array.shape)
+        imageF.array[3, 5] = np.nan
+        imageF.array[7, 11] = np.inf
+        imageF.array[9, 100] = -1e6  # masked as BAD, so it shouldn't set MIN
+        mask = afwImage.Mask(bbox)
+        mask.array[:] = np.where(np.random.uniform(size=mask.array.shape) < 0.1, satBit, 0)
+        mask.array[9, 100] = badBit
+        imageD = afwImage.ImageD(bbox)
+        imageD.array[:] = imageF.array
+
+        # a sub-image with an odd width, so rows aren't contiguous or a multiple of the vector length
+        subBox = lsst.geom.Box2I(lsst.geom.Point2I(2, 1), lsst.geom.Extent2I(123, 40))
+        for box in (bbox, subBox):
+            for useMask in (False, True):
+                if useMask:
+                    statsF = afwMath.makeStatistics(imageF.subset(box), mask.subset(box), flags, ctrl)
+                    statsD = afwMath.makeStatistics(imageD.subset(box), mask.subset(box), flags, ctrl)
+                else:
+                    statsF = afwMath.makeStatistics(imageF.subset(box), flags, ctrl)
+                    statsD = afwMath.makeStatistics(imageD.subset(box), flags, ctrl)
+                for prop in (afwMath.NPOINT, afwMath.MIN, afwMath.MAX, afwMath.ORMASK, afwMath.NMASKED):
+                    self.assertEqual(statsF.getValue(prop), statsD.getValue(prop))
+                for prop in (afwMath.MEAN, afwMath.STDEV, afwMath.VARIANCE, afwMath.SUM,
+                             afwMath.MEANSQUARE):
+                    self.assertFloatsAlmostEqual(statsF.getValue(prop), statsD.getValue(prop), rtol=1e-12)
+                    self.assertFloatsAlmostEqual(statsF.getError(prop), statsD.getError(prop), rtol=1e-9)
+
+    def testQuantiles(self):
+        """Test the median and quartiles of masked images, with and without ties
+
+        Small images copy their pixels to find the quantiles and large ones don't, so test both.
+        """
+        badBit = afwImage.Mask.getPlaneBitMask("BAD")
+        ctrl = afwMath.StatisticsControl()
+        ctrl.setAndMask(badBit)
+
+        np.random.seed(666)
+        for dims in (lsst.geom.Extent2I(97, 61), lsst.geom.Extent2I(256, 160)):
+            bbox = lsst.geom.Box2I(lsst.geom.Point2I(0, 0), dims)
+            mask = afwImage.Mask(bbox)
+            mask.array[:] = np.where(np.random.uniform(size=mask.array.shape) < 0.1, badBit, 0)
+            good = mask.array == 0
+
+            # Floating point values; values either side of zero, and a NaN, exercise the sort order
+            for ImageClass in (afwImage.ImageF, afwImage.ImageD):
+                image = ImageClass(bbox)
+                image.array[:] = np.random.normal(0.0, 1e3, image.array.shape)
+                image.array[0, 0] = np.nan
+                image.array[0, 1] = -0.0
+                values = image.array[np.logical_and(good, np.isfinite(image.array))]
+                stats = afwMath.makeStatistics(image, mask, afwMath.MEDIAN | afwMath.IQRANGE, ctrl)
+                self.assertFloatsAlmostEqual(stats.getValue(afwMath.MEDIAN), np.percentile(values, 50),
+                                             rtol=1e-14)
+                self.assertFloatsAlmostEqual(stats.getValue(afwMath.IQRANGE),
+                                             np.percentile(values, 75) - np.percentile(values, 25),
+                                             rtol=1e-12)
+
+            # Integer values with lots of ties; the median shouldn't depend on whether we ask for
+            # IQRANGE too
+            for ImageClass, mean in ((afwImage.ImageI, -3.0), (afwImage.ImageU, 1000.0)):
+                image = ImageClass(bbox)
+                image.array[:] = np.floor(np.random.normal(mean, 1.0, image.array.shape) + 0.5)
+                median = afwMath.makeStatistics(image, mask, afwMath.MEDIAN, ctrl).getValue()
+                stats = afwMath.makeStatistics(image, mask, afwMath.MEDIAN | afwMath.IQRANGE, ctrl)
+                self.assertEqual(stats.getValue(afwMath.MEDIAN), median)
+                self.assertAlmostEqual(median, mean, delta=0.1)
+                self.assertAlmostEqual(stats.getValue(afwMath.IQRANGE), 1.349, delta=0.1)
+
+    def testGridStatistics(self):
+        """Test that makeGridStatistics matches makeStatistics on each cell"""
+        badBit = afwImage.Mask.getPlaneBitMask("BAD")
+        ctrl = afwMath.StatisticsControl()
+        ctrl.setAndMask(badBit)
+        flags = (afwMath.NPOINT | afwMath.MEAN | afwMath.STDEV | afwMath.MIN | afwMath.MAX | afwMath.SUM |
+                 afwMath.ORMASK | afwMath.NMASKED | afwMath.ERRORS)
+
+        np.random.seed(7)
+        bbox = lsst.geom.Box2I(lsst.geom.Point2I(0, 0), lsst.geom.Extent2I(103, 58))
+        mimg = afwImage.MaskedImageF(bbox)
+        mimg.image.array[:] = np.random.normal(100.0, 5.0, mimg.image.array.shape)
+        mimg.image.array[10:20, 30:40] = np.nan
+        mimg.mask.array[:] = np.where(np.random.uniform(size=mimg.mask.array.shape) < 0.1, badBit, 0)
+
+        # overlapping cells of odd sizes that don't cover the whole image
+        xOrigins, xSizes = [0, 17, 40, 90], [17, 30, 33, 13]
+        yOrigins, ySizes = [1, 20, 35], [19, 20, 23]
+        for nThreads in (1, 3):
+            ctrl.setNThreads(nThreads)
+            for image in (mimg, mimg.image):
+                results = afwMath.makeGridStatistics(image, xOrigins, xSizes, yOrigins, ySizes, flags, ctrl)
+                self.assertEqual(len(results), len(xOrigins)*len(yOrigins))
+                for iY, (y0, height) in enumerate(zip(yOrigins, ySizes)):
+                    for iX, (x0, width) in enumerate(zip(xOrigins, xSizes)):
+                        box = lsst.geom.Box2I(lsst.geom.Point2I(x0, y0), lsst.geom.Extent2I(width, height))
+                        expected = afwMath.makeStatistics(image.subset(box), flags, ctrl)
+                        stats = results[iY*len(xOrigins) + iX]
+                        for prop in (afwMath.NPOINT, afwMath.MEAN, afwMath.STDEV, afwMath.MIN, afwMath.MAX,
+                                     afwMath.SUM, afwMath.ORMASK, afwMath.NMASKED):
+                            self.assertEqual(stats.getResult(prop), expected.getResult(prop))
+
+        self.assertTrue(afwMath.canMakeGridStatistics(flags, ctrl))
+        self.assertFalse(afwMath.canMakeGridStatistics(afwMath.MEANCLIP, ctrl))
+        with self.assertRaises(lsst.pex.exceptions.InvalidParameterError):
+            afwMath.makeGridStatistics(mimg, xOrigins, xSizes, yOrigins, ySizes, afwMath.MEDIAN, ctrl)
+        with self.assertRaises(lsst.pex.exceptions.LengthError):
+            afwMath.makeGridStatistics(mimg, [95], [10], [0], [10], flags, ctrl)
+
 
 class TestMemory(lsst.utils.tests.MemoryTestCase):
     pass
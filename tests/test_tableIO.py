@@ -26,6 +26,7 @@ import numpy as np
 import astropy.io.fits
 
 import lsst.utils.tests
+import lsst.pex.exceptions
 import lsst.geom
 import lsst.afw.table
 import lsst.afw.image
@@ -102,6 +103,257 @@ class TableIoTestCase(lsst.utils.tests.TestCase):
             self.assertFloatsEqual(larger[bb], larger2[bb])
             self.assertFloatsEqual(larger[cc], larger2[cc])
 
+    def _makeCatalog(self, nRows):
+        """Make a catalog with a field of each kind the FITS reader and writer handle separately.
+        """
+        schema = lsst.afw.table.Schema()
+        schema.addField("a", type=np.int64, doc="a")
+        schema.addField("b", type="Angle", doc="b")
+        schema.addField("c", type="ArrayF", doc="c", size=3)
+        schema.addField("d", type=str, doc="d", size=8)
+        schema.addField("e", type="Flag", doc="e")
+        schema.addField("f", type="Flag", doc="f")
+        schema.addField("g", type="ArrayD", doc="g", size=0)
+        schema.addField("h", type=str, doc="h", size=0)
+        rng = np.random.RandomState(5)
+        cat = lsst.afw.table.BaseCatalog(schema)
+        for ii in range(nRows):
+            record = cat.addNew()
+            record["a"] = rng.randint(1 << 40)
+            record["b"] = rng.randn()*lsst.geom.radians
+            record["c"] = rng.randn(3).astype(np.float32)
+            record["d"] = "s%d" % ii
+            record["e"] = ii % 2 == 0
+            record["f"] = ii % 3 == 0
+            record["g"] = rng.randn(ii)
+            record["h"] = "t"*ii
+        return cat
+
+    def _assertCatalogsEqual(self, cat1, cat2):
+        self.assertEqual(cat1.schema, cat2.schema)
+        self.assertEqual(len(cat1), len(cat2))
+        for record1, record2 in zip(cat1, cat2):
+            for name in ("a", "b", "d", "e", "f", "h"):
+                self.assertEqual(record1[name], record2[name])
+            for name in ("c", "g"):
+                self.assertFloatsEqual(record1[name], record2[name])
+
+    def testWrittenRows(self):
+        """Test that a catalog written a block of rows at a time reads back the same,
+        whether or not the number of rows is a multiple of the block size.
+        """
+        oldFactor = lsst.afw.table.io.getWrittenRowsFactor()
+        try:
+            for nRows in (0, 1, 4, 11):
+                cat = self._makeCatalog(nRows)
+                lsst.afw.table.io.setWrittenRowsFactor(4*cat.schema.getRecordSize())
+                with lsst.utils.tests.getTempFilePath(".fits") as tmpFile:
+                    cat.writeFits(tmpFile)
+                    cat2 = lsst.afw.table.BaseCatalog.readFits(tmpFile)
+                self._assertCatalogsEqual(cat, cat2)
+        finally:
+            lsst.afw.table.io.setWrittenRowsFactor(oldFactor)
+
+    def _makeFlagCatalog(self, nFlags, nRows):
+        """Make a catalog with only Flag fields, set at random.
+        """
+        schema = lsst.afw.table.Schema()
+        keys = [schema.addField("f%d" % bit, type="Flag", doc="f%d" % bit) for bit in range(nFlags)]
+        flags = np.random.RandomState(nFlags).rand(nRows, nFlags) < 0.5
+        cat = lsst.afw.table.BaseCatalog(schema)
+        for ii in range(nRows):
+            record = cat.addNew()
+            for key, value in zip(keys, flags[ii]):
+                record.set(key, bool(value))
+        return cat, flags
+
+    def testWrittenFlags(self):
+        """Test that flags written a block of rows at a time are laid out as the FITS standard requires,
+        with each row padded to a whole number of bytes, whether or not there is a multiple of 8 of them.
+        """
+        oldFactor = lsst.afw.table.io.getWrittenRowsFactor()
+        try:
+            for nFlags in (1, 3, 8, 11):
+                nRows = 13
+                cat, flags = self._makeFlagCatalog(nFlags, nRows)
+                lsst.afw.table.io.setWrittenRowsFactor(4*cat.schema.getRecordSize())
+                with lsst.utils.tests.getTempFilePath(".fits") as tmpFile:
+                    cat.writeFits(tmpFile)
+                    with astropy.io.fits.open(tmpFile) as inFits:
+                        self.assertEqual(inFits[1].header["TFORM1"], "%dX" % nFlags)
+                        written = np.asarray(inFits[1].data["flags"], dtype=bool).reshape(nRows, nFlags)
+                self.assertTrue(np.all(written == flags))
+        finally:
+            lsst.afw.table.io.setWrittenRowsFactor(oldFactor)
+
+    def testPreppedRowsAllTypes(self):
+        """Test that catalogs read a chunk of rows at a time match what was written,
+        for every kind of field and whether or not the number of rows is a multiple of
+        the chunk size.
+        """
+        oldFactor = lsst.afw.table.io.getPreppedRowsFactor()
+        try:
+            for nRows in (1, 3, 10):
+                cat = self._makeCatalog(nRows)
+                with lsst.utils.tests.getTempFilePath(".fits") as tmpFile:
+                    cat.writeFits(tmpFile)
+                    for nRowsToPrep in (1, 2, 3):
+                        lsst.afw.table.io.setPreppedRowsFactor(nRowsToPrep*cat.schema.getRecordSize())
+                        cat2 = lsst.afw.table.BaseCatalog.readFits(tmpFile)
+                        self._assertCatalogsEqual(cat, cat2)
+        finally:
+            lsst.afw.table.io.setPreppedRowsFactor(oldFactor)
+
+    def testReadFlagsWrittenByRow(self):
+        """Test that flags written one row at a time, as older versions of afw did, are read correctly
+        a chunk of rows at a time, whether or not there is a multiple of 8 of them.
+        """
+        oldWritten = lsst.afw.table.io.getWrittenRowsFactor()
+        oldPrepped = lsst.afw.table.io.getPreppedRowsFactor()
+        try:
+            for nFlags in (1, 3, 8, 11):
+                nRows = 13
+                cat, flags = self._makeFlagCatalog(nFlags, nRows)
+                lsst.afw.table.io.setWrittenRowsFactor(1)
+                with lsst.utils.tests.getTempFilePath(".fits") as tmpFile:
+                    cat.writeFits(tmpFile)
+                    with astropy.io.fits.open(tmpFile) as inFits:
+                        written = np.asarray(inFits[1].data["flags"], dtype=bool).reshape(nRows, nFlags)
+                    self.assertTrue(np.all(written == flags))
+                    for nRowsToPrep in (1, 4, nRows):
+                        lsst.afw.table.io.setPreppedRowsFactor(nRowsToPrep*cat.schema.getRecordSize())
+                        cat2 = lsst.afw.table.BaseCatalog.readFits(tmpFile)
+                        self.assertEqual(len(cat2), nRows)
+                        for bit in range(nFlags):
+                            self.assertEqual(list(cat2["f%d" % bit]), list(flags[:, bit]))
+        finally:
+            lsst.afw.table.io.setWrittenRowsFactor(oldWritten)
+            lsst.afw.table.io.setPreppedRowsFactor(oldPrepped)
+
+    def testReadOptions(self):
+        """Test reading a subset of the columns and rows of a catalog.
+        """
+        cat = self._makeCatalog(10)
+        with lsst.utils.tests.getTempFilePath(".fits") as tmpFile:
+            cat.writeFits(tmpFile)
+
+            options = lsst.afw.table.io.FitsReadOptions()
+            options.columns = ["a", "c", "f", "h"]
+            cat2 = lsst.afw.table.BaseCatalog.readFits(tmpFile, options)
+            self.assertEqual(cat2.schema.getNames(), {"a", "c", "f", "h"})
+            self.assertEqual(len(cat2), len(cat))
+            for record1, record2 in zip(cat, cat2):
+                for name in ("a", "f", "h"):
+                    self.assertEqual(record1[name], record2[name])
+                self.assertFloatsEqual(record1["c"], record2["c"])
+
+            options = lsst.afw.table.io.FitsReadOptions()
+            options.beginRow = 3
+            options.endRow = 7
+            cat2 = lsst.afw.table.BaseCatalog.readFits(tmpFile, options)
+            self._assertCatalogsEqual(cat[3:7], cat2)
+
+            options.rows = [8, 2, 5]
+            cat2 = lsst.afw.table.BaseCatalog.readFits(tmpFile, options)
+            self.assertEqual(list(cat2["a"]), [cat[i]["a"] for i in options.rows])
+
+            # scattered rows out of order, with runs of consecutive rows, with and without a filter;
+            # read one row at a time, and a few rows at a time
+            rows = [9, 3, 4, 5, 0, 7, 7, 2, 1]
+            for factor in (1, 64):
+                oldFactor = lsst.afw.table.io.getPreppedRowsFactor()
+                try:
+                    lsst.afw.table.io.setPreppedRowsFactor(factor)
+                    options = lsst.afw.table.io.FitsReadOptions()
+                    options.rows = rows
+                    cat2 = lsst.afw.table.BaseCatalog.readFits(tmpFile, options)
+                    self.assertEqual(list(cat2["a"]), [cat[i]["a"] for i in rows])
+                    self.assertEqual(list(cat2["h"]), [cat[i]["h"] for i in rows])
+                    options.filterColumn = "f"
+                    options.filter = lambda record: not record["f"]
+                    cat2 = lsst.afw.table.BaseCatalog.readFits(tmpFile, options)
+                    self.assertEqual(list(cat2["a"]), [cat[i]["a"] for i in rows if not cat[i]["f"]])
+                finally:
+                    lsst.afw.table.io.setPreppedRowsFactor(oldFactor)
+
+            for filterColumn in ("a", "e"):
+                options = lsst.afw.table.io.FitsReadOptions()
+                options.columns = ["d"]
+                options.filterColumn = filterColumn
+                if filterColumn == "a":
+                    threshold = np.median(cat["a"])
+                    options.filter = lambda record: record["a"] > threshold
+                    expected = [record["d"] for record in cat if record["a"] > threshold]
+                else:
+                    options.filter = lambda record: record["e"]
+                    expected = [record["d"] for record in cat if record["e"]]
+                # read one row at a time, and a few rows at a time
+                for factor in (1, 64):
+                    oldFactor = lsst.afw.table.io.getPreppedRowsFactor()
+                    try:
+                        lsst.afw.table.io.setPreppedRowsFactor(factor)
+                        cat2 = lsst.afw.table.BaseCatalog.readFits(tmpFile, options)
+                    finally:
+                        lsst.afw.table.io.setPreppedRowsFactor(oldFactor)
+                    self.assertEqual(cat2.schema.getNames(), {"d", filterColumn})
+                    self.assertEqual([record["d"] for record in cat2], expected)
+
+            options = lsst.afw.table.io.FitsReadOptions()
+            options.columns = ["a", "nonexistent"]
+            with self.assertRaises(lsst.pex.exceptions.NotFoundError):
+                lsst.afw.table.BaseCatalog.readFits(tmpFile, options)
+            options = lsst.afw.table.io.FitsReadOptions()
+            options.rows = [10]
+            with self.assertRaises(lsst.pex.exceptions.OutOfRangeError):
+                lsst.afw.table.BaseCatalog.readFits(tmpFile, options)
+
+    def testMappedFitsTable(self):
+        """Test that the fields of a mapped FITS table match those of the catalog read from it.
+
+        MappedFitsTable reads the bits of each row from the row's own bytes, so this also checks
+        that flags are written with the layout the FITS standard requires.
+        """
+        schema = self._makeCatalog(0).schema
+        mapper = lsst.afw.table.SchemaMapper(schema)
+        mapper.addMinimalSchema(schema)
+        mapper.editOutputSchema().addField("u", type=np.uint16, doc="u")
+        cat = lsst.afw.table.BaseCatalog(mapper.getOutputSchema())
+        cat.extend(self._makeCatalog(10), mapper=mapper)
+        cat = cat.copy(deep=True)  # make the records contiguous
+        cat["u"] = np.arange(len(cat), dtype=np.uint16)*5000
+        with lsst.utils.tests.getTempFilePath(".fits") as tmpFile:
+            cat.writeFits(tmpFile)
+            mapped = lsst.afw.table.io.MappedFitsTable(tmpFile)
+            self.assertEqual(len(mapped), len(cat))
+            self.assertEqual(mapped.schema, lsst.afw.table.BaseCatalog.readFits(tmpFile).schema)
+            for name in ("a", "b", "c", "e", "f", "u"):
+                self.assertTrue(mapped.isMapped(name))
+                self.assertFloatsEqual(np.asarray(mapped[name], dtype=float),
+                                       np.asarray(cat[name], dtype=float))
+            for name in ("d", "g", "h", "nonexistent"):
+                self.assertFalse(mapped.isMapped(name))
+            for name in ("d", "g", "h"):
+                with self.assertRaises(lsst.pex.exceptions.TypeError):
+                    mapped.getColumn(name)
+            # columns outlive the table they came from
+            column = mapped["a"]
+            del mapped
+            self.assertFloatsEqual(np.asarray(column, dtype=float), np.asarray(cat["a"], dtype=float))
+            del column
+        # flags that span more than one byte of each row, written a few rows at a time
+        oldFactor = lsst.afw.table.io.getWrittenRowsFactor()
+        try:
+            cat, flags = self._makeFlagCatalog(11, 13)
+            lsst.afw.table.io.setWrittenRowsFactor(4*cat.schema.getRecordSize())
+            with lsst.utils.tests.getTempFilePath(".fits") as tmpFile:
+                cat.writeFits(tmpFile)
+                mapped = lsst.afw.table.io.MappedFitsTable(tmpFile)
+                for bit in range(flags.shape[1]):
+                    self.assertEqual(list(np.asarray(mapped["f%d" % bit], dtype=bool)), list(flags[:, bit]))
+                del mapped
+        finally:
+            lsst.afw.table.io.setWrittenRowsFactor(oldFactor)
+
 
 class MemoryTester(lsst.utils.tests.MemoryTestCase):
     pass
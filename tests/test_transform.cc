@@ -26,9 +26,11 @@
 #define BOOST_TEST_MODULE TransformCpp
 
 #include <array>
+#include <vector>
 
 #include "boost/test/unit_test.hpp"
 
+#include "lsst/pex/exceptions.h"
 #include "lsst/afw/geom/Transform.h"
 
 /*
@@ -105,6 +107,88 @@ BOOST_AUTO_TEST_CASE(getJacobianDimensions) {
         }
     }
 }
+
+/*
+ * Tests that Transform::applyForwardGrid and applyInverseGrid match applyForward and applyInverse
+ * applied to the same points, and that they check their arguments.
+ */
+BOOST_AUTO_TEST_CASE(applyGrid) {
+    using GenericTransform = Transform<GenericEndpoint, GenericEndpoint>;
+
+    for (std::size_t nIn : {1, 2, 3}) {
+        auto polyMap = makeForwardPolyMap(nIn, 2);
+        GenericTransform transform(polyMap);
+
+        std::vector<double> const start = {-1.5, 2.0, 0.25};
+        std::vector<double> const step = {0.5, -1.0, 3.0};
+        std::vector<int> const count = {7, 4, 3};
+        std::vector<double> const gridStart(start.begin(), start.begin() + nIn);
+        std::vector<double> const gridStep(step.begin(), step.begin() + nIn);
+        std::vector<int> const gridCount(count.begin(), count.begin() + nIn);
+        int nPoints = 1;
+        for (auto axisCount : gridCount) {
+            nPoints *= axisCount;
+        }
+
+        // the grid points, computed the obvious way; the first axis varies fastest
+        ndarray::Array<double, 2, 2> expectedFrom = ndarray::allocate(ndarray::makeVector<int>(nIn, nPoints));
+        for (int i = 0; i < nPoints; ++i) {
+            int index = i;
+            for (std::size_t axis = 0; axis < nIn; ++axis) {
+                expectedFrom[axis][i] = gridStart[axis] + (index % gridCount[axis]) * gridStep[axis];
+                index /= gridCount[axis];
+            }
+        }
+        auto const expectedTo = transform.applyForward(expectedFrom);
+
+        ndarray::Array<double, 2, 2> from = ndarray::allocate(ndarray::makeVector<int>(nIn, nPoints));
+        ndarray::Array<double, 2, 2> to = ndarray::allocate(ndarray::makeVector(2, nPoints));
+        transform.applyForwardGrid(gridStart, gridStep, gridCount, from, to);
+        for (int i = 0; i < nPoints; ++i) {
+            for (std::size_t axis = 0; axis < nIn; ++axis) {
+                BOOST_TEST(from[axis][i] == expectedFrom[axis][i]);
+            }
+            for (int axis = 0; axis < 2; ++axis) {
+                BOOST_TEST(to[axis][i] == expectedTo[axis][i]);
+            }
+        }
+
+        // wrong number of grid values, negative count, and wrong array shapes
+        std::vector<double> const tooLong(nIn + 1, 1.0);
+        BOOST_CHECK_THROW(transform.applyForwardGrid(tooLong, gridStep, gridCount, from, to),
+                          pex::exceptions::InvalidParameterError);
+        std::vector<int> negativeCount(gridCount);
+        negativeCount[0] = -1;
+        BOOST_CHECK_THROW(transform.applyForwardGrid(gridStart, gridStep, negativeCount, from, to),
+                          pex::exceptions::InvalidParameterError);
+        ndarray::Array<double, 2, 2> shortTo = ndarray::allocate(ndarray::makeVector(2, nPoints - 1));
+        BOOST_CHECK_THROW(transform.applyForwardGrid(gridStart, gridStep, gridCount, from, shortTo),
+                          pex::exceptions::InvalidParameterError);
+        ndarray::Array<double, 2, 2> wideFrom = ndarray::allocate(ndarray::makeVector<int>(nIn + 1, nPoints));
+        BOOST_CHECK_THROW(transform.applyForwardGrid(gridStart, gridStep, gridCount, wideFrom, to),
+                          pex::exceptions::InvalidParameterError);
+    }
+
+    // inverse, using a mapping that has an inverse
+    Transform<Point2Endpoint, Point2Endpoint> zoomTransform(ast::ZoomMap(2, 2.5));
+    std::vector<double> const start = {3.0, -4.0};
+    std::vector<double> const step = {1.0, 0.5};
+    std::vector<int> const count = {5, 6};
+    ndarray::Array<double, 2, 2> to = ndarray::allocate(ndarray::makeVector(2, 30));
+    ndarray::Array<double, 2, 2> from = ndarray::allocate(ndarray::makeVector(2, 30));
+    zoomTransform.applyInverseGrid(start, step, count, to, from);
+    for (int j1 = 0, i = 0; j1 < count[1]; ++j1) {
+        for (int j0 = 0; j0 < count[0]; ++j0, ++i) {
+            lsst::geom::Point2D const toPoint(start[0] + j0 * step[0], start[1] + j1 * step[1]);
+            auto const fromPoint = zoomTransform.applyInverse(toPoint);
+            BOOST_TEST(to[0][i] == toPoint[0]);
+            BOOST_TEST(to[1][i] == toPoint[1]);
+            BOOST_TEST(from[0][i] == fromPoint[0]);
+            BOOST_TEST(from[1][i] == fromPoint[1]);
+        }
+    }
+}
+
 }  // namespace geom
 }  // namespace afw
 }  // namespace lsst
@@ -233,6 +233,14 @@ class WarpExposureTestCase(lsst.utils.tests.TestCase):
                 self.assertEqual(
                     wc.getMaskWarpingKernel().getCacheSize(), newCacheSize)
 
+        wc = afwMath.WarpingControl("lanczos3")
+        self.assertEqual(wc.getNThreads(), 1)
+        for nThreads in (0, 4):
+            wc = afwMath.WarpingControl("lanczos3", nThreads=nThreads)
+            self.assertEqual(wc.getNThreads(), nThreads)
+            wc.setNThreads(2)
+            self.assertEqual(wc.getNThreads(), 2)
+
     def testWarpingControlError(self):
         """Test error handling of WarpingControl
         """
@@ -387,6 +395,129 @@ class WarpExposureTestCase(lsst.utils.tests.TestCase):
             self.assertImagesAlmostEqual(afwWarpedImage, swarpedImage,
                                          skipMask=noDataMaskArr, rtol=rtol, atol=atol)
 
+    def makeWarpInputs(self):
+        """Make a random source masked image, its WCS and a rotated and rescaled destination WCS
+
+        Returns
+        -------
+        srcMaskedImage : `lsst.afw.image.MaskedImageF`
+        srcWcs : `lsst.afw.geom.SkyWcs`
+        destWcs : `lsst.afw.geom.SkyWcs`
+        """
+        srcWcs = afwGeom.makeSkyWcs(
+            crpix=lsst.geom.Point2D(50, 60),
+            crval=lsst.geom.SpherePoint(10, 20, lsst.geom.degrees),
+            cdMatrix=afwGeom.makeCdMatrix(scale=0.2*lsst.geom.arcseconds),
+        )
+        destWcs = afwGeom.makeSkyWcs(
+            crpix=lsst.geom.Point2D(55, 58),
+            crval=lsst.geom.SpherePoint(10, 20, lsst.geom.degrees),
+            cdMatrix=afwGeom.makeCdMatrix(scale=0.21*lsst.geom.arcseconds,
+                                          orientation=17*lsst.geom.degrees),
+        )
+        srcMaskedImage = afwImage.MaskedImageF(120, 110)
+        srcImArr, srcMaskArr, srcVarArr = srcMaskedImage.getArrays()
+        srcImArr[:] = np.random.normal(100, 10, srcImArr.shape)
+        srcVarArr[:] = np.random.uniform(50, 150, srcVarArr.shape)
+        srcMaskArr[:] = np.where(np.random.uniform(size=srcMaskArr.shape) < 0.02,
+                                 afwImage.Mask.getPlaneBitMask("BAD"), 0)
+        return srcMaskedImage, srcWcs, destWcs
+
+    def testMultiThreadedWarp(self):
+        """Test that warping with several threads matches warping with one thread
+        """
+        srcMaskedImage, srcWcs, destWcs = self.makeWarpInputs()
+        for interpLength in (0, 1, 7, 10):
+            for kernelName, maskKernelName in (("lanczos3", ""), ("lanczos4", "bilinear")):
+                destList = []
+                numGoodPixList = []
+                for nThreads in (1, 3, 0):
+                    warpingControl = afwMath.WarpingControl(kernelName, maskKernelName, 0, interpLength,
+                                                            nThreads=nThreads)
+                    destMaskedImage = afwImage.MaskedImageF(100, 113)
+                    numGoodPixList.append(afwMath.warpImage(destMaskedImage, destWcs, srcMaskedImage,
+                                                            srcWcs, warpingControl))
+                    destList.append(destMaskedImage)
+                self.assertGreater(numGoodPixList[0], 0)
+                for numGoodPix, destMaskedImage in zip(numGoodPixList[1:], destList[1:]):
+                    self.assertEqual(numGoodPix, numGoodPixList[0])
+                    self.assertMaskedImagesEqual(destMaskedImage, destList[0])
+
+    def testRelativeAreaNoInterp(self):
+        """Test the pixel area correction of warping without interpolation, on a distorted transform
+
+        Warping an image of ones gives the relative area of each destination pixel, which is computed
+        from the source positions of the pixel, and of the pixels above-left and above it.
+        """
+        srcToDest = afwGeom.makeRadialTransform([0.0, 1.0, 2e-3])
+        srcImage = afwImage.ImageF(100, 100)
+        srcImage.set(1.0)
+        destImage = afwImage.ImageF(40, 40)
+        destImage.setXY0(20, 20)
+        for nThreads in (1, 3):
+            warpingControl = afwMath.WarpingControl("bilinear", "", 0, 0, nThreads=nThreads)
+            numGoodPix = afwMath.warpImage(destImage, srcImage, srcToDest, warpingControl)
+            self.assertEqual(numGoodPix, destImage.getWidth()*destImage.getHeight())
+
+            # source positions of the destination pixels, including row and column -1
+            destXList, destYList = np.meshgrid(np.arange(19, 60), np.arange(19, 60))
+            srcPosList = srcToDest.applyInverse([lsst.geom.Point2D(x, y) for x, y in
+                                                 zip(destXList.flat, destYList.flat)])
+            srcPosArr = np.array([(pos.getX(), pos.getY()) for pos in srcPosList]).reshape(41, 41, 2)
+            dSrcA = srcPosArr[1:, 1:] - srcPosArr[:-1, :-1]
+            dSrcB = srcPosArr[1:, 1:] - srcPosArr[:-1, 1:]
+            relativeArea = np.abs(dSrcA[:, :, 0]*dSrcB[:, :, 1] - dSrcA[:, :, 1]*dSrcB[:, :, 0])
+            self.assertFloatsAlmostEqual(destImage.getArray(), relativeArea, rtol=1e-6)
+
+    def testLanczosLutWarpingKernel(self):
+        """Test that LanczosLutWarpingKernel matches LanczosWarpingKernel
+        """
+        for order in (2, 3, 5):
+            exactKernel = afwMath.LanczosWarpingKernel(order)
+            for oversample, atol in ((1024, 1e-6), (256, 1e-5)):
+                lutKernel = afwMath.LanczosLutWarpingKernel(order, oversample)
+                self.assertEqual(lutKernel.getOrder(), order)
+                self.assertEqual(lutKernel.getOversample(), oversample)
+                self.assertEqual(lutKernel.getDimensions(), exactKernel.getDimensions())
+                self.assertEqual(lutKernel.clone().getOversample(), oversample)
+
+                exactImage = afwImage.ImageD(exactKernel.getDimensions())
+                lutImage = afwImage.ImageD(lutKernel.getDimensions())
+                maxDiff = 0.0
+                for xFrac, yFrac in [(0.0, 0.0), (1.0, 1.0)] + list(np.random.uniform(size=(50, 2))):
+                    exactKernel.setKernelParameters((xFrac, yFrac))
+                    lutKernel.setKernelParameters((xFrac, yFrac))
+                    exactKernel.computeImage(exactImage, False)
+                    lutKernel.computeImage(lutImage, False)
+                    self.assertImagesAlmostEqual(lutImage, exactImage, atol=atol, rtol=0)
+                    maxDiff = max(maxDiff, np.max(np.abs(lutImage.getArray() - exactImage.getArray())))
+                # make sure the kernel really is tabulated
+                self.assertGreater(maxDiff, 0.0)
+
+        for name, order, oversample in (("lanczos3-lut", 3, 1024), ("lanczos4-lut4096", 4, 4096)):
+            kernel = afwMath.WarpingControl(name).getWarpingKernel()
+            self.assertIsInstance(kernel, afwMath.LanczosLutWarpingKernel)
+            self.assertEqual(kernel.getOrder(), order)
+            self.assertEqual(kernel.getOversample(), oversample)
+
+        for order, oversample in ((0, 1024), (3, 0)):
+            with self.assertRaises(pexExcept.InvalidParameterError):
+                afwMath.LanczosLutWarpingKernel(order, oversample)
+
+    def testLanczosLutWarp(self):
+        """Test that warping with lanczos#-lut matches warping with lanczos#
+        """
+        srcMaskedImage, srcWcs, destWcs = self.makeWarpInputs()
+        for order in (3, 4):
+            for interpLength in (0, 10):
+                destList = []
+                for kernelName in ("lanczos%d" % (order,), "lanczos%d-lut" % (order,)):
+                    warpingControl = afwMath.WarpingControl(kernelName, "bilinear", 0, interpLength)
+                    destMaskedImage = afwImage.MaskedImageF(100, 113)
+                    afwMath.warpImage(destMaskedImage, destWcs, srcMaskedImage, srcWcs, warpingControl)
+                    destList.append(destMaskedImage)
+                self.assertMaskedImagesAlmostEqual(destList[1], destList[0], rtol=1e-5)
+
     def testTicket2441(self):
         """Test ticket 2441: warpExposure sometimes mishandles zero-extent dest exposures"""
         fromWcs = afwGeom.makeSkyWcs(